@@ -70,6 +70,10 @@ virtual	const IBoneData&		_BCL	GetBoneData(u16 bone_id) const = 0;
 	// Main functionality
 	virtual void						CalculateBones(BOOL bForceExact	= FALSE) = 0; // Recalculate skeleton
 	virtual void						CalculateBones_Invalidate() = 0;
+	// animation LOD: interval of the non-exact updates (0 - default) and
+	// whether they may skip the bones without pickable shapes
+	virtual void						SetUpdateLOD(u32 interval, BOOL partial) = 0;
+	virtual void						CalculateBones_Hit() = 0;	// current pose of the pickable bones, for ray/hit queries
 	virtual void						Callback(UpdateCallback C, void* Param) = 0;
 
 	//	Callback: data manipulation
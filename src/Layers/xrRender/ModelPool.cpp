@@ -2,6 +2,7 @@
 #pragma hdrstop
 
 #include "ModelPool.h"
+#include "dxRenderDeviceRender.h"
 
 #ifndef _EDITOR
 	#include "../../xrEngine/IGame_Persistent.h"
@@ -316,6 +317,58 @@ void	CModelPool::Delete		(dxRender_Visual* &V, BOOL bDiscard)
 	V							=	NULL;
 }
 
+// runs on a stream worker: requests the textures of the model and of its children,
+// but not the ones the resource manager has loaded already
+static void stream_ogf_textures	(IReader& data, float priority)
+{
+	if (data.find_chunk(OGF_TEXTURE))
+	{
+		string256		fnT;
+		data.r_stringZ	(fnT,sizeof(fnT));
+		u32 count		= _GetItemCount(fnT);
+		for (u32 it=0; it<count; it++)
+		{
+			string_path	name;
+			_GetItem	(fnT,it,name);
+			if (strext(name))	*strext(name) = 0;
+			if (DEV->_HasTexture(name))	continue;
+			xr_strcat	(name,".dds");
+			FS.stream_request	("$game_textures$",name,priority);
+		}
+	}
+
+	IReader* OBJ		= data.open_chunk(OGF_CHILDREN);
+	if (OBJ)
+	{
+		IReader* O		= OBJ->open_chunk(0);
+		for (int count=1; O; count++)
+		{
+			stream_ogf_textures	(*O,priority);
+			O->close	();
+			O			= OBJ->open_chunk(count);
+		}
+		OBJ->close		();
+	}
+}
+
+bool	CModelPool::Stream		(LPCSTR name, float priority)
+{
+	string_path low_name;	VERIFY	(xr_strlen(name)<sizeof(low_name));
+	xr_strcpy(low_name,name);	strlwr	(low_name);
+	if (strext(low_name))	*strext	(low_name)=0;
+
+	if (Pool.find(low_name)!=Pool.end() || Instance_Find(low_name))
+		return				false;
+
+	string_path				fn, ogf_name;
+	strconcat				(sizeof(ogf_name),ogf_name,low_name,".ogf");
+	if (!FS.exist(fn,"$level$",ogf_name) && !FS.exist(fn,"$game_meshes$",ogf_name))
+		return				false;
+
+	FS.stream_request		(0,fn,priority,stream_ogf_textures);
+	return					FS.stream_pending(0,fn);
+}
+
 void	CModelPool::DeleteQueue		()
 {
 	for (u32 it=0; it<ModelsToDelete.size(); it++)
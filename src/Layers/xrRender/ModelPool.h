@@ -65,6 +65,7 @@ public:
 	void					Logging				(BOOL bEnable)	{ bLogging=bEnable; }
 	
 	void					Prefetch			();
+	bool					Stream				(LPCSTR name, float priority);
 	void					ClearPool			( BOOL b_complete );
 
 	void					dump 				();
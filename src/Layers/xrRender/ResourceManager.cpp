@@ -342,6 +342,21 @@ void CResourceManager::DeferredUpload()
 		t->second->Load();
 	}
 }
+
+// the map is changed on the main thread only and under the lock, the stream
+// workers look up through here
+BOOL CResourceManager::_HasTexture	(LPCSTR _Name)
+{
+	string_path		Name;
+	xr_strcpy		(Name,_Name);
+	fix_texture_name(Name);
+
+	m_textures_lock.Enter	();
+	map_TextureIt	I	= m_textures.find(Name);
+	BOOL const	result	= (I!=m_textures.end()) && I->second->flags.bLoaded;
+	m_textures_lock.Leave	();
+	return			result;
+}
 /*
 void	CResourceManager::DeferredUnload	()
 {
@@ -49,6 +49,7 @@ private:
 	// data
 	map_Blender											m_blenders;
 	map_Texture											m_textures;
+	xrCriticalSection									m_textures_lock;	// m_textures changes, for _HasTexture
 	map_Matrix											m_matrices;
 	map_Constant										m_constants;
 	map_RT												m_rtargets;
@@ -117,6 +118,7 @@ public:
 	// Low level resource creation
 	CTexture*						_CreateTexture		(LPCSTR Name);
 	void							_DeleteTexture		(const CTexture* T);
+	BOOL							_HasTexture			(LPCSTR Name);		// created and loaded, any thread
 
 	CMatrix*						_CreateMatrix		(LPCSTR Name);
 	void							_DeleteMatrix		(const CMatrix*  M);
@@ -193,7 +195,11 @@ public:
 	Shader*							_lua_Create			(LPCSTR		s_shader,	LPCSTR s_textures);
 	BOOL							_lua_HasShader		(LPCSTR		s_shader);
 
-	CResourceManager						()	: bDeferredLoad(TRUE){	}
+	CResourceManager						()	: bDeferredLoad(TRUE)
+#ifdef PROFILE_CRITICAL_SECTIONS
+		,m_textures_lock(MUTEX_PROFILE_ID(CResourceManager::m_textures_lock))
+#endif // PROFILE_CRITICAL_SECTIONS
+	{	}
 	~CResourceManager						()	;
 
 	void			OnDeviceCreate			(IReader* F);
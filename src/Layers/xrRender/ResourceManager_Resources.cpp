@@ -438,7 +438,9 @@ CTexture* CResourceManager::_CreateTexture	(LPCSTR _Name)
 	{
 		CTexture *	T		=	xr_new<CTexture>();
 		T->dwFlags			|=	xr_resource_flagged::RF_REGISTERED;
+		m_textures_lock.Enter	();
 		m_textures.insert	(mk_pair(T->set_name(Name),T));
+		m_textures_lock.Leave	();
 		T->Preload			();
 		if (RDEVICE.b_is_Ready && !bDeferredLoad) T->Load();
 		return		T;
@@ -452,7 +454,9 @@ void	CResourceManager::_DeleteTexture		(const CTexture* T)
 	LPSTR N					= LPSTR		(*T->cName);
 	map_Texture::iterator I	= m_textures.find	(N);
 	if (I!=m_textures.end())	{
+		m_textures_lock.Enter	();
 		m_textures.erase(I);
+		m_textures_lock.Leave	();
 		return;
 	}
 	Msg	("! ERROR: Failed to find texture surface '%s'",*T->cName);
@@ -949,6 +949,14 @@ void CKinematicsAnimated::OnCalculateBones		()
 {
 	UpdateTracks	()	;
 }
+
+BOOL CKinematicsAnimated::Bone_Static			()
+{
+	if (m_update_tracks_callback || !blend_fx.empty())	return FALSE;
+	for (u16 i=0; i<MAX_PARTS; ++i)
+		if (!blend_cycles[i].empty())	return FALSE;
+	return			inherited::Bone_Static();
+}
 IBlendDestroyCallback* CKinematicsAnimated::GetBlendDestroyCallback	( )
 {
 	return m_blend_destroy_callback;
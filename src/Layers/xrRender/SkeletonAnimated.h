@@ -65,6 +65,7 @@ virtual	void					BuildBoneMatrix				( const CBoneData* bd, CBoneInstance &bi, co
 public:
 
 	virtual void				OnCalculateBones		();
+	virtual BOOL				Bone_Static				();
 public: 
 #ifdef _EDITOR
 public:
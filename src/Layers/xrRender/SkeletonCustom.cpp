@@ -96,10 +96,19 @@ CKinematics::CKinematics()
 #endif
 
 	m_is_original_lod = false;
+	UCalc_BatchFrame  = u32(-1);
+	UCalc_LODInterval = 0;
+	UCalc_LODSkipTime = 0;
+	UCalc_LODMask	  = 0;
+	UCalc_Partial	  = FALSE;
+	UCalc_Static	  = FALSE;
 }
 
 CKinematics::~CKinematics	()
 {
+#ifndef _EDITOR
+	CalculateBones_Unregister	();
+#endif
 	IBoneInstances_Destroy	();
 	// wallmarks
 	ClearWallmarks			();
@@ -387,6 +396,7 @@ void CKinematics::Copy(dxRender_Visual *P)
 void CKinematics::CalculateBones_Invalidate	()
 {	
 	UCalc_Time		= 0x0; 
+	UCalc_Static	= FALSE;
 	UCalc_Visibox	= psSkeletonUpdate;		
 }
 
@@ -398,6 +408,8 @@ void CKinematics::Spawn			()
 		bone_instances[i].construct();
 	Update_Callback				= NULL;
 	CalculateBones_Invalidate	();
+	UCalc_LODInterval			= 0;
+	UCalc_LODMask				= 0;
 	// wallmarks
 	ClearWallmarks				();
 	Visibility_Invalidate		();
@@ -407,6 +419,9 @@ void CKinematics::Spawn			()
 void CKinematics::Depart		()
 {
 	inherited::Depart			();
+#ifndef _EDITOR
+	CalculateBones_Unregister	();
+#endif
 	// wallmarks
 	ClearWallmarks				();
 
@@ -94,6 +94,8 @@ public:
 	BOOL						dbg_single_use_marker;
 #endif
 			void				Bone_Calculate		(CBoneData* bd, Fmatrix* parent);
+			void				Bone_Calculate_Partial(CBoneData* bd, Fmatrix* parent, u64 mask);
+			u64					Bones_HitMask		();
 			void				CLBone				(const CBoneData* bd, CBoneInstance &bi, const Fmatrix *parent, u8 mask_channel = (1<<0));
 
 			void				BoneChain_Calculate	(const CBoneData* bd, CBoneInstance &bi,u8 channel_mask, bool ignore_callbacks);
@@ -124,6 +126,12 @@ protected:
 	BOOL						Update_Visibility		;
 	u32							UCalc_Time				;
 	s32							UCalc_Visibox			;
+	u32							UCalc_BatchFrame		;	// last frame the model was queued to the skeleton batch
+	u32							UCalc_LODInterval		;	// slow update interval requested by the animation LOD
+	u32							UCalc_LODSkipTime		;	// ...last slow update skipped because of it
+	u64							UCalc_LODMask			;	// bones evaluated by slow updates, 0 - all
+	BOOL						UCalc_Partial			;	// last evaluation skipped the bones outside UCalc_LODMask
+	BOOL						UCalc_Static			;	// last batch evaluation had nothing moving the bones
 
     Flags64						visimask;
     
@@ -136,6 +144,14 @@ protected:
 	void						Visibility_Invalidate	()	{ Update_Visibility=TRUE; };
 	void						Visibility_Update		()	;
 
+	BOOL						CalculateBones_Prepare	(BOOL bForceExact);
+	void						CalculateBones_Finish	();
+	void						CalculateBones_Request	();
+	void						CalculateBones_Unregister();
+	BOOL						Bone_HasCallbacks		();
+	virtual BOOL				Bone_Static				()	{ return !Update_Callback && !Bone_HasCallbacks(); }	// the pose can't change by itself
+	static void					BatchWorker				(LPVOID params);
+
     void						LL_Validate				();
 public:
 	UpdateCallback				Update_Callback;
@@ -211,6 +227,9 @@ public:
 	// Main functionality
 	virtual void					CalculateBones				(BOOL bForceExact	=	FALSE);		// Recalculate skeleton
 	void							CalculateBones_Invalidate	();
+	static void						CalculateBones_Batch		();									// frame-level evaluation of the models queued last frame
+	virtual void					SetUpdateLOD				(u32 interval, BOOL partial);
+	virtual void					CalculateBones_Hit			();									// evaluates the pickable bones now, under the LOD too
 	void							Callback					(UpdateCallback C, void* Param)		{	Update_Callback	= C; Update_Callback_Param	= Param;	}
 
 	//	Callback: data manipulation
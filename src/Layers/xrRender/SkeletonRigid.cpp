@@ -4,6 +4,11 @@
 
 #include 	"SkeletonCustom.h"
 
+#ifndef _EDITOR
+#include	"../../xrCPU_Pipe/ttapi.h"
+#pragma comment(lib,"xrCPU_Pipe.lib")
+#endif
+
 extern int	psSkeletonUpdate;
 
 #ifdef DEBUG
@@ -15,29 +20,97 @@ void CKinematics::CalculateBones			(BOOL bForceExact)
 	// early out.
 	// check if the info is still relevant
 	// skip all the computations - assume nothing changes in a small period of time :)
-	if		(RDEVICE.dwTimeGlobal == UCalc_Time)										return;	// early out for "fast" update
+#ifndef _EDITOR
+	if		(bForceExact && (UCalc_BatchFrame != RDEVICE.dwFrame))		CalculateBones_Request	();	// evaluate with the next frame batch
+#endif
+	if		((RDEVICE.dwTimeGlobal == UCalc_Time) && !(bForceExact && UCalc_Partial))	return;	// early out for "fast" update
 	UCalc_mtlock	lock	;
-	OnCalculateBones		();
-	if		(!bForceExact && (RDEVICE.dwTimeGlobal < (UCalc_Time + UCalc_Interval)))	return;	// early out for "slow" update
-	if		(Update_Visibility)									Visibility_Update	();
+	if		(!CalculateBones_Prepare(bForceExact))				return;
+	UCalc_Static					= FALSE;
 
 	_DBG_SINGLE_USE_MARKER;
-	// here we have either:
-	//	1:	timeout elapsed
-	//	2:	exact computation required
-	UCalc_Time			= RDEVICE.dwTimeGlobal;
-
 	// exact computation
 	// Calculate bones
 #ifdef DEBUG
 	RDEVICE.Statistic->Animation.Begin();
 #endif
-
-	Bone_Calculate					(bones->at(iRoot),&Fidentity);
+	u64 const		eval_start		= CPU::QPC();
+	UCalc_Partial					= !bForceExact && UCalc_LODMask;
+	if (UCalc_Partial)
+	{
+		Bone_Calculate_Partial		(bones->at(iRoot),&Fidentity,UCalc_LODMask);
+		u32 const	evaluated		= u32(btwCount1(UCalc_LODMask));
+		RDEVICE.Statistic->Animation_BonesEvaluated	+= evaluated;
+		RDEVICE.Statistic->Animation_BonesAvoided	+= LL_BoneCount() - evaluated;
+	} else {
+		Bone_Calculate				(bones->at(iRoot),&Fidentity);
+		RDEVICE.Statistic->Animation_BonesEvaluated	+= LL_BoneCount();
+	}
+	RDEVICE.Statistic->Animation_EvalTicks			+= CPU::QPC() - eval_start;
 #ifdef DEBUG
 	check_kinematics				(this, dbg_name.c_str() );
 	RDEVICE.Statistic->Animation.End	();
 #endif
+	CalculateBones_Finish			();
+}
+
+// Ray/hit queries only test the bones with pickable shapes: under the
+// animation LOD those (and their parents) are evaluated right away, the rest
+// of the skeleton is left to the LOD schedule and no batch request is made.
+void CKinematics::CalculateBones_Hit		()
+{
+	if		(!UCalc_LODInterval && !UCalc_LODMask)				{ CalculateBones(); return; }
+	if		(RDEVICE.dwTimeGlobal == UCalc_Time)					return;	// partial updates cover the pickable bones
+	UCalc_mtlock	lock	;
+	if		(!CalculateBones_Prepare(TRUE))						return;
+	UCalc_Static					= FALSE;
+
+	u64 const		eval_start		= CPU::QPC();
+	UCalc_Partial					= LL_BoneCount()<=64;
+	if (UCalc_Partial)
+	{
+		u64 const	mask			= UCalc_LODMask ? UCalc_LODMask : Bones_HitMask();
+		Bone_Calculate_Partial		(bones->at(iRoot),&Fidentity,mask);
+		u32 const	evaluated		= u32(btwCount1(mask));
+		RDEVICE.Statistic->Animation_BonesEvaluated	+= evaluated;
+		RDEVICE.Statistic->Animation_BonesAvoided	+= LL_BoneCount() - evaluated;
+	} else {
+		Bone_Calculate				(bones->at(iRoot),&Fidentity);
+		RDEVICE.Statistic->Animation_BonesEvaluated	+= LL_BoneCount();
+	}
+	RDEVICE.Statistic->Animation_EvalTicks			+= CPU::QPC() - eval_start;
+#ifdef DEBUG
+	check_kinematics				(this, dbg_name.c_str() );
+#endif
+	CalculateBones_Finish			();
+}
+
+BOOL CKinematics::CalculateBones_Prepare	(BOOL bForceExact)
+{
+	if		((RDEVICE.dwTimeGlobal == UCalc_Time) && !(bForceExact && UCalc_Partial))	return	FALSE;
+	OnCalculateBones		();
+	if		(!bForceExact && (RDEVICE.dwTimeGlobal < (UCalc_Time + UCalc_Interval)))	return	FALSE;
+	if		(!bForceExact && (RDEVICE.dwTimeGlobal < (UCalc_Time + UCalc_LODInterval)))
+	{
+		// animation LOD: count the updates the default interval would have done
+		if (RDEVICE.dwTimeGlobal >= (_max(UCalc_Time,UCalc_LODSkipTime) + UCalc_Interval))
+		{
+			UCalc_LODSkipTime							= RDEVICE.dwTimeGlobal;
+			RDEVICE.Statistic->Animation_BonesAvoided	+= LL_BoneCount();
+		}
+		return				FALSE;
+	}
+	if		(Update_Visibility)									Visibility_Update	();
+
+	// here we have either:
+	//	1:	timeout elapsed
+	//	2:	exact computation required
+	UCalc_Time			= RDEVICE.dwTimeGlobal;
+	return				TRUE;
+}
+
+void CKinematics::CalculateBones_Finish	()
+{
 	VERIFY( LL_GetBonesVisible()!=0 );
 	// Calculate BOXes/Spheres if needed
 	UCalc_Visibox++; 
@@ -95,6 +168,180 @@ void CKinematics::CalculateBones			(BOOL bForceExact)
 	if (Update_Callback)	Update_Callback(this);
 }
 
+#ifndef _EDITOR
+//---------------------------------------------------------------------------
+// Frame-level skeleton batch.
+// Models that asked for exact bones during the previous frame are evaluated
+// together from the render's OnFrame, ahead of the game update and while the
+// MT thread is parked, so the ttapi workers are not shared with its
+// seqParallel jobs. Track updates, visibility and the box/callback tail stay
+// serial (they touch game code and ::Random), the bone hierarchies of models
+// without bone callbacks are built in parallel. UCalc_Mutex is taken per model
+// for the serial steps; a prepared model has its UCalc_Time set, so an inline
+// CalculateBones early-outs on it while the workers build its bones.
+// A model the batch evaluated with nothing to move its bones (no blends, no
+// callbacks) and still in that state is not evaluated again.
+int			psSkeletonBatch			= 1;
+
+static	xr_vector<CKinematics*>		g_skeleton_requests;
+static	xr_vector<CKinematics*>		g_skeleton_batch;
+static	xr_vector<CKinematics*>		g_skeleton_parallel;
+static	xr_vector<CKinematics*>		g_skeleton_serial;
+static	u32							g_skeleton_batch_frame	= u32(-1);
+
+struct skeleton_batch_worker
+{
+	CKinematics**	from;
+	CKinematics**	to;
+};
+
+void CKinematics::CalculateBones_Request	()
+{
+	UCalc_mtlock			lock;
+	if (UCalc_BatchFrame == RDEVICE.dwFrame)	return;
+	UCalc_BatchFrame		= RDEVICE.dwFrame;
+	if ((RDEVICE.dwFrame-g_skeleton_batch_frame) > 2)	return;	// nobody consumes the queue (no render calculation)
+	g_skeleton_requests.push_back	(this);
+}
+
+void CKinematics::CalculateBones_Unregister	()
+{
+	if (UCalc_BatchFrame == u32(-1))			return;
+	UCalc_mtlock			lock;
+	UCalc_BatchFrame		= u32(-1);
+	g_skeleton_requests.erase	(std::remove(g_skeleton_requests.begin(),g_skeleton_requests.end(),this),g_skeleton_requests.end());
+	g_skeleton_batch.erase		(std::remove(g_skeleton_batch.begin(),g_skeleton_batch.end(),this),g_skeleton_batch.end());
+	g_skeleton_parallel.erase	(std::remove(g_skeleton_parallel.begin(),g_skeleton_parallel.end(),this),g_skeleton_parallel.end());
+	g_skeleton_serial.erase		(std::remove(g_skeleton_serial.begin(),g_skeleton_serial.end(),this),g_skeleton_serial.end());
+}
+
+BOOL CKinematics::Bone_HasCallbacks			()
+{
+	for (u16 i=0, n=LL_BoneCount(); i<n; ++i)
+		if (bone_instances[i].callback())		return	TRUE;
+	return						FALSE;
+}
+
+void CKinematics::BatchWorker				(LPVOID params)
+{
+	skeleton_batch_worker*	W	= (skeleton_batch_worker*)params;
+	for (CKinematics** it=W->from; it!=W->to; ++it)
+	{
+		CKinematics*		K	= *it;
+		K->Bone_Calculate		(K->bones->at(K->iRoot),&Fidentity);
+	}
+}
+
+void CKinematics::CalculateBones_Batch		()
+{
+	RDEVICE.Statistic->Animation_BatchBones	= 0;
+	RDEVICE.Statistic->Animation_BatchModels	= 0;
+	RDEVICE.Statistic->Animation_BatchSkipped	= 0;
+	{
+		UCalc_mtlock		lock;
+		g_skeleton_batch_frame	= RDEVICE.dwFrame;
+		if (!psSkeletonBatch)
+		{
+			g_skeleton_requests.clear	();
+			return;
+		}
+
+		g_skeleton_batch.swap	(g_skeleton_requests);
+		g_skeleton_requests.clear	();
+	}
+	if (g_skeleton_batch.empty())				return;
+
+	RDEVICE.Statistic->Animation_Batch.Begin	();
+
+	// serial: tracks, visibility, skip the models that are already up to date
+	u32						bones_total	= 0;
+	u32						skipped		= 0;
+	u32 const				requested	= g_skeleton_batch.size();
+	g_skeleton_parallel.clear	();
+	g_skeleton_serial.clear		();
+	for (u32 i=0; i<g_skeleton_batch.size(); ++i)
+	{
+		CKinematics*		K	= g_skeleton_batch[i];
+		UCalc_mtlock		lock;
+		// evaluated exactly this frame already
+		if ((K->UCalc_Time == RDEVICE.dwTimeGlobal) && !K->UCalc_Partial)	{ ++skipped; continue; }
+		// unchanged since the last batch evaluation
+		if (K->UCalc_Static && K->UCalc_Time && !K->UCalc_Partial && K->Bone_Static())
+		{
+			K->UCalc_Time		= RDEVICE.dwTimeGlobal;
+			++skipped;
+			continue;
+		}
+		if (!K->CalculateBones_Prepare(TRUE))	{ ++skipped; continue; }
+		K->UCalc_Partial		= FALSE;
+		K->UCalc_Static			= K->Bone_Static();
+		bones_total				+= K->LL_BoneCount();
+		if (K->Bone_HasCallbacks())	g_skeleton_serial.push_back		(K);
+		else						g_skeleton_parallel.push_back	(K);
+	}
+
+	// parallel: bone hierarchies, split by bone count
+	u32 const		count		= g_skeleton_parallel.size();
+	u32				workers		= _min(u32(ttapi_GetWorkersCount()),count/4);
+	if (workers < 2)
+	{
+		skeleton_batch_worker	W;
+		W.from					= count ? &g_skeleton_parallel.front() : 0;
+		W.to					= W.from + count;
+		BatchWorker				(&W);
+	} else {
+		u32			parallel_bones	= 0;
+		for (u32 i=0; i<count; ++i)	parallel_bones	+= g_skeleton_parallel[i]->LL_BoneCount();
+
+		skeleton_batch_worker*	W	= (skeleton_batch_worker*)_alloca(sizeof(skeleton_batch_worker)*workers);
+		u32			it			= 0;
+		u32			bones_done	= 0;
+		for (u32 w=0; w<workers; ++w)
+		{
+			u32 const	bones_limit	= (w==workers-1) ? parallel_bones : (parallel_bones*(w+1))/workers;
+			W[w].from				= &g_skeleton_parallel.front() + it;
+			while ((it<count) && ((bones_done<bones_limit) || (w==workers-1)))
+				bones_done			+= g_skeleton_parallel[it++]->LL_BoneCount();
+			W[w].to					= &g_skeleton_parallel.front() + it;
+			ttapi_AddWorker			(BatchWorker,(LPVOID)&W[w]);
+		}
+		ttapi_RunAllWorkers		();
+	}
+
+	// serial: models with bone callbacks, in request order
+	for (u32 i=0; i<g_skeleton_serial.size(); ++i)
+	{
+		CKinematics*		K	= g_skeleton_serial[i];
+		UCalc_mtlock		lock;
+		K->Bone_Calculate		(K->bones->at(K->iRoot),&Fidentity);
+	}
+
+	// serial: boxes, update callbacks
+	for (u32 i=0; i<g_skeleton_parallel.size(); ++i)
+	{
+		UCalc_mtlock		lock;
+#ifdef DEBUG
+		check_kinematics				(g_skeleton_parallel[i], g_skeleton_parallel[i]->dbg_name.c_str() );
+#endif
+		g_skeleton_parallel[i]->CalculateBones_Finish	();
+	}
+	for (u32 i=0; i<g_skeleton_serial.size(); ++i)
+	{
+		UCalc_mtlock		lock;
+		g_skeleton_serial[i]->CalculateBones_Finish		();
+	}
+
+	g_skeleton_parallel.clear	();
+	g_skeleton_serial.clear		();
+	g_skeleton_batch.clear		();
+	RDEVICE.Statistic->Animation_Batch.End		();
+	RDEVICE.Statistic->Animation_BatchBones		= bones_total;
+	RDEVICE.Statistic->Animation_BonesEvaluated	+= bones_total;
+	RDEVICE.Statistic->Animation_BatchModels	= requested - skipped;
+	RDEVICE.Statistic->Animation_BatchSkipped	= skipped;
+}
+#endif // _EDITOR
+
 #ifdef DEBUG
 void check_kinematics(CKinematics* _k, LPCSTR s)
 {
@@ -171,6 +418,41 @@ void CKinematics::Bone_Calculate(CBoneData* bd, Fmatrix *parent)
 
 }
 
+// same as Bone_Calculate, but skips the subtrees outside the mask
+void CKinematics::Bone_Calculate_Partial(CBoneData* bd, Fmatrix *parent, u64 mask)
+{
+	u16							SelfID				= bd->GetSelfID();
+	if (!(mask&(u64(1)<<SelfID)))					return;
+	CBoneInstance				&BONE_INST			= LL_GetBoneInstance(SelfID);
+	CLBone( bd, BONE_INST, parent, u8(-1) );
+	// Calculate children
+	for (xr_vector<CBoneData*>::iterator C=bd->children.begin(); C!=bd->children.end(); C++)
+		Bone_Calculate_Partial( *C, &BONE_INST.mTransform, mask );
+}
+
+// bones with pickable shapes and all their parents
+u64 CKinematics::Bones_HitMask()
+{
+	u64							mask				= u64(1)<<iRoot;
+	for (u16 i=0; i<LL_BoneCount(); ++i)
+	{
+		SBoneShape&				shape				= (*bones)[i]->shape;
+		if (SBoneShape::stNone==shape.type)			continue;
+		if (shape.flags.is(SBoneShape::sfNoPickable))continue;
+		for (u16 b=i; b!=BI_NONE; b=(*bones)[b]->GetParentID())
+			mask				|= u64(1)<<b;
+	}
+	return						mask;
+}
+
+void CKinematics::SetUpdateLOD(u32 interval, BOOL partial)
+{
+	if ((UCalc_LODInterval==interval) && ((UCalc_LODMask!=0)==!!partial))	return;
+	UCalc_mtlock				lock;
+	UCalc_LODInterval			= interval;
+	UCalc_LODMask				= (partial && (LL_BoneCount()<=64)) ? Bones_HitMask() : 0;
+}
+
 void	CKinematics::BoneChain_Calculate		(const CBoneData* bd, CBoneInstance &bi, u8 mask_channel, bool ignore_callbacks)
 {
 	u16 SelfID					= bd->GetSelfID();
@@ -88,6 +88,7 @@ xr_token							qminmax_sm_token					[ ]={
 
 // Common
 extern int			psSkeletonUpdate;
+extern int			psSkeletonBatch;
 extern float		r__dtex_range;
 
 //int		ps_r__Supersample			= 1		;
@@ -653,6 +654,7 @@ void		xrRender_initconsole	()
 	CMD3(CCC_Preset,	"_preset",				&ps_Preset,	qpreset_token	);
 
 	CMD4(CCC_Integer,	"rs_skeleton_update",	&psSkeletonUpdate,	2,		128	);
+	CMD4(CCC_Integer,	"rs_skeleton_batch",	&psSkeletonBatch,	0,		1	);
 #ifdef	DEBUG
 	CMD1(CCC_DumpResources,		"dump_resources");
 #endif	//	 DEBUG
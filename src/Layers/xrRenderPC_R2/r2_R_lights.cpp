@@ -1,4 +1,5 @@
 #include "stdafx.h"
+#include "../../xrCore/frame_arena.h"
 
 IC		bool	pred_area		(light* _1, light* _2)
 {
@@ -31,7 +32,7 @@ void	CRender::render_lights	(light_Package& LP)
 	// 2. refactor - infact we could go from the backside and sort in ascending order
 	{
 		xr_vector<light*>&		source		= LP.v_shadowed;
-		xr_vector<light*>		refactored	;
+		xr_vector<light*,frame_alloc<light*> >	refactored	;
 		refactored.reserve		(source.size());
 		u32						total		= source.size();
 
@@ -57,7 +58,7 @@ void	CRender::render_lights	(light_Package& LP)
 
 		// save (lights are popped from back)
 		std::reverse	(refactored.begin(),refactored.end());
-		LP.v_shadowed	= refactored;
+		LP.v_shadowed.assign	(refactored.begin(),refactored.end());
 	}
 
 	//////////////////////////////////////////////////////////////////////////
@@ -77,7 +78,7 @@ void	CRender::render_lights	(light_Package& LP)
 	while		(LP.v_shadowed.size() )
 	{
 		// if (has_spot_shadowed)
-		xr_vector<light*>	L_spot_s;
+		xr_vector<light*,frame_alloc<light*> >	L_spot_s;
 		stats.s_used		++;
 
 		// generate spot shadowmap
@@ -1,4 +1,5 @@
 #include "stdafx.h"
+#include "../../xrCore/frame_arena.h"
 #include "../../xrEngine/igame_persistent.h"
 #include "../../xrEngine/irenderable.h"
 #include "../xrRender/FBasicVisual.h"
@@ -473,7 +474,7 @@ class	DumbConvexVolume
 public:
 	struct	_poly
 	{
-		xr_vector<int>	points;
+		xr_vector<int,frame_alloc<int> >	points;
 		Fvector3		planeN;
 		float			planeD;
 		float			classify	(Fvector3& p)	{	return planeN.dotproduct(p)+planeD; 	}
@@ -486,9 +487,9 @@ public:
 		bool			equal		(_edge& E)												{ return p0==E.p0 && p1==E.p1;	}
 	};
 public:
-	xr_vector<Fvector3>		points;
-	xr_vector<_poly>		polys;
-	xr_vector<_edge>		edges;
+	xr_vector<Fvector3,frame_alloc<Fvector3> >	points;
+	xr_vector<_poly,frame_alloc<_poly> >		polys;
+	xr_vector<_edge,frame_alloc<_edge> >		edges;
 public:
 	void				compute_planes	()
 	{
@@ -545,7 +546,7 @@ public:
 			int		marker		= (base.planeN.dotproduct(direction)<=0)?-1:1;
 
 			// register edges
-			xr_vector<int>&	plist		= polys[it].points;
+			xr_vector<int,frame_alloc<int> >&	plist		= polys[it].points;
 			for (int p=0; p<int(plist.size()); p++)	{
 				_edge	E		(plist[p],plist[ (p+1)%plist.size() ], marker);
 				bool	found	= false;
@@ -625,7 +626,7 @@ const	float	_eps	= 0.000001f;
 struct	DumbClipper
 {
 	CFrustum				frustum;
-	xr_vector<D3DXPLANE>	planes;
+	xr_vector<D3DXPLANE,frame_alloc<D3DXPLANE> >	planes;
 	BOOL					clip	(D3DXVECTOR3& p0, D3DXVECTOR3& p1)		// returns TRUE if result meaningfull
 	{
 		float		denum;
@@ -210,7 +210,7 @@ const	float	_eps	= 0.000001f;
 struct	DumbClipper
 {
 	CFrustum				frustum;
-	xr_vector<D3DXPLANE>	planes;
+	xr_vector<D3DXPLANE,frame_alloc<D3DXPLANE> >	planes;
 	BOOL					clip	(D3DXVECTOR3& p0, D3DXVECTOR3& p1)		// returns TRUE if result meaningfull
 	{
 		float		denum;
@@ -499,6 +499,10 @@ void CRender::OnFrame()
 void CRender::OnFrame()
 {
 	Models->DeleteQueue			();
+
+	// skeletons queued last frame, before the game asks for them one by one
+	CKinematics::CalculateBones_Batch	();
+
 	if (ps_r2_ls_flags.test(R2FLAG_EXP_MT_CALC))	{
 		// MT-details (@front)
 		Device.seqParallel.insert	(Device.seqParallel.begin(),
@@ -554,6 +558,7 @@ IRenderVisual*			CRender::model_CreateParticles	(LPCSTR name)
 	}
 }
 void					CRender::models_Prefetch		()					{ Models->Prefetch	();}
+bool					CRender::model_Stream			(LPCSTR name, float priority)	{ return Models->Stream(name,priority);	}
 void					CRender::models_Clear			(BOOL b_complete)	{ Models->ClearPool	(b_complete);}
 
 ref_shader				CRender::getShader				(int id)			{ VERIFY(id<int(Shaders.size()));	return Shaders[id];	}
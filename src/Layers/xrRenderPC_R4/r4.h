@@ -321,6 +321,7 @@ public:
 	virtual void 					model_Delete				(IRender_DetailModel* & F);
 	virtual void					model_Logging				(BOOL bEnable)				{ Models->Logging(bEnable);	}
 	virtual void					models_Prefetch				();
+	virtual bool					model_Stream				(LPCSTR name, float priority);
 	virtual void					models_Clear				(BOOL b_complete);
 
 	// Occlusion culling
@@ -2,6 +2,8 @@
 #define	r4_R_sun_support_included
 #pragma once
 
+#include "../../xrCore/frame_arena.h"
+
 const u32 LIGHT_CUBOIDSIDEPOLYS_COUNT	= 4;
 const u32 LIGHT_CUBOIDVERTICES_COUNT	= 2*LIGHT_CUBOIDSIDEPOLYS_COUNT;
 
@@ -282,7 +284,7 @@ class	DumbConvexVolume
 public:
 	struct	_poly
 	{
-		xr_vector<int>	points;
+		xr_vector<int,frame_alloc<int> >	points;
 		Fvector3		planeN;
 		float			planeD;
 		float			classify	(Fvector3& p)	{	return planeN.dotproduct(p)+planeD; 	}
@@ -295,9 +297,9 @@ public:
 		bool			equal		(_edge& E)												{ return p0==E.p0 && p1==E.p1;	}
 	};
 public:
-	xr_vector<Fvector3>		points;
-	xr_vector<_poly>		polys;
-	xr_vector<_edge>		edges;
+	xr_vector<Fvector3,frame_alloc<Fvector3> >	points;
+	xr_vector<_poly,frame_alloc<_poly> >		polys;
+	xr_vector<_edge,frame_alloc<_edge> >		edges;
 public:
 	void				compute_planes	()
 	{
@@ -407,7 +409,7 @@ public:
 			int		marker		= (base.planeN.dotproduct(direction)<=0)?-1:1;
 
 			// register edges
-			xr_vector<int>&	plist		= polys[it].points;
+			xr_vector<int,frame_alloc<int> >&	plist		= polys[it].points;
 			for (int p=0; p<int(plist.size()); p++)	{
 				_edge	E		(plist[p],plist[ (p+1)%plist.size() ], marker);
 				bool	found	= false;
@@ -472,6 +472,8 @@ virtual	const IBoneData&_BCL	GetBoneData(u16 bone_id) const 															{ ret
 	// Main functionality
 	virtual void				CalculateBones(BOOL bForceExact	= FALSE) 												{ } // Recalculate skeleton
 	virtual void				CalculateBones_Invalidate()																{ }
+	virtual void				SetUpdateLOD(u32 interval, BOOL partial)												{ }
+	virtual void				CalculateBones_Hit()																	{ }
 	virtual void				Callback(UpdateCallback C, void* Param) 												{ VERIFY(false); }
 
 	//	Callback: data manipulation
@@ -230,7 +230,7 @@ struct	RC { RayCache	C; };
 
 class	CoverThread : public CThread
 {
-	u32					Nstart, Nend;
+	CThreadChunks&		chunks;
 	xr_vector<RC>		cache;
 	CDB::COLLIDER		DB;
 	Query				Q;
@@ -238,19 +238,43 @@ class	CoverThread : public CThread
 	typedef float	Cover[4];
 
 public:
-	CoverThread			(u32 ID, u32 _start, u32 _end) : CThread(ID)
+	u64					rays;
+
+	CoverThread			(u32 ID, CThreadChunks& _chunks) : CThread(ID), chunks(_chunks)
 	{
-		Nstart	= _start;
-		Nend	= _end;
+		thMessages	= FALSE;
+		thDestroyOnComplete	= FALSE;
+		rays		= 0;
 	}
 
-	void				compute_cover_value	(u32 const &N, vertex &BaseNode, float const &cover_height, Cover &cover)
+	static void			compute_cover		(float const (&c_total)[8], float const (&c_passed)[8], Cover &cover)
+	{
+		// analyze probabilities
+		float	value	[8];
+		for (int dirs=0; dirs<8; dirs++)	{
+			R_ASSERT(c_passed[dirs]<=c_total[dirs]);
+			if (c_total[dirs]==0)	value[dirs] = 0;
+			else					value[dirs]	= float(c_passed[dirs])/float(c_total[dirs]);
+			clamp(value[dirs],0.f,1.f);
+		}
+
+		cover	[0]	= (value[2]+value[3]+value[4]+value[5])/4.f; clamp(cover[0],0.f,1.f);	// left
+		cover	[1]	= (value[0]+value[1]+value[2]+value[3])/4.f; clamp(cover[1],0.f,1.f);	// forward
+		cover	[2]	= (value[6]+value[7]+value[0]+value[1])/4.f; clamp(cover[2],0.f,1.f);	// right
+		cover	[3]	= (value[4]+value[5]+value[6]+value[7])/4.f; clamp(cover[3],0.f,1.f);	// back
+	}
+
+	// both cover heights share the volumetric query, the rays to every
+	// neighbour are traced as a pair against the same cached polygon
+	void				compute_cover_values(u32 const &N, vertex &BaseNode)
 	{
 		Fvector&	BasePos	= BaseNode.Pos;
-		Fvector		TestPos = BasePos; TestPos.y+=cover_height;
+		Fvector		TestPos[2];
+		TestPos[0]	= BasePos; TestPos[0].y	+= high_cover_height;
+		TestPos[1]	= BasePos; TestPos[1].y	+= low_cover_height;
 		
-		float	c_total	[8]	= {0,0,0,0,0,0,0,0};
-		float	c_passed[8]	= {0,0,0,0,0,0,0,0};
+		float	c_total	[8]		= {0,0,0,0,0,0,0,0};
+		float	c_passed[2][8]	= {{0,0,0,0,0,0,0,0},{0,0,0,0,0,0,0,0}};
 		
 		// perform volumetric query
 		Q.Init			(BasePos);
@@ -273,27 +297,14 @@ public:
 			// raytrace
 			int			sector		=	calcSphereSector(Dir);
 			c_total		[sector]	+=	1.f;
-			c_passed	[sector]	+=	rayTrace (&DB, TestPos, Dir, range, cache[ID].C); //
+			c_passed	[0][sector]	+=	rayTrace (&DB, TestPos[0], Dir, range, cache[ID].C);
+			c_passed	[1][sector]	+=	rayTrace (&DB, TestPos[1], Dir, range, cache[ID].C);
+			rays					+=	2;
 		}
 		Q.Clear			();
-		
-		// analyze probabilities
-		float	value	[8];
-		for (int dirs=0; dirs<8; dirs++)	{
-			R_ASSERT(c_passed[dirs]<=c_total[dirs]);
-			if (c_total[dirs]==0)	value[dirs] = 0;
-			else					value[dirs]	= float(c_passed[dirs])/float(c_total[dirs]);
-			clamp(value[dirs],0.f,1.f);
-		}
 
-		if (value[0] < .999f) {
-			value[0] = value[0];
-		}
-		
-		cover	[0]	= (value[2]+value[3]+value[4]+value[5])/4.f; clamp(cover[0],0.f,1.f);	// left
-		cover	[1]	= (value[0]+value[1]+value[2]+value[3])/4.f; clamp(cover[1],0.f,1.f);	// forward
-		cover	[2]	= (value[6]+value[7]+value[0]+value[1])/4.f; clamp(cover[2],0.f,1.f);	// right
-		cover	[3]	= (value[4]+value[5]+value[6]+value[7])/4.f; clamp(cover[3],0.f,1.f);	// back
+		compute_cover	(c_total, c_passed[0], BaseNode.high_cover);
+		compute_cover	(c_total, c_passed[1], BaseNode.low_cover);
 	}
 
 	virtual void		Execute()
@@ -305,32 +316,77 @@ public:
 			rc.C[1].set		(0,0,0); 
 			rc.C[2].set		(0,0,0);
 			
-			cache.assign	(g_nodes.size()*2,rc);
+			cache.assign	(g_nodes.size(),rc);
 		}
 
 		FPU::m24r		();
 
 		Q.Begin			(g_nodes.size());
-		for (u32 N=Nstart; N<Nend; N++) {
-			// initialize process
-			thProgress	= float(N-Nstart)/float(Nend-Nstart);
-			vertex&		BaseNode= g_nodes[N];
-
-			if (!g_cover_nodes[N]) {
-				BaseNode.high_cover[0]	= flt_max;
-				BaseNode.high_cover[1]	= flt_max;
-				BaseNode.high_cover[2]	= flt_max;
-				BaseNode.high_cover[3]	= flt_max;
-				BaseNode.low_cover[0]	= flt_max;
-				BaseNode.low_cover[1]	= flt_max;
-				BaseNode.low_cover[2]	= flt_max;
-				BaseNode.low_cover[3]	= flt_max;
-				continue;
+		u32				from, to;
+		while (chunks.pull(from,to)) {
+			for (u32 N=from; N<to; N++) {
+				vertex&		BaseNode= g_nodes[N];
+
+				if (!g_cover_nodes[N]) {
+					BaseNode.high_cover[0]	= flt_max;
+					BaseNode.high_cover[1]	= flt_max;
+					BaseNode.high_cover[2]	= flt_max;
+					BaseNode.high_cover[3]	= flt_max;
+					BaseNode.low_cover[0]	= flt_max;
+					BaseNode.low_cover[1]	= flt_max;
+					BaseNode.low_cover[2]	= flt_max;
+					BaseNode.low_cover[3]	= flt_max;
+					continue;
+				}
+
+				compute_cover_values	(N, BaseNode);
 			}
+			thProgress	= chunks.progress();
+		}
+		thProgress		= 1.f;
+		cache.clear_and_free	();
+	}
+};
+
+class	CoverSmoothThread : public CThread
+{
+	CThreadChunks&		chunks;
+	Nodes const&		Old;
+public:
+	CoverSmoothThread	(u32 ID, CThreadChunks& _chunks, Nodes const& _Old) : CThread(ID), chunks(_chunks), Old(_Old)
+	{
+		thMessages	= FALSE;
+	}
 
-			compute_cover_value	(N, BaseNode, high_cover_height, BaseNode.high_cover);
-			compute_cover_value	(N, BaseNode, low_cover_height,  BaseNode.low_cover);
+	virtual void		Execute()
+	{
+		u32				from, to;
+		while (chunks.pull(from,to)) {
+			for (u32 N=from; N<to; N++)
+			{
+				vertex const&	Base	= Old[N];
+				vertex&			Dest	= g_nodes[N];
+				
+				for (int dir=0; dir<4; dir++)
+				{
+					float val		= 2*Base.high_cover[dir];
+					float val2		= 2*Base.low_cover[dir];
+					float cnt		= 2;
+					
+					for (int nid=0; nid<4; nid++) {
+						if (Base.n[nid]!=InvalidNode) {
+							val		+=  Old[Base.n[nid]].high_cover[dir];
+							val2	+=  Old[Base.n[nid]].low_cover[dir];
+							cnt		+=	1.f;
+						}
+					}
+					Dest.high_cover[dir]	=  val/cnt;
+					Dest.low_cover[dir]		=  val2/cnt;
+				}
+			}
+			thProgress	= chunks.progress();
 		}
+		thProgress		= 1.f;
 	}
 };
 
@@ -561,7 +617,6 @@ void compute_non_covers		()
 	}
 }
 
-#define NUM_THREADS	3
 extern	void mem_Optimize();
 void	xrCover	(bool pure_covers)
 {
@@ -573,17 +628,26 @@ void	xrCover	(bool pure_covers)
 		g_cover_nodes.assign(g_nodes.size(),true);
 
 	// Start threads, wait, continue --- perform all the work
+	// small chunks: the cost of a node depends on the geometry around it
 	u32	start_time		= timeGetTime();
+	// every thread keeps a ray cache entry per node
+	u32	num_threads		= thread_count(u64(g_nodes.size())*sizeof(RC));
 	CThreadManager		Threads;
-	u32	stride			= g_nodes.size()/NUM_THREADS;
-	u32	last			= g_nodes.size()-stride*(NUM_THREADS-1);
-	for (u32 thID=0; thID<NUM_THREADS; thID++) {
-		Threads.start(xr_new<CoverThread>(thID,thID*stride,thID*stride+((thID==(NUM_THREADS-1))?last:stride)));
-//		CoverThread(thID,thID*stride,thID*stride+((thID==(NUM_THREADS-1))?last:stride)).Execute();
-//		Threads.wait		();
+	CThreadChunks		Chunks(g_nodes.size(),64);
+	xr_vector<CoverThread*>	workers;
+	for (u32 thID=0; thID<num_threads; thID++) {
+		workers.push_back	(xr_new<CoverThread>(thID,Chunks));
+		Threads.start		(workers.back());
 	}
 	Threads.wait			();
-	Msg("%d seconds elapsed.",(timeGetTime()-start_time)/1000);
+
+	u64	rays			= 0;
+	for (u32 thID=0; thID<num_threads; thID++) {
+		rays			+= workers[thID]->rays;
+		xr_delete		(workers[thID]);
+	}
+	u32	elapsed			= _max(timeGetTime()-start_time,u32(1));
+	Msg("%d seconds elapsed, %d threads, %I64u rays, %.0f rays/sec.",elapsed/1000,num_threads,rays,double(rays)*1000.0/double(elapsed));
 
 	if (!pure_covers) {
 		compute_non_covers	();
@@ -599,27 +663,11 @@ void	xrCover	(bool pure_covers)
 	// Smooth
 	Status			("Smoothing coverage mask...");
 	mem_Optimize	();
+	start_time		= timeGetTime();
 	Nodes	Old		= g_nodes;
-	for (u32 N=0; N<g_nodes.size(); N++)
-	{
-		vertex&	Base		= Old[N];
-		vertex&	Dest		= g_nodes[N];
-		
-		for (int dir=0; dir<4; dir++)
-		{
-			float val		= 2*Base.high_cover[dir];
-			float val2		= 2*Base.low_cover[dir];
-			float cnt		= 2;
-			
-			for (int nid=0; nid<4; nid++) {
-				if (Base.n[nid]!=InvalidNode) {
-					val		+=  Old[Base.n[nid]].high_cover[dir];
-					val2	+=  Old[Base.n[nid]].low_cover[dir];
-					cnt		+=	1.f;
-				}
-			}
-			Dest.high_cover[dir]	=  val/cnt;
-			Dest.low_cover[dir]		=  val2/cnt;
-		}
-	}
+	CThreadChunks	SmoothChunks(g_nodes.size(),4096);
+	for (u32 thID=0; thID<num_threads; thID++)
+		Threads.start		(xr_new<CoverSmoothThread>(thID,SmoothChunks,Old));
+	Threads.wait	(100);
+	Msg("Smoothing: %d ms elapsed.",timeGetTime()-start_time);
 }
@@ -34,7 +34,7 @@ IC bool RayPick(CDB::COLLIDER& DB, Fvector& P, Fvector& D, float r, R_Light& L)
 	}
 }
 
-float LightPoint(CDB::COLLIDER& DB, Fvector &P, Fvector &N, LSelection& SEL)
+float LightPoint(CDB::COLLIDER& DB, Fvector &P, Fvector &N, LSelection& SEL, u64& rays)
 {
 	Fvector		Ldir,Pnew;
 	Pnew.mad	(P,N,0.05f);
@@ -53,6 +53,7 @@ float LightPoint(CDB::COLLIDER& DB, Fvector &P, Fvector &N, LSelection& SEL)
 			if( D <=0 ) continue;
 
 			// Raypick
+			++rays;
 			if (!RayPick(DB,Pnew,Ldir,1000.f,*L))	amount+=D*L->amount;
 		} else {
 			// Distance
@@ -67,6 +68,7 @@ float LightPoint(CDB::COLLIDER& DB, Fvector &P, Fvector &N, LSelection& SEL)
 			
 			// Raypick
 			float R		= _sqrt(sqD);
+			++rays;
 			if (!RayPick(DB,Pnew,Ldir,R,*L))
 				amount += (D*L->amount)/(L->attenuation0 + L->attenuation1*R + L->attenuation2*sqD);
 		}
@@ -76,18 +78,22 @@ float LightPoint(CDB::COLLIDER& DB, Fvector &P, Fvector &N, LSelection& SEL)
 
 class	LightThread : public CThread
 {
-	u32	Nstart, Nend;
+	CThreadChunks&		chunks;
 public:
-	LightThread			(u32 ID, u32 _start, u32 _end) : CThread(ID)
+	u64					rays;
+
+	LightThread			(u32 ID, CThreadChunks& _chunks) : CThread(ID), chunks(_chunks)
 	{
-		Nstart	= _start;
-		Nend	= _end;
+		thMessages			= FALSE;
+		thDestroyOnComplete	= FALSE;
+		rays				= 0;
 	}
 	virtual void		Execute()
 	{
 		CDB::COLLIDER DB;
 		DB.ray_options	(CDB::OPT_ONLYFIRST);
 
+		// private copy: RayPick caches the last occluder in the light
 		xr_vector<R_Light>	Lights = g_lights;
 
 		Fvector			P,D,PLP;
@@ -96,7 +102,9 @@ public:
 		
 		LSelection		Selected;
 		float			LperN	= float(g_lights.size());
-		for (u32 i=Nstart; i<Nend; i++)
+		u32				from, to;
+		while (chunks.pull(from,to))
+		for (u32 i=from; i<to; i++)
 		{
 			vertex& N = g_nodes[i];
 			
@@ -104,7 +112,7 @@ public:
 			Selected.clear();
 			for (u32 L=0; L<Lights.size(); L++)
 			{
-				R_Light&	R = g_lights[L];
+				R_Light&	R = Lights[L];
 				if (R.type==LT_DIRECT)	Selected.push_back(&R);
 				else {
 					float dist = N.Pos.distance_to(R.position);
@@ -128,31 +136,41 @@ public:
 					P.y = PLP.y;
 					
 					// light point
-					amount += LightPoint(DB,P,N.Plane.n,Selected);
+					amount += LightPoint(DB,P,N.Plane.n,Selected,rays);
 				}
 			}
 			
 			// calculation of luminocity
 			N.LightLevel	= amount/float(LIGHT_Total);
 			
-			thProgress		= float(i-Nstart)/float(Nend-Nstart);
+			thProgress		= chunks.progress();
 		}
+		thProgress			= 1.f;
 	}
 };
 
-#define NUM_THREADS	8
 void	xrLight			()
 {
 	// Start threads, wait, continue --- perform all the work
 	/*
 	u32	start_time		= timeGetTime();
+	u32	num_threads		= thread_count();
 	CThreadManager			Threads;
-	u32	stride			= g_nodes.size()/NUM_THREADS;
-	u32	last			= g_nodes.size()-stride*(NUM_THREADS-1);
-	for (u32 thID=0; thID<NUM_THREADS; thID++)
-		Threads.start(xr_new<LightThread>(thID,thID*stride,thID*stride+((thID==(NUM_THREADS-1))?last:stride)));
+	CThreadChunks			Chunks(g_nodes.size(),64);
+	xr_vector<LightThread*>	workers;
+	for (u32 thID=0; thID<num_threads; thID++) {
+		workers.push_back	(xr_new<LightThread>(thID,Chunks));
+		Threads.start		(workers.back());
+	}
 	Threads.wait			();
-	Msg("%d seconds elapsed.",(timeGetTime()-start_time)/1000);
+
+	u64	rays			= 0;
+	for (u32 thID=0; thID<num_threads; thID++) {
+		rays			+= workers[thID]->rays;
+		xr_delete		(workers[thID]);
+	}
+	u32	elapsed			= _max(timeGetTime()-start_time,u32(1));
+	Msg("%d seconds elapsed, %d threads, %I64u rays, %.0f rays/sec.",elapsed/1000,num_threads,rays,double(rays)*1000.0/double(elapsed));
 
 	// Smooth
 	Status("Smoothing lighting...");
@@ -137,6 +137,83 @@ public:
 	}
 };
 
+// the same static covers CCoverManager::compute_static_cover selects on level load
+#define MIN_COVER_VALUE 16
+
+class CCoverBaker {
+	const xr_vector<NodeCompressed>	&m_nodes;
+	xr_vector<bool>					m_temp;
+
+	IC	bool	valid_vertex_id	(u32 vertex_id) const
+	{
+		return		(vertex_id < m_nodes.size());
+	}
+
+	IC	bool	edge_vertex		(const NodeCompressed &v) const
+	{
+		for (u8 i=0; i<4; ++i)
+			if (!valid_vertex_id(v.link(i)) && ((v.high.cover(i) < MIN_COVER_VALUE) || (v.low.cover(i) < MIN_COVER_VALUE)))
+				return	(true);
+		return		(false);
+	}
+
+	IC	bool	cover			(const NodeCompressed &v, u8 index0, u8 index1) const
+	{
+		return		(
+			valid_vertex_id(v.link(index0)) &&
+			valid_vertex_id(m_nodes[v.link(index0)].link(index1)) &&
+			m_temp[m_nodes[v.link(index0)].link(index1)]
+		);
+	}
+
+	IC	bool	critical_point	(const NodeCompressed &v, u8 index, u8 index0, u8 index1) const
+	{
+		return		(
+			!valid_vertex_id(v.link(index)) &&
+			(
+				!valid_vertex_id(v.link(index0)) || 
+				!valid_vertex_id(v.link(index1)) ||
+				cover(v,index0,index) || 
+				cover(v,index1,index)
+			)
+		);
+	}
+
+	IC	bool	critical_cover	(const NodeCompressed &v) const
+	{
+		return		(
+			critical_point(v,0,1,3) || 
+			critical_point(v,2,1,3) || 
+			critical_point(v,1,0,2) || 
+			critical_point(v,3,0,2)
+		);
+	}
+
+public:
+				CCoverBaker		(const xr_vector<NodeCompressed> &nodes) :
+					m_nodes(nodes)
+	{
+	}
+
+	void		bake			(xr_vector<u32> &covers)
+	{
+		u32			N = (u32)m_nodes.size();
+		m_temp.resize	(N);
+		for (u32 i=0; i<N; ++i) {
+			const NodeCompressed	&v = m_nodes[i];
+			bool	has_cover = false;
+			for (u8 j=0; j<4; ++j)
+				has_cover	= has_cover || v.high.cover(j) || v.low.cover(j);
+			m_temp[i]	= has_cover && edge_vertex(v);
+		}
+
+		covers.clear	();
+		for (u32 i=0; i<N; ++i)
+			if (m_temp[i] && critical_cover(m_nodes[i]))
+				covers.push_back(i);
+	}
+};
+
 void xrSaveNodes(LPCSTR N, LPCSTR out_name)
 {
 	Msg				("NS: %d, CNS: %d, ratio: %f%%",sizeof(vertex),sizeof(CLevelGraph::CVertex),100*float(sizeof(CLevelGraph::CVertex))/float(sizeof(vertex)));
@@ -179,6 +256,21 @@ void xrSaveNodes(LPCSTR N, LPCSTR out_name)
 		fs->w			(&compressed_nodes[i],sizeof(NodeCompressed));
 		Progress		(float(i)/float(g_nodes.size()));
 	}
+
+	// Covers
+	Status			("Baking covers...");
+	xr_vector<u32>	covers;
+	CCoverBaker(compressed_nodes).bake(covers);
+
+	hdrCOVERS		C;
+	C.magic			= XRAI_COVERS_MAGIC;
+	C.version		= XRAI_COVERS_VERSION;
+	C.count			= covers.size();
+	fs->w			(&C,sizeof(C));
+	if (!covers.empty())
+		fs->w		(&*covers.begin(),covers.size()*sizeof(u32));
+	Msg				("%d static covers baked",covers.size());
+
 	// Stats
 	u32	SizeTotal	= fs->tell();
 	Msg				("%dK saved",SizeTotal/1024);
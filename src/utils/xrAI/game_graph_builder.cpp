@@ -17,6 +17,7 @@
 #include "xrCrossTable.h"
 #include "guid_generator.h"
 #include "graph_engine.h"
+#include "xrThread.h"
 
 CGameGraphBuilder::CGameGraphBuilder		()
 {
@@ -321,6 +322,205 @@ void CGameGraphBuilder::iterate_distances	(const float &start, const float &amou
 	Progress							(start + amount);
 }
 
+void CGameGraphBuilder::compute_cross_table_legacy	(const float &start, const float &amount)
+{
+	fill_marks							(start + 0.000000f*amount,0.019512f*amount);
+	fill_distances						(start + 0.019512f*amount,0.191457f*amount);
+	iterate_distances					(start + 0.210969f*amount,0.789031f*amount);
+
+	m_result_distances.resize			(level_graph().header().vertex_count());
+	for (u32 i=0, n=level_graph().header().vertex_count(); i<n; ++i)
+		m_result_distances[i]			= m_distances[m_results[i]][i];
+
+	m_marks.clear						();
+	m_mark_stack.clear					();
+	m_distances.clear					();
+	m_current_fringe.clear				();
+	m_next_fringe.clear					();
+}
+
+namespace cross_table {
+
+// Level synchronous BFS from all the game vertices at once.
+// Every level vertex gets the game vertex with the smallest distance, ties go
+// to the smallest game vertex id, which is what the sequential per game vertex
+// passes produce. The only exception is a level vertex holding several game
+// vertices: the sequential builder gives it to the last of them.
+// Frontiers are expanded by all the threads, a vertex is claimed by a CAS on
+// its distance and its game vertex is an atomic minimum, so the result does
+// not depend on the order the threads visit the frontier in.
+struct bfs
+{
+	const CLevelGraph*			level_graph;
+	u32*						distances;
+	volatile LONG*				owners;
+
+	xr_vector<u32>				frontier;
+	xr_vector<xr_vector<u32> >	next;
+	u32							level;
+	u32							visited;
+	volatile BOOL				done;
+
+	u32							threads;
+	volatile LONG				chunk_next;
+	volatile LONG				barrier_count;
+	volatile LONG				barrier_generation;
+	volatile LONG				finished;
+
+	static const u32			chunk_size	= 256;
+
+	void			barrier			()
+	{
+		LONG const		generation = barrier_generation;
+		if (InterlockedIncrement(&barrier_count) == LONG(threads)) {
+			barrier_count		= 0;
+			InterlockedIncrement(&barrier_generation);
+			return;
+		}
+		while (barrier_generation == generation)
+			SwitchToThread		();
+	}
+
+	IC	void		update_owner	(u32 vertex_id, LONG owner)
+	{
+		LONG			current = owners[vertex_id];
+		while (u32(owner) < u32(current)) {
+			LONG		previous = InterlockedCompareExchange(owners + vertex_id,owner,current);
+			if (previous == current)
+				break;
+			current		= previous;
+		}
+	}
+
+	void			expand			(u32 vertex_id, xr_vector<u32> &dest)
+	{
+		LONG						owner = owners[vertex_id];
+		CLevelGraph::const_iterator	i, e;
+		CLevelGraph::CVertex		*node = level_graph->vertex(vertex_id);
+		level_graph->begin			(vertex_id,i,e);
+		for ( ; i != e; ++i) {
+			u32						next_vertex_id = node->link(i);
+			if (!level_graph->valid_vertex_id(next_vertex_id))
+				continue;
+
+			// reached on one of the previous levels
+			if (distances[next_vertex_id] <= level)
+				continue;
+
+			if (InterlockedCompareExchange((volatile LONG*)(distances + next_vertex_id),LONG(level + 1),LONG(u32(-1))) == LONG(u32(-1)))
+				dest.push_back		(next_vertex_id);
+
+			update_owner			(next_vertex_id,owner);
+		}
+	}
+
+	void			execute			(u32 thread_id, const float &start, const float &amount)
+	{
+		xr_vector<u32>			&dest = next[thread_id];
+		for (;;) {
+			u32					count = u32(frontier.size());
+			for (;;) {
+				u32				from = u32(InterlockedIncrement(&chunk_next) - 1)*chunk_size;
+				if (from >= count)
+					break;
+
+				u32				to = _min(from + chunk_size,count);
+				for (u32 i=from; i<to; ++i)
+					expand		(frontier[i],dest);
+			}
+
+			barrier				();
+
+			if (!thread_id) {
+				frontier.clear	();
+				for (u32 i=0; i<threads; ++i) {
+					frontier.insert	(frontier.end(),next[i].begin(),next[i].end());
+					next[i].clear	();
+				}
+				visited			+= u32(frontier.size());
+				++level;
+				chunk_next		= 0;
+				done			= frontier.empty();
+				Progress		(start + amount*float(visited)/float(level_graph->header().vertex_count()));
+			}
+
+			barrier				();
+
+			if (done)
+				break;
+		}
+	}
+};
+
+struct worker
+{
+	bfs							*owner;
+	u32							thread_id;
+};
+
+static void worker_thread		(void *params)
+{
+	worker						*W = (worker*)params;
+	W->owner->execute			(W->thread_id,0.f,0.f);
+	InterlockedIncrement		(&W->owner->finished);
+}
+
+} // namespace cross_table
+
+void CGameGraphBuilder::compute_cross_table	(const float &start, const float &amount)
+{
+	Progress							(start);
+
+	u32									vertex_count = level_graph().header().vertex_count();
+	xr_vector<u32>						owners;
+	m_result_distances.assign			(vertex_count,u32(-1));
+	owners.assign						(vertex_count,u32(-1));
+	m_results.assign					(vertex_count,0);
+
+	cross_table::bfs					B;
+	B.level_graph						= &level_graph();
+	B.distances							= &*m_result_distances.begin();
+	B.owners							= (volatile LONG*)&*owners.begin();
+	B.level								= 0;
+	B.visited							= 0;
+	B.done								= FALSE;
+	B.threads							= thread_count();
+	B.chunk_next						= 0;
+	B.barrier_count						= 0;
+	B.barrier_generation				= 0;
+	B.finished							= 0;
+	B.next.resize						(B.threads);
+
+	// sources: the smallest game vertex id propagates, the largest one owns the vertex
+	for (u32 i=0, n=graph().header().vertex_count(); i<n; ++i) {
+		u32								level_vertex_id = graph().vertex(i)->data().level_vertex_id();
+		if (m_result_distances[level_vertex_id]) {
+			m_result_distances[level_vertex_id]	= 0;
+			owners[level_vertex_id]		= i;
+			B.frontier.push_back		(level_vertex_id);
+		}
+		m_results[level_vertex_id]		= i;
+	}
+	B.visited							= u32(B.frontier.size());
+
+	xr_vector<cross_table::worker>		workers(B.threads);
+	for (u32 i=1; i<B.threads; ++i) {
+		workers[i].owner				= &B;
+		workers[i].thread_id			= i;
+		thread_spawn					(cross_table::worker_thread,"cross-table",0,&workers[i]);
+	}
+	B.execute							(0,start,amount);
+	while (B.finished < LONG(B.threads - 1))
+		Sleep							(1);
+
+	for (u32 i=0; i<vertex_count; ++i)
+		if (m_result_distances[i] && (m_result_distances[i] != u32(-1)))
+			m_results[i]				= owners[i];
+
+	Msg									("%d level vertices reached in %d steps by %d threads",B.visited,B.level,B.threads);
+	Progress							(start + amount);
+}
+
 void CGameGraphBuilder::save_cross_table	(const float &start, const float &amount)
 {
 	Progress							(start);
@@ -349,7 +549,7 @@ void CGameGraphBuilder::save_cross_table	(const float &start, const float &amoun
 		CGameLevelCrossTable::CCell	tCrossTableCell;
 		tCrossTableCell.tGraphIndex = (GameGraph::_GRAPH_ID)m_results[i];
 		VERIFY						(graph().header().vertex_count() > tCrossTableCell.tGraphIndex);
-		tCrossTableCell.fDistance	= float(m_distances[tCrossTableCell.tGraphIndex][i])*level_graph().header().cell_size();
+		tCrossTableCell.fDistance	= float(m_result_distances[i])*level_graph().header().cell_size();
 		tMemoryStream.w				(&tCrossTableCell,sizeof(tCrossTableCell));
 	}
 
@@ -363,11 +563,8 @@ void CGameGraphBuilder::save_cross_table	(const float &start, const float &amoun
 
 //	Msg						("Freiing cross table resources");
 
-	m_marks.clear			();
-	m_mark_stack.clear		();
-	m_distances.clear		();
-	m_current_fringe.clear	();
-	m_next_fringe.clear		();
+	m_results.clear			();
+	m_result_distances.clear();
 
 //	Msg						("CT:SAVE : %f",timer.GetElapsed_sec());
 	Progress				(start + amount);
@@ -379,15 +576,36 @@ void CGameGraphBuilder::build_cross_table	(const float &start, const float &amou
 	
 	Msg						("Building cross table");
 
-//	CTimer					timer;
-//	timer.Start				();
+	CTimer					timer;
+
+	// -cross_table_compare: runs the sequential builder as well, compares and times both
+	if (strstr(Core.Params,"-cross_table_compare")) {
+		timer.Start			();
+		compute_cross_table_legacy(start + 0.000000f*amount,0.959659f*amount);
+		float				legacy_time = timer.GetElapsed_sec();
+
+		xr_vector<u32>		legacy_results, legacy_distances;
+		legacy_results.swap	(m_results);
+		legacy_distances.swap(m_result_distances);
+
+		timer.Start			();
+		compute_cross_table	(start + 0.000000f*amount,0.959659f*amount);
+		float				time = timer.GetElapsed_sec();
+
+		u32					mismatches = 0;
+		for (u32 i=0, n=(u32)m_results.size(); i<n; ++i)
+			if ((m_results[i] != legacy_results[i]) || (m_result_distances[i] != legacy_distances[i]))
+				++mismatches;
+
+		Msg					("Cross table: sequential %.3fs, parallel %.3fs, %d mismatches",legacy_time,time,mismatches);
+		R_ASSERT2			(!mismatches,"parallel cross table differs from the sequential one");
+	}
+	else {
+		timer.Start			();
+		compute_cross_table	(start + 0.000000f*amount,0.959659f*amount);
+		Msg					("Cross table: %.3fs",timer.GetElapsed_sec());
+	}
 
-	fill_marks				(start + 0.000000f*amount,0.018725f*amount);
-//	Msg						("CT : %f",timer.GetElapsed_sec());
-	fill_distances			(start + 0.018725f*amount,0.183732f*amount);
-//	Msg						("CT : %f",timer.GetElapsed_sec());
-	iterate_distances		(start + 0.202457f*amount,0.757202f*amount);
-//	Msg						("CT : %f",timer.GetElapsed_sec());
 	save_cross_table		(start + 0.959659f*amount,0.040327f*amount);
 //	Msg						("CT : %f",timer.GetElapsed_sec());
 	load_cross_table		(start + 0.999986f*amount,0.000014f*amount);
@@ -56,6 +56,7 @@ private:
 	xr_vector<u32>			m_current_fringe;
 	xr_vector<u32>			m_next_fringe;
 	xr_vector<u32>			m_results;
+	xr_vector<u32>			m_result_distances;
 	// cross table itself
 	CGameLevelCrossTable	*m_cross_table;
 	TRIPPLES				m_tripples;
@@ -74,6 +75,8 @@ private:
 			void		fill_distances				(const float &start, const float &amount);
 			void		recursive_update			(const u32 &index, const float &start, const float &amount);
 			void		iterate_distances			(const float &start, const float &amount);
+			void		compute_cross_table			(const float &start, const float &amount);
+			void		compute_cross_table_legacy	(const float &start, const float &amount);
 			void		save_cross_table			(const float &start, const float &amount);
 			void		build_cross_table			(const float &start, const float &amount);
 			void		load_cross_table			(const float &start, const float &amount);
@@ -35,4 +35,51 @@ class ENGINE_API CThreadManager
 public:
 	void				start	(CThread*	T);
 	void				wait	(u32		sleep_time=1000);
-};
\ No newline at end of file
+};
+
+// Dynamic chunked scheduling of [0,count): workers pull the next chunk from a
+// shared counter, so threads which get cheap items simply take more chunks
+class ENGINE_API CThreadChunks
+{
+	volatile LONG		next;
+	u32					count;
+	u32					chunk;
+public:
+						CThreadChunks	(u32 _count, u32 _chunk)
+	{
+		next			= 0;
+		count			= _count;
+		chunk			= _max(_chunk,u32(1));
+	}
+	bool				pull			(u32& from, u32& to)
+	{
+		LONG	id		= InterlockedIncrement(&next)-1;
+		u64		start	= u64(id)*chunk;
+		if (start>=count)	return false;
+		from			= u32(start);
+		to				= _min(from+chunk,count);
+		return			true;
+	}
+	float				progress		() const
+	{
+		return			count ? _min(float(u64(next)*chunk)/float(count),1.f) : 1.f;
+	}
+};
+
+// number of workers for the compiler phases, all hardware threads of the machine
+IC u32					thread_count	()
+{
+	return				_max(CPU::ID.n_threads,u32(1));
+}
+
+// ...capped so that the per-thread memory fits into a half of the free
+// address space (the 32-bit compiler runs out of it before the RAM)
+IC u32					thread_count	(u64 thread_bytes)
+{
+	u32					result	= thread_count();
+	MEMORYSTATUSEX		status;
+	status.dwLength		= sizeof(status);
+	if (thread_bytes && GlobalMemoryStatusEx(&status))
+		result			= _min(result,_max(u32(_min(status.ullAvailVirtual/2/thread_bytes,u64(result))),u32(1)));
+	return				result;
+}
@@ -1,9 +1,11 @@
 #include "stdafx.h"
 #include "xrCompress.h"
+#include "../../xrCore/FS_blocks.h"
 
 #ifndef MOD_COMPRESS
 	extern int				ProcessDifference();
 #endif
+extern int					ProcessBenchmark(LPCSTR pack_name);
 
 int __cdecl main	(int argc, char* argv[])
 {
@@ -16,6 +18,12 @@ int __cdecl main	(int argc, char* argv[])
 
 	C.SetStoreFiles(NULL!=strstr(params,"-store"));
 
+	if(strstr(params,"-bench "))
+	{
+		string_path				pack_name;
+		sscanf					(strstr(params,"-bench ")+7,"%[^ ] ", pack_name);
+		ProcessBenchmark		(pack_name);
+	}else
 #ifndef MOD_COMPRESS
 	if(strstr(params,"-diff"))
 	{
@@ -30,6 +38,9 @@ int __cdecl main	(int argc, char* argv[])
 			printf("-diff /? option to get information about creating difference.\n");
 			printf("-fast	- fast compression.\n");
 			printf("-store	- store files. No compression.\n");
+			printf("-blocks	- split files larger than a block into separately compressed blocks.\n");
+			printf("-block_size <KB> - block size for -blocks, 256 by default.\n");
+			printf("-bench <pack_file> - measure read throughput of a pack.\n");
 			printf("-ltx <file_name.ltx> - pathes to compress.\n");
 			printf("\n");
 			printf("LTX format:\n");
@@ -52,6 +63,11 @@ int __cdecl main	(int argc, char* argv[])
 		FS.append_path	("$working_folder$","",0,false);
 
 		C.SetFastMode	(NULL!=strstr(params,"-fast"));
+
+		u32	block_kb	= fs_block_default_size/1024;
+		if (strstr(params,"-block_size "))
+			sscanf		(strstr(params,"-block_size ")+12,"%d",&block_kb);
+		C.SetBlocks		(NULL!=strstr(params,"-blocks"),_max(block_kb,4u)*1024);
 		C.SetTargetName	(argv[1]);
 
 		LPCSTR p		= strstr(params,"-ltx");
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "xrCompress.h"
+#include "../../xrCore/FS_blocks.h"
 
 //typedef void DUMMY_STUFF (const void*,const u32&,void*);
 //XRCORE_API DUMMY_STUFF	*g_temporary_stuff;
@@ -12,7 +13,7 @@
 //#	undef TRIVIAL_ENCRYPTOR_DECODER
 
 xrCompressor::xrCompressor()
-:fs_pack_writer(NULL),bFast(false),files_list(NULL),folders_list(NULL),bStoreFiles(false),pPackHeader(NULL),config_ltx(NULL)
+:fs_pack_writer(NULL),bFast(false),files_list(NULL),folders_list(NULL),bStoreFiles(false),bBlocks(false),block_size(fs_block_default_size),pPackHeader(NULL),config_ltx(NULL)
 {
 	bytesSRC		= 0;
 	bytesDST		= 0;
@@ -170,9 +171,74 @@ void xrCompressor::write_file_header(LPCSTR file_name, const u32 &crc, const u32
 
 	*(u32*)buffer		= ptr;
 
+	DESC				D;
+	D.name				= file_name;
+	xr_strlwr			(D.name);
+	D.offset			= fs_desc.size();
+	D.size				= full_buffer_size;
+	fs_desc_index.push_back	(D);
 	fs_desc.w			(buffer_start,full_buffer_size);
 }
 
+// Writes src as a block compressed entry (see FS_blocks.h).
+// Returns false and writes nothing if it doesn't pay off.
+bool xrCompressor::CompressBlocks(IReader* src, u32& c_ptr, u32& c_size_compressed)
+{
+	u32 const		size		= src->length();
+	u32 const		count		= (size+block_size-1)/block_size;
+	xr_vector<u32>	offsets		(count+1);
+	CMemoryWriter	packed;
+	u32 const		c_size_max	= rtc_csize(block_size);
+	u8*				c_data		= xr_alloc<u8>(c_size_max);
+	u8*				c_out		= bFast ? NULL : xr_alloc<u8>(block_size);
+
+	t_compress.Begin	();
+	offsets[0]			= 0;
+	for (u32 it=0; it<count; it++)
+	{
+		u8*		block		= (u8*)src->pointer() + it*block_size;
+		u32		real		= _min(block_size,size-it*block_size);
+		u32		c_size		= c_size_max;
+		if (bFast)
+		{
+			R_ASSERT(LZO_E_OK == lzo1x_1_compress	(block,real,c_data,&c_size,c_heap));
+		}else
+		{
+			R_ASSERT(LZO_E_OK == lzo1x_999_compress	(block,real,c_data,&c_size,c_heap));
+		}
+
+		if (c_size>=real)
+			packed.w		(block,real);			// store
+		else
+		{
+			if (!bFast)
+			{
+				u32		c_orig	= real;
+				R_ASSERT		(LZO_E_OK	== lzo1x_optimize	(c_data,c_size,c_out,&c_orig, NULL));
+				R_ASSERT		(c_orig		== real				);
+			}
+			packed.w		(c_data,c_size);
+		}
+		offsets[it+1]		= packed.size();
+	}
+	t_compress.End		();
+
+	xr_free				(c_data);
+	xr_free				(c_out);
+
+	u32 const		total		= CBlockIndex::table_size(count) + packed.size();
+	if ((total+16) >= size)
+		return			false;
+
+	c_ptr				= fs_pack_writer->tell();
+	fs_pack_writer->w_u32	(block_size);
+	fs_pack_writer->w_u32	(count);
+	fs_pack_writer->w		(&*offsets.begin(),offsets.size()*sizeof(u32));
+	fs_pack_writer->w		(packed.pointer(),packed.size());
+	c_size_compressed	= total | fs_block_flag;
+	return				true;
+}
+
 void xrCompressor::CompressOne(LPCSTR path)
 {
 	filesTOTAL		++;
@@ -226,7 +292,13 @@ void xrCompressor::CompressOne(LPCSTR path)
 		c_size_compressed	= A->c_size_compressed;
 	} else 
 	{
-		if (testVFS(path))	
+		if (bBlocks && !bStoreFiles && (src->length()>block_size) && CompressBlocks(src,c_ptr,c_size_compressed))
+		{
+			c_size_real			= src->length();
+			u32 c_size			= c_size_compressed & (~fs_block_flag);
+			printf				("%3.1f%% (B)",	100.f*float(c_size)/float(c_size_real));
+			Msg					("%-80s   - OK (%3.1f%%, %d blocks)",path,100.f*float(c_size)/float(c_size_real),(c_size_real+block_size-1)/block_size);
+		} else if (testVFS(path))	
 		{
 			filesVFS			++;
 
@@ -328,6 +400,7 @@ void xrCompressor::OpenPack(LPCSTR tgt_folder, int num)
 	unlink			(fname);
 	fs_pack_writer	= FS.w_open	(fname);
 	fs_desc.clear	();
+	fs_desc_index.clear	();
 	aliases.clear	();
 
 	bytesSRC		= 0;
@@ -394,7 +467,11 @@ void xrCompressor::ClosePack()
 	bytesDST		= fs_pack_writer->tell	();
 	Msg				("...Writing pack desc");
 
-	fs_pack_writer->w_chunk		(1|CFS_CompressMark, fs_desc.pointer(),fs_desc.size());
+	std::sort					(fs_desc_index.begin(),fs_desc_index.end());
+	CMemoryWriter				fs_desc_sorted;
+	for (u32 it=0; it<fs_desc_index.size(); it++)
+		fs_desc_sorted.w		(fs_desc.pointer()+fs_desc_index[it].offset,fs_desc_index[it].size);
+	fs_pack_writer->w_chunk		(1|CFS_CompressMark, fs_desc_sorted.pointer(),fs_desc_sorted.size());
 
 
 	Msg				("Data size: %d. Desc size: %d.",bytesDST,fs_desc.size());
@@ -6,8 +6,20 @@ class xrCompressor
 {
 	bool						bFast;
 	bool						bStoreFiles;
+	bool						bBlocks;
+	u32							block_size;
 	IWriter*					fs_pack_writer;
 	CMemoryWriter				fs_desc;
+
+	// file table records, written sorted by name so the engine registers them in order
+	struct	DESC
+	{
+		xr_string	name;
+		u32			offset;		// in fs_desc
+		u32			size;
+		bool operator < (const DESC& other) const { return xr_strcmp(name.c_str(),other.name.c_str())<0; }
+	};
+	xr_vector<DESC>				fs_desc_index;
 	shared_str					target_name;
 	IReader*					pPackHeader;
 	CInifile*					config_ltx;
@@ -40,6 +52,7 @@ class xrCompressor
 	void	PerformWork			();
 
 	void	CompressOne			(LPCSTR path);
+	bool	CompressBlocks		(IReader* src, u32& c_ptr, u32& c_size_compressed);
 
 
 
@@ -60,6 +73,7 @@ public:
 			~xrCompressor		();
 	void	SetFastMode			(bool b)					{bFast=b;}
 	void	SetStoreFiles		(bool b)					{bStoreFiles=b;}
+	void	SetBlocks			(bool b, u32 size)			{bBlocks=b; block_size=size;}
 	void	SetMaxVolumeSize	(u32 sz)					{XRP_MAX_SIZE=sz;}
 	void	SetTargetName		(LPCSTR n)					{target_name=n;}
 	void	SetPackHeaderName	(LPCSTR n);
@@ -0,0 +1,121 @@
+#include "stdafx.h"
+#include "../../xrCore/FS_blocks.h"
+
+// Read throughput of a pack: every file is read in full the way the engine
+// reads it (stored - copy, LZO - whole file, blocks - on one thread and on all
+// of them), blocked files also get a partial read of a single block.
+
+struct bench_counter
+{
+	u32				files;
+	u64				bytes;
+	float			sec;
+	CTimer			timer;
+	bench_counter	()	{ files = 0; bytes = 0; sec = 0; }
+
+	void			begin	()	{ timer.Start();					}
+	void			end		()	{ sec += timer.GetElapsed_sec();	}
+
+	void			print	(LPCSTR name)
+	{
+		float		mb		= float(bytes)/float(1024*1024);
+		printf		("%-24s: %6d files, %9.1f Mb, %8.3f s, %8.1f Mb/s\n",name,files,mb,sec,sec>0?mb/sec:0.f);
+		Msg			("%-24s: %6d files, %9.1f Mb, %8.3f s, %8.1f Mb/s",name,files,mb,sec,sec>0?mb/sec:0.f);
+	}
+};
+
+int ProcessBenchmark(LPCSTR pack_name)
+{
+	HANDLE	hFile	= CreateFile(pack_name, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, 0, 0);
+	if (hFile==INVALID_HANDLE_VALUE)
+	{
+		printf		("ERROR: can't open pack %s\n",pack_name);
+		return		1;
+	}
+	u32		size	= GetFileSize(hFile,0);
+	HANDLE	hMap	= CreateFileMapping(hFile, 0, PAGE_READONLY, 0, 0, 0);
+	u8*		base	= (u8*)MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+	R_ASSERT2		(base,"can't map the pack, use x64 build for large packs");
+
+	IReader			pack	(base,size);
+	IReader*		hdr		= pack.open_chunk(1);
+	R_ASSERT2		(hdr,"file table not found");
+
+	bench_counter	stored, lzo, blocks_serial, blocks_parallel, partial_block, partial_whole;
+	xr_vector<u8>	dest;
+	while (!hdr->eof())
+	{
+		u16			buffer_size	= hdr->r_u16();
+		u32			size_real	= hdr->r_u32();
+		u32			size_compr	= hdr->r_u32();
+		hdr->advance			(sizeof(u32));				// crc
+		hdr->advance			(buffer_size - 4*sizeof(u32));	// name
+		u32			ptr			= hdr->r_u32();
+		if (0==size_real)		continue;
+
+		dest.resize				(size_real);
+		if (size_compr & fs_block_flag)
+		{
+			CBlockIndex			I;
+			I.load				(base+ptr,ptr,size_real);
+
+			blocks_serial.begin	();
+			for (u32 it=0; it<I.count(); it++)
+				fs_block_decompress	(&*dest.begin()+it*I.block_size,base,0,I,it,it+1);
+			blocks_serial.end		();
+			blocks_serial.files	++;
+			blocks_serial.bytes	+= size_real;
+
+			blocks_parallel.begin	();
+			fs_block_decompress	(&*dest.begin(),base,0,I,0,I.count());
+			blocks_parallel.end	();
+			blocks_parallel.files	++;
+			blocks_parallel.bytes	+= size_real;
+
+			u32	middle			= I.count()/2;
+			partial_block.begin	();
+			fs_block_decompress	(&*dest.begin(),base,0,I,middle,middle+1);
+			partial_block.end		();
+			partial_block.files	++;
+			partial_block.bytes	+= I.block_real(middle);
+		}
+		else if (size_compr==size_real)
+		{
+			stored.begin	();
+			Memory.mem_copy		(&*dest.begin(),base+ptr,size_real);
+			stored.end	();
+			stored.files		++;
+			stored.bytes		+= size_real;
+		}
+		else
+		{
+			lzo.begin		();
+			rtc_decompress		(&*dest.begin(),size_real,base+ptr,size_compr);
+			lzo.end		();
+			lzo.files			++;
+			lzo.bytes			+= size_real;
+
+			// a partial read of an LZO file costs the whole file
+			partial_whole.begin	();
+			rtc_decompress		(&*dest.begin(),size_real,base+ptr,size_compr);
+			partial_whole.end		();
+			partial_whole.files	++;
+			partial_whole.bytes	+= _min(size_real,fs_block_default_size);
+		}
+	}
+	hdr->close		();
+
+	printf			("\nRead benchmark of %s:\n",pack_name);
+	Msg				("Read benchmark of %s:",pack_name);
+	stored.print			("stored");
+	lzo.print				("lzo, whole file");
+	blocks_serial.print		("blocks, one thread");
+	blocks_parallel.print	("blocks, all threads");
+	partial_whole.print		("partial read, lzo");
+	partial_block.print		("partial read, block");
+
+	UnmapViewOfFile	(base);
+	CloseHandle		(hMap);
+	CloseHandle		(hFile);
+	return			0;
+}
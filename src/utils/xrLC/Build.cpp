@@ -245,6 +245,7 @@ void CBuild::Run	(LPCSTR P)
 		Light_prepare				();
 		xrPhase_Radiosity			();
 	}
+	lc_global_data()->L_static().build_hash	();
 
 	//****************************************** Starting MU
 	FPU::m64r					();
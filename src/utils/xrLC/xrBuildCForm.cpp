@@ -194,6 +194,18 @@ void CBuild::BuildCForm	()
 	}
 
 	FS.w_close		(MFS);
+
+	// Prebuilt collision tree, the engine validates it against the crc of the data above
+	if ((CL.getVS()>=4) && (CL.getTS()>=2))
+	{
+		Status			("Building collision tree...");
+		u32 source_crc	= crc32(CL.getT(),(u32)CL.getTS()*sizeof(CDB::TRI),crc32(CL.getV(),(u32)CL.getVS()*sizeof(Fvector)));
+		CDB::MODEL		M;
+		M.build			(CL.getV(),(int)CL.getVS(),CL.getT(),(int)CL.getTS(),0,0,CDB::MODEL::build_sah);
+		IWriter*	TFS	= FS.w_open	(strconcat(sizeof(fn),fn,pBuild->path,"level.cform_tree"));
+		M.serialize		(*TFS,source_crc);
+		FS.w_close		(TFS);
+	}
 }
 
 void CBuild::BuildPortals(IWriter& fs)
@@ -0,0 +1,651 @@
+#include "stdafx.h"
+#include <sys\stat.h>
+#include "build.h"
+#include "xrBuildCache.h"
+
+#include "../xrLC_Light/xrdeflector.h"
+#include "../xrLC_Light/xrLC_GlobalData.h"
+#include "../xrLC_Light/xrface.h"
+#include "../../xrEngine/xrLevel.h"
+
+CBuildCache				g_build_cache;
+
+static const u32		build_cache_version		= 1;
+static const float		build_cache_cell_size	= 32.f;		// meters, occluder change tracking
+
+static LPCSTR			build_cache_outputs[]	=
+{
+	"level", "level.geom", "level.geomx", "level.cform", "level.cform_tree", "build.lights", "build.cform", 0
+};
+
+// FNV-1a, 64 bit: deflector keys must not collide over tens of thousands of entries
+IC u64 hash_bytes		(const void* P, u32 len, u64 h)
+{
+	const u8*	it		= (const u8*)P;
+	const u8*	end		= it+len;
+	for (; it!=end; ++it)
+	{
+		h				^= *it;
+		h				*= u64(0x100000001b3);
+	}
+	return				h;
+}
+template <typename T>
+IC u64 hash_pod			(const T& v, u64 h)		{ return hash_bytes(&v,sizeof(T),h); }
+
+static const u64		hash_seed				= u64(0xcbf29ce484222325);
+
+// R_Light without the cached ray-test triangle
+IC u32 light_crc		(const R_Light& L, u32 crc)
+{
+	return				crc32(&L,u32(offsetof(R_Light,tri)),crc);
+}
+
+IC u64 cell_id			(const Fvector& P)
+{
+	s64 x				= iFloor(P.x/build_cache_cell_size) + 0x100000;
+	s64 y				= iFloor(P.y/build_cache_cell_size) + 0x100000;
+	s64 z				= iFloor(P.z/build_cache_cell_size) + 0x100000;
+	return				(u64(x&0x1fffff)<<42) | (u64(y&0x1fffff)<<21) | u64(z&0x1fffff);
+}
+
+// a counted table of PODs; false if the chunk is missing or short
+template <typename T>
+static bool r_table		(IReader* R, u32 chunk, xr_vector<T>& table)
+{
+	IReader*	C		= R->open_chunk(chunk);
+	if (!C)				return false;
+	bool		result	= false;
+	if (C->elapsed()>=int(sizeof(u32)))
+	{
+		u32		count	= C->r_u32();
+		if (count<=u32(C->elapsed())/sizeof(T))
+		{
+			table.resize(count);
+			if (count)	C->r(&table.front(),count*sizeof(T));
+			result		= true;
+		}
+	}
+	C->close			();
+	return				result;
+}
+
+CBuildCache::CBuildCache	()
+{
+	m_enabled			= false;
+	m_level_path[0]		= 0;
+	m_cache_path[0]		= 0;
+	m_project_crc		= 0;
+	m_env_crc			= 0;
+	m_textures_crc		= 0;
+	m_defl_lit			= 0;
+	m_defl_restored		= 0;
+	m_saved_build		= 0;
+	m_project_reused	= false;
+}
+
+u32 CBuildCache::textures_crc	()
+{
+	u32 crc				= 0;
+	xr_vector<b_BuildTexture>&	T	= pBuild->textures();
+	for (u32 it=0; it<T.size(); ++it)
+	{
+		b_BuildTexture&	BT	= T[it];
+		crc				= crc32(BT.name,xr_strlen(BT.name),crc);
+		crc				= crc32(&BT.dwWidth,sizeof(BT.dwWidth),crc);
+		crc				= crc32(&BT.dwHeight,sizeof(BT.dwHeight),crc);
+		crc				= crc32(&BT.bHasAlpha,sizeof(BT.bHasAlpha),crc);
+		if (BT.pSurface)
+			crc			= crc32(BT.pSurface,BT.dwWidth*BT.dwHeight*sizeof(u32),crc);
+	}
+	return				crc;
+}
+
+// everything that affects the lighting of every deflector
+u32 CBuildCache::env_crc		()
+{
+	u32 crc				= crc32(&build_cache_version,sizeof(build_cache_version));
+	crc					= crc32(&g_params(),sizeof(b_params),crc);
+	BOOL nosun			= lc_global_data()->b_nosun();
+	crc					= crc32(&nosun,sizeof(nosun),crc);
+	crc					= crc32(&g_build_options.b_noise,sizeof(g_build_options.b_noise),crc);
+
+	base_lighting&	L	= pBuild->L_static();
+	for (u32 it=0; it<L.hemi.size(); ++it)	crc = light_crc(L.hemi[it],crc);
+	for (u32 it=0; it<L.sun.size(); ++it)	crc = light_crc(L.sun[it],crc);
+
+	Shader_xrLCVec&	S	= pBuild->shaders().Library();
+	if (!S.empty())		crc = crc32(&S.front(),u32(S.size()*sizeof(Shader_xrLC)),crc);
+	xr_vector<b_material>&	M	= pBuild->materials();
+	if (!M.empty())		crc = crc32(&M.front(),u32(M.size()*sizeof(b_material)),crc);
+
+	return				crc ^ m_textures_crc;
+}
+
+u64 CBuildCache::deflector_key	(CDeflector* D)
+{
+	u64 h				= hash_seed;
+	for (u32 it=0; it<D->UVpolys.size(); ++it)
+	{
+		UVtri&		T	= D->UVpolys[it];
+		Face*		F	= T.owner;
+		for (int v=0; v<3; ++v)
+		{
+			h			= hash_pod(F->v[v]->P,h);
+			h			= hash_pod(F->v[v]->N,h);
+			h			= hash_pod(T.uv[v],h);
+		}
+		h				= hash_pod(F->N,h);
+		h				= hash_pod(F->dwMaterial,h);
+	}
+	h					= hash_pod(D->normal,h);
+	h					= hash_pod(D->layer.width,h);
+	h					= hash_pod(D->layer.height,h);
+	return				h;
+}
+
+// the same bounds as CDeflector::Light computes
+void CBuildCache::deflector_sphere(CDeflector* D, Fsphere& S)
+{
+	Fbox bb;			bb.invalidate	();
+	for (u32 it=0; it<D->UVpolys.size(); ++it)
+	{
+		Face*	F		= D->UVpolys[it].owner;
+		for (int v=0; v<3; ++v)	bb.modify(F->v[v]->P);
+	}
+	bb.getsphere		(S.P,S.R);
+}
+
+void CBuildCache::collect_lights	(xr_vector<light_rec>& dest)
+{
+	xr_vector<R_Light>&	rgb	= pBuild->L_static().rgb;
+	dest.resize			(rgb.size());
+	for (u32 it=0; it<rgb.size(); ++it)
+	{
+		light_rec&	R	= dest[it];
+		R.hash			= light_crc(rgb[it],0);
+		R.type			= rgb[it].type;
+		R.position		= rgb[it].position;
+		R.range			= rgb[it].range;
+	}
+	std::sort			(dest.begin(),dest.end());
+}
+
+// occluders are hashed per grid cell, the sum of triangle crc's doesn't depend on the order
+void CBuildCache::collect_cells	(xr_vector<cell_rec>& dest)
+{
+	dest.clear			();
+	CDB::MODEL*	M		= lc_global_data()->RCAST_Model();
+	if (!M)				return;
+
+	xr_map<u64,cell_rec>	cells;
+	const Fvector*	V	= M->get_verts();
+	const CDB::TRI*	T	= M->get_tris();
+	for (int it=0; it<M->get_tris_count(); ++it)
+	{
+		const CDB::TRI&	tri	= T[it];
+		Fvector		P[3]	= { V[tri.verts[0]], V[tri.verts[1]], V[tri.verts[2]] };
+		base_Face*	F		= (base_Face*)(*((void**)&tri.dummy));
+
+		u32 crc				= crc32(P,sizeof(P));
+		if (F)	crc			= crc32(&F->dwMaterial,sizeof(F->dwMaterial),crc);
+
+		Fvector		center;
+		center.add			(P[0],P[1]).add(P[2]).div(3.f);
+		u64 const	id		= cell_id(center);
+		xr_map<u64,cell_rec>::iterator	c	= cells.find(id);
+		if (c==cells.end())
+		{
+			cell_rec	R;
+			R.id			= id;
+			R.sum			= 0;
+			R.count			= 0;
+			R.box.invalidate();
+			c				= cells.insert(mk_pair(id,R)).first;
+		}
+		c->second.sum		+= crc;
+		c->second.count		++;
+		c->second.box.modify(P[0]);
+		c->second.box.modify(P[1]);
+		c->second.box.modify(P[2]);
+	}
+
+	dest.reserve		(cells.size());
+	for (xr_map<u64,cell_rec>::iterator it=cells.begin(); it!=cells.end(); ++it)
+		dest.push_back	(it->second);
+}
+
+void CBuildCache::collect_outputs	(xr_vector<output_rec>& dest)
+{
+	dest.clear			();
+	string_path			fn;
+	for (u32 it=0; build_cache_outputs[it]; ++it)
+	{
+		struct _stat	st;
+		if (0!=_stat(strconcat(sizeof(fn),fn,m_level_path,build_cache_outputs[it]),&st))
+			continue;
+		output_rec		R;
+		R.name			= build_cache_outputs[it];
+		R.size			= u32(st.st_size);
+		R.modif			= u32(st.st_mtime);
+		dest.push_back	(R);
+	}
+
+	// lightmaps are written by the DXT compressor, not through FS
+	_finddata_t			fd;
+	intptr_t			h	= _findfirst(strconcat(sizeof(fn),fn,m_level_path,"lmap#*.dds"),&fd);
+	if (h==-1)			return;
+	do {
+		output_rec		R;
+		R.name			= fd.name;
+		R.size			= u32(fd.size);
+		R.modif			= u32(fd.time_write);
+		dest.push_back	(R);
+	} while (0==_findnext(h,&fd));
+	_findclose			(h);
+}
+
+void CBuildCache::initialize	(LPCSTR level_path, IReader& project)
+{
+	xr_strcpy			(m_level_path,level_path);
+	strconcat			(sizeof(m_cache_path),m_cache_path,level_path,"build_cache\\");
+	if (!m_enabled)		return;
+
+	project.seek		(0);
+	m_project_crc		= crc32(project.pointer(),project.length());
+	m_project_crc		= crc32(&build_cache_version,sizeof(build_cache_version),m_project_crc);
+	m_project_crc		= crc32(&XRCL_PRODUCTION_VERSION,sizeof(XRCL_PRODUCTION_VERSION),m_project_crc);
+	m_project_crc		= crc32(&g_build_options,sizeof(g_build_options),m_project_crc);
+	BOOL nosun			= lc_global_data()->b_nosun();
+	m_project_crc		= crc32(&nosun,sizeof(nosun),m_project_crc);
+	Shader_xrLCVec&	S	= pBuild->shaders().Library();
+	if (!S.empty())		m_project_crc = crc32(&S.front(),u32(S.size()*sizeof(Shader_xrLC)),m_project_crc);
+	m_textures_crc		= textures_crc();
+	m_project_crc		^= m_textures_crc;
+}
+
+bool CBuildCache::project_reuse	()
+{
+	if (!m_enabled)		return false;
+
+	string_path			fn;
+	IReader*	R		= FS.r_open(strconcat(sizeof(fn),fn,m_cache_path,"project.manifest"));
+	if (!R)				return false;
+
+	// a short or corrupt manifest is a miss
+	bool		result	= false;
+	if ((R->elapsed()>=int(4*sizeof(u32))) && (R->r_u32()==build_cache_version) && (R->r_u32()==m_project_crc))
+	{
+		float	time	= R->r_float();
+		u32		count	= R->r_u32();
+
+		xr_vector<output_rec>	current;
+		collect_outputs	(current);
+
+		result			= (count==current.size()) && (count!=0);
+		for (u32 it=0; result && (it<count); ++it)
+		{
+			if (!R->elapsed() || !memchr(R->pointer(),0,R->elapsed()))
+			{
+				clMsg	("build cache: project manifest is truncated");
+				result	= false;
+				break;
+			}
+			output_rec	O;
+			R->r_stringZ(O.name);
+			if (R->elapsed()<int(2*sizeof(u32)))
+			{
+				clMsg	("build cache: project manifest is truncated");
+				result	= false;
+				break;
+			}
+			O.size		= R->r_u32();
+			O.modif		= R->r_u32();
+
+			result		= false;
+			for (u32 c=0; c<current.size(); ++c)
+			{
+				if (0!=xr_strcmp(current[c].name.c_str(),O.name.c_str()))	continue;
+				result	= (current[c].size==O.size) && (current[c].modif==O.modif);
+				break;
+			}
+			if (!result)
+				clMsg	("build cache: output '%s' was modified",O.name.c_str());
+		}
+		if (result)
+			m_saved_build	= time;
+	}
+	FS.r_close			(R);
+
+	m_project_reused	= result;
+	if (result)
+	{
+		clMsg			("build cache: inputs are not changed, outputs of the previous build are up to date");
+		phase			("Build",true,m_saved_build);
+	}
+	return				result;
+}
+
+void CBuildCache::project_store	(float build_time)
+{
+	if (!m_enabled)		return;
+
+	xr_vector<output_rec>	outputs;
+	collect_outputs		(outputs);
+
+	string_path			fn;
+	IWriter*	W		= FS.w_open(strconcat(sizeof(fn),fn,m_cache_path,"project.manifest"));
+	if (!W)				return;
+	W->w_u32			(build_cache_version);
+	W->w_u32			(m_project_crc);
+	W->w_float			(build_time);
+	W->w_u32			(outputs.size());
+	for (u32 it=0; it<outputs.size(); ++it)
+	{
+		W->w_stringZ	(outputs[it].name);
+		W->w_u32		(outputs[it].size);
+		W->w_u32		(outputs[it].modif);
+	}
+	FS.w_close			(W);
+	phase				("Build",false,build_time);
+}
+
+void CBuildCache::lmaps_select	(xr_vector<int>& tasks)
+{
+	vecDefl&	D		= lc_global_data()->g_deflectors();
+	u32 const	count	= D.size();
+
+	tasks.clear			();
+	m_defl_keys.assign	(count,0);
+	m_defl_time.assign	(count,0.f);
+	m_defl_reused.assign(count,0);
+	m_defl_lit			= 0;
+	m_defl_restored		= 0;
+
+	if (!m_enabled || g_build_options.b_net_light)
+	{
+		for (u32 it=0; it<count; ++it)
+			tasks.push_back	(it);
+		return;
+	}
+
+	Status				("Build cache: hashing...");
+	m_env_crc			= env_crc();
+	for (u32 it=0; it<count; ++it)
+		m_defl_keys[it]	= deflector_key(D[it]);
+	collect_lights		(m_lights);
+	collect_cells		(m_cells);
+
+	// previous build
+	string_path			fn;
+	IReader*	R		= FS.r_open(strconcat(sizeof(fn),fn,m_cache_path,"lmaps.cache"));
+	IReader*	H		= R ? R->open_chunk(0) : 0;
+	bool		valid	= H && (H->elapsed()>=int(2*sizeof(u32))) && (H->r_u32()==build_cache_version) && (H->r_u32()==m_env_crc);
+	if (H)				H->close();
+	if (!valid)
+	{
+		if (R)	clMsg	("build cache: lighting environment changed, all deflectors are dirty");
+		else	clMsg	("build cache: no lightmaps cached");
+		FS.r_close		(R);
+		for (u32 it=0; it<count; ++it)
+			tasks.push_back	(it);
+		return;
+	}
+
+	// a short or corrupt cache is a miss, the restore below reads only what is checked here
+	xr_vector<light_rec>	old_lights;
+	xr_vector<cell_rec>		old_cells;
+	xr_vector<defl_rec>		old_defl;
+	valid				= r_table(R,1,old_lights) && r_table(R,2,old_cells);
+	IReader*	L		= valid ? R->open_chunk(3) : 0;
+	valid				= L && (L->elapsed()>=int(sizeof(u32)));
+	if (valid)
+	{
+		u32		defl_count	= L->r_u32();
+		u32 const	defl_head	= sizeof(u64)+sizeof(float)+sizeof(Fsphere)+3*sizeof(u32);
+		valid			= defl_count<=u32(L->elapsed())/defl_head;
+		if (valid)		old_defl.resize	(defl_count);
+		for (u32 it=0; valid && (it<old_defl.size()); ++it)
+		{
+			if (u32(L->elapsed())<defl_head)								{ valid = false; break; }
+			defl_rec&	rec	= old_defl[it];
+			rec.key		= L->r_u64();
+			rec.time	= L->r_float();
+			rec.offset	= L->tell();
+			L->advance	(sizeof(Fsphere)+2*sizeof(u32));
+			u32	size	= L->r_u32();
+			if (size>u32(L->elapsed())/sizeof(base_color))				{ valid = false; break; }
+			L->advance	(size*sizeof(base_color));
+			if (u32(L->elapsed())<sizeof(u32))							{ valid = false; break; }
+			size		= L->r_u32();
+			if (size>u32(L->elapsed()))									{ valid = false; break; }
+			L->advance	(size*sizeof(u8));
+		}
+	}
+	if (!valid)
+	{
+		clMsg			("build cache: lightmaps cache is corrupt, all deflectors are dirty");
+		if (L)			L->close();
+		FS.r_close		(R);
+		for (u32 it=0; it<count; ++it)
+			tasks.push_back	(it);
+		return;
+	}
+	std::sort			(old_defl.begin(),old_defl.end());
+
+	// changed lights
+	bool		all		= false;
+	xr_vector<Fsphere>	spheres;
+	{
+		xr_vector<light_rec>	changed;
+		std::set_symmetric_difference(old_lights.begin(),old_lights.end(),m_lights.begin(),m_lights.end(),std::back_inserter(changed));
+		for (u32 it=0; it<changed.size(); ++it)
+		{
+			if (changed[it].type!=LT_POINT)	{ all = true; break; }
+			Fsphere	S;	S.set	(changed[it].position,changed[it].range);
+			spheres.push_back	(S);
+		}
+		if (!changed.empty())
+			clMsg		("build cache: %d lights changed",changed.size());
+	}
+
+	// changed occluders
+	xr_vector<Fbox>		boxes;
+	{
+		xr_vector<cell_rec>::iterator	o	= old_cells.begin(), o_e = old_cells.end();
+		xr_vector<cell_rec>::iterator	n	= m_cells.begin(),	n_e = m_cells.end();
+		while ((o!=o_e) || (n!=n_e))
+		{
+			if ((n==n_e) || ((o!=o_e) && (o->id<n->id)))	{ boxes.push_back(o->box); ++o; continue; }
+			if ((o==o_e) || (n->id<o->id))					{ boxes.push_back(n->box); ++n; continue; }
+			if ((o->sum!=n->sum) || (o->count!=n->count))
+			{
+				Fbox	B;
+				B.merge	(o->box,n->box);
+				boxes.push_back	(B);
+			}
+			++o; ++n;
+		}
+		if (!boxes.empty())
+			clMsg		("build cache: occluders changed in %d cells",boxes.size());
+	}
+
+	// a changed occluder inside of a point light changes its shadows everywhere in its range
+	for (u32 b=0; b<boxes.size(); ++b)
+	{
+		for (u32 it=0; it<m_lights.size(); ++it)
+		{
+			light_rec&	LR	= m_lights[it];
+			if (LR.type!=LT_POINT)		continue;
+			Fbox		B	= boxes[b];
+			B.grow		(LR.range);
+			if (!B.contains(LR.position))	continue;
+			Fsphere		S;	S.set	(LR.position,LR.range);
+			spheres.push_back	(S);
+		}
+	}
+
+	// directions towards the directional lights
+	xr_vector<Fvector>	dirs;
+	{
+		base_lighting&	LS	= pBuild->L_static();
+		for (u32 it=0; it<LS.hemi.size(); ++it)	if (LS.hemi[it].type==LT_DIRECT)	dirs.push_back(Fvector().invert(LS.hemi[it].direction));
+		for (u32 it=0; it<LS.sun.size(); ++it)	if (LS.sun[it].type==LT_DIRECT)		dirs.push_back(Fvector().invert(LS.sun[it].direction));
+		for (u32 it=0; it<LS.rgb.size(); ++it)	if (LS.rgb[it].type==LT_DIRECT)		dirs.push_back(Fvector().invert(LS.rgb[it].direction));
+	}
+
+	Status				("Build cache: restoring...");
+	for (u32 it=0; it<count; ++it)
+	{
+		Progress		(float(it)/float(count));
+		CDeflector*	defl	= D[it];
+
+		defl_rec	rec;	rec.key	= m_defl_keys[it];
+		xr_vector<defl_rec>::iterator	c	= std::lower_bound(old_defl.begin(),old_defl.end(),rec);
+		bool		dirty	= all || (c==old_defl.end()) || (c->key!=rec.key);
+
+		Fsphere		S;
+		deflector_sphere	(defl,S);
+		for (u32 s=0; !dirty && (s<spheres.size()); ++s)
+			dirty		= !!S.intersect(spheres[s]);
+		for (u32 b=0; !dirty && (b<boxes.size()); ++b)
+		{
+			// a change on the way from any of the lightmap texels to a directional light
+			Fbox		B	= boxes[b];
+			B.grow		(S.R);
+			if (B.contains(S.P))	{ dirty = true; break; }
+			Fvector		coord;
+			for (u32 d=0; !dirty && (d<dirs.size()); ++d)
+				dirty	= B.Pick2(S.P,dirs[d],coord)!=Fbox::rpNone;
+		}
+
+		if (dirty)
+		{
+			tasks.push_back	(it);
+			continue;
+		}
+
+		L->seek			(c->offset);
+		L->r			(&defl->Sphere,sizeof(Fsphere));
+		defl->layer.width	= L->r_u32();
+		defl->layer.height	= L->r_u32();
+		u32 size		= L->r_u32();
+		defl->layer.surface.resize	(size);
+		if (size)		L->r(&defl->layer.surface.front(),size*sizeof(base_color));
+		size			= L->r_u32();
+		defl->layer.marker.resize	(size);
+		if (size)		L->r(&defl->layer.marker.front(),size*sizeof(u8));
+
+		m_defl_time[it]		= c->time;
+		m_defl_reused[it]	= 1;
+		++m_defl_restored;
+	}
+	L->close			();
+	FS.r_close			(R);
+
+	clMsg				("build cache: %d deflectors to light, %d restored",tasks.size(),m_defl_restored);
+}
+
+void CBuildCache::lmaps_store	(float phase_time)
+{
+	if (!m_enabled || g_build_options.b_net_light)
+		return;
+
+	vecDefl&	D		= lc_global_data()->g_deflectors();
+	float		saved	= 0;
+	for (u32 it=0; it<D.size(); ++it)
+		if (m_defl_reused[it])	saved	+= m_defl_time[it];
+	m_defl_lit			= D.size()-m_defl_restored;
+
+	string_path			fn;
+	IWriter*	W		= FS.w_open(strconcat(sizeof(fn),fn,m_cache_path,"lmaps.cache"));
+	if (W)
+	{
+		W->open_chunk	(0);
+		W->w_u32		(build_cache_version);
+		W->w_u32		(m_env_crc);
+		W->close_chunk	();
+
+		W->open_chunk	(1);
+		W->w_u32		(m_lights.size());
+		if (!m_lights.empty())	W->w(&m_lights.front(),m_lights.size()*sizeof(light_rec));
+		W->close_chunk	();
+
+		W->open_chunk	(2);
+		W->w_u32		(m_cells.size());
+		if (!m_cells.empty())	W->w(&m_cells.front(),m_cells.size()*sizeof(cell_rec));
+		W->close_chunk	();
+
+		W->open_chunk	(3);
+		W->w_u32		(D.size());
+		for (u32 it=0; it<D.size(); ++it)
+		{
+			CDeflector*	defl	= D[it];
+			W->w_u64	(m_defl_keys[it]);
+			W->w_float	(m_defl_time[it]);
+			W->w		(&defl->Sphere,sizeof(Fsphere));
+			W->w_u32	(defl->layer.width);
+			W->w_u32	(defl->layer.height);
+			W->w_u32	(defl->layer.surface.size());
+			if (!defl->layer.surface.empty())	W->w(&defl->layer.surface.front(),defl->layer.surface.size()*sizeof(base_color));
+			W->w_u32	(defl->layer.marker.size());
+			if (!defl->layer.marker.empty())	W->w(&defl->layer.marker.front(),defl->layer.marker.size()*sizeof(u8));
+		}
+		W->close_chunk	();
+		FS.w_close		(W);
+	}
+
+	string256			line;
+	m_defl_report.clear	();
+	xr_sprintf			(line,"deflectors: %d, lit: %d, restored: %d",D.size(),m_defl_lit,m_defl_restored);
+	m_defl_report.push_back	(line);
+	for (u32 it=0; it<D.size(); ++it)
+	{
+		Fsphere&	S	= D[it]->Sphere;
+		xr_sprintf		(line,"%016I64x [%9.2f,%9.2f,%9.2f] r=%7.2f %-10s %8.3f s",
+			m_defl_keys[it],S.P.x,S.P.y,S.P.z,S.R,m_defl_reused[it]?"restored":"lit",m_defl_time[it]);
+		m_defl_report.push_back	(line);
+	}
+
+	phase				("LIGHT: LMaps (lit)",false,phase_time);
+	if (m_defl_restored)
+		phase			("LIGHT: LMaps (restored)",true,saved);
+}
+
+void CBuildCache::phase		(LPCSTR name, bool reused, float time)
+{
+	phase_rec			P;
+	P.name				= name;
+	P.reused			= reused;
+	P.time				= time;
+	m_phases.push_back	(P);
+}
+
+void CBuildCache::report	()
+{
+	if (!m_enabled)		return;
+
+	string_path			fn;
+	IWriter*	W		= FS.w_open(strconcat(sizeof(fn),fn,m_cache_path,"report.txt"));
+	string1024			line;
+
+	float		saved	= 0;
+	for (u32 it=0; it<m_phases.size(); ++it)
+	{
+		phase_rec&	P	= m_phases[it];
+		if (P.reused)	saved	+= P.time;
+		xr_sprintf		(line,"%-32s %-10s %10.2f s",*P.name,P.reused?"reused":"recomputed",P.time);
+		clMsg			("build cache: %s",line);
+		if (W)			W->w_string(line);
+	}
+	xr_sprintf			(line,"wall time saved: %.2f s",saved);
+	clMsg				("build cache: %s",line);
+	if (W)				W->w_string(line);
+
+	if (W)
+	{
+		for (u32 it=0; it<m_defl_report.size(); ++it)
+			W->w_string	(m_defl_report[it].c_str());
+		FS.w_close		(W);
+	}
+}
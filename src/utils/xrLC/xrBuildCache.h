@@ -0,0 +1,108 @@
+#pragma once
+
+// Incremental rebuild support (-incremental).
+//
+// The cache lives in "<level>\build_cache\" and is used on two levels:
+//  - project: all inputs (build.prj, textures, shader library, options) are
+//    hashed; if they match the previous run and its outputs are still on disk,
+//    the whole build is skipped.
+//  - lightmaps: every deflector is keyed by a hash of its geometry. Deflectors
+//    whose key is cached and which are outside of the regions touched by
+//    changed lights or changed occluders get their lightmap from the cache.
+
+class CDeflector;
+
+class CBuildCache
+{
+public:
+	struct light_rec
+	{
+		u32				hash;
+		u32				type;
+		Fvector			position;
+		float			range;
+		bool operator < (const light_rec& other) const { return hash<other.hash; }
+	};
+
+	struct cell_rec
+	{
+		u64				id;
+		u32				sum;
+		u32				count;
+		Fbox			box;
+		bool operator < (const cell_rec& other) const { return id<other.id; }
+	};
+
+	struct defl_rec
+	{
+		u64				key;
+		u32				offset;		// of the layer data in the cache file
+		float			time;		// seconds spent lighting it
+		bool operator < (const defl_rec& other) const { return key<other.key; }
+	};
+
+	struct output_rec
+	{
+		xr_string		name;
+		u32				size;
+		u32				modif;
+	};
+
+	struct phase_rec
+	{
+		shared_str		name;
+		bool			reused;
+		float			time;		// spent, or saved if reused
+	};
+
+private:
+	bool				m_enabled;
+	string_path			m_level_path;
+	string_path			m_cache_path;
+	u32					m_project_crc;
+	u32					m_env_crc;
+	u32					m_textures_crc;
+
+	xr_vector<u64>		m_defl_keys;	// per current deflector
+	xr_vector<float>	m_defl_time;	// per current deflector, seconds
+	xr_vector<u8>		m_defl_reused;	// per current deflector
+	u32					m_defl_lit;
+	u32					m_defl_restored;
+
+	xr_vector<light_rec> m_lights;		// current build
+	xr_vector<cell_rec>	m_cells;		// current build
+	float				m_saved_build;	// previous build time, if reused
+	bool				m_project_reused;
+
+	xr_vector<phase_rec> m_phases;
+	xr_vector<xr_string> m_defl_report;	// deflectors are gone by the time the report is written
+
+	u32					textures_crc	();
+	u32					env_crc			();
+	u64					deflector_key	(CDeflector* D);
+	void				deflector_sphere(CDeflector* D, Fsphere& S);
+	void				collect_lights	(xr_vector<light_rec>& dest);
+	void				collect_cells	(xr_vector<cell_rec>& dest);
+	void				collect_outputs	(xr_vector<output_rec>& dest);
+public:
+						CBuildCache		();
+
+	void				enable			()			{ m_enabled = true;		}
+	bool				enabled			() const	{ return m_enabled;		}
+
+	// level_path ends with '\\', project is the opened build.prj
+	void				initialize		(LPCSTR level_path, IReader& project);
+
+	bool				project_reuse	();
+	void				project_store	(float build_time);
+
+	// fills tasks with indices of the deflectors to light, the rest is restored from the cache
+	void				lmaps_select	(xr_vector<int>& tasks);
+	void				lmaps_timing	(u32 id, float time)	{ if (id<m_defl_time.size()) m_defl_time[id] = time; }
+	void				lmaps_store		(float phase_time);
+
+	void				phase			(LPCSTR name, bool reused, float time);
+	void				report			();
+};
+
+extern CBuildCache		g_build_cache;
@@ -4,6 +4,7 @@
 #include "math.h"
 #include "build.h"
 #include "../xrLC_Light/xrLC_GlobalData.h"
+#include "xrBuildCache.h"
 
 //#pragma comment(linker,"/STACK:0x800000,0x400000")
 //#pragma comment(linker,"/HEAP:0x70000000,0x10000000")
@@ -38,6 +39,9 @@ static const char* h_str =
 	"-? or -h	== this help\n"
 	"-o			== modify build options\n"
 	"-nosun		== disable sun-lighting\n"
+	"-incremental	== reuse results of the previous build for unchanged inputs\n"
+	"-lm_scalar	== trace lightmap shadow rays one by one (no packets)\n"
+	"-lm_compare	== trace lightmaps both ways, report timings and deviation\n"
 	"-f<NAME>	== compile level in GameData\\Levels\\<NAME>\\\n"
 	"\n"
 	"NOTE: The last key is required for any functionality\n";
@@ -64,6 +68,7 @@ void Startup(LPSTR     lpCmdLine)
 	if (strstr(cmd,"-gi"))								g_build_options.b_radiosity		= TRUE;
 	if (strstr(cmd,"-noise"))							g_build_options.b_noise			= TRUE;
 	if (strstr(cmd,"-net"))								g_build_options.b_net_light		= TRUE;
+	if (strstr(cmd,"-incremental"))						g_build_cache.enable			();
 	VERIFY( lc_global_data() );
 	lc_global_data()->b_nosun_set						( !!strstr(cmd,"-nosun") );
 	//if (strstr(cmd,"-nosun"))							b_nosun			= TRUE;
@@ -136,13 +141,23 @@ void Startup(LPSTR     lpCmdLine)
 	Phase					("Converting data structures...");
 	pBuild					= xr_new<CBuild>();
 	pBuild->Load			(Params,*F);
+
+	string_path				lfn;
+	FS.update_path			(lfn,_game_levels_,name);
+	{
+		string_path			level_path;
+		g_build_cache.initialize(strconcat(sizeof(level_path),level_path,lfn,"\\"),*F);
+	}
 	FS.r_close				(F);
 	
 	// Call for builder
-	string_path				lfn;
 	CTimer	dwStartupTime;	dwStartupTime.Start();
-	FS.update_path			(lfn,_game_levels_,name);
-	pBuild->Run				(lfn);
+	if (!g_build_cache.project_reuse())
+	{
+		pBuild->Run			(lfn);
+		g_build_cache.project_store	(dwStartupTime.GetElapsed_sec());
+	}
+	g_build_cache.report	();
 	xr_delete				(pBuild);
 
 	// Show statistic
@@ -11,6 +11,7 @@
 //#include "../xrLC_Light/net_task_manager.h"
 #include "../xrLC_Light/lcnet_task_manager.h"
 #include "../xrLC_Light/mu_model_light.h"
+#include "xrBuildCache.h"
 xrCriticalSection	task_CS
 #ifdef PROFILE_CRITICAL_SECTIONS
 	(MUTEX_PROFILE_ID(task_C_S))
@@ -35,6 +36,7 @@ public:
 	virtual void	Execute()
 	{
 		CDeflector* D	= 0;
+		u32			id	= 0;
 
 		for (;;) 
 		{
@@ -47,17 +49,20 @@ public:
 				return;
 			}
 
-			D					= lc_global_data()->g_deflectors()[task_pool.back()];
+			id					= task_pool.back();
+			D					= lc_global_data()->g_deflectors()[id];
 			task_pool.pop_back	();
 			task_CS.Leave		();
 
 			// Perform operation
+			CTimer	T;	T.Start	();
 			try {
 				D->Light	(&DB,&LightsSelected,H);
 			} catch (...)
 			{
 				clMsg("* ERROR: CLMThread::Execute - light");
 			}
+			g_build_cache.lmaps_timing	(id,T.GetElapsed_sec());
 		}
 	}
 };
@@ -80,8 +85,8 @@ void	CBuild::LMapsLocal				()
 #endif
 
 #ifndef NET_CMP	
-for(u32 dit = 0; dit<lc_global_data()->g_deflectors().size(); dit++)	
-		task_pool.push_back(dit);
+		// deflectors not affected by the changes are restored from the build cache
+		g_build_cache.lmaps_select	(task_pool);
 #else
 		task_pool.push_back(14);
 		task_pool.push_back(16);
@@ -96,6 +101,10 @@ for(u32 dit = 0; dit<lc_global_data()->g_deflectors().size(); dit++)
 		for				(int L=0; L<thNUM; L++)	threads.start(xr_new<CLMThread> (L));
 		threads.wait	(500);
 		clMsg			("%f seconds",start_time.GetElapsed_sec());
+		LightmapTraceReport	();
+#ifndef NET_CMP
+		g_build_cache.lmaps_store	(start_time.GetElapsed_sec());
+#endif
 }
 
 void	CBuild::LMaps					()
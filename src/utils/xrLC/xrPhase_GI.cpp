@@ -10,20 +10,23 @@
 #include "../../xrcdb/xrcdb.h"
 
 
-#define	GI_THREADS		2
 const	u32				gi_num_photons		= 32;
 const	float			gi_optimal_range	= 15.f;
 const	float			gi_reflect			= 0.9f;
 const	float			gi_clip				= 0.05f;
 const	u32				gi_maxlevel			= 4;
+const	u32				gi_chunk			= 4;		// sources taken by a thread at once
 //////////////////////////////////////////////////////////////////////////
-static xr_vector<R_Light>*		task;
-xrCriticalSection		task_cs
-#ifdef PROFILE_CRITICAL_SECTIONS
-	(MUTEX_PROFILE_ID(task_cs))
-#endif // PROFILE_CRITICAL_SECTIONS
-;
-static u32						task_it;
+// The solver works by generations: all the lights of a level are the sources
+// of the next one. Sources are handed out to the threads in small chunks, every
+// source restarts the random stream and has its own output list, and the outputs are
+// appended in source order - so the result doesn't depend on the thread count.
+static xr_vector<R_Light>*				task;
+static u32								task_begin;		// sources of the current generation
+static u32								task_end;
+static volatile LONG					task_next;
+static volatile LONG					task_done;
+static xr_vector<xr_vector<R_Light> >	task_result;	// per source of the current generation
 
 //////////////////////////////////////////////////////////////////////////
 static Fvector		GetPixel_7x7		(CDB::RESULT& rpinf)
@@ -89,100 +92,95 @@ public:
 	{
 		CDB::COLLIDER		xrc;
 		xrc.ray_options		(CDB::OPT_CULL|CDB::OPT_ONLYNEAREST);
-		CDB::MODEL*	model	= lc_global_data()->RCAST_Model();
-		CDB::TRI*	tris	= lc_global_data()->RCAST_Model()->get_tris();
-		Fvector*	verts	= lc_global_data()->RCAST_Model()->get_verts();
 
 		// full iteration
 		for (;;)	
 		{
-			// get task
-			R_Light				src,dst;
-			task_cs.Enter		();
-			if (task_it>=task->size())	{
-				task_cs.Leave	();
-				return;
-			} else {
-				src					= (*task)[task_it];
-				if (0==src.level)	src.range	*= 1.5f;
-				dst					= src;
-				//if (LT_POINT==src.type)	(*task)[task_it].energy		= 0.f;
-				dst.type			= LT_SECONDARY;
-				dst.level			++;
-				task_it				++;
-				thProgress			= float(task_it)/float(task->size())/float(GI_THREADS);
+			// get chunk of tasks
+			u32	first			= task_begin + u32(InterlockedExchangeAdd(&task_next,LONG(gi_chunk)));
+			if (first>=task_end)	break;
+			u32	last			= _min(first+gi_chunk,task_end);
+			for (u32 it=first; it<last; it++)
+				Process			(xrc,it);
+
+			u32 done			= u32(InterlockedExchangeAdd(&task_done,LONG(last-first))) + (last-first);
+			thProgress			= float(done)/float(task_end-task_begin);
+		}
+		thProgress				= 1.f;
+	}
+
+	void			Process	(CDB::COLLIDER& xrc, u32 id)
+	{
+		CDB::MODEL*	model	= lc_global_data()->RCAST_Model();
+		CDB::TRI*	tris	= lc_global_data()->RCAST_Model()->get_tris();
+		Fvector*	verts	= lc_global_data()->RCAST_Model()->get_verts();
+
+		R_Light				src,dst;
+		src					= (*task)[id];
+		if (0==src.level)	src.range	*= 1.5f;
+		dst					= src;
+		dst.type			= LT_SECONDARY;
+		dst.level			++;
+		if (dst.level>gi_maxlevel)	return;
+
+		xr_vector<R_Light>&	result	= task_result[id-task_begin];
+
+		// analyze
+		CRandom				random;
+		random.seed			(0x12071980);		// restarted per source, as the serial solver did
+		float	factor		=  _sqrt(src.range / gi_optimal_range);			// smaller lights get smaller amount of photons
+				if (factor>1)	factor=1;
+		if (LT_SECONDARY == src.type)	factor /= powf(2.f,float(src.level));// secondary lights get half the photons
+				factor		*= _sqrt(src.energy);							// 2.f is optimal energy = baseline
+		int		count		= iCeil( factor * float(gi_num_photons) );
+		float	_clip		= (_sqrt(src.energy)/10.f + gi_clip)/2.f;
+		float	_scale		= 1.f / _sqrt(factor);
+		for (int it=0; it<count; it++)	{
+			Fvector	dir,idir;		float	s=1.f;
+			switch	(src.type)		{
+				case LT_POINT		:	dir.random_dir(random).normalize();				break;
+				case LT_SECONDARY	:	
+					dir.random_dir	(src.direction,PI_DIV_2,random);					//. or PI ?
+					s				= src.direction.dotproduct(dir.normalize());
+					break;
+				default:			continue;											// continue loop
 			}
-			task_cs.Leave				();
-			if (dst.level>gi_maxlevel)	continue;
-
-			// analyze
-			CRandom				random;
-			random.seed			(0x12071980);
-			float	factor		=  _sqrt(src.range / gi_optimal_range);			// smaller lights get smaller amount of photons
-					if (factor>1)	factor=1;
-			if (LT_SECONDARY == src.type)	factor /= powf(2.f,float(src.level));// secondary lights get half the photons
-					factor		*= _sqrt(src.energy);							// 2.f is optimal energy = baseline
-					//factor	= _sqrt (factor);								// move towards 1.0 (one)
-			int		count		= iCeil( factor * float(gi_num_photons) );
-					//count		= gi_num_photons;
-			float	_clip		= (_sqrt(src.energy)/10.f + gi_clip)/2.f;
-			float	_scale		= 1.f / _sqrt(factor);
-			//clMsg	("src_LER[%d/%f/%f] -> factor(%f), count(%d), clip(%f)",
-			//	src.level, src.energy, src.range, factor, count, _clip
-			//	);
-			for (int it=0; it<count; it++)	{
-				Fvector	dir,idir;		float	s=1.f;
-				switch	(src.type)		{
-					case LT_POINT		:	dir.random_dir(random).normalize();				break;
-					case LT_SECONDARY	:	
-						dir.random_dir	(src.direction,PI_DIV_2,random);					//. or PI ?
-						s				= src.direction.dotproduct(dir.normalize());
-						break;
-					default:			continue;											// continue loop
-				}
-				xrc.ray_query		(model,src.position,dir,src.range);
-				if					(!xrc.r_count()) continue;
-				CDB::RESULT *R		= xrc.r_begin	();
-				CDB::TRI&	T		= tris[R->id];
-				Fvector		Tv[3]	= { verts[T.verts[0]],verts[T.verts[1]],verts[T.verts[2]] };
-				Fvector		TN;		TN.mknormal		(Tv[0],Tv[1],Tv[2]);
-				float		dot		= TN.dotproduct	(idir.invert(dir));
-
-				dst.position.mad		(src.position,dir,R->range);
-				dst.position.mad		(TN,0.01f);		// 1cm away from surface
-				dst.direction.reflect	(dir,TN);
-				dst.energy				= src.energy * dot * gi_reflect * (1-R->range/src.range) * _scale;
-				if (dst.energy < _clip)	continue;
-
-				// color bleeding
-				dst.diffuse.mul			(src.diffuse,GetPixel_7x7(*R));
-				dst.diffuse.mul			(dst.energy);
-				{
-					float			_e		=	(dst.diffuse.x+dst.diffuse.y+dst.diffuse.z)/3.f;
-					Fvector			_c		=	{dst.diffuse.x,dst.diffuse.y,dst.diffuse.z};
-					if (_abs(_e)>EPS_S)		_c.div	(_e);
-					else					{ _c.set(0,0,0); _e=0; }
-					dst.diffuse				= _c;
-					dst.energy				= _e;
-				}
-				if (dst.energy < _clip)	continue;
-
-				// scale range in proportion with energy
-				float	_r1			= src.range * _sqrt(dst.energy / src.energy);
-				float	_r2			= (dst.energy - _clip)/_clip;
-				float	_r3			= src.range;
-				dst.range			= 1 * ( (1.f*_r1 + 3.f*_r2 + 3.f*_r3)/7.f );	// empirical
-				// clMsg			("submit: level[%d],type[%d], energy[%f]",dst.level,dst.type,dst.energy);
-
-				// submit answer
-				if (dst.energy > gi_clip/4)	
-				{
-					//clMsg	("dst_ER[%f/%f]", dst.energy, dst.range);
-					task_cs.Enter		();
-					task->push_back		(dst);
-					task_cs.Leave		();
-				}
+			xrc.ray_query		(model,src.position,dir,src.range);
+			if					(!xrc.r_count()) continue;
+			CDB::RESULT *R		= xrc.r_begin	();
+			CDB::TRI&	T		= tris[R->id];
+			Fvector		Tv[3]	= { verts[T.verts[0]],verts[T.verts[1]],verts[T.verts[2]] };
+			Fvector		TN;		TN.mknormal		(Tv[0],Tv[1],Tv[2]);
+			float		dot		= TN.dotproduct	(idir.invert(dir));
+
+			dst.position.mad		(src.position,dir,R->range);
+			dst.position.mad		(TN,0.01f);		// 1cm away from surface
+			dst.direction.reflect	(dir,TN);
+			dst.energy				= src.energy * dot * gi_reflect * (1-R->range/src.range) * _scale;
+			if (dst.energy < _clip)	continue;
+
+			// color bleeding
+			dst.diffuse.mul			(src.diffuse,GetPixel_7x7(*R));
+			dst.diffuse.mul			(dst.energy);
+			{
+				float			_e		=	(dst.diffuse.x+dst.diffuse.y+dst.diffuse.z)/3.f;
+				Fvector			_c		=	{dst.diffuse.x,dst.diffuse.y,dst.diffuse.z};
+				if (_abs(_e)>EPS_S)		_c.div	(_e);
+				else					{ _c.set(0,0,0); _e=0; }
+				dst.diffuse				= _c;
+				dst.energy				= _e;
 			}
+			if (dst.energy < _clip)	continue;
+
+			// scale range in proportion with energy
+			float	_r1			= src.range * _sqrt(dst.energy / src.energy);
+			float	_r2			= (dst.energy - _clip)/_clip;
+			float	_r3			= src.range;
+			dst.range			= 1 * ( (1.f*_r1 + 3.f*_r2 + 3.f*_r3)/7.f );	// empirical
+
+			// submit answer
+			if (dst.energy > gi_clip/4)	
+				result.push_back	(dst);
 		}
 	}
 };
@@ -190,23 +188,46 @@ public:
 // test_radios
 void	CBuild::xrPhase_Radiosity	()
 {
-	CThreadManager			gi;
 	Status					("Working...");
 	task					= &(pBuild->L_static().rgb);
-	task_it					= 0;
 
 	// calculate energy
 	float	_energy_before	= 0;
 	for (u32 l=0; l<task->size(); l++)
 		if (task->at(l).type == LT_POINT)	_energy_before	+= task->at(l).energy;
 
-	// perform all the work
+	// perform all the work, generation by generation
 	u32	setup_old			= task->size	();
-	for (int t=0; t<GI_THREADS; t++)	{
-		gi.start(xr_new<CGI>(t));
-		Sleep	(10);
+	u32	threads				= _max(CPU::ID.n_threads,1u);
+	CTimer					timer;	timer.Start();
+	task_end				= 0;
+	for (u32 generation=0; task_end<task->size(); generation++)
+	{
+		task_begin			= task_end;
+		task_end			= task->size();
+		task_next			= 0;
+		task_done			= 0;
+		task_result.clear	();
+		task_result.resize	(task_end-task_begin);
+
+		CTimer				gen_timer;	gen_timer.Start();
+		Status				("Generation %d: %d sources, %d threads...",generation,task_end-task_begin,threads);
+		CThreadManager		gi;
+		u32	count			= _min(threads,(task_end-task_begin+gi_chunk-1)/gi_chunk);
+		for (u32 t=0; t<count; t++)
+			gi.start		(xr_new<CGI>(t));
+		gi.wait				(100);
+
+		u32	produced		= 0;
+		for (u32 it=0; it<task_result.size(); it++)
+		{
+			task->insert	(task->end(),task_result[it].begin(),task_result[it].end());
+			produced		+= task_result[it].size();
+		}
+		clMsg				("GI generation %d: %d sources -> %d lights, %f seconds",generation,task_end-task_begin,produced,gen_timer.GetElapsed_sec());
 	}
-	gi.wait					();
+	task_result.clear_and_free	();
+	clMsg					("GI: %f seconds on %d threads",timer.GetElapsed_sec(),threads);
 	u32 setup_new			= task->size	();
 
 	// renormalize
@@ -2,6 +2,105 @@
 
 #include "base_lighting.h"
 #include "serialize.h"
+static u32 const	light_hash_max_cells	= 512;
+
+// distance at which the light stops affecting anything, negative if it is global
+IC float	light_cull_range	(const R_Light& L)
+{
+	switch (L.type)
+	{
+	case LT_POINT:		return L.range;
+	case LT_SECONDARY:	return _sqrt(L.range2);		// LightPoint culls secondary lights by range2
+	}
+	return		-1.f;
+}
+
+IC u32		light_hash_key		(int x, int y, int z)
+{
+	return		u32(x*73856093) ^ u32(y*19349663) ^ u32(z*83492791);
+}
+
+IC void		light_hash_cells	(float cell, const Fvector& P, float R, Ivector& min, Ivector& max)
+{
+	min.set		(iFloor((P.x-R)/cell),iFloor((P.y-R)/cell),iFloor((P.z-R)/cell));
+	max.set		(iFloor((P.x+R)/cell),iFloor((P.y+R)/cell),iFloor((P.z+R)/cell));
+}
+
+IC float	light_hash_volume	(const Ivector& min, const Ivector& max)
+{
+	return		float(max.x-min.x+1)*float(max.y-min.y+1)*float(max.z-min.z+1);
+}
+
+void	light_hash::clear		()
+{
+	m_cell		= 0;
+	m_src		= 0;
+	m_count		= 0;
+	m_always.clear_and_free		();
+	m_entries.clear_and_free	();
+}
+
+void	light_hash::build		(const xr_vector<R_Light>& src)
+{
+	clear		();
+	if (src.empty())	return;
+
+	// cell is about the average light diameter
+	float		sum		= 0;
+	u32			local	= 0;
+	for (u32 it=0; it<src.size(); it++)
+	{
+		float	r		= light_cull_range(src[it]);
+		if (r<0)		continue;
+		sum				+= 2*r;
+		local			++;
+	}
+	m_cell		= local ? _max(2.f,_min(sum/float(local),100.f)) : 100.f;
+
+	for (u32 it=0; it<src.size(); it++)
+	{
+		float	r		= light_cull_range(src[it]);
+		Ivector	min,max;
+		if (r>=0)		light_hash_cells	(m_cell,src[it].position,r,min,max);
+		if ((r<0) || (light_hash_volume(min,max)>float(light_hash_max_cells)))
+		{
+			m_always.push_back	(it);
+			continue;
+		}
+		for (int x=min.x; x<=max.x; x++)
+			for (int y=min.y; y<=max.y; y++)
+				for (int z=min.z; z<=max.z; z++)
+					m_entries.push_back	((u64(light_hash_key(x,y,z))<<32) | u64(it));
+	}
+	std::sort	(m_entries.begin(),m_entries.end());
+
+	m_src		= &*src.begin();
+	m_count		= src.size();
+}
+
+bool	light_hash::query		(xr_vector<u32>& dest, const Fvector& P, float R) const
+{
+	Ivector		min,max;
+	light_hash_cells	(m_cell,P,R,min,max);
+	if (light_hash_volume(min,max)>float(light_hash_max_cells))	return false;
+
+	dest.assign	(m_always.begin(),m_always.end());
+	for (int x=min.x; x<=max.x; x++)
+		for (int y=min.y; y<=max.y; y++)
+			for (int z=min.z; z<=max.z; z++)
+			{
+				u64		key		= u64(light_hash_key(x,y,z))<<32;
+				xr_vector<u64>::const_iterator	it	= std::lower_bound(m_entries.begin(),m_entries.end(),key);
+				for (; (it!=m_entries.end()) && ((*it&0xffffffff00000000ull)==key); it++)
+					dest.push_back	(u32(*it&0xffffffff));
+			}
+
+	// keep the order of the source list
+	std::sort	(dest.begin(),dest.end());
+	dest.erase	(std::unique(dest.begin(),dest.end()),dest.end());
+	return		true;
+}
+
 void	base_lighting::select	(xr_vector<R_Light>& dest, xr_vector<R_Light>& src, Fvector& P, float R)
 {
 	Fsphere		Sphere;
@@ -10,18 +109,46 @@ void	base_lighting::select	(xr_vector<R_Light>& dest, xr_vector<R_Light>& src, F
 	R_Light*	L			= &*src.begin();
 	for (; L!=&*src.end(); L++)
 	{
-		if (L->type==LT_POINT) {
+		float range							= light_cull_range(*L);
+		if (range>=0) {
 			float dist						= Sphere.P.distance_to(L->position);
-			if (dist>(Sphere.R+L->range))	continue;
+			if (dist>(Sphere.R+range))		continue;
 		}
 		dest.push_back(*L);
 	}
 }
+void	base_lighting::select	(xr_vector<R_Light>& dest, xr_vector<R_Light>& src, const light_hash& H, Fvector& P, float R)
+{
+	xr_vector<u32>	candidates;
+	if (!H.valid(src) || !H.query(candidates,P,R))
+	{
+		select	(dest,src,P,R);
+		return;
+	}
+
+	dest.clear	();
+	for (u32 it=0; it<candidates.size(); it++)
+	{
+		R_Light&	L		= src[candidates[it]];
+		float range							= light_cull_range(L);
+		if (range>=0) {
+			float dist						= P.distance_to(L.position);
+			if (dist>(R+range))				continue;
+		}
+		dest.push_back(L);
+	}
+}
 void	base_lighting::select	(base_lighting& from, Fvector& P, float R)
 {
-	select(rgb,from.rgb,P,R);
-	select(hemi,from.hemi,P,R);
-	select(sun,from.sun,P,R);
+	select(rgb,from.rgb,from.rgb_hash,P,R);
+	select(hemi,from.hemi,from.hemi_hash,P,R);
+	select(sun,from.sun,from.sun_hash,P,R);
+}
+void	base_lighting::build_hash	()
+{
+	rgb_hash.build	(rgb);
+	hemi_hash.build	(hemi);
+	sun_hash.build	(sun);
 }
 /*
 	xr_vector<R_Light>		rgb;		// P,N	
@@ -33,6 +160,9 @@ void		base_lighting::read( INetReader	&r )
 	r_pod_vector( r, rgb ) ;
 	r_pod_vector( r, hemi );
 	r_pod_vector( r, sun ) ;
+	rgb_hash.clear	();
+	hemi_hash.clear	();
+	sun_hash.clear	();
 }
 void		base_lighting::write( IWriter	&w ) const 
 {
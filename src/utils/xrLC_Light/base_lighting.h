@@ -4,6 +4,24 @@
 
 class INetReader;
 
+// Spatial hash of the local lights of a list. It is built once the list is
+// final and lets select() look only at the lights near the query sphere.
+class XRLC_LIGHT_API light_hash
+{
+	float					m_cell;
+	const R_Light*			m_src;		// list the hash was built for
+	u32						m_count;
+	xr_vector<u32>			m_always;	// directional and very large lights
+	xr_vector<u64>			m_entries;	// cell key << 32 | light index, sorted
+public:
+							light_hash	() : m_cell(0), m_src(0), m_count(0)	{}
+	void					build		(const xr_vector<R_Light>& src);
+	void					clear		();
+	bool					valid		(const xr_vector<R_Light>& src) const	{ return m_count && (m_count==src.size()) && (m_src==&*src.begin()); }
+	// candidate lights, sorted; false if the sphere is too large for the hash
+	bool					query		(xr_vector<u32>& dest, const Fvector& P, float R) const;
+};
+
 #pragma pack(push,4)
 class XRLC_LIGHT_API base_lighting
 {
@@ -12,8 +30,14 @@ public:
 	xr_vector<R_Light>		hemi;		// P,N	
 	xr_vector<R_Light>		sun;		// P
 
+	light_hash				rgb_hash;
+	light_hash				hemi_hash;
+	light_hash				sun_hash;
+
 	void					select		(xr_vector<R_Light>& dest, xr_vector<R_Light>& src, Fvector& P, float R);
+	void					select		(xr_vector<R_Light>& dest, xr_vector<R_Light>& src, const light_hash& H, Fvector& P, float R);
 	void					select		(base_lighting& from, Fvector& P, float R);
+	void					build_hash	();
 	void					read		( INetReader	&r );
 	void					write		( IWriter	&w ) const ;
 };
@@ -52,11 +52,111 @@ void CDeflector::L_Direct_Edge (CDB::COLLIDER* DB, base_lighting* LightsSelected
 	}
 }
 
-void CDeflector::L_Direct	(CDB::COLLIDER* DB, base_lighting* LightsSelected, HASH& H)
+// Texel lighting modes:
+//	default		- shadow rays are gathered per lightmap row and traced in packets
+//	-lm_scalar	- texel by texel, ray by ray (the old path)
+//	-lm_compare	- both, the results are compared and the timings are reported
+enum
 {
-	R_ASSERT	(DB);
-	R_ASSERT	(LightsSelected);
+	lmt_packets		= 0,
+	lmt_scalar,
+	lmt_compare,
+};
+
+static u32 lightmap_trace_mode()
+{
+	static u32	mode	= u32(-1);
+	if (mode==u32(-1))
+	{
+		if (strstr(Core.Params,"-lm_compare"))		mode	= lmt_compare;
+		else if (strstr(Core.Params,"-lm_scalar"))	mode	= lmt_scalar;
+		else										mode	= lmt_packets;
+	}
+	return		mode;
+}
+
+static struct lightmap_trace_stats
+{
+	xrCriticalSection	lock;
+	float				time_packets;		// thread seconds
+	float				time_scalar;
+	u32					texels;
+	u32					texels_diff;		// marker mismatch
+	double				sum_rgb, sum_sun, sum_hemi;
+	float				max_rgb, max_sun, max_hemi;
+
+	lightmap_trace_stats	()
+	{
+		time_packets	= time_scalar	= 0;
+		texels			= texels_diff	= 0;
+		sum_rgb			= sum_sun		= sum_hemi	= 0;
+		max_rgb			= max_sun		= max_hemi	= 0;
+	}
+} lm_trace_stats;
+
+void LightmapTraceReport()
+{
+	lightmap_trace_stats&	S	= lm_trace_stats;
+	switch (lightmap_trace_mode())
+	{
+	case lmt_packets:
+		clMsg	("* Lightmap texels: packet tracing, %3.2f s (sum over threads)",S.time_packets);
+		break;
+	case lmt_scalar:
+		clMsg	("* Lightmap texels: scalar tracing, %3.2f s (sum over threads)",S.time_scalar);
+		break;
+	case lmt_compare:
+		{
+			float	n	= float(_max(S.texels,1u));
+			clMsg	("* Lightmap texels: scalar %3.2f s, packets %3.2f s (sum over threads), speedup %2.2fx",
+				S.time_scalar,S.time_packets,S.time_packets>0?S.time_scalar/S.time_packets:0.f);
+			clMsg	("* Lightmap texels: %d compared, %d with different coverage",S.texels,S.texels_diff);
+			clMsg	("* Lightmap deviation: rgb max %f mean %f, sun max %f mean %f, hemi max %f mean %f",
+				S.max_rgb,float(S.sum_rgb/n),S.max_sun,float(S.sum_sun/n),S.max_hemi,float(S.sum_hemi/n));
+		}
+		break;
+	}
+}
+
+static void lightmap_trace_compare(const lm_layer& scalar, const lm_layer& packets, float time_scalar, float time_packets)
+{
+	u32		texels		= 0, texels_diff = 0;
+	double	sum_rgb		= 0, sum_sun = 0, sum_hemi = 0;
+	float	max_rgb		= 0, max_sun = 0, max_hemi = 0;
+	for (u32 it=0; it<scalar.surface.size(); it++)
+	{
+		if (scalar.marker[it]!=packets.marker[it])	{ texels_diff++; continue; }
+		if (!scalar.marker[it])						continue;
 
+		base_color_c	A,B;
+		scalar.surface[it]._get		(A);
+		packets.surface[it]._get	(B);
+		float	d_rgb	= _max(_abs(A.rgb.x-B.rgb.x),_max(_abs(A.rgb.y-B.rgb.y),_abs(A.rgb.z-B.rgb.z)));
+		float	d_sun	= _abs(A.sun-B.sun);
+		float	d_hemi	= _abs(A.hemi-B.hemi);
+		max_rgb			= _max(max_rgb,d_rgb);		sum_rgb		+= d_rgb;
+		max_sun			= _max(max_sun,d_sun);		sum_sun		+= d_sun;
+		max_hemi		= _max(max_hemi,d_hemi);	sum_hemi	+= d_hemi;
+		texels			++;
+	}
+
+	lightmap_trace_stats&	S	= lm_trace_stats;
+	S.lock.Enter		();
+	S.time_scalar		+= time_scalar;
+	S.time_packets		+= time_packets;
+	S.texels			+= texels;
+	S.texels_diff		+= texels_diff;
+	S.sum_rgb			+= sum_rgb;
+	S.sum_sun			+= sum_sun;
+	S.sum_hemi			+= sum_hemi;
+	S.max_rgb			= _max(S.max_rgb,max_rgb);
+	S.max_sun			= _max(S.max_sun,max_sun);
+	S.max_hemi			= _max(S.max_hemi,max_hemi);
+	S.lock.Leave		();
+}
+
+void CDeflector::L_Direct_Texels	(CDB::COLLIDER* DB, base_lighting* LightsSelected, HASH& H)
+{
 	lm_layer&	lm = layer;
 
 	// Setup variables
@@ -139,6 +239,146 @@ void CDeflector::L_Direct	(CDB::COLLIDER* DB, base_lighting* LightsSelected, HAS
 			}
 		}
 	}
+}
+
+void CDeflector::L_Direct_Packets	(CDB::COLLIDER* DB, base_lighting* LightsSelected, HASH& H)
+{
+	lm_layer&	lm = layer;
+
+	// Setup variables
+	Fvector2	dim,half;
+	dim.set		(float(lm.width),float(lm.height));
+	half.set	(.5f/dim.x,.5f/dim.y);
+	
+	// Jitter data
+	Fvector2	JS;
+	JS.set		(.4999f/dim.x, .4999f/dim.y);
+	
+	u32			Jcount;
+	Fvector2*	Jitter;
+	Jitter_Select(Jitter, Jcount);
+
+	VERIFY(inlc_global_data());
+	VERIFY(inlc_global_data()->RCAST_Model());
+	CDB::MODEL*	MDL		= inlc_global_data()->RCAST_Model();
+	u32			flags	= (inlc_global_data()->b_nosun()?LP_dont_sun:0)|LP_UseFaceDisable;
+
+	// Samples of a whole row are lit together
+	xr_vector<light_sample>	samples;
+	xr_vector<u32>			counts	(lm.width);
+	samples.reserve			(lm.width*Jcount);
+	
+	for (u32 V=0; V<lm.height; V++)	{
+		if(_net_session && !_net_session->test_connection())
+			 return;
+
+		samples.clear_not_free	();
+		for (u32 U=0; U<lm.width; U++)	{
+			counts[U]	= 0;
+			for (u32 J=0; J<Jcount; J++) 
+			{
+				// LUMEL space
+				Fvector2 P;
+				P.x = float(U)/dim.x + half.x + Jitter[J].x * JS.x;
+				P.y = float(V)/dim.y + half.y + Jitter[J].y * JS.y;
+				
+				xr_vector<UVtri*>&	space	= H.query(P.x,P.y);
+				
+				// World space
+				Fvector		B;
+				for (UVtri** it=&*space.begin(); it!=&*space.end(); it++)
+				{
+					if ((*it)->isInside(P,B)) {
+						// We found triangle and have barycentric coords
+						Face	*F	= (*it)->owner;
+						Vertex	*V1 = F->v[0];
+						Vertex	*V2 = F->v[1];
+						Vertex	*V3 = F->v[2];
+
+						samples.push_back	(light_sample());
+						light_sample&	S	= samples.back();
+						S.P.from_bary	(V1->P,V2->P,V3->P,B);
+						S.N.from_bary	(V1->N,V2->N,V3->N,B);	exact_normalize	(S.N); 
+						S.N.add			(F->N);					exact_normalize	(S.N);
+						S.skip			= F;
+						counts[U]		++;
+						break;
+					}
+				}
+			}
+		}
+
+		try {
+			if (!samples.empty())
+				LightPoints	(DB, MDL, &*samples.begin(), samples.size(), *LightsSelected, flags);
+		} catch (...) {
+			clMsg("* ERROR (CDB). Recovered. ");
+		}
+
+		light_sample*	S	= samples.empty() ? 0 : &*samples.begin();
+		for (u32 U=0; U<lm.width; U++)	{
+			u32				Fcount	= counts[U];
+			base_color_c	C;
+			for (u32 it=0; it<Fcount; it++, S++)
+				C.add		(S->C);
+
+			if (Fcount) {
+				C.scale			(Fcount);
+				C.mul			(.5f);
+				lm.surface		[V*lm.width+U]._set(C);
+				lm.marker		[V*lm.width+U] = 255;
+			} else {
+				lm.surface		[V*lm.width+U]._set(C);	// 0-0-0-0-0
+				lm.marker		[V*lm.width+U] = 0;
+			}
+		}
+	}
+}
+
+void CDeflector::L_Direct	(CDB::COLLIDER* DB, base_lighting* LightsSelected, HASH& H)
+{
+	R_ASSERT	(DB);
+	R_ASSERT	(LightsSelected);
+
+	lm_layer&	lm = layer;
+
+	CTimer		T;
+	switch (lightmap_trace_mode())
+	{
+	case lmt_packets:
+		T.Start			();
+		L_Direct_Packets(DB,LightsSelected,H);
+		lm_trace_stats.lock.Enter	();
+		lm_trace_stats.time_packets	+= T.GetElapsed_sec();
+		lm_trace_stats.lock.Leave	();
+		break;
+	case lmt_scalar:
+		T.Start			();
+		L_Direct_Texels	(DB,LightsSelected,H);
+		lm_trace_stats.lock.Enter	();
+		lm_trace_stats.time_scalar	+= T.GetElapsed_sec();
+		lm_trace_stats.lock.Leave	();
+		break;
+	case lmt_compare:
+		{
+			T.Start			();
+			L_Direct_Texels	(DB,LightsSelected,H);
+			float	time_scalar		= T.GetElapsed_sec();
+			lm_layer		scalar;
+			scalar.width	= lm.width;
+			scalar.height	= lm.height;
+			scalar.surface	= lm.surface;
+			scalar.marker	= lm.marker;
+
+			T.Start			();
+			L_Direct_Packets(DB,LightsSelected,H);
+			float	time_packets	= T.GetElapsed_sec();
+
+			lightmap_trace_compare	(scalar,lm,time_scalar,time_packets);
+		}
+		break;
+	}
+
 	// *** Render Edges
 	float texel_size = (1.f/float(_max(lm.width,lm.height)))/8.f;
 	for (u32 t=0; t<UVpolys.size(); t++)
@@ -42,6 +42,8 @@ static	CDeflector*		read_create					();
 		
 	void	Light				(CDB::COLLIDER* DB, base_lighting* LightsSelected, HASH& H	);
 	void	L_Direct			(CDB::COLLIDER* DB, base_lighting* LightsSelected, HASH& H  );
+	void	L_Direct_Texels		(CDB::COLLIDER* DB, base_lighting* LightsSelected, HASH& H  );
+	void	L_Direct_Packets	(CDB::COLLIDER* DB, base_lighting* LightsSelected, HASH& H  );
 	void	L_Direct_Edge		(CDB::COLLIDER* DB, base_lighting* LightsSelected, Fvector2& p1, Fvector2& p2, Fvector& v1, Fvector& v2, Fvector& N, float texel_size, Face* skip);
 	void	L_Calculate			(CDB::COLLIDER* DB, base_lighting* LightsSelected, HASH& H  );
 	u32		weight				() { return layer.Area(); }	
@@ -96,6 +98,16 @@ extern void		blit_r			(u32* dest,		u32 ds_x, u32 ds_y, u32* src,		u32 ss_x, u32
 extern XRLC_LIGHT_API void		blit_r			(lm_layer& dst, u32 ds_x, u32 ds_y, lm_layer& src,	u32 ss_x, u32 ss_y, u32 px, u32 py, u32 aREF);
 extern void		lblit			(lm_layer& dst, lm_layer& src, u32 px, u32 py, u32 aREF);
 extern XRLC_LIGHT_API void		LightPoint		(CDB::COLLIDER* DB, CDB::MODEL* MDL, base_color_c &C, Fvector &P, Fvector &N, base_lighting& lights, u32 flags, Face* skip);
+
+struct light_sample
+{
+	Fvector			P;
+	Fvector			N;
+	Face*			skip;
+	base_color_c	C;			// accumulated
+};
+extern XRLC_LIGHT_API void		LightPoints		(CDB::COLLIDER* DB, CDB::MODEL* MDL, light_sample* samples, u32 count, base_lighting& lights, u32 flags);
+extern XRLC_LIGHT_API void		LightmapTraceReport	();
 extern XRLC_LIGHT_API BOOL		ApplyBorders	(lm_layer &lm, u32 ref);
 extern XRLC_LIGHT_API void		DumpDeflctor	( u32 id );
 extern XRLC_LIGHT_API void		DumpDeflctor	( const CDeflector &d );
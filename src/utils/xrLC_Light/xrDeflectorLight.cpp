@@ -347,11 +347,47 @@ BOOL ApplyBorders( lm_layer &lm, u32 ref )
 }
 
 
+// opacity factor of an alpha-tested polygon at the hit point
+IC float getRP_Opacity(const CDB::RESULT& rpinf, base_Face* F)
+{
+	b_material& M	= inlc_global_data()->materials()			[F->dwMaterial];
+	b_texture&	T	= inlc_global_data()->textures()			[M.surfidx];
+#ifdef		DEBUG
+	const b_BuildTexture	&build_texture  = inlc_global_data()->textures()			[M.surfidx];
+
+	VERIFY( !!(build_texture.THM.HasSurface()) ==  !!(T.pSurface) );
+#endif
+	if (0==T.pSurface)	{
+		F->flags.bOpaque	= true;
+		clMsg			("* ERROR: RAY-TRACE: Strange face detected... Has alpha without texture...");
+		return 0;
+	}
+
+	// barycentric coords
+	// note: W,U,V order
+	Fvector B;
+	B.set	(1.0f - rpinf.u - rpinf.v,rpinf.u,rpinf.v);
+
+	// calc UV
+	Fvector2*	cuv = F->getTC0					();
+	Fvector2	uv;
+	uv.x = cuv[0].x*B.x + cuv[1].x*B.y + cuv[2].x*B.z;
+	uv.y = cuv[0].y*B.x + cuv[1].y*B.y + cuv[2].y*B.z;
+
+	int U = iFloor(uv.x*float(T.dwWidth) + .5f);
+	int V = iFloor(uv.y*float(T.dwHeight)+ .5f);
+	U %= T.dwWidth;		if (U<0) U+=T.dwWidth;
+	V %= T.dwHeight;	if (V<0) V+=T.dwHeight;
+
+	u32 pixel		= T.pSurface[V*T.dwWidth+U];
+	u32 pixel_a		= color_get_A(pixel);
+	return			1.f - _sqr(float(pixel_a)/255.f);
+}
+
 float getLastRP_Scale(CDB::COLLIDER* DB, CDB::MODEL* MDL, R_Light& L, Face* skip, BOOL bUseFaceDisable)
 {
 	u32		tris_count	= DB->r_count();
 	float	scale		= 1.f;
-	Fvector B;
 
 	X_TRY 
 	{
@@ -376,37 +412,8 @@ float getLastRP_Scale(CDB::COLLIDER* DB, CDB::MODEL* MDL, R_Light& L, Face* skip
 				return 0;
 			}
 
-			b_material& M	= inlc_global_data()->materials()			[F->dwMaterial];
-			b_texture&	T	= inlc_global_data()->textures()			[M.surfidx];
-#ifdef		DEBUG
-			const b_BuildTexture	&build_texture  = inlc_global_data()->textures()			[M.surfidx];
-
-			VERIFY( !!(build_texture.THM.HasSurface()) ==  !!(T.pSurface) );
-#endif
-			if (0==T.pSurface)	{
-				F->flags.bOpaque	= true;
-				clMsg			("* ERROR: RAY-TRACE: Strange face detected... Has alpha without texture...");
-				return 0;
-			}
-
-			// barycentric coords
-			// note: W,U,V order
-			B.set	(1.0f - rpinf.u - rpinf.v,rpinf.u,rpinf.v);
-
-			// calc UV
-			Fvector2*	cuv = F->getTC0					();
-			Fvector2	uv;
-			uv.x = cuv[0].x*B.x + cuv[1].x*B.y + cuv[2].x*B.z;
-			uv.y = cuv[0].y*B.x + cuv[1].y*B.y + cuv[2].y*B.z;
-
-			int U = iFloor(uv.x*float(T.dwWidth) + .5f);
-			int V = iFloor(uv.y*float(T.dwHeight)+ .5f);
-			U %= T.dwWidth;		if (U<0) U+=T.dwWidth;
-			V %= T.dwHeight;	if (V<0) V+=T.dwHeight;
-
-			u32 pixel		= T.pSurface[V*T.dwWidth+U];
-			u32 pixel_a		= color_get_A(pixel);
-			float opac		= 1.f - _sqr(float(pixel_a)/255.f);
+			float opac		= getRP_Opacity(rpinf,F);
+			if (F->flags.bOpaque)	return 0;
 			scale			*= opac;
 		}
 	} 
@@ -606,6 +613,291 @@ void LightPoint(CDB::COLLIDER* DB, CDB::MODEL* MDL, base_color_c &C, Fvector &P,
 	}
 }
 
+// Batched version of LightPoint: shadow rays of all the samples go through the
+// collision tree in packets (CDB::COLLIDER::ray_packet_query). The shading is
+// the same as in LightPoint; secondary lights are jittered per ray, so they are
+// still traced one by one.
+struct shadow_ray
+{
+	Fvector		P;
+	Fvector		D;
+	float		R;
+	u32			sample;
+	float		cosine;
+	float		sqD;
+	float		T;			// transmission, 0 - occluded
+};
+
+struct shadow_packet
+{
+	R_Light*	light;
+	shadow_ray*	rays;
+	u32*		index;		// packet ray -> shadow ray
+	Face**		skip;		// per sample
+};
+
+static u32 shadow_filter(const CDB::RESULT& R, u32 ray, void* param)
+{
+	shadow_packet&	S	= *((shadow_packet*)param);
+	base_Face*		F	= (base_Face*)(*((void**)&R.dummy));
+	if (0==F)										return CDB::RP_IGNORE;
+	if (S.skip[S.rays[S.index[ray]].sample]==F)	return CDB::RP_IGNORE;
+	if (!F->Shader().flags.bLIGHT_CastShadow)		return CDB::RP_IGNORE;
+	if (F->flags.bOpaque)	{
+		// Opaque poly - cache it
+		S.light->tri[0].set	(R.verts[0]);
+		S.light->tri[1].set	(R.verts[1]);
+		S.light->tri[2].set	(R.verts[2]);
+		return				CDB::RP_OCCLUDE;
+	}
+	return					CDB::RP_RECORD;
+}
+
+static void rayTracePackets(CDB::COLLIDER* DB, CDB::MODEL* MDL, R_Light& L, shadow_ray* rays, u32 count, Face** skip)
+{
+	CDB::ray_packet	P;
+	u32				index	[CDB::ray_packet::max_rays];
+	shadow_packet	S;
+	S.light			= &L;
+	S.rays			= rays;
+	S.index			= index;
+	S.skip			= skip;
+	P.count			= 0;
+
+	for (u32 it=0; it<=count; it++)
+	{
+		if (it<count)
+		{
+			shadow_ray&	r	= rays[it];
+			r.T				= 1.f;
+
+			// 1. Check cached polygon
+			float _u,_v,range;
+			if (CDB::TestRayTri(r.P,r.D,L.tri,_u,_v,range,false) && (range>0) && (range<r.R))	{
+				r.T			= 0;
+				continue;
+			}
+
+			index[P.count]	= it;
+			P.start	[P.count].set	(r.P);
+			P.dir	[P.count].set	(r.D);
+			P.range	[P.count]		= r.R;
+			if (++P.count<CDB::ray_packet::max_rays)	continue;
+		}
+		if (0==P.count)		continue;
+
+		// 2. Trace the packet, opaque hits stop the rays
+		u32 stopped		= DB->ray_packet_query(MDL,P,shadow_filter,&S);
+		for (u32 k=0; k<P.count; k++)
+			if (stopped&(1<<k))	rays[index[k]].T = 0;
+
+		// 3. Alpha-tested polygons, in bulk
+		CDB::RESULT*	H	= DB->r_begin();
+		int				Hc	= DB->r_count();
+		for (int h=0; h<Hc; h++)
+		{
+			shadow_ray&	r	= rays[index[DB->r_ray(h)]];
+			if (r.T<=0)		continue;
+			r.T				*= getRP_Opacity(H[h],(base_Face*)(*((void**)&H[h].dummy)));
+		}
+		P.count			= 0;
+	}
+}
+
+// gathers shadow rays of a directional light
+static void collect_direct(xr_vector<shadow_ray>& rays, light_sample* S, u32 count, R_Light& L, float offset)
+{
+	Fvector		Ldir;
+	Ldir.invert	(L.direction);
+	rays.clear_not_free	();
+	for (u32 s=0; s<count; s++)
+	{
+		float D		= Ldir.dotproduct( S[s].N );
+		if( D <=0 ) continue;
+
+		rays.push_back		(shadow_ray());
+		shadow_ray&	r	= rays.back();
+		r.P.mad		(S[s].P,S[s].N,0.01f);
+		if (offset>0)	r.P.mad	(Ldir,offset);
+		r.D.set		(Ldir);
+		r.R			= 1000.f;
+		r.sample	= s;
+		r.cosine	= D;
+		r.sqD		= 0;
+	}
+}
+
+// gathers shadow rays of a point light
+static void collect_point(xr_vector<shadow_ray>& rays, light_sample* S, u32 count, R_Light& L)
+{
+	rays.clear_not_free	();
+	for (u32 s=0; s<count; s++)
+	{
+		// Distance
+		float sqD	=	S[s].P.distance_to_sqr	(L.position);
+		if (sqD > L.range2) continue;
+
+		// Dir
+		Fvector		Ldir;
+		Ldir.sub			(L.position,S[s].P);
+		Ldir.normalize_safe	();
+		float D				= Ldir.dotproduct( S[s].N );
+		if( D <=0 )			continue;
+
+		rays.push_back		(shadow_ray());
+		shadow_ray&	r	= rays.back();
+		r.P.mad		(S[s].P,S[s].N,0.01f);
+		r.D.set		(Ldir);
+		r.R			= _sqrt(sqD);
+		r.sample	= s;
+		r.cosine	= D;
+		r.sqD		= sqD;
+	}
+}
+
+void LightPoints(CDB::COLLIDER* DB, CDB::MODEL* MDL, light_sample* S, u32 count, base_lighting& lights, u32 flags)
+{
+	if (0==count)		return;
+
+	xr_vector<shadow_ray>	rays;
+	xr_vector<Face*>		skip	(count);
+	rays.reserve			(count);
+	for (u32 s=0; s<count; s++)
+		skip[s]				= S[s].skip;
+
+	BOOL		bUseFaceDisable	= flags&LP_UseFaceDisable;
+
+	DB->ray_options	(0);
+	if (0==(flags&LP_dont_rgb))
+	{
+		R_Light	*L	= &*lights.rgb.begin(), *E = &*lights.rgb.end();
+		for (;L!=E; L++)
+		{
+			switch (L->type)
+			{
+			case LT_DIRECT:
+				{
+					collect_direct	(rays,S,count,*L,0);
+					if (rays.empty())	continue;
+					rayTracePackets	(DB,MDL,*L,&*rays.begin(),rays.size(),&*skip.begin());
+					for (u32 it=0; it<rays.size(); it++)
+					{
+						shadow_ray&	r	= rays[it];
+						float scale	=	r.cosine*L->energy*r.T;
+						base_color_c&	C	= S[r.sample].C;
+						C.rgb.x		+=	scale * L->diffuse.x; 
+						C.rgb.y		+=	scale * L->diffuse.y;
+						C.rgb.z		+=	scale * L->diffuse.z;
+					}
+				}
+				break;
+			case LT_POINT:
+				{
+					collect_point	(rays,S,count,*L);
+					if (rays.empty())	continue;
+					rayTracePackets	(DB,MDL,*L,&*rays.begin(),rays.size(),&*skip.begin());
+					for (u32 it=0; it<rays.size(); it++)
+					{
+						shadow_ray&	r	= rays[it];
+						float scale = r.cosine*L->energy*r.T;
+						float A		;
+						if ( inlc_global_data()->gl_linear() )
+							A	= 1-r.R/L->range;
+						else
+						{
+							//	Igor: let A equal 0 at the light boundary
+							A	= scale * 
+								(
+									1/(L->attenuation0 + L->attenuation1*r.R + L->attenuation2*r.sqD) - 
+									r.R*L->falloff
+								);
+						}
+
+						base_color_c&	C	= S[r.sample].C;
+						C.rgb.x += A * L->diffuse.x;
+						C.rgb.y += A * L->diffuse.y;
+						C.rgb.z += A * L->diffuse.z;
+					}
+				}
+				break;
+			case LT_SECONDARY:
+				{
+					for (u32 s=0; s<count; s++)
+					{
+						Fvector&	P	= S[s].P;
+						Fvector&	N	= S[s].N;
+						Fvector		Ldir,Pnew;
+						Pnew.mad	(P,N,0.01f);
+
+						// Distance
+						float sqD	=	P.distance_to_sqr	(L->position);
+						if (sqD > L->range2) continue;
+
+						// Dir
+						Ldir.sub	(L->position,P);
+						Ldir.normalize_safe();
+						float	D	=	Ldir.dotproduct		( N );
+						if( D <=0 ) continue;
+								D	*=	-Ldir.dotproduct	(L->direction);
+						if( D <=0 ) continue;
+
+						// Jitter + trace light -> monte-carlo method
+						Fvector	Psave	= L->position, Pdir;
+						L->position.mad	(Pdir.random_dir(L->direction,PI_DIV_4),.05f);
+						float R			= _sqrt(sqD);
+						float scale		= powf(D, 1.f/8.f)*L->energy*rayTrace(DB,MDL, *L,Pnew,Ldir,R,S[s].skip,bUseFaceDisable);
+						float A			= scale * (1-R/L->range);
+						L->position		= Psave;
+
+						S[s].C.rgb.x += A * L->diffuse.x;
+						S[s].C.rgb.y += A * L->diffuse.y;
+						S[s].C.rgb.z += A * L->diffuse.z;
+					}
+				}
+				break;
+			}
+		}
+	}
+	if (0==(flags&LP_dont_sun))
+	{
+		R_Light	*L		= &*(lights.sun.begin()), *E = &*(lights.sun.end());
+		for (;L!=E; L++)
+		{
+			if (L->type==LT_DIRECT)	collect_direct	(rays,S,count,*L,0);
+			else					collect_point	(rays,S,count,*L);
+			if (rays.empty())		continue;
+			rayTracePackets			(DB,MDL,*L,&*rays.begin(),rays.size(),&*skip.begin());
+			for (u32 it=0; it<rays.size(); it++)
+			{
+				shadow_ray&	r	= rays[it];
+				if (L->type==LT_DIRECT)
+					S[r.sample].C.sun	+=	L->energy*r.T;
+				else
+					S[r.sample].C.sun	+=	r.cosine*L->energy*r.T / (L->attenuation0 + L->attenuation1*r.R + L->attenuation2*r.sqD);
+			}
+		}
+	}
+	if (0==(flags&LP_dont_hemi))
+	{
+		R_Light	*L	= &*lights.hemi.begin(), *E = &*lights.hemi.end();
+		for (;L!=E; L++)
+		{
+			if (L->type==LT_DIRECT)	collect_direct	(rays,S,count,*L,0.001f);
+			else					collect_point	(rays,S,count,*L);
+			if (rays.empty())		continue;
+			rayTracePackets			(DB,MDL,*L,&*rays.begin(),rays.size(),&*skip.begin());
+			for (u32 it=0; it<rays.size(); it++)
+			{
+				shadow_ray&	r	= rays[it];
+				if (L->type==LT_DIRECT)
+					S[r.sample].C.hemi	+=	L->energy*r.T;
+				else
+					S[r.sample].C.hemi	+=	r.cosine*L->energy*r.T / (L->attenuation0 + L->attenuation1*r.R + L->attenuation2*r.sqD);
+			}
+		}
+	}
+}
+
 IC u32	rms_diff	(u32 a, u32 b)
 {
 	if (a>b)	return a-b;
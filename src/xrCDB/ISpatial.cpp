@@ -148,6 +148,7 @@ ISpatial_DB::ISpatial_DB()
 #endif // PROFILE_CRITICAL_SECTIONS
 {
 	m_root					= NULL;
+	q_readers				= 0;
 	stat_nodes				= 0;
 	stat_objects			= 0;
 }
@@ -254,6 +255,7 @@ void			ISpatial_DB::_insert	(ISpatial_NODE* N, Fvector& n_C, float n_R)
 void			ISpatial_DB::insert		(ISpatial* S)
 {
 	cs.Enter			();
+	wait_readers		();
 #ifdef DEBUG
 	stat_insert.Begin	();
 
@@ -314,6 +316,7 @@ void			ISpatial_DB::_remove	(ISpatial_NODE* N, ISpatial_NODE* N_sub)
 void			ISpatial_DB::remove		(ISpatial* S)
 {
 	cs.Enter			();
+	wait_readers		();
 #ifdef DEBUG
 	stat_remove.Begin	();
 #endif
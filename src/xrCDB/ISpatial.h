@@ -152,7 +152,12 @@ public:
 class XRCDB_API	ISpatial_DB
 {
 private:
+	// q_ray walks the tree holding a reader count only, so the rays of several
+	// threads go in parallel; insert and remove wait under cs for the readers
+	// to leave, and a reader waits on cs for the writer
 	xrCriticalSection				cs;
+	volatile LONG					q_readers;
+	IC void							wait_readers	()	{ while (q_readers) SwitchToThread();	}
 
 	poolSS< ISpatial_NODE, 128 >	allocator;
 
@@ -179,9 +179,9 @@ public:
 	u32				mask;
 	float			range;
 	float			range2;
-	ISpatial_DB*	space;
+	xr_vector<ISpatial*>*	result;
 public:
-	walker					(ISpatial_DB*	_space, u32 _mask, const Fvector& _start, const Fvector&	_dir, float _range)
+	walker					(xr_vector<ISpatial*>*	_result, u32 _mask, const Fvector& _start, const Fvector&	_dir, float _range)
 	{
 		mask			= _mask;
 		ray.pos.set		(_start);
@@ -195,7 +195,7 @@ public:
 		}
 		range	= _range;
 		range2	= _range*_range;
-		space	= _space;
+		result	= _result;
 	}
 	// fpu
 	ICF BOOL		_box_fpu	(const Fvector& n_C, const float n_R, Fvector& coord)
@@ -260,7 +260,7 @@ public:
 					}
 					range2			=range*range; 
 				}
-				space->q_result->push_back	(S);
+				result->push_back			(S);
 				if (b_first)				return;
 			}
 		}
@@ -272,35 +272,38 @@ public:
 			if (0==N->children[octant])	continue;
 			Fvector		c_C;			c_C.mad	(n_C,c_spatial_offset[octant],c_R);
 			walk						(N->children[octant],c_C,c_R);
-			if (b_first && !space->q_result->empty())	return;
+			if (b_first && !result->empty())	return;
 		}
 	}
 };
 
 void	ISpatial_DB::q_ray	(xr_vector<ISpatial*>& R, u32 _o, u32 _mask_and, const Fvector&	_start,  const Fvector&	_dir, float _range)
 {
+	// a reader: no writer inside, then the tree is only read
 	cs.Enter						();
-	q_result						= &R;
-	q_result->clear_not_free		();
+	InterlockedIncrement			(&q_readers);
+	cs.Leave						();
+
+	R.clear_not_free				();
 	if (CPU::ID.hasFeature(CPUFeature::SSE))	
 	{
 		if (_o & O_ONLYFIRST)
 		{
-			if (_o & O_ONLYNEAREST)		{ walker<true,true,true>	W(this,_mask_and,_start,_dir,_range);	W.walk(m_root,m_center,m_bounds); } 
-			else						{ walker<true,true,false>	W(this,_mask_and,_start,_dir,_range);	W.walk(m_root,m_center,m_bounds); } 
+			if (_o & O_ONLYNEAREST)		{ walker<true,true,true>	W(&R,_mask_and,_start,_dir,_range);	W.walk(m_root,m_center,m_bounds); } 
+			else						{ walker<true,true,false>	W(&R,_mask_and,_start,_dir,_range);	W.walk(m_root,m_center,m_bounds); } 
 		} else {
-			if (_o & O_ONLYNEAREST)		{ walker<true,false,true>	W(this,_mask_and,_start,_dir,_range);	W.walk(m_root,m_center,m_bounds); } 
-			else						{ walker<true,false,false>	W(this,_mask_and,_start,_dir,_range);	W.walk(m_root,m_center,m_bounds); } 
+			if (_o & O_ONLYNEAREST)		{ walker<true,false,true>	W(&R,_mask_and,_start,_dir,_range);	W.walk(m_root,m_center,m_bounds); } 
+			else						{ walker<true,false,false>	W(&R,_mask_and,_start,_dir,_range);	W.walk(m_root,m_center,m_bounds); } 
 		}
 	} else {
 		if (_o & O_ONLYFIRST)
 		{
-			if (_o & O_ONLYNEAREST)		{ walker<false,true,true>	W(this,_mask_and,_start,_dir,_range);	W.walk(m_root,m_center,m_bounds); } 
-			else						{ walker<false,true,false>	W(this,_mask_and,_start,_dir,_range);	W.walk(m_root,m_center,m_bounds); } 
+			if (_o & O_ONLYNEAREST)		{ walker<false,true,true>	W(&R,_mask_and,_start,_dir,_range);	W.walk(m_root,m_center,m_bounds); } 
+			else						{ walker<false,true,false>	W(&R,_mask_and,_start,_dir,_range);	W.walk(m_root,m_center,m_bounds); } 
 		} else {
-			if (_o & O_ONLYNEAREST)		{ walker<false,false,true>	W(this,_mask_and,_start,_dir,_range);	W.walk(m_root,m_center,m_bounds); } 
-			else						{ walker<false,false,false>	W(this,_mask_and,_start,_dir,_range);	W.walk(m_root,m_center,m_bounds); } 
+			if (_o & O_ONLYNEAREST)		{ walker<false,false,true>	W(&R,_mask_and,_start,_dir,_range);	W.walk(m_root,m_center,m_bounds); } 
+			else						{ walker<false,false,false>	W(&R,_mask_and,_start,_dir,_range);	W.walk(m_root,m_center,m_bounds); } 
 		}
 	}
-	cs.Leave		();
+	InterlockedDecrement			(&q_readers);
 }
@@ -261,3 +261,26 @@ bool OPCODE_Model::Build(const OPCODECREATE& create)
 #endif // __MESHMERIZER_H__
 	return true;
 }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Creates a non-quantized no-leaf model from externally built nodes.
+ *	\param		nodes		[in] CALLOC'ed nodes, ownership is taken
+ *	\param		nb_nodes	[in] number of nodes (N-1)
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool OPCODE_Model::Adopt(AABBNoLeafNode* nodes, udword nb_nodes)
+{
+	if(!nodes || !nb_nodes)	return false;
+
+	CDELETE			(mTree);
+	mNoLeaf			= true;
+	mQuantized		= false;
+
+	AABBNoLeafTree*	T	= CNEW(AABBNoLeafTree)();
+	CHECKALLOC		(T);
+	T->Adopt		(nodes,nb_nodes);
+	mTree			= T;
+	return true;
+}
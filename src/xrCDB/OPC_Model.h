@@ -55,6 +55,16 @@
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 						bool				Build(const OPCODECREATE& create);
 
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Creates a non-quantized no-leaf model from externally built nodes.
+		 *	\param		nodes		[in] CALLOC'ed nodes, ownership is taken
+		 *	\param		nb_nodes	[in] number of nodes (N-1)
+		 *	\return		true if success
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+						bool				Adopt(AABBNoLeafNode* nodes, udword nb_nodes);
+
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		/**
 		 *	A method to access the tree.
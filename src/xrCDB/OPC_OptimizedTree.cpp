@@ -270,6 +270,20 @@ AABBNoLeafTree::~AABBNoLeafTree()
 	CFREE(mNodes);
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Takes ownership of nodes built outside of OPCODE (SAH builder, cache file).
+ *	\param		nodes			[in] CALLOC'ed nodes, root first, children linked by pointers
+ *	\param		nb_nodes		[in] number of nodes
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void AABBNoLeafTree::Adopt(AABBNoLeafNode* nodes, udword nb_nodes)
+{
+	CFREE(mNodes);
+	mNodes		= nodes;
+	mNbNodes	= nb_nodes;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Builds the collision tree from a generic AABB tree.
@@ -148,6 +148,10 @@
 	class OPCODE_API AABBNoLeafTree : public AABBOptimizedTree
 	{
 		IMPLEMENT_COLLISION_TREE(AABBNoLeafTree, AABBNoLeafNode)
+
+		public:
+		/* Takes ownership of externally built nodes (CALLOC'ed, root first) */
+						void				Adopt(AABBNoLeafNode* nodes, udword nb_nodes);
 	};
 
 	class OPCODE_API AABBQuantizedTree : public AABBOptimizedTree
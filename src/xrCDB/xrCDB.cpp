@@ -66,6 +66,7 @@ struct	BTHREAD_params
 	int					Tcnt;
 	build_callback*		BC;
 	void*				BCP;
+	u32					mode;
 };
 
 void	MODEL::build_thread		(void *params)
@@ -74,35 +75,35 @@ void	MODEL::build_thread		(void *params)
 	FPU::m64r					();
 	BTHREAD_params	P			= *( (BTHREAD_params*)params );
 	P.M->cs.Enter				();
-	P.M->build_internal			(P.V,P.Vcnt,P.T,P.Tcnt,P.BC,P.BCP);
+	P.M->build_internal			(P.V,P.Vcnt,P.T,P.Tcnt,P.BC,P.BCP,P.mode);
 	P.M->status					= S_READY;
 	P.M->cs.Leave				();
 	//Msg						("* xrCDB: cform build completed, memory usage: %d K",P.M->memory()/1024);
 }
 
-void	MODEL::build			(Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callback* bc, void* bcp)
+void	MODEL::build			(Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callback* bc, void* bcp, u32 mode)
 {
 	R_ASSERT					(S_INIT == status);
     R_ASSERT					((Vcnt>=4)&&(Tcnt>=2));
 
 	_initialize_cpu_thread		();
 #ifdef _EDITOR    
-	build_internal				(V,Vcnt,T,Tcnt,bc,bcp);
+	build_internal				(V,Vcnt,T,Tcnt,bc,bcp,mode);
 #else
 	if(!strstr(Core.Params, "-mt_cdb"))
 	{
-		build_internal				(V,Vcnt,T,Tcnt,bc,bcp);
+		build_internal				(V,Vcnt,T,Tcnt,bc,bcp,mode);
 		status						= S_READY;
 	}else
 	{
-		BTHREAD_params				P = { this, V, Vcnt, T, Tcnt, bc, bcp };
+		BTHREAD_params				P = { this, V, Vcnt, T, Tcnt, bc, bcp, mode };
 		thread_spawn				(build_thread,"CDB-construction",0,&P);
 		while						(S_INIT	== status)	Sleep	(5);
 	}
 #endif
 }
 
-void	MODEL::build_internal	(Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callback* bc, void* bcp)
+void	MODEL::copy_source		(Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callback* bc, void* bcp)
 {
 	// verts
 	verts_count	= Vcnt;
@@ -116,9 +117,27 @@ void	MODEL::build_internal	(Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callba
 
 	// callback
 	if (bc)		bc	(verts,Vcnt,tris,Tcnt,bcp);
+}
+
+void	MODEL::build_internal	(Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callback* bc, void* bcp, u32 mode)
+{
+	copy_source	(V,Vcnt,T,Tcnt,bc,bcp);
 
 	// Release data pointers
 	status		= S_BUILD;
+
+	if ((build_sah==mode) && (tris_count>=2))
+	{
+		u32						nodes_count	= 0;
+		AABBNoLeafNode*			nodes		= build_tree_sah(nodes_count);
+		tree					= CNEW(OPCODE_Model) ();
+		if (tree->Adopt(nodes,nodes_count))
+			return;
+
+		// fall back to the standard build
+		CFREE		(nodes);
+		CDELETE		(tree);
+	}
 	
 	// Allocate temporary "OPCODE" tris + convert tris to 'pointer' form
 	u32*		temp_tris	= CALLOC(u32,tris_count*3);
@@ -159,6 +178,89 @@ void	MODEL::build_internal	(Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callba
 	return;
 }
 
+// Tree cache format:
+//   u32 magic, u32 version, u32 source_crc, u32 verts_count, u32 tris_count, u32 nodes_count
+//   nodes_count * { float center[3], float extents[3], u32 pos, u32 neg }
+// Children are stored as (node_index<<1) or (primitive<<1)|1, so the file
+// does not depend on the address or pointer size of the loading process.
+static const u32	cache_magic		= 0x45455254;	// "TREE"
+static const u32	cache_version	= 1;
+
+static u32	pack_child			(uintptr_t data, const AABBNoLeafNode* nodes)
+{
+	if (data&1)		return u32(data);
+	return			u32(((const AABBNoLeafNode*)data - nodes)<<1);
+}
+
+void MODEL::serialize	(IWriter& W, u32 source_crc) const
+{
+	R_ASSERT				(S_READY==status && tree);
+	const AABBNoLeafTree*	T		= (const AABBNoLeafTree*)tree->GetTree();
+	R_ASSERT				(!tree->HasLeafNodes() && !tree->IsQuantized());
+	const AABBNoLeafNode*	nodes	= T->GetNodes();
+	u32 const				count	= T->GetNbNodes();
+
+	W.w_u32					(cache_magic);
+	W.w_u32					(cache_version);
+	W.w_u32					(source_crc);
+	W.w_u32					(u32(verts_count));
+	W.w_u32					(u32(tris_count));
+	W.w_u32					(count);
+	for (u32 i=0; i<count; ++i)
+	{
+		const AABBNoLeafNode&	N	= nodes[i];
+		W.w					(&N.mAABB.mCenter,3*sizeof(float));
+		W.w					(&N.mAABB.mExtents,3*sizeof(float));
+		W.w_u32				(pack_child(N.mData,nodes));
+		W.w_u32				(pack_child(N.mData2,nodes));
+	}
+}
+
+bool MODEL::deserialize	(IReader& R, u32 source_crc, Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callback* bc, void* bcp)
+{
+	R_ASSERT				(S_INIT==status);
+	if (R.elapsed()<6*sizeof(u32))			return false;
+	if (R.r_u32()!=cache_magic)				return false;
+	if (R.r_u32()!=cache_version)			return false;
+	if (R.r_u32()!=source_crc)				return false;
+	if (R.r_u32()!=u32(Vcnt))				return false;
+	if (R.r_u32()!=u32(Tcnt))				return false;
+	u32 const				count	= R.r_u32();
+	if ((Tcnt<2) || (count!=u32(Tcnt-1)))	return false;
+	if (u32(R.elapsed())!=count*(6*sizeof(float)+2*sizeof(u32)))	return false;
+
+	AABBNoLeafNode*			nodes	= CALLOC(AABBNoLeafNode,count);
+	if (0==nodes)							return false;
+	for (u32 i=0; i<count; ++i)
+	{
+		AABBNoLeafNode&		N		= nodes[i];
+		R.r					(&N.mAABB.mCenter,3*sizeof(float));
+		R.r					(&N.mAABB.mExtents,3*sizeof(float));
+		u32					child[2];
+		child[0]			= R.r_u32();
+		child[1]			= R.r_u32();
+		uintptr_t*			dest[2]	= { &N.mData, &N.mData2 };
+		for (u32 c=0; c<2; ++c)
+		{
+			u32 const		id		= child[c]>>1;
+			// children always follow their parent, this also rejects cycles
+			bool const		valid	= (child[c]&1) ? (id<u32(Tcnt)) : ((id>i) && (id<count));
+			if (!valid)		{ CFREE(nodes); return false; }
+			*dest[c]		= (child[c]&1) ? uintptr_t(child[c]) : uintptr_t(nodes+id);
+		}
+	}
+
+	copy_source				(V,Vcnt,T,Tcnt,bc,bcp);
+	tree					= CNEW(OPCODE_Model) ();
+	if (!tree->Adopt(nodes,count))
+	{
+		CFREE				(nodes);
+		return				false;
+	}
+	status					= S_READY;
+	return					true;
+}
+
 u32 MODEL::memory	()
 {
 	if (S_BUILD==status)	{ Msg	("! xrCDB: model still isn't ready"); return 0; }
@@ -92,10 +92,24 @@ namespace CDB
 			}
 		}
 
+		// tree construction
+		enum
+		{
+			build_opcode		= 0,		// OPCODE generic tree, converted to no-leaf
+			build_sah			= 1,		// parallel binned SAH straight into no-leaf nodes
+		};
+
 		static	void			build_thread	(void*);
-		void					build_internal	(Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callback* bc=NULL, void* bcp=NULL);
-		void					build			(Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callback* bc=NULL, void* bcp=NULL);
+		void					build_internal	(Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callback* bc=NULL, void* bcp=NULL, u32 mode=build_opcode);
+		void					build			(Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callback* bc=NULL, void* bcp=NULL, u32 mode=build_opcode);
 		u32						memory			();
+
+		// tree cache, source_crc identifies the geometry the tree was built from
+		void					serialize		(IWriter& W, u32 source_crc) const;
+		bool					deserialize		(IReader& R, u32 source_crc, Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callback* bc=NULL, void* bcp=NULL);
+	private:
+		void					copy_source		(Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callback* bc, void* bcp);
+		Opcode::AABBNoLeafNode*	build_tree_sah	(u32& nodes_count);
 	};
 
 	// Collider result
@@ -124,6 +138,24 @@ namespace CDB
 		OPT_FULL_TEST   = (1<<3)		// for box & frustum queries - enable class III test(s)
 	};
 
+	// Packet of rays traced together through the tree (see COLLIDER::ray_packet_query)
+	struct XRCDB_API ray_packet
+	{
+		enum			{ max_rays = 4 };
+		Fvector			start	[max_rays];
+		Fvector			dir		[max_rays];
+		float			range	[max_rays];
+		u32				count;
+	};
+
+	// What a hit does to the ray of a packet
+	enum {
+		RP_IGNORE		= 0,			// skip the triangle
+		RP_OCCLUDE,						// stop the ray
+		RP_RECORD,						// keep the hit in the results, continue the ray
+	};
+	typedef u32 ray_packet_filter	(const RESULT& R, u32 ray, void* param);
+
 	// Collider itself
 	class XRCDB_API COLLIDER
 	{
@@ -134,12 +166,16 @@ namespace CDB
 
 		// Result management
 		xr_vector<RESULT>	rd;
+		xr_vector<u32>		rp_ray;		// packet queries: ray of every result
 	public:
 		COLLIDER		();
 		~COLLIDER		();
 
 		ICF void		ray_options		(u32 f)	{	ray_mode = f;		}
 		void			ray_query		(const MODEL *m_def, const Fvector& r_start,  const Fvector& r_dir, float r_range = 10000.f);
+		// non-culling query of all rays of the packet in one tree walk, returns the mask of stopped rays
+		u32				ray_packet_query(const MODEL *m_def, const ray_packet& P, ray_packet_filter* filter, void* param);
+		ICF u32			r_ray			(int id)	{	return rp_ray[id];			};
 
 		ICF void		box_options		(u32 f)	{	box_mode = f;		}
 		void			box_query		(const MODEL *m_def, const Fvector& b_center, const Fvector& b_dim);
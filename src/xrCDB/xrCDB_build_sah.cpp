@@ -0,0 +1,269 @@
+#include "stdafx.h"
+#pragma hdrstop
+
+#include "xrCDB.h"
+
+using namespace		CDB;
+using namespace		Opcode;
+
+// Binned SAH builder of the OPCODE no-leaf tree.
+// The tree is complete (one triangle per leaf), so a subtree over m triangles
+// always takes m-1 nodes. Node indices are therefore known before the subtree
+// is built: a node at index i with m_left triangles on the left side has its
+// left child at i+1 and its right child at i+m_left. This lets independent
+// subtrees be built by different threads straight into the final array.
+
+namespace {
+
+static u32 const	sah_bins			= 16;
+static u32 const	sah_task_min_tris	= 4096;		// don't spawn tasks for smaller subtrees
+
+struct sah_prim
+{
+	Fbox		box;
+	Fvector		center;
+};
+
+struct sah_task
+{
+	u32			node;		// index of the subtree root node
+	u32			first;		// range in the primitive index array
+	u32			count;
+};
+
+struct sah_builder
+{
+	const sah_prim*			prims;
+	u32*					index;
+	AABBNoLeafNode*			nodes;
+
+	xr_vector<sah_task>		tasks;
+	volatile LONG			next_task;
+	volatile LONG			threads_done;
+
+	void			bounds			(u32 first, u32 count, Fbox& box, Fbox& centers) const
+	{
+		box.invalidate		();
+		centers.invalidate	();
+		for (u32 i=first; i<first+count; ++i)
+		{
+			const sah_prim&	P	= prims[index[i]];
+			box.merge		(P.box);
+			centers.modify	(P.center);
+		}
+	}
+
+	// returns the number of primitives put on the left side
+	u32				split			(u32 first, u32 count, const Fbox& centers) const
+	{
+		if (count==2)		return 1;
+
+		Fvector				extent;
+		centers.getsize		(extent);
+
+		float				best_cost	= flt_max;
+		u32					best_axis	= 0;
+		u32					best_bin	= 0;
+		for (u32 axis=0; axis<3; ++axis)
+		{
+			float const		axis_min	= centers.min[axis];
+			float const		axis_size	= extent[axis];
+			if (axis_size<=EPS_S)		continue;
+
+			Fbox			bin_box		[sah_bins];
+			u32				bin_count	[sah_bins];
+			for (u32 b=0; b<sah_bins; ++b)	{ bin_box[b].invalidate(); bin_count[b] = 0; }
+
+			float const		scale		= float(sah_bins)*(1.f-EPS_S)/axis_size;
+			for (u32 i=first; i<first+count; ++i)
+			{
+				const sah_prim&	P	= prims[index[i]];
+				u32 const	b		= _min(u32((P.center[axis]-axis_min)*scale),sah_bins-1);
+				bin_box[b].merge	(P.box);
+				++bin_count[b];
+			}
+
+			// sweep from the right, then from the left
+			float			right_area	[sah_bins];
+			Fbox			acc;		acc.invalidate();
+			u32				acc_count	= 0;
+			for (u32 b=sah_bins-1; b>0; --b)
+			{
+				// empty bins hold an invalidated box, merging it would blow up the bounds
+				if (bin_count[b])	acc.merge(bin_box[b]);
+				acc_count			+= bin_count[b];
+				Fvector				size;	acc.getsize(size);
+				right_area[b]		= acc_count ? (size.x*size.y+size.y*size.z+size.z*size.x)*float(acc_count) : 0.f;
+			}
+			acc.invalidate	();
+			acc_count		= 0;
+			for (u32 b=0; b<sah_bins-1; ++b)
+			{
+				if (bin_count[b])	acc.merge(bin_box[b]);
+				acc_count			+= bin_count[b];
+				if (!acc_count || (acc_count==count))	continue;
+				Fvector				size;	acc.getsize(size);
+				float const	cost	= (size.x*size.y+size.y*size.z+size.z*size.x)*float(acc_count) + right_area[b+1];
+				if (cost<best_cost)
+				{
+					best_cost		= cost;
+					best_axis		= axis;
+					best_bin		= b;
+				}
+			}
+		}
+
+		if (best_cost==flt_max)
+		{
+			// all centers coincide - split by count
+			return			count/2;
+		}
+
+		float const			axis_min	= centers.min[best_axis];
+		float const			scale		= float(sah_bins)*(1.f-EPS_S)/extent[best_axis];
+		u32*				it			= index+first;
+		u32*				it_e		= index+first+count;
+		u32*				middle		= std::partition(it,it_e,[&](u32 id)
+		{
+			return			_min(u32((prims[id].center[best_axis]-axis_min)*scale),sah_bins-1) <= best_bin;
+		});
+		return				u32(middle-it);
+	}
+
+	void			write_node		(u32 node, const Fbox& box)
+	{
+		AABBNoLeafNode&		N		= nodes[node];
+		Fvector				center, extents;
+		box.getcenter		(center);
+		box.getradius		(extents);
+		N.mAABB.mCenter.Set	(center.x,center.y,center.z);
+		N.mAABB.mExtents.Set(extents.x,extents.y,extents.z);
+	}
+
+	// fills the node of a task and pushes its non-leaf children to dest
+	void			subdivide		(const sah_task& T, xr_vector<sah_task>& dest)
+	{
+		Fbox				box, centers;
+		bounds				(T.first,T.count,box,centers);
+		write_node			(T.node,box);
+
+		u32 const			left	= split(T.first,T.count,centers);
+		u32 const			right	= T.count-left;
+		VERIFY				(left && right);
+
+		AABBNoLeafNode&		N		= nodes[T.node];
+		if (left==1)		N.mData		= (uintptr_t(index[T.first])<<1)|1;
+		else
+		{
+			N.mData			= (uintptr_t)&nodes[T.node+1];
+			sah_task		L	= { T.node+1, T.first, left };
+			dest.push_back	(L);
+		}
+		if (right==1)		N.mData2	= (uintptr_t(index[T.first+left])<<1)|1;
+		else
+		{
+			N.mData2		= (uintptr_t)&nodes[T.node+left];
+			sah_task		R	= { T.node+left, T.first+left, right };
+			dest.push_back	(R);
+		}
+	}
+
+	// builds the whole subtree of a task
+	void			build			(const sah_task& root)
+	{
+		xr_vector<sah_task>	stack;
+		stack.push_back		(root);
+		while (!stack.empty())
+		{
+			sah_task		T		= stack.back();
+			stack.pop_back	();
+			subdivide		(T,stack);
+		}
+	}
+
+	// splits the top levels serially until there are enough tasks for the threads
+	void			schedule		(u32 count, u32 threads)
+	{
+		sah_task			root	= { 0, 0, count };
+		tasks.push_back		(root);
+		u32 const			target	= threads*4;
+		while (!tasks.empty() && (tasks.size()<target))
+		{
+			// pick the largest pending task
+			u32				largest	= 0;
+			for (u32 i=1; i<tasks.size(); ++i)
+				if (tasks[i].count>tasks[largest].count)	largest	= i;
+			if (tasks[largest].count<sah_task_min_tris)
+				break;
+
+			sah_task		T		= tasks[largest];
+			tasks.erase		(tasks.begin()+largest);
+			subdivide		(T,tasks);
+		}
+		// largest first, so the threads finish at about the same time
+		std::sort			(tasks.begin(),tasks.end(),[](const sah_task& a, const sah_task& b) { return a.count>b.count; });
+	}
+
+	void			run_tasks		()
+	{
+		for (;;)
+		{
+			LONG const		id		= InterlockedIncrement(&next_task)-1;
+			if (id>=LONG(tasks.size()))	break;
+			build			(tasks[id]);
+		}
+	}
+
+	static void		thread_proc		(void* params)
+	{
+		_initialize_cpu_thread		();
+		FPU::m24r					();
+		sah_builder*	B		= (sah_builder*)params;
+		B->run_tasks			();
+		InterlockedIncrement	(&B->threads_done);
+	}
+};
+
+} // namespace
+
+AABBNoLeafNode* MODEL::build_tree_sah	(u32& nodes_count)
+{
+	VERIFY						(tris_count>=2);
+	nodes_count					= u32(tris_count-1);
+
+	xr_vector<sah_prim>			prims	(tris_count);
+	xr_vector<u32>				index	(tris_count);
+	for (int i=0; i<tris_count; ++i)
+	{
+		sah_prim&		P		= prims[i];
+		P.box.invalidate		();
+		P.box.modify			(verts[tris[i].verts[0]]);
+		P.box.modify			(verts[tris[i].verts[1]]);
+		P.box.modify			(verts[tris[i].verts[2]]);
+		P.box.getcenter			(P.center);
+		index[i]				= u32(i);
+	}
+
+	AABBNoLeafNode*	nodes		= CALLOC(AABBNoLeafNode,nodes_count);
+	if (0==nodes)				return 0;
+	ZeroMemory					(nodes,nodes_count*sizeof(AABBNoLeafNode));
+
+	sah_builder					B;
+	B.prims						= &prims.front();
+	B.index						= &index.front();
+	B.nodes						= nodes;
+	B.next_task					= 0;
+	B.threads_done				= 0;
+
+	u32 const		threads		= _max(CPU::ID.n_threads,1u);
+	B.schedule					(u32(tris_count),threads);
+
+	// the calling thread works as well
+	u32 const		helpers		= B.tasks.empty() ? 0 : _min(threads,u32(B.tasks.size()))-1;
+	for (u32 i=0; i<helpers; ++i)
+		thread_spawn			(sah_builder::thread_proc,"CDB-sah-construction",0,&B);
+	B.run_tasks					();
+	while (B.threads_done<LONG(helpers))	Sleep(1);
+
+	return						nodes;
+}
@@ -0,0 +1,235 @@
+#include "stdafx.h"
+#pragma hdrstop
+#pragma warning(push)
+#pragma warning(disable:4995)
+#include <xmmintrin.h>
+#pragma warning(pop)
+
+#include "xrCDB.h"
+
+using namespace		CDB;
+using namespace		Opcode;
+
+// Packet ray query: up to four rays walk the tree together, node boxes are
+// tested against all of them at once (one ray per SSE lane). A subtree is
+// visited with the mask of the rays that hit its box, rays stopped by the
+// filter leave the walk immediately. Triangle tests are scalar and match the
+// non-culling path of ray_query.
+
+#ifndef _MM_ALIGN16
+#	define _MM_ALIGN16	__declspec(align(16))
+#endif // _MM_ALIGN16
+
+static const float packet_plus_inf	= -logf(0);
+
+class _MM_ALIGN16	ray_packet_collider
+{
+public:
+	__m128				pos_x, pos_y, pos_z;
+	__m128				inv_x, inv_y, inv_z;
+	__m128				range;
+	__m128				plus_inf, minus_inf;
+
+	COLLIDER*			dest;
+	xr_vector<u32>*		dest_ray;
+	const ray_packet*	packet;
+	TRI*				tris;
+	Fvector*			verts;
+	ray_packet_filter*	filter;
+	void*				param;
+
+	u32					active;
+	u32					stopped;
+
+	IC void			_init		(COLLIDER* CL, xr_vector<u32>* CR, Fvector* V, TRI* T, const ray_packet& P, ray_packet_filter* F, void* FP)
+	{
+		dest			= CL;
+		dest_ray		= CR;
+		packet			= &P;
+		tris			= T;
+		verts			= V;
+		filter			= F;
+		param			= FP;
+		active			= (1<<P.count)-1;
+		stopped			= 0;
+
+		_MM_ALIGN16 float	px[4], py[4], pz[4], ix[4], iy[4], iz[4], r[4];
+		for (u32 i=0; i<4; ++i)
+		{
+			u32 const	s	= (i<P.count) ? i : 0;	// unused lanes are masked out
+			px[i]		= P.start[s].x;
+			py[i]		= P.start[s].y;
+			pz[i]		= P.start[s].z;
+			ix[i]		= 1.f/P.dir[s].x;
+			iy[i]		= 1.f/P.dir[s].y;
+			iz[i]		= 1.f/P.dir[s].z;
+			r[i]		= P.range[s];
+		}
+		pos_x			= _mm_load_ps(px);
+		pos_y			= _mm_load_ps(py);
+		pos_z			= _mm_load_ps(pz);
+		inv_x			= _mm_load_ps(ix);
+		inv_y			= _mm_load_ps(iy);
+		inv_z			= _mm_load_ps(iz);
+		range			= _mm_load_ps(r);
+		plus_inf		= _mm_set1_ps(packet_plus_inf);
+		minus_inf		= _mm_set1_ps(-packet_plus_inf);
+	}
+
+	// slab test of one axis, NaNs (0*inf) are filtered out like in isect_sse
+	ICF void		_slab		(float c, float e, const __m128& pos, const __m128& inv, __m128& t_near, __m128& t_far)
+	{
+		const __m128	l1	= _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(c-e),pos),inv);
+		const __m128	l2	= _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(c+e),pos),inv);
+		const __m128	lmax	= _mm_max_ps(_mm_min_ps(l1,plus_inf),_mm_min_ps(l2,plus_inf));
+		const __m128	lmin	= _mm_min_ps(_mm_max_ps(l1,minus_inf),_mm_max_ps(l2,minus_inf));
+		t_far			= _mm_min_ps(t_far,lmax);
+		t_near			= _mm_max_ps(t_near,lmin);
+	}
+
+	ICF u32			_box		(const AABBNoLeafNode* node)
+	{
+		const Point&	C	= node->mAABB.mCenter;
+		const Point&	E	= node->mAABB.mExtents;
+		__m128		t_near	= minus_inf;
+		__m128		t_far	= plus_inf;
+		_slab		(C.x,E.x,pos_x,inv_x,t_near,t_far);
+		_slab		(C.y,E.y,pos_y,inv_y,t_near,t_far);
+		_slab		(C.z,E.z,pos_z,inv_z,t_near,t_far);
+
+		__m128		hit		= _mm_cmpge_ps(t_far,_mm_setzero_ps());
+		hit					= _mm_and_ps(hit,_mm_cmpge_ps(t_far,t_near));
+		hit					= _mm_and_ps(hit,_mm_cmple_ps(t_near,range));
+		return		u32(_mm_movemask_ps(hit));
+	}
+
+	// the same as ray_collider::_tri without culling
+	IC bool			_tri		(u32 ray, u32* p, float& u, float& v, float& r)
+	{
+		const Fvector&	pos		= packet->start[ray];
+		const Fvector&	dir		= packet->dir[ray];
+		Fvector edge1, edge2, tvec, pvec, qvec;
+		float	det,inv_det;
+
+		Fvector&			p0	= verts[ p[0] ];
+		Fvector&			p1	= verts[ p[1] ];
+		Fvector&			p2	= verts[ p[2] ];
+		edge1.sub			(p1, p0);
+		edge2.sub			(p2, p0);
+		pvec.crossproduct	(dir, edge2);
+		det = edge1.dotproduct(pvec);
+		if (det > -EPS && det < EPS) return false;
+		inv_det = 1.0f / det;
+		tvec.sub(pos, p0);
+		u = tvec.dotproduct(pvec)*inv_det;
+		if (u < 0.0f || u > 1.0f)    return false;
+		qvec.crossproduct(tvec, edge1);
+		v = dir.dotproduct(qvec)*inv_det;
+		if (v < 0.0f || u + v > 1.0f) return false;
+		r = edge2.dotproduct(qvec)*inv_det;
+		return true;
+	}
+
+	void			_prim		(DWORD prim, u32 mask)
+	{
+		for (u32 ray=0; mask; ++ray, mask>>=1)
+		{
+			if (0==(mask&1))						continue;
+
+			float	u,v,r;
+			if (!_tri(ray,tris[prim].verts,u,v,r))	continue;
+			if (r<=0 || r>packet->range[ray])		continue;
+
+			RESULT		R;
+			R.id		= prim;
+			R.range		= r;
+			R.u			= u;
+			R.v			= v;
+			R.verts	[0]	= verts[tris[prim].verts[0]];
+			R.verts	[1]	= verts[tris[prim].verts[1]];
+			R.verts	[2]	= verts[tris[prim].verts[2]];
+			R.dummy		= tris[prim].dummy;
+
+			switch (filter(R,ray,param))
+			{
+			case RP_OCCLUDE:
+				stopped		|= (1<<ray);
+				active		&= ~(1<<ray);
+				break;
+			case RP_RECORD:
+				dest->r_add	()	= R;
+				dest_ray->push_back	(ray);
+				break;
+			}
+		}
+	}
+
+	void			_stab		(const AABBNoLeafNode* node, u32 mask)
+	{
+		_mm_prefetch( (char *) node->GetNeg() , _MM_HINT_NTA );
+
+		mask		&= active & _box(node);
+		if (!mask)				return;
+
+		// 1st chield
+		if (node->HasLeaf())	_prim	(node->GetPrimitive(),mask);
+		else					_stab	(node->GetPos(),mask);
+
+		// Early exit for stopped rays
+		mask		&= active;
+		if (!mask)				return;
+
+		// 2nd chield
+		if (node->HasLeaf2())	_prim	(node->GetPrimitive2(),mask);
+		else					_stab	(node->GetNeg(),mask);
+	}
+};
+
+// FPU fallback, ray by ray through the regular query
+static u32	ray_packet_scalar	(COLLIDER* CL, xr_vector<RESULT>& rd, xr_vector<u32>& rp_ray, const MODEL* m_def, const ray_packet& P, ray_packet_filter* filter, void* param)
+{
+	u32					stopped	= 0;
+	xr_vector<RESULT>	hits;
+	for (u32 ray=0; ray<P.count; ++ray)
+	{
+		CL->ray_query	(m_def,P.start[ray],P.dir[ray],P.range[ray]);
+		hits.assign		(CL->r_begin(),CL->r_end());
+		for (u32 it=0; it<hits.size(); ++it)
+		{
+			u32 const	code	= filter(hits[it],ray,param);
+			if (RP_OCCLUDE==code)	{ stopped |= (1<<ray); break; }
+			if (RP_RECORD==code)	{ rd.push_back(hits[it]); rp_ray.push_back(ray); }
+		}
+	}
+	return				stopped;
+}
+
+u32		COLLIDER::ray_packet_query	(const MODEL *m_def, const ray_packet& P, ray_packet_filter* filter, void* param)
+{
+	VERIFY					(P.count && (P.count<=ray_packet::max_rays));
+	m_def->syncronize		();
+
+	if (!CPU::ID.hasFeature(CPUFeature::SSE))
+	{
+		u32 const	mode	= ray_mode;
+		ray_mode			= 0;
+		xr_vector<RESULT>	packet_rd;
+		xr_vector<u32>		packet_ray;
+		u32 const	stopped	= ray_packet_scalar(this,packet_rd,packet_ray,m_def,P,filter,param);
+		ray_mode			= mode;
+		rd.swap				(packet_rd);
+		rp_ray.swap			(packet_ray);
+		return				stopped;
+	}
+
+	// Get nodes
+	const AABBNoLeafTree* T = (const AABBNoLeafTree*)m_def->tree->GetTree();
+	const AABBNoLeafNode* N = T->GetNodes();
+	r_clear					();
+	rp_ray.clear_not_free	();
+
+	ray_packet_collider		RC;
+	RC._init				(this,&rp_ray,m_def->verts,m_def->tris,P,filter,param);
+	RC._stab				(N,RC.active);
+	return					RC.stopped;
+}
@@ -106,9 +106,22 @@ void	CObjectSpace::		Load				(  LPCSTR path, LPCSTR fname, CDB::build_callback b
 #ifdef USE_ARENA_ALLOCATOR
 	Msg( "CObjectSpace::Load, g_collision_allocator.get_allocated_size() - %d", int(g_collision_allocator.get_allocated_size()/1024.0/1024) );
 #endif // #ifdef USE_ARENA_ALLOCATOR
-	IReader *F					= FS.r_open	(path, fname);
+	string_path					source_name;
+	FS.update_path				(source_name, path, fname);
+	IReader *F					= FS.r_open	(source_name);
 	R_ASSERT					(F);
-	Load( F, build_callback );
+
+	hdrCFORM					H;
+	F->r						(&H,sizeof(hdrCFORM));
+	Fvector*	verts			= (Fvector*)F->pointer();
+	CDB::TRI*	tris			= (CDB::TRI*)(verts+H.vertcount);
+	R_ASSERT					(CFORM_CURRENT_VERSION==H.version);
+
+	if (strstr(Core.Params,"-cform_bench"))
+		BenchmarkStatic			( verts, tris, H );
+
+	CreateCached				( source_name, verts, tris, H, build_callback );
+	FS.r_close					(F);
 }
 void	CObjectSpace::	Load				(  IReader* F, CDB::build_callback build_callback  )
 
@@ -126,6 +139,11 @@ void			CObjectSpace::Create				(  Fvector*	verts, CDB::TRI* tris, const hdrCFORM
 {
 	R_ASSERT							(CFORM_CURRENT_VERSION==H.version);
 	Static.build						( verts, H.vertcount, tris, H.facecount, build_callback );
+	CreateSpaces						( H );
+}
+
+void			CObjectSpace::CreateSpaces			(  const hdrCFORM &H  )
+{
 	m_BoundingVolume.set				(H.aabb);
 	g_SpatialSpace->initialize			(m_BoundingVolume);
 	g_SpatialSpacePhysic->initialize	(m_BoundingVolume);
@@ -133,6 +151,89 @@ void			CObjectSpace::Create				(  Fvector*	verts, CDB::TRI* tris, const hdrCFORM
 	//Sound->set_handler					( _sound_event );
 }
 
+// The collision tree is looked up in:
+//   1. <source>_tree next to the source, emitted by xrLC together with level.cform
+//   2. $app_data_root$\cform_cache\<path crc>.tree, written here after a rebuild
+// Both are validated against the crc of the source geometry, on any mismatch
+// the tree is rebuilt with the parallel SAH builder and the cache is rewritten.
+void			CObjectSpace::CreateCached			(  LPCSTR source_name, Fvector*	verts, CDB::TRI* tris, const hdrCFORM &H, CDB::build_callback build_callback  )
+{
+	CTimer								T;
+	T.Start								();
+
+	u32 const	source_crc				= crc32(tris, H.facecount*sizeof(CDB::TRI), crc32(verts, H.vertcount*sizeof(Fvector)));
+
+	string_path							cache_names[2];
+	strconcat							(sizeof(cache_names[0]), cache_names[0], source_name, "_tree");
+	string32							cache_file;
+	xr_sprintf							(cache_file, "cform_cache\\%08x.tree", path_crc32(source_name, xr_strlen(source_name)));
+	FS.update_path						(cache_names[1], "$app_data_root$", cache_file);
+
+	for (u32 i=0; i<2; ++i)
+	{
+		if (!FS.exist(cache_names[i]))
+			continue;
+		IReader*	R					= FS.r_open(cache_names[i]);
+		if (!R)
+			continue;
+		bool const	loaded				= Static.deserialize(*R, source_crc, verts, H.vertcount, tris, H.facecount, build_callback);
+		FS.r_close						(R);
+		if (loaded)
+		{
+			Msg							("* CFORM: collision tree loaded from cache [%s] in %.1f ms", cache_names[i], T.GetElapsed_sec()*1000.f);
+			CreateSpaces				( H );
+			return;
+		}
+		Msg								("! CFORM: collision tree cache [%s] is outdated", cache_names[i]);
+	}
+
+	Static.build						( verts, H.vertcount, tris, H.facecount, build_callback, 0, CDB::MODEL::build_sah );
+	Msg									("* CFORM: collision tree built in %.1f ms (%d tris)", T.GetElapsed_sec()*1000.f, H.facecount);
+
+	Static.syncronize					();
+	IWriter*	W						= FS.w_open(cache_names[1]);
+	if (W)
+	{
+		Static.serialize				(*W, source_crc);
+		FS.w_close						(W);
+	}
+	CreateSpaces						( H );
+}
+
+// -cform_bench: compares the tree construction paths on the loaded level
+void			CObjectSpace::BenchmarkStatic		(  Fvector*	verts, CDB::TRI* tris, const hdrCFORM &H  )
+{
+	CTimer								T;
+	float		opcode_ms, sah_ms, cache_ms;
+	u32			cache_size;
+	{
+		CDB::MODEL						M;
+		T.Start							();
+		M.build							( verts, H.vertcount, tris, H.facecount, 0, 0, CDB::MODEL::build_opcode );
+		M.syncronize					();
+		opcode_ms						= T.GetElapsed_sec()*1000.f;
+	}
+	CMemoryWriter						W;
+	{
+		CDB::MODEL						M;
+		T.Start							();
+		M.build							( verts, H.vertcount, tris, H.facecount, 0, 0, CDB::MODEL::build_sah );
+		M.syncronize					();
+		sah_ms							= T.GetElapsed_sec()*1000.f;
+		M.serialize						(W, 0);
+		cache_size						= W.size();
+	}
+	{
+		CDB::MODEL						M;
+		IReader							R(W.pointer(), W.size());
+		T.Start							();
+		R_ASSERT						(M.deserialize(R, 0, verts, H.vertcount, tris, H.facecount));
+		cache_ms						= T.GetElapsed_sec()*1000.f;
+	}
+	Msg("* CFORM bench: %d verts, %d tris, %d threads", H.vertcount, H.facecount, CPU::ID.n_threads);
+	Msg("* CFORM bench: opcode build %.1f ms, sah build %.1f ms, cache load %.1f ms (%d KB)", opcode_ms, sah_ms, cache_ms, cache_size/1024);
+}
+
 //----------------------------------------------------------------------
 #ifdef DEBUG
 void CObjectSpace::dbgRender()
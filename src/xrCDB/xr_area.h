@@ -44,6 +44,10 @@ private:
 	BOOL								_RayQuery			( collide::rq_results& dest, const collide::ray_defs& rq, collide::rq_callback* cb, LPVOID user_data, collide::test_callback* tb, CObject* ignore_object);
 	BOOL								_RayQuery2			( collide::rq_results& dest, const collide::ray_defs& rq, collide::rq_callback* cb, LPVOID user_data, collide::test_callback* tb, CObject* ignore_object);
 	BOOL								_RayQuery3			( collide::rq_results& dest, const collide::ray_defs& rq, collide::rq_callback* cb, LPVOID user_data, collide::test_callback* tb, CObject* ignore_object);
+
+	void								CreateSpaces		(  const hdrCFORM &H );
+	void								CreateCached		(  LPCSTR source_name, Fvector*	verts, CDB::TRI* tris, const hdrCFORM &H, CDB::build_callback build_callback  );
+	void								BenchmarkStatic		(  Fvector*	verts, CDB::TRI* tris, const hdrCFORM &H );
 public:
 										CObjectSpace		( );
 										~CObjectSpace		( );
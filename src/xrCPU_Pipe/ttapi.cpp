@@ -1,6 +1,8 @@
 #include "stdafx.h"
 #pragma hdrstop
 
+#include "../xrCore/frame_arena.h"
+
 typedef struct TTAPI_WORKER_PARAMS {
 	volatile LONG			vlFlag;
 	LPPTTAPI_WORKER_FUNC	lpWorkerFunc;
@@ -70,6 +72,8 @@ DWORD WINAPI ttapiThreadProc( LPVOID lpParameter )
 
 	} // while
 
+	frame_arena_thread_exit();
+
 	return 0;
 }
 
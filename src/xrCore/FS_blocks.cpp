@@ -0,0 +1,185 @@
+#include "stdafx.h"
+#pragma hdrstop
+
+#include "FS_blocks.h"
+#include "frame_arena.h"
+
+static u32 const	block_parallel_min		= 8;	// blocks in a run worth more threads
+static u32 const	block_parallel_per_task	= 4;	// blocks per helper thread at least
+
+void CBlockIndex::load	(const u8* table, u32 entry_ptr, u32 _file_size)
+{
+	const u32*		T	= (const u32*)table;
+	block_size			= T[0];
+	file_size			= _file_size;
+	u32	const		cnt	= T[1];
+	R_ASSERT2			(block_size && (cnt==(file_size+block_size-1)/block_size),"corrupted block table");
+
+	u32	const		data	= entry_ptr + table_size(cnt);
+	offsets.resize		(cnt+1);
+	for (u32 it=0; it<=cnt; ++it)
+		offsets[it]		= data + T[2+it];
+}
+
+namespace {
+
+struct block_job
+{
+	u8*					dest;
+	const u8*			base;
+	u32					base_offset;
+	const CBlockIndex*	index;
+	u32					first;
+	u32					last;
+	volatile LONG		next;
+	volatile LONG		users;			// helper threads inside run
+
+	void			unpack		(u32 id)
+	{
+		const CBlockIndex&	I	= *index;
+		u8*				dst		= dest + (id-first)*I.block_size;
+		const u8*		src		= base + (I.offsets[id]-base_offset);
+		u32 const		real	= I.block_real(id);
+		u32 const		packed	= I.block_packed(id);
+		if (packed==real)
+			Memory.mem_copy	(dst,src,real);
+		else
+		{
+			u32	const	size	= rtc_decompress(dst,real,src,packed);
+			R_ASSERT2			(size==real,"corrupted compressed block");
+		}
+	}
+
+	void			run			()
+	{
+		for (;;)
+		{
+			u32 const	id		= first + u32(InterlockedIncrement(&next)-1);
+			if (id>=last)		break;
+			unpack				(id);
+		}
+	}
+
+};
+
+// Helper threads started on the first long run and parked on the semaphore
+// between the runs. A woken helper joins any job with blocks left; the caller
+// unlinks its job under the lock and waits for the helpers inside it.
+struct block_pool
+{
+	xrCriticalSection		lock;
+	HANDLE					semaphore;
+	xr_vector<block_job*>	jobs;
+	u32						threads;
+	volatile LONG			threads_running;
+	volatile LONG			quit;
+
+	block_pool				()
+#ifdef PROFILE_CRITICAL_SECTIONS
+		:lock				(MUTEX_PROFILE_ID(block_pool::lock))
+#endif // PROFILE_CRITICAL_SECTIONS
+	{
+		semaphore			= 0;
+		threads				= 0;
+		threads_running		= 0;
+		quit				= 0;
+	}
+
+	static void				thread_proc	(void* params);
+};
+
+block_pool					g_block_pool;
+
+void block_pool::thread_proc	(void* params)
+{
+	block_pool&			P		= *(block_pool*)params;
+	while (!P.quit)
+	{
+		WaitForSingleObject		(P.semaphore,INFINITE);
+
+		P.lock.Enter			();
+		block_job*		J		= 0;
+		for (u32 it=0; it<P.jobs.size(); ++it)
+			if (u32(P.jobs[it]->next) < P.jobs[it]->last-P.jobs[it]->first)
+			{
+				J				= P.jobs[it];
+				InterlockedIncrement	(&J->users);
+				break;
+			}
+		P.lock.Leave			();
+
+		if (J)
+		{
+			J->run				();
+			InterlockedDecrement	(&J->users);
+		}
+	}
+	frame_arena_thread_exit		();
+	InterlockedDecrement		(&P.threads_running);
+}
+
+} // namespace
+
+void fs_block_decompress	(u8* dest, const u8* base, u32 base_offset, const CBlockIndex& I, u32 first, u32 last)
+{
+	VERIFY						((first<=last) && (last<=I.count()));
+
+	block_job					J;
+	J.dest						= dest;
+	J.base						= base;
+	J.base_offset				= base_offset;
+	J.index						= &I;
+	J.first						= first;
+	J.last						= last;
+	J.next						= 0;
+	J.users						= 0;
+
+	u32 const		count		= last-first;
+	u32				helpers		= 0;
+	if (count>=block_parallel_min)
+		helpers					= _min(_max(CPU::ID.n_threads,1u),count/block_parallel_per_task)-1;
+	if (!helpers)
+	{
+		J.run					();
+		return;
+	}
+
+	block_pool&		P			= g_block_pool;
+	P.lock.Enter				();
+	if (!P.semaphore && !P.quit)
+	{
+		P.semaphore				= CreateSemaphore(0,0,0x7fffffff,0);
+		P.threads				= _max(CPU::ID.n_threads,1u)-1;
+		for (u32 it=0; it<P.threads; ++it)
+		{
+			InterlockedIncrement	(&P.threads_running);
+			thread_spawn		(block_pool::thread_proc,"FS-block-unpack",0,&P);
+		}
+	}
+	helpers						= _min(helpers,P.threads);
+	P.jobs.push_back			(&J);
+	P.lock.Leave				();
+	if (helpers)
+		ReleaseSemaphore		(P.semaphore,helpers,0);
+
+	// the calling thread works as well
+	J.run						();
+
+	P.lock.Enter				();
+	P.jobs.erase				(std::find(P.jobs.begin(),P.jobs.end(),&J));
+	P.lock.Leave				();
+	while (J.users)				Sleep(0);
+}
+
+void fs_block_pool_destroy	()
+{
+	block_pool&		P			= g_block_pool;
+	if (!P.semaphore)			return;
+
+	P.quit						= 1;
+	ReleaseSemaphore			(P.semaphore,P.threads,0);
+	while (P.threads_running)	Sleep(1);
+	CloseHandle					(P.semaphore);
+	P.semaphore					= 0;
+	P.threads					= 0;
+}
@@ -0,0 +1,53 @@
+#ifndef FS_BLOCKS_H
+#define FS_BLOCKS_H
+
+// Block compressed archive entries.
+//
+// The file is split into blocks of the same size (the last one may be shorter),
+// every block is compressed with LZO on its own, so any part of the file can be
+// unpacked without touching the rest. Entry layout at the file table pointer:
+//
+//   u32 block_size | u32 block_count | u32 offset[block_count+1] | blocks
+//
+// Offsets are relative to the end of the table. A block whose packed size
+// equals its real size is stored as is. Such entries have fs_block_flag set
+// in size_compressed of the file table.
+
+u32 const	fs_block_flag			= u32(1)<<31;
+u32 const	fs_block_default_size	= 256*1024;
+
+class XRCORE_API CBlockIndex
+{
+public:
+	u32				block_size;
+	u32				file_size;
+	xr_vector<u32>	offsets;		// archive offsets of the packed blocks, plus the end
+
+public:
+	// table points to the entry in memory, entry_ptr is its offset in the archive
+	void			load			(const u8* table, u32 entry_ptr, u32 file_size);
+	IC u32			count			() const			{ return u32(offsets.size())-1;		}
+	IC u32			block_real		(u32 id) const		{ return _min(block_size,file_size-id*block_size);	}
+	IC u32			block_packed	(u32 id) const		{ return offsets[id+1]-offsets[id];	}
+	IC u32			entry_size		() const			{ return offsets.back()-offsets.front()+table_size(count());	}
+	static IC u32	table_size		(u32 count)			{ return 2*sizeof(u32) + (count+1)*sizeof(u32);	}
+};
+
+// Unpacks blocks [first,last) into dest (the offset of block first). base is
+// the archive mapped at base_offset, all the blocks must be inside. Long runs
+// of blocks are unpacked by several threads.
+XRCORE_API void		fs_block_decompress	(u8* dest, const u8* base, u32 base_offset, const CBlockIndex& I, u32 first, u32 last);
+// stops the helper threads of fs_block_decompress
+void				fs_block_pool_destroy	();
+
+// The block table and the unpacked block of a block compressed stream, shared
+// by the stream and the chunks opened from it (on the same thread)
+struct CBlockStream
+{
+	CBlockIndex		index;
+	u8*				data;
+	u32				block_id;		// the block unpacked in data
+	u32				refs;
+};
+
+#endif // FS_BLOCKS_H
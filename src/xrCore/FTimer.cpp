@@ -8,6 +8,7 @@ CStatTimer::CStatTimer()
 	accum	= 0;
 	result	= 0.f;
 	count	= 0;
+	name	= 0;
 }
 
 void	CStatTimer::FrameStart	()
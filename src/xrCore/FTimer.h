@@ -164,13 +164,14 @@ public:
 	u64			accum;
 	float		result;
 	u32			count;
+	LPCSTR		name;		// zone name for xrTrace and allocation tag for memory_profiler, unnamed timers are not traced
 public:
 				CStatTimer		();
 	void		FrameStart		();
 	void		FrameEnd		();
 
-	ICF void	Begin			()		{	if (!g_bEnableStatGather) return;	count++; T.Start();				}
-	ICF void	End				()		{	if (!g_bEnableStatGather) return;	accum += T.GetElapsed_ticks();	}
+	ICF void	Begin			()		{	if (name) { xrTrace::zone_begin(name);	if (memory_profiler::tagging) memory_profiler::push_tag(name);	}	if (!g_bEnableStatGather) return;	count++; T.Start();				}
+	ICF void	End				()		{	if (name) { xrTrace::zone_end(name);	if (memory_profiler::tagging) memory_profiler::pop_tag(name);	}	if (!g_bEnableStatGather) return;	accum += T.GetElapsed_ticks();	}
 
 	ICF u64		GetElapsed_ticks()const	{	return accum;					}
 
@@ -14,6 +14,7 @@
 #include "FS_internal.h"
 #include "stream_reader.h"
 #include "file_stream_reader.h"
+#include "FS_blocks.h"
 
 const u32 BIG_FILE_READER_WINDOW_SIZE	= 1024*1024;
 
@@ -176,6 +177,7 @@ XRCORE_API void _dump_open_files(int mode)
 CLocatorAPI::CLocatorAPI()
 #ifdef PROFILE_CRITICAL_SECTIONS
 	:m_auth_lock			(MUTEX_PROFILE_ID(CLocatorAPI::m_auth_lock))
+	,m_files_lock			(MUTEX_PROFILE_ID(CLocatorAPI::m_files_lock))
 #endif // PROFILE_CRITICAL_SECTIONS
 {
     m_Flags.zero		();
@@ -185,6 +187,11 @@ CLocatorAPI::CLocatorAPI()
 	dwAllocGranularity	= sys_inf.dwAllocationGranularity;
     m_iLockRescan		= 0; 
 	dwOpenCounter		= 0;
+	m_index_used		= 0;
+	m_index_erased		= 0;
+	m_insert_hint		= m_files.end();
+	m_stream			= 0;
+	m_prefetch			= 0;
 }
 
 CLocatorAPI::~CLocatorAPI()
@@ -208,14 +215,16 @@ void CLocatorAPI::Register		(LPCSTR name, u32 vfs, u32 crc, u32 ptr, u32 size_re
 	desc.crc			= crc;
 	desc.ptr			= ptr;
 	desc.size_real		= size_real;
-	desc.size_compressed= size_compressed;
+	desc.size_compressed= size_compressed & (~fs_block_flag);
     desc.modif			= modif & (~u32(0x3));
+	desc.blocks			= !!(size_compressed & fs_block_flag);
 //	Msg("registering file %s - %d", name, size_real);
 //	if file already exist - update info
-	files_it			I = m_files.find(desc);
+	files_it			I = files_find(desc.name);
 	if (I != m_files.end()) {
 //.		Msg("-- file already scanned [%s]", I->name);
 		desc.name		= I->name;
+		desc.hash		= I->hash;
 
 		// sad but true, performance option
 		// correct way is to erase and then insert new record:
@@ -227,7 +236,8 @@ void CLocatorAPI::Register		(LPCSTR name, u32 vfs, u32 crc, u32 ptr, u32 size_re
 	}
 
 	// otherwise insert file
-	m_files.insert		(desc); 
+	bool				inserted;
+	files_insert		(desc,inserted); 
 	
 	// Try to register folder(s)
 	string_path			temp;	
@@ -246,9 +256,11 @@ void CLocatorAPI::Register		(LPCSTR name, u32 vfs, u32 crc, u32 ptr, u32 size_re
 			desc.size_real		= 0;
 			desc.size_compressed= 0;
             desc.modif			= u32(-1);
-            std::pair<files_it,bool> I = m_files.insert(desc); 
+			desc.blocks			= false;
+            bool		inserted;
+            files_insert		(desc,inserted); 
 
-            R_ASSERT(I.second);
+            R_ASSERT(inserted);
 		}
 		xr_strcpy					(temp,sizeof(temp),folder);
 		if (xr_strlen(temp))		temp[xr_strlen(temp)-1]=0;
@@ -427,7 +439,9 @@ void CLocatorAPI::ProcessArchive(LPCSTR _path)
 		if (it->path==path)	
 				return;
 
+	m_files_lock.Enter			();
 	m_archives.push_back		(archive());
+	m_files_lock.Leave			();
 	archive& A					= m_archives.back();
 	A.vfs_idx					= m_archives.size()-1;
 	A.path						= path;
@@ -458,6 +472,8 @@ void CLocatorAPI::ProcessArchive(LPCSTR _path)
 
 void CLocatorAPI::unload_archive(CLocatorAPI::archive& A)
 {
+	prefetch_cancel	();
+	stream_flush	();
 	files_it	I 	= m_files.begin();
 	for (; I!=m_files.end(); ++I)
 	{
@@ -467,9 +483,7 @@ void CLocatorAPI::unload_archive(CLocatorAPI::archive& A)
 #ifndef MASTER_GOLD
 			Msg("unregistering file [%s]", I->name);
 #endif // #ifndef MASTER_GOLD
-			char* str		= LPSTR(I->name);
-			xr_free			(str);
-			m_files.erase	(I);
+			files_erase		(I);
 			break;
 		}
 	}	
@@ -809,6 +823,8 @@ void CLocatorAPI::_initialize	(u32 flags, LPCSTR target_folder, LPCSTR fs_name)
 	m_Flags.set		(flReady,TRUE);
 
 	Msg("Init FileSystem %f sec",t.GetElapsed_sec());
+	if (strstr(Core.Params,"-fs_bench"))
+		index_benchmark	();
 	//-----------------------------------------------------------
 	if (strstr(Core.Params, "-overlaypath"))
 	{
@@ -839,13 +855,16 @@ void CLocatorAPI::_initialize	(u32 flags, LPCSTR target_folder, LPCSTR fs_name)
 void CLocatorAPI::_destroy		()
 {
 	CloseLog		();
+	prefetch_destroy();
+	stream_destroy	();
+	fs_block_pool_destroy	();
 
 	for				(files_it I=m_files.begin(); I!=m_files.end(); I++)
 	{
 		char* str	= LPSTR(I->name);
 		xr_free		(str);
 	}
-	m_files.clear		();
+	files_clear			();
 	for				(PathPairIt p_it=pathes.begin(); p_it!=pathes.end(); p_it++)
     {
 		char* str	= LPSTR(p_it->first);
@@ -911,9 +930,7 @@ xr_vector<char*>* CLocatorAPI::file_list_open			(const char* _path, u32 flags)
 	else					
 		xr_strcpy(N,sizeof(N), _path);
 
-	file			desc;
-	desc.name		= N;
-	files_it	I 	= m_files.find(desc);
+	files_it	I 	= files_find(N);
 	if (I==m_files.end())	return 0;
 	
 	xr_vector<char*>*	dest	= xr_new<xr_vector<char*> > ();
@@ -969,9 +986,7 @@ int CLocatorAPI::file_list(FS_FileSet& dest, LPCSTR path, u32 flags, LPCSTR mask
     else			
 		xr_strcpy(N,sizeof(N),path);
 
-	file			desc;
-	desc.name		= N;
-	files_it	I 	= m_files.find(desc);
+	files_it	I 	= files_find(N);
 	if (I==m_files.end())	return 0;
 
 	SStringVec 		masks;
@@ -1117,30 +1132,41 @@ void CLocatorAPI::file_from_archive	(IReader *&R, LPCSTR fname, const file &desc
 {
 	// Archived one
 	archive& A					= m_archives[desc.vfs];
+	file_from_mapping			(R,A.hSrcMap,A.size,*A.path,fname,desc);
+}
+
+// the mapping is resolved by the caller, the stream workers don't touch m_archives
+void CLocatorAPI::file_from_mapping	(IReader *&R, void* hSrcMap, u32 map_size, LPCSTR archive_name, LPCSTR fname, const file &desc)
+{
 	u32 start					= (desc.ptr/dwAllocGranularity)*dwAllocGranularity;
 	u32 end						= (desc.ptr+desc.size_compressed)/dwAllocGranularity;
 	if ((desc.ptr+desc.size_compressed)%dwAllocGranularity)	end+=1;
 	end							*= dwAllocGranularity;
-	if (end>A.size)				end = A.size;
+	if (end>map_size)			end = map_size;
 	u32 sz						= (end-start);
-	u8* ptr						= (u8*)MapViewOfFile(A.hSrcMap, FILE_MAP_READ, 0, start, sz); VERIFY3(ptr,"cannot create file mapping on file",fname);
+	u8* ptr						= (u8*)MapViewOfFile(hSrcMap, FILE_MAP_READ, 0, start, sz); VERIFY3(ptr,"cannot create file mapping on file",fname);
 
 	string512					temp;
-	xr_sprintf					(temp, sizeof(temp),"%s:%s",*A.path,fname);
+	xr_sprintf					(temp, sizeof(temp),"%s:%s",archive_name,fname);
 
 #ifdef FS_DEBUG
 	register_file_mapping		(ptr,sz,temp);
 #endif // DEBUG
 
 	u32 ptr_offs				= desc.ptr-start;
-	if (desc.size_real == desc.size_compressed) {
+	if (!desc.blocks && (desc.size_real == desc.size_compressed)) {
 		R						= xr_new<CPackReader>(ptr,ptr+ptr_offs,desc.size_real);
 		return;
 	}
 
 	// Compressed
 	u8*							dest = xr_alloc<u8>(desc.size_real);
-	rtc_decompress				(dest,desc.size_real,ptr+ptr_offs,desc.size_compressed);
+	if (desc.blocks) {
+		CBlockIndex				I;
+		I.load					(ptr+ptr_offs,desc.ptr,desc.size_real);
+		fs_block_decompress		(dest,ptr,start,I,0,I.count());
+	} else
+		rtc_decompress			(dest,desc.size_real,ptr+ptr_offs,desc.size_compressed);
 	R							= xr_new<CTempReader>(dest,desc.size_real,0);
 	UnmapViewOfFile				(ptr);
 
@@ -1149,13 +1175,38 @@ void CLocatorAPI::file_from_archive	(IReader *&R, LPCSTR fname, const file &desc
 #endif // DEBUG
 }
 
+// maps the given part of an archive, returns the pointer to its first byte
+static u8* map_archive_range	(void* hSrcMap, u32 archive_size, u32 offset, u32 size, u8*& view)
+{
+	u32 start					= (offset/FS.dwAllocGranularity)*FS.dwAllocGranularity;
+	u32 end						= _min(offset+size,archive_size);
+	view						= (u8*)MapViewOfFile(hSrcMap, FILE_MAP_READ, 0, start, end-start);
+	R_ASSERT					(view);
+	return						view + (offset-start);
+}
+
 void CLocatorAPI::file_from_archive	(CStreamReader *&R, LPCSTR fname, const file &desc)
 {
 	archive						&A = m_archives[desc.vfs];
+	if (desc.blocks) {
+		// only the block table is read here, blocks are unpacked as the stream reaches them
+		u8*						view;
+		u32						count = ((u32*)map_archive_range(A.hSrcMap,A.size,desc.ptr,2*sizeof(u32),view))[1];
+		UnmapViewOfFile			(view);
+
+		CBlockIndex				I;
+		I.load					(map_archive_range(A.hSrcMap,A.size,desc.ptr,CBlockIndex::table_size(count),view),desc.ptr,desc.size_real);
+		UnmapViewOfFile			(view);
+
+		R						= xr_new<CStreamReader>();
+		R->construct_blocks		(A.hSrcMap,I,0,desc.size_real,A.size);
+		return;
+	}
+
 	R_ASSERT2					(
 		desc.size_compressed == desc.size_real,
 		make_string(
-			"cannot use stream reading for compressed data %s, do not compress data to be streamed",
+			"cannot use stream reading for compressed data %s, do not compress data to be streamed or pack it with -blocks",
 			fname
 		)
 	);
@@ -1270,10 +1321,7 @@ bool CLocatorAPI::check_for_file	(LPCSTR path, LPCSTR _fname, string_path& fname
 		update_path			(fname,path,fname);
 
 	// Search entry
-	file					desc_f;
-	desc_f.name				= fname;
-
-	files_it				I = m_files.find(desc_f);
+	files_it				I = files_find(fname);
 	if (I == m_files.end())
 		return				(false);
 
@@ -1293,11 +1341,16 @@ T *CLocatorAPI::r_open_impl	(LPCSTR path, LPCSTR _fname)
 	if (!check_for_file(path,_fname,fname,desc))
 		return				(0);
 
-	// OK, analyse
-	if (0xffffffff == desc->vfs)
-		file_from_cache		(R,fname,sizeof(fname),*desc,source_name);
-	else
-		file_from_archive	(R,fname,*desc);
+	// OK, analyse, unless a stream worker has read it already
+	bool const				streamed = stream_take(*desc,R);
+	if (!streamed)
+	{
+		if (0xffffffff == desc->vfs)
+			file_from_cache		(R,fname,sizeof(fname),*desc,source_name);
+		else
+			file_from_archive	(R,fname,*desc);
+	}
+	prefetch_opened			(*desc,R,streamed);
 
 #ifdef DEBUG
 	if (R && m_Flags.is(flBuildCopy|flReady))
@@ -1385,15 +1438,8 @@ CLocatorAPI::files_it CLocatorAPI::file_find_it(LPCSTR fname)
 	//     
     check_pathes	();
 
-	file			desc_f;
-	string_path		file_name;
-	VERIFY			(xr_strlen(fname)*sizeof(char) < sizeof(file_name));
-	xr_strcpy		(file_name,sizeof(file_name),fname);
-	desc_f.name		= file_name;
-//	desc_f.name		= xr_strlwr(xr_strdup(fname));
-    files_it I		= m_files.find(desc_f);
-//	xr_free			(desc_f.name);
-	return			(I);
+	VERIFY			(xr_strlen(fname)*sizeof(char) < sizeof(string_path));
+	return			(files_find(fname));
 }
 
 BOOL CLocatorAPI::dir_delete(LPCSTR path,LPCSTR nm,BOOL remove_files)
@@ -1418,7 +1464,7 @@ BOOL CLocatorAPI::dir_delete(LPCSTR path,LPCSTR nm,BOOL remove_files)
 //		        const char* entry_begin = entry.name+base_len;
 				if (!remove_files) return FALSE;
 		    	unlink		(entry.name);
-				m_files.erase	(cur_item);
+				files_erase	(cur_item);
 	        }else{
             	folders.insert(entry);
             }
@@ -1430,7 +1476,9 @@ BOOL CLocatorAPI::dir_delete(LPCSTR path,LPCSTR nm,BOOL remove_files)
 	    const char* end_symbol = r_it->name+xr_strlen(r_it->name)-1;
     	if ((*end_symbol) =='\\'){
         	_rmdir		(r_it->name);
-            m_files.erase	(*r_it);
+            files_it	I	= files_find(r_it->name);
+            if (I!=m_files.end())
+				files_erase	(I);
         }
     }
     return TRUE;
@@ -1446,9 +1494,7 @@ void CLocatorAPI::file_delete(LPCSTR path, LPCSTR nm)
     if (I!=m_files.end()){
 	    // remove file
     	unlink			(I->name);
-		char* str		= LPSTR(I->name);
-		xr_free			(str);
-	    m_files.erase		(I);
+	    files_erase		(I);
     }
 }
 
@@ -1475,19 +1521,16 @@ void CLocatorAPI::file_rename(LPCSTR src, LPCSTR dest, bool bOwerwrite)
 		if (D!=m_files.end()){ 
 	        if (!bOwerwrite) return;
             unlink		(D->name);
-			char* str	= LPSTR(D->name);
-			xr_free		(str);
-			m_files.erase	(D);
+			files_erase	(D);
         }
 
         file new_desc	= *S;
 		// remove existing item
-		char* str		= LPSTR(S->name);
-		xr_free			(str);
-		m_files.erase		(S);
+		files_erase		(S);
 		// insert updated item
         new_desc.name	= xr_strlwr(xr_strdup(dest));
-		m_files.insert	(new_desc); 
+		bool			inserted;
+		files_insert	(new_desc,inserted); 
         
         // physically rename file
         VerifyPath		(dest);
@@ -1514,7 +1557,9 @@ FS_Path* CLocatorAPI::append_path(LPCSTR path_alias, LPCSTR root, LPCSTR add, BO
 	FS_Path* P		= xr_new<FS_Path>(root,add,LPCSTR(0),LPCSTR(0),0);
 	bNoRecurse		= !recursive;
 	Recurse			(P->m_Path);
+	m_files_lock.Enter	();
 	pathes.insert	(mk_pair(xr_strdup(path_alias),P));
+	m_files_lock.Leave	();
 	return P;
 }
 
@@ -1583,9 +1628,7 @@ void CLocatorAPI::rescan_path(LPCSTR full_path, BOOL bRecurse)
 		const char* entry_begin = entry.name+base_len;
         if (!bRecurse&&strstr(entry_begin,"\\"))		continue;
         // erase item
-		char* str		= LPSTR(cur_item->name);
-		xr_free			(str);
-		m_files.erase		(cur_item);
+		files_erase		(cur_item);
 	}
     bNoRecurse	= !bRecurse;
     Recurse		(full_path);
@@ -28,6 +28,8 @@ public:
 		u32						size_real;		// 
 		u32						size_compressed;// if (size_real==size_compressed) - uncompressed
         u32						modif;			// for editor
+		bool					blocks;			// split into independently compressed blocks, see FS_blocks.h
+		u32						hash;			// of the name, see file_hash
 	};
 	struct	archive
 	{
@@ -64,9 +66,56 @@ private:
 	files_set					m_files			;
 	BOOL						bNoRecurse		;
 
+	// Open addressing index of m_files by file::hash. Exact name lookups go
+	// through it, ordered walks (file_list, rescan_path) still use the set.
+	struct	file_slot
+	{
+		files_it				it;
+		u32						hash;
+		u32						state;			// slot_empty, slot_used or slot_erased
+	};
+	enum	{ slot_empty = 0, slot_used, slot_erased };
+	xr_vector<file_slot>		m_index			;
+	u32							m_index_used	;
+	u32							m_index_erased	;
+	files_it					m_insert_hint	;	// archives register in order, see xrCompress
+
+	void						index_rebuild	(u32 size);
+	files_it					files_find		(LPCSTR name);
+	files_it					files_insert	(file& desc, bool& inserted);
+	void						files_erase		(files_it it);
+	void						files_clear		();
+	void						index_benchmark	();
+
 	xrCriticalSection			m_auth_lock		;
+	// taken by the writers of m_files, m_index, pathes and m_archives, and by
+	// the lookups made off the main thread (stream callbacks)
+	xrCriticalSection			m_files_lock	;
 	u64							m_auth_code		;
 
+	// background reading, see LocatorAPI_stream.cpp
+	struct						stream_state;
+	stream_state*				m_stream		;
+
+	static void					stream_thread	(void* params);
+	const file*					stream_find		(LPCSTR path, LPCSTR name);
+	bool						stream_take		(const file& desc, IReader*& R);
+	bool						stream_take		(const file& desc, CStreamReader*& R)	{ return false; }
+	bool						stream_drop		(const file& desc);
+	void						stream_destroy	();
+	u32							stream_window	();
+
+	// level load prefetch, see LocatorAPI_prefetch.cpp
+	struct						prefetch_state;
+	prefetch_state*				m_prefetch		;
+
+	void						prefetch_advance();
+	void						prefetch_opened	(const file& desc, IReader* R, bool streamed);
+	void						prefetch_opened	(const file& desc, CStreamReader* R, bool streamed)	{}
+	void						prefetch_forget	(const file& desc);
+	void						prefetch_cancel	();
+	void						prefetch_destroy();
+
 	void						Register		(LPCSTR name, u32 vfs, u32 crc, u32 ptr, u32 size_real, u32 size_compressed, u32 modif);
 	void						ProcessArchive	(LPCSTR path);
 	void						ProcessOne		(LPCSTR path, void* F);
@@ -74,6 +123,7 @@ private:
 
 	files_it					file_find_it	(LPCSTR n);
 public:
+	static u32					file_hash		(LPCSTR name);
 	enum{
 		flNeedRescan			= (1<<0),
 		flBuildCopy				= (1<<1),
@@ -99,6 +149,7 @@ private:
 			void				file_from_cache		(T *&R, LPSTR fname, const u32 &fname_size, const file &desc, LPCSTR &source_name);
 			
 			void				file_from_archive	(IReader *&R, LPCSTR fname, const file &desc);
+			void				file_from_mapping	(IReader *&R, void* hSrcMap, u32 map_size, LPCSTR archive_name, LPCSTR fname, const file &desc);
 			void				file_from_archive	(CStreamReader *&R, LPCSTR fname, const file &desc);
 
 			void				copy_file_to_build	(IWriter *W, IReader *r);
@@ -128,6 +179,24 @@ public:
 	void						r_close				(IReader* &S);
 	void						r_close				(CStreamReader* &fs);
 
+	// Reads the file on a worker thread ahead of its r_open, the lowest priority
+	// first; the callback runs on the worker over the data and may request the
+	// files it depends on. Pending until the file and those are in memory.
+	// Priorities: the distance to the camera in meters (>= 0), the level load
+	// prefetch goes ahead of those with stream_priority_prefetch.
+	typedef void				stream_callback		(IReader& data, float priority);
+	static float const			stream_priority_prefetch;		// + the order of the file in the manifest
+	void						stream_request		(LPCSTR path, LPCSTR name, float priority, stream_callback* callback=0);
+	bool						stream_pending		(LPCSTR path, LPCSTR name);
+	void						stream_flush		();
+	void						stream_stats		();
+
+	// Records the files opened from prefetch_begin to prefetch_end into the
+	// manifest of the level and streams the files of the previous manifest
+	// ahead of the loader (unless -no_prefetch).
+	void						prefetch_begin		(LPCSTR level);
+	void						prefetch_end		();
+
 	IWriter*					w_open				(LPCSTR initial, LPCSTR N);
 	IC IWriter*					w_open				(LPCSTR N){return w_open(0,N);}
 	IWriter*					w_open_ex			(LPCSTR initial, LPCSTR N);
@@ -0,0 +1,173 @@
+// LocatorAPI_index.cpp: hash index of the file set
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#pragma hdrstop
+
+static u32 const	index_min_size		= 1024;		// power of two
+
+// FNV-1a
+u32 CLocatorAPI::file_hash		(LPCSTR name)
+{
+	u32				h		= 2166136261u;
+	for (const u8* p=(const u8*)name; *p; ++p)
+		h					= (h ^ u32(*p))*16777619u;
+	return			h;
+}
+
+void CLocatorAPI::index_rebuild	(u32 size)
+{
+	xr_vector<file_slot>	old;
+	old.swap				(m_index);
+
+	file_slot				empty;
+	empty.hash				= 0;
+	empty.state				= slot_empty;
+	m_index.assign			(size,empty);
+	m_index_used			= 0;
+	m_index_erased			= 0;
+
+	u32 const		mask	= size-1;
+	for (u32 it=0; it<old.size(); ++it)
+	{
+		if (old[it].state!=slot_used)	continue;
+		u32			id		= old[it].hash&mask;
+		while (m_index[id].state!=slot_empty)
+			id				= (id+1)&mask;
+		m_index[id]			= old[it];
+		++m_index_used;
+	}
+}
+
+CLocatorAPI::files_it CLocatorAPI::files_find	(LPCSTR name)
+{
+	if (m_index.empty())	return m_files.end();
+
+	u32 const		hash	= file_hash(name);
+	u32 const		mask	= u32(m_index.size())-1;
+	for (u32 id=hash&mask; ; id=(id+1)&mask)
+	{
+		const file_slot&	S	= m_index[id];
+		if (S.state==slot_empty)	return m_files.end();
+		if ((S.state==slot_used) && (S.hash==hash) && (0==xr_strcmp(S.it->name,name)))
+			return			S.it;
+	}
+}
+
+// the writers take m_files_lock, the main thread looks up without it
+CLocatorAPI::files_it CLocatorAPI::files_insert	(file& desc, bool& inserted)
+{
+	desc.hash				= file_hash(desc.name);
+
+	files_it		I		= files_find(desc.name);
+	if (I!=m_files.end())
+	{
+		inserted			= false;
+		return				I;
+	}
+
+	m_files_lock.Enter		();
+
+	// keep load under 3/4, erased slots count as used
+	if ((m_index_used+m_index_erased+1)*4 >= u32(m_index.size())*3)
+	{
+		u32			size	= index_min_size;
+		while ((m_index_used+1)*2 >= size)	size *= 2;
+		index_rebuild		(size);
+	}
+
+	// sorted input (archive file tables) goes right before the hint, no tree search
+	bool			fits	= !m_files.empty();
+	if (fits && (m_insert_hint!=m_files.begin()))
+	{
+		files_it	prev	= m_insert_hint;	--prev;
+		fits				= xr_strcmp(prev->name,desc.name)<0;
+	}
+	if (fits && (m_insert_hint!=m_files.end()))
+		fits				= xr_strcmp(desc.name,m_insert_hint->name)<0;
+	I						= fits ? m_files.insert(m_insert_hint,desc) : m_files.insert(desc).first;
+	m_insert_hint			= I;	++m_insert_hint;
+
+	u32 const		mask	= u32(m_index.size())-1;
+	u32				id		= desc.hash&mask;
+	while (m_index[id].state==slot_used)
+		id					= (id+1)&mask;
+	if (m_index[id].state==slot_erased)
+		--m_index_erased;
+	m_index[id].it			= I;
+	m_index[id].hash		= desc.hash;
+	m_index[id].state		= slot_used;
+	++m_index_used;
+	m_files_lock.Leave		();
+
+	inserted				= true;
+	return					I;
+}
+
+// frees the name of the entry, under the lock: the stream workers look names
+// up from their callbacks
+void CLocatorAPI::files_erase	(files_it I)
+{
+	prefetch_forget			(*I);	// before m_files_lock, the prefetcher requests under its own lock
+	m_files_lock.Enter		();
+	stream_drop				(*I);
+	u32 const		mask	= u32(m_index.size())-1;
+	for (u32 id=I->hash&mask; m_index[id].state!=slot_empty; id=(id+1)&mask)
+	{
+		file_slot&	S		= m_index[id];
+		if ((S.state==slot_used) && (S.it==I))
+		{
+			S.state			= slot_erased;
+			--m_index_used;
+			++m_index_erased;
+			break;
+		}
+	}
+	if (m_insert_hint==I)	++m_insert_hint;
+	char*			str		= LPSTR(I->name);
+	m_files.erase			(I);
+	xr_free					(str);
+	m_files_lock.Leave		();
+}
+
+void CLocatorAPI::files_clear	()
+{
+	m_files_lock.Enter		();
+	m_files.clear			();
+	m_index.clear_and_free	();
+	m_index_used			= 0;
+	m_index_erased			= 0;
+	m_insert_hint			= m_files.end();
+	m_files_lock.Leave		();
+}
+
+// -fs_bench: exact lookups of every registered name, hash index vs the set
+void CLocatorAPI::index_benchmark	()
+{
+	xr_vector<LPCSTR>		names;
+	names.reserve			(m_files.size());
+	for (files_it I=m_files.begin(); I!=m_files.end(); ++I)
+		names.push_back		(I->name);
+	std::random_shuffle		(names.begin(),names.end());
+
+	u32				found	= 0;
+	CTimer			T;
+	T.Start					();
+	for (u32 it=0; it<names.size(); ++it)
+		found				+= (files_find(names[it])!=m_files.end()) ? 1 : 0;
+	float			t_hash	= T.GetElapsed_sec();
+
+	T.Start					();
+	file			desc;
+	for (u32 it=0; it<names.size(); ++it)
+	{
+		desc.name			= names[it];
+		found				+= (m_files.find(desc)!=m_files.end()) ? 1 : 0;
+	}
+	float			t_set	= T.GetElapsed_sec();
+
+	Msg				("FS: %d lookups, hash index %3.3f ms, sorted set %3.3f ms (%d found)",
+		names.size(),t_hash*1000.f,t_set*1000.f,found);
+	Msg				("FS: index %d slots, %d used, %d erased",m_index.size(),m_index_used,m_index_erased);
+}
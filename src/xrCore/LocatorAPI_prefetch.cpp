@@ -0,0 +1,283 @@
+// LocatorAPI_prefetch.cpp: the files of a level load recorded and read ahead on the next one
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#pragma hdrstop
+
+// Between prefetch_begin and prefetch_end the files the loader opens are
+// recorded in order into a manifest of the level. When the level is loaded
+// again, the files of its manifest are requested from the stream workers
+// (see LocatorAPI_stream.cpp) in the same order, kept a window ahead of the
+// loader, so r_open finds them read and unpacked. The manifest also keeps the
+// last load time with the prefetcher and without it (-no_prefetch).
+// The state points at the file nodes, files_erase takes the erased ones out
+// (prefetch_forget).
+
+namespace
+{
+
+u32 const		prefetch_version	= 1;
+
+void prefetch_manifest_name		(string_path& fn, LPCSTR level)
+{
+	xr_sprintf				(fn,sizeof(fn),"prefetch\\%s.prefetch",level);
+}
+
+} // namespace
+
+struct CLocatorAPI::prefetch_state
+{
+	DEFINE_MAP					(const file*,u32,INDEX,INDEX_IT);
+	DEFINE_SET					(const file*,OPENED,OPENED_IT);
+
+	xrCriticalSection			lock;
+	volatile LONG				active;
+	string_path					level;
+	bool						replay;
+	CTimer						timer;
+
+	// the manifest replayed, 0 - erased during the load
+	xr_vector<const file*>		manifest;
+	xr_vector<u32>				offsets;		// of the files in the manifest, in bytes
+	INDEX						index;
+	u32							cursor;			// the next file to request
+	u32							position;		// past the furthest file the loader opened
+	u32							window;
+	u32							stale;			// gone or changed since the recording
+	u32							hits;
+
+	// the manifest recorded
+	xr_vector<const file*>		recorded;
+	OPENED						opened;
+	u32							recorded_bytes;
+
+	u32							load_ms_on;
+	u32							load_ms_off;
+
+	prefetch_state				()
+#ifdef PROFILE_CRITICAL_SECTIONS
+		:lock					(MUTEX_PROFILE_ID(CLocatorAPI::prefetch_state::lock))
+#endif // PROFILE_CRITICAL_SECTIONS
+	{
+		active					= 0;
+		level[0]				= 0;
+		clear					();
+	}
+
+	void						clear			()
+	{
+		replay					= false;
+		manifest.clear			();
+		offsets.clear			();
+		index.clear				();
+		cursor					= 0;
+		position				= 0;
+		window					= 0;
+		stale					= 0;
+		hits					= 0;
+		recorded.clear			();
+		opened.clear			();
+		recorded_bytes			= 0;
+		load_ms_on				= 0;
+		load_ms_off				= 0;
+	}
+};
+
+void CLocatorAPI::prefetch_begin	(LPCSTR level)
+{
+	if (!m_prefetch)	m_prefetch	= xr_new<prefetch_state>();
+	prefetch_state&		P		= *m_prefetch;
+	if (P.active)		return;
+
+	P.clear				();
+	xr_strcpy			(P.level,level);
+	P.replay			= (0==strstr(Core.Params,"-no_prefetch"));
+
+	// read while not recording
+	string_path			fn;
+	prefetch_manifest_name	(fn,level);
+	if (exist("$app_data_root$",fn))
+	{
+		IReader*		F	= r_open("$app_data_root$",fn);
+		if (F && F->length()>=4*sizeof(u32) && F->r_u32()==prefetch_version)
+		{
+			P.load_ms_on	= F->r_u32();
+			P.load_ms_off	= F->r_u32();
+			u32 count		= F->r_u32();
+			P.offsets.push_back	(0);
+			for (u32 i=0; i<count && !F->eof(); ++i)
+			{
+				string_path	name;
+				F->r_stringZ	(name,sizeof(name));
+				u32 size	= F->r_u32();
+
+				files_it	I	= files_find(name);
+				if (I==m_files.end() || I->size_real!=size)
+				{
+					P.stale	++;
+					continue;
+				}
+				P.index.insert		(mk_pair(&*I,P.manifest.size()));
+				P.manifest.push_back(&*I);
+				P.offsets.push_back	(P.offsets.back()+size);
+			}
+		}
+		r_close			(F);
+	}
+
+	if (P.replay && !P.manifest.empty())
+	{
+		P.window		= stream_window();
+		P.lock.Enter	();
+		prefetch_advance();
+		P.lock.Leave	();
+	}
+
+	P.timer.Start		();
+	InterlockedExchange	(&P.active,1);
+}
+
+// under the lock
+void CLocatorAPI::prefetch_advance	()
+{
+	prefetch_state&		P		= *m_prefetch;
+	if (P.cursor<P.position)
+		P.cursor		= P.position;
+
+	// the nearest file goes even if it alone is over the window
+	while ((P.cursor<P.manifest.size()) && ((P.cursor==P.position) || (P.offsets[P.cursor+1]-P.offsets[P.position]<=P.window)))
+	{
+		if (P.manifest[P.cursor])
+			stream_request	(0,P.manifest[P.cursor]->name,stream_priority_prefetch+float(P.cursor));
+		P.cursor		++;
+	}
+}
+
+// the file node is about to be freed
+void CLocatorAPI::prefetch_forget	(const file& desc)
+{
+	if (!m_prefetch || !m_prefetch->active)
+		return;
+
+	prefetch_state&		P		= *m_prefetch;
+	P.lock.Enter		();
+	if (P.active)
+	{
+		prefetch_state::INDEX_IT it	= P.index.find(&desc);
+		if (it!=P.index.end())
+		{
+			P.manifest[it->second]	= 0;
+			P.index.erase	(it);
+		}
+		if (P.opened.erase(&desc))
+		{
+			P.recorded.erase	(std::find(P.recorded.begin(),P.recorded.end(),&desc));
+			P.recorded_bytes	-= desc.size_real;
+		}
+	}
+	P.lock.Leave		();
+}
+
+void CLocatorAPI::prefetch_opened	(const file& desc, IReader* R, bool streamed)
+{
+	if (!m_prefetch || !m_prefetch->active || !R)
+		return;
+
+	prefetch_state&		P		= *m_prefetch;
+	P.lock.Enter		();
+	if (P.active)
+	{
+		if (P.opened.insert(&desc).second)
+		{
+			P.recorded.push_back(&desc);
+			P.recorded_bytes	+= desc.size_real;
+		}
+
+		prefetch_state::INDEX_IT it	= P.index.find(&desc);
+		if (it!=P.index.end())
+		{
+			if (streamed)
+				P.hits	++;
+			if (it->second>=P.position)
+			{
+				P.position	= it->second+1;
+				prefetch_advance();
+			}
+		}
+	}
+	P.lock.Leave		();
+}
+
+void CLocatorAPI::prefetch_end		()
+{
+	if (!m_prefetch || !m_prefetch->active)
+		return;
+
+	// active until the state is cleared, files_erase patches it meanwhile
+	prefetch_state&		P		= *m_prefetch;
+	P.lock.Enter		();
+
+	u32 const			load_ms		= P.timer.GetElapsed_ms();
+	bool const			replayed	= P.replay && !P.manifest.empty();
+
+	Msg					("* FS prefetch: %s, %d files (%d KB) opened, %d of %d from the manifest served from memory, %d stale",
+						P.level,P.recorded.size(),P.recorded_bytes>>10,P.hits,P.manifest.size(),P.stale);
+	Msg					("* FS prefetch: %s loaded in %d ms %s, the last load %d ms with the prefetcher and %d ms without",
+						P.level,load_ms,replayed ? "prefetched" : "not prefetched",P.load_ms_on,P.load_ms_off);
+
+	if (replayed)		P.load_ms_on	= load_ms;
+	else				P.load_ms_off	= load_ms;
+
+	string_path			fn;
+	prefetch_manifest_name	(fn,P.level);
+	IWriter*			W			= w_open("$app_data_root$",fn);
+	if (W)
+	{
+		W->w_u32		(prefetch_version);
+		W->w_u32		(P.load_ms_on);
+		W->w_u32		(P.load_ms_off);
+		W->w_u32		(P.recorded.size());
+		for (u32 i=0; i<P.recorded.size(); ++i)
+		{
+			W->w_stringZ(P.recorded[i]->name);
+			W->w_u32	(P.recorded[i]->size_real);
+		}
+		w_close			(W);
+	}
+
+	// the files requested but not opened are freed, a stale manifest shows here
+	u32					unused		= 0;
+	u32					unused_bytes= 0;
+	for (u32 i=0; i<P.cursor; ++i)
+	{
+		if (!P.manifest[i] || (P.opened.find(P.manifest[i])!=P.opened.end()))
+			continue;
+		stream_drop		(*P.manifest[i]);
+		unused			++;
+		unused_bytes	+= P.offsets[i+1]-P.offsets[i];
+	}
+	if (unused)
+		Msg				("* FS prefetch: %s, %d prefetched files (%d KB) were not opened and are freed",P.level,unused,unused_bytes>>10);
+
+	InterlockedExchange	(&P.active,0);
+	P.clear				();
+	P.lock.Leave		();
+}
+
+void CLocatorAPI::prefetch_cancel	()
+{
+	if (!m_prefetch)	return;
+
+	prefetch_state&		P		= *m_prefetch;
+	P.lock.Enter		();
+	InterlockedExchange	(&P.active,0);
+	P.clear				();
+	P.lock.Leave		();
+}
+
+void CLocatorAPI::prefetch_destroy	()
+{
+	prefetch_cancel		();
+	xr_delete			(m_prefetch);
+}
@@ -0,0 +1,477 @@
+// LocatorAPI_stream.cpp: background reading of files requested ahead of r_open
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#pragma hdrstop
+
+#include "FS_internal.h"
+#include "frame_arena.h"
+
+// A requested file is read (and unpacked) by a worker thread into memory, the
+// nearest request (the lowest priority value) first. The next r_open of the
+// file takes the memory instead of mapping the archive. A callback given with
+// the request runs on the worker over the data and may request more files,
+// the file stays pending until they are read too. Resident files over the
+// budget are dropped, the oldest first.
+// The file and its archive mapping are resolved under m_files_lock when the
+// file is requested, the worker reads from the copy and never looks into the
+// file set, which the main thread may rescan meanwhile. Entries are keyed by
+// the file node: files_erase drops the entry of a node it frees, and the
+// request keeps m_files_lock until its entry is in (m_files_lock, then
+// S.lock, the workers run the callbacks with neither held).
+
+float const		CLocatorAPI::stream_priority_prefetch	= -1000000.f;
+
+namespace
+{
+
+u32 const		stream_threads_max	= 2;
+u32 const		stream_budget		= 64*1024*1024;
+
+enum
+{
+	stream_queued		= 0,
+	stream_loading,
+	stream_resident,
+};
+
+__declspec(thread) CLocatorAPI::file const*	t_stream_parent	= 0;
+
+} // namespace
+
+struct CLocatorAPI::stream_state
+{
+	struct source
+	{
+		file				desc;			// a copy, the name points to the path below
+		string_path			path;
+		void*				hSrcMap;		// of the archive, 0 for a standart file
+		u32					map_size;
+		LPCSTR				archive_name;
+	};
+	struct entry
+	{
+		const file*			desc;			// the key, not read by the workers
+		source				src;
+		const file*			parent;
+		stream_callback*	callback;
+		float				priority;
+		u32					state;
+		u32					children;		// pending requests made by the callback
+		bool				dropped;		// freed as soon as it is read
+		u8*					data;
+		u32					time;			// of the request, of the read when resident
+		u64					read_ticks;
+	};
+	DEFINE_MAP					(const file*,entry*,ENTRIES,ENTRIES_IT);
+
+	xrCriticalSection			lock;
+	HANDLE						semaphore;
+	ENTRIES						entries;
+	xr_vector<entry*>			queue;
+	u32							loading;
+	u32							resident_bytes;
+	u32							budget;
+	u32							threads;
+	volatile LONG				threads_running;
+	volatile LONG				quit;
+
+	// statistic
+	u32							requests;
+	u32							hits;			// r_open served from memory
+	u32							late;			// r_open of a file still being read
+	u32							evicted;
+	u64							bytes_read;
+	u64							read_ticks;
+	u64							hit_ticks;		// read time of the files served from memory
+	u32							hit_bytes;
+
+	stream_state				()
+#ifdef PROFILE_CRITICAL_SECTIONS
+		:lock					(MUTEX_PROFILE_ID(CLocatorAPI::stream_state::lock))
+#endif // PROFILE_CRITICAL_SECTIONS
+	{
+		semaphore				= CreateSemaphore(0,0,0x7fffffff,0);
+		loading					= 0;
+		resident_bytes			= 0;
+		budget					= stream_budget;
+		threads					= 0;
+		threads_running			= 0;
+		quit					= 0;
+		requests				= 0;
+		hits					= 0;
+		late					= 0;
+		evicted					= 0;
+		bytes_read				= 0;
+		read_ticks				= 0;
+		hit_ticks				= 0;
+		hit_bytes				= 0;
+
+		if (LPCSTR param = strstr(Core.Params,"-stream_budget "))
+		{
+			int					mb	= 0;
+			sscanf				(param+xr_strlen("-stream_budget "),"%d",&mb);
+			if (mb>0)			budget	= u32(mb)*1024*1024;
+		}
+	}
+	~stream_state				()
+	{
+		CloseHandle				(semaphore);
+	}
+
+	// under the lock
+	void						erase			(ENTRIES_IT it)
+	{
+		entry*			E		= it->second;
+		if (E->state==stream_resident)
+			resident_bytes		-= E->src.desc.size_real;
+		xr_free					(E->data);
+		xr_delete				(E);
+		entries.erase			(it);
+	}
+	void						child_done		(const file* parent)
+	{
+		if (!parent)			return;
+		ENTRIES_IT		it		= entries.find(parent);
+		if (it!=entries.end() && it->second->children)
+			it->second->children--;
+	}
+	entry*						pop_nearest		()
+	{
+		if (queue.empty())		return 0;
+		u32				best	= 0;
+		for (u32 i=1; i<queue.size(); ++i)
+			if (queue[i]->priority<queue[best]->priority)
+				best			= i;
+		entry*			E		= queue[best];
+		queue[best]				= queue.back();
+		queue.pop_back			();
+		return					E;
+	}
+	void						evict			(u32 size)
+	{
+		while (resident_bytes && (resident_bytes+size>budget))
+		{
+			ENTRIES_IT	oldest	= entries.end();
+			for (ENTRIES_IT it=entries.begin(); it!=entries.end(); ++it)
+				if (it->second->state==stream_resident && (oldest==entries.end() || it->second->time<oldest->second->time))
+					oldest		= it;
+			if (oldest==entries.end())
+				break;
+			erase				(oldest);
+			evicted				++;
+		}
+	}
+};
+
+void CLocatorAPI::stream_thread		(void* params)
+{
+	CLocatorAPI*		self	= (CLocatorAPI*)params;
+	stream_state&		S		= *self->m_stream;
+
+	while (!S.quit)
+	{
+		WaitForSingleObject		(S.semaphore,INFINITE);
+
+		S.lock.Enter			();
+		stream_state::entry* E	= S.pop_nearest();
+		if (!E || S.quit)
+		{
+			S.lock.Leave		();
+			continue;
+		}
+		E->state				= stream_loading;
+		S.loading				++;
+		S.evict					(E->src.desc.size_real);
+		S.lock.Leave			();
+
+		stream_state::source&	src		= E->src;
+		const file&		desc	= src.desc;
+		CTimer			T;		T.Start();
+
+		IReader*		R		= 0;
+		if (0xffffffff==desc.vfs)
+			self->file_from_cache_impl	(R,src.path,desc);
+		else
+			self->file_from_mapping		(R,src.hSrcMap,src.map_size,src.archive_name,src.path,desc);
+
+		u8*				data	= xr_alloc<u8>(_max(desc.size_real,1u));
+		CopyMemory				(data,R->pointer(),desc.size_real);
+		xr_delete				(R);
+
+		if (E->callback)
+		{
+			IReader				F(data,desc.size_real);
+			t_stream_parent		= E->desc;
+			E->callback			(F,E->priority);
+			t_stream_parent		= 0;
+		}
+
+		S.lock.Enter			();
+		E->data					= data;
+		E->read_ticks			= T.GetElapsed_ticks();
+		E->time					= GetTickCount();
+		E->state				= stream_resident;
+		S.loading				--;
+		S.resident_bytes		+= desc.size_real;
+		S.bytes_read			+= desc.size_real;
+		S.read_ticks			+= E->read_ticks;
+		S.child_done			(E->parent);
+		if (E->dropped)
+			S.erase				(S.entries.find(E->desc));
+		S.lock.Leave			();
+	}
+
+	frame_arena_thread_exit		();
+	InterlockedDecrement		(&S.threads_running);
+}
+
+// under m_files_lock
+const CLocatorAPI::file* CLocatorAPI::stream_find	(LPCSTR path, LPCSTR name)
+{
+	// no check_pathes, the callbacks request from the workers
+	string_path			fname;
+	xr_strcpy			(fname,name);
+	xr_strlwr			(fname);
+	if (path&&path[0])
+		update_path		(fname,path,fname);
+
+	files_it			I = files_find(fname);
+	return				(I==m_files.end()) ? 0 : &*I;
+}
+
+void CLocatorAPI::stream_request	(LPCSTR path, LPCSTR name, float priority, stream_callback* callback)
+{
+	stream_state::source	src;
+	m_files_lock.Enter	();
+	const file*			desc	= stream_find(path,name);
+	if (desc)
+	{
+		src.desc		= *desc;
+		xr_strcpy		(src.path,desc->name);
+		src.desc.name	= src.path;
+		src.hSrcMap		= 0;
+		src.map_size	= 0;
+		src.archive_name= 0;
+		if (0xffffffff!=desc->vfs)
+		{
+			archive&	A		= m_archives[desc->vfs];
+			src.hSrcMap		= A.hSrcMap;
+			src.map_size	= A.size;
+			src.archive_name= *A.path;
+		}
+	}
+	if (!desc)
+	{
+		m_files_lock.Leave	();
+		return;
+	}
+
+	if (!m_stream)		m_stream	= xr_new<stream_state>();
+	stream_state&		S		= *m_stream;
+
+	S.lock.Enter		();
+	stream_state::ENTRIES_IT it	= S.entries.find(desc);
+	if (it!=S.entries.end())
+	{
+		// requested again, possibly nearer
+		stream_state::entry* E	= it->second;
+		if (E->state==stream_queued)
+			E->priority			= _min(E->priority,priority);
+		S.lock.Leave	();
+		m_files_lock.Leave	();
+		return;
+	}
+
+	if (src.desc.size_real>S.budget/4)
+	{
+		S.lock.Leave	();
+		m_files_lock.Leave	();
+		return;
+	}
+
+	stream_state::entry* E		= xr_new<stream_state::entry>();
+	E->desc				= desc;
+	E->src				= src;
+	E->src.desc.name	= E->src.path;
+	E->parent			= t_stream_parent;
+	E->callback			= callback;
+	E->priority			= priority;
+	E->state			= stream_queued;
+	E->children			= 0;
+	E->dropped			= false;
+	E->data				= 0;
+	E->time				= GetTickCount();
+	E->read_ticks		= 0;
+	S.entries.insert	(mk_pair(desc,E));
+	S.queue.push_back	(E);
+	S.requests			++;
+
+	if (E->parent)
+	{
+		stream_state::ENTRIES_IT p	= S.entries.find(E->parent);
+		if (p!=S.entries.end())
+			p->second->children++;
+	}
+
+	if (0==S.threads)
+	{
+		S.threads		= _max(_min(CPU::ID.n_threads/2,stream_threads_max),1u);
+		for (u32 i=0; i<S.threads; ++i)
+		{
+			InterlockedIncrement	(&S.threads_running);
+			thread_spawn			(stream_thread,"FS-stream",0,this);
+		}
+	}
+	S.lock.Leave		();
+	m_files_lock.Leave	();
+
+	ReleaseSemaphore	(S.semaphore,1,0);
+}
+
+bool CLocatorAPI::stream_pending	(LPCSTR path, LPCSTR name)
+{
+	if (!m_stream)		return false;
+
+	m_files_lock.Enter	();
+	const file*			desc	= stream_find(path,name);
+	m_files_lock.Leave	();
+	if (!desc)			return false;
+
+	stream_state&		S		= *m_stream;
+	S.lock.Enter		();
+	stream_state::ENTRIES_IT it	= S.entries.find(desc);
+	bool				result	= (it!=S.entries.end()) && ((it->second->state!=stream_resident) || it->second->children);
+	S.lock.Leave		();
+	return				result;
+}
+
+bool CLocatorAPI::stream_take		(const file& desc, IReader*& R)
+{
+	if (!m_stream)		return false;
+
+	stream_state&		S		= *m_stream;
+	S.lock.Enter		();
+	stream_state::ENTRIES_IT it	= S.entries.find(&desc);
+	if (it==S.entries.end())
+	{
+		S.lock.Leave	();
+		return			false;
+	}
+
+	stream_state::entry* E		= it->second;
+	switch (E->state)
+	{
+	case stream_queued:
+		// read here anyway, the request is dropped
+		S.queue.erase	(std::find(S.queue.begin(),S.queue.end(),E));
+		S.child_done	(E->parent);
+		S.erase			(it);
+		break;
+	case stream_loading:
+		S.late			++;
+		break;
+	case stream_resident:
+		R				= xr_new<CTempReader>(E->data,E->src.desc.size_real,0);
+		E->data			= 0;
+		S.hits			++;
+		S.hit_bytes		+= E->src.desc.size_real;
+		S.hit_ticks		+= E->read_ticks;
+		S.erase			(it);
+		break;
+	}
+	S.lock.Leave		();
+	return				(R!=0);
+}
+
+// frees the request of the file whatever its state, returns false if there was none
+bool CLocatorAPI::stream_drop		(const file& desc)
+{
+	if (!m_stream)		return false;
+
+	stream_state&		S		= *m_stream;
+	S.lock.Enter		();
+	stream_state::ENTRIES_IT it	= S.entries.find(&desc);
+	if (it==S.entries.end())
+	{
+		S.lock.Leave	();
+		return			false;
+	}
+
+	stream_state::entry* E		= it->second;
+	switch (E->state)
+	{
+	case stream_queued:
+		S.queue.erase	(std::find(S.queue.begin(),S.queue.end(),E));
+		S.child_done	(E->parent);
+		S.erase			(it);
+		break;
+	case stream_loading:
+		E->dropped		= true;
+		break;
+	case stream_resident:
+		S.erase			(it);
+		break;
+	}
+	S.lock.Leave		();
+	return				true;
+}
+
+void CLocatorAPI::stream_flush		()
+{
+	if (!m_stream)		return;
+
+	stream_state&		S		= *m_stream;
+	for (;;)
+	{
+		S.lock.Enter	();
+		S.queue.clear	();
+		if (0==S.loading)
+			break;
+		S.lock.Leave	();
+		Sleep			(1);
+	}
+	while (!S.entries.empty())
+		S.erase			(S.entries.begin());
+	S.lock.Leave		();
+}
+
+void CLocatorAPI::stream_destroy	()
+{
+	if (!m_stream)		return;
+
+	stream_flush		();
+	m_stream->quit		= 1;
+	ReleaseSemaphore	(m_stream->semaphore,m_stream->threads,0);
+	while (m_stream->threads_running)
+		Sleep			(1);
+	xr_delete			(m_stream);
+}
+
+u32 CLocatorAPI::stream_window		()
+{
+	// a half of the budget, the rest holds the files read but not yet taken
+	if (!m_stream)		m_stream	= xr_new<stream_state>();
+	return				m_stream->budget/2;
+}
+
+void CLocatorAPI::stream_stats		()
+{
+	if (!m_stream)
+	{
+		Msg				("* FS stream: no requests");
+		return;
+	}
+
+	stream_state&		S		= *m_stream;
+	S.lock.Enter		();
+	float const		read_sec	= float(double(S.read_ticks)/double(CPU::qpc_freq));
+	float const		hit_ms		= float(double(S.hit_ticks)*1000.0/double(CPU::qpc_freq));
+	Msg					("* FS stream: %d requests, %d served from memory (%2.1f ms of reading off the calling thread), %d read too late, %d evicted",
+						S.requests,S.hits,hit_ms,S.late,S.evicted);
+	Msg					("* FS stream: %d MB read in %2.2f s (%2.1f MB/s), %d KB resident of %d KB, %d queued, %d threads",
+						u32(S.bytes_read>>20),read_sec,read_sec>0.f ? float(double(S.bytes_read)/(1024.0*1024.0))/read_sec : 0.f,
+						S.resident_bytes>>10,S.budget>>10,S.queue.size(),S.threads);
+	S.lock.Leave		();
+}
@@ -3,8 +3,11 @@
 
 #include "fs_internal.h"
 
+void	ini_stat_read		(LPCSTR S, LPCSTR L);	// Xr_ini_handles.cpp
+
 XRCORE_API CInifile const * pSettings		= NULL;
 XRCORE_API CInifile const * pSettingsAuth	= NULL;
+XRCORE_API BOOL             ps_ini_cache_log	= FALSE;
 
 CInifile* CInifile::Create(const char* szFileName, BOOL ReadOnly)
 {	return xr_new<CInifile>(szFileName,ReadOnly); }
@@ -101,6 +104,10 @@ CInifile::CInifile(IReader* F ,LPCSTR path
 	m_flags.set		(eSaveAtEnd,		FALSE);
 	m_flags.set		(eReadOnly,			TRUE);
 	m_flags.set		(eOverrideNames,	FALSE);
+	m_values_free	= 0;
+#ifndef _EDITOR
+	m_load_deps		= 0;
+#endif
 	Load			(F,path
     #ifndef _EDITOR
     , allow_include_func
@@ -129,13 +136,37 @@ CInifile::CInifile(LPCSTR szFileName,
 
 	m_flags.set		(eSaveAtEnd, SaveAtEnd);
 	m_flags.set		(eReadOnly, ReadOnly);
+	m_values_free	= 0;
+#ifndef _EDITOR
+	m_load_deps		= 0;
+#endif
 
 	if (bLoad)
 	{	
+#ifndef _EDITOR
+		// read-only files without an include filter are taken from the binary cache when it is up to date
+		CTimer		T;
+		T.Start		();
+		string_path	cache;
+		bool const	b_cache	= ReadOnly && !allow_include_func && cache_name(cache);
+		if (b_cache && load_cache(cache))
+		{
+			if (ps_ini_cache_log)
+				Msg	("* [%s]: %d sections from cache in %2.3f ms",m_file_name,DATA.size(),T.GetElapsed_sec()*1000.f);
+			return;
+		}
+		xr_vector<shared_str>	deps;
+		if (b_cache)
+		{
+			deps.push_back	(m_file_name);
+			m_load_deps		= &deps;
+		}
+#endif
     	string_path	path,folder; 
 		_splitpath	(m_file_name, path, folder, 0, 0 );
         xr_strcat		(path,sizeof(path),folder);
 		IReader* R 	= FS.r_open(szFileName);
+		bool const	b_loaded	= (0!=R);
         if (R){
 			if(sect_count)
 				DATA.reserve(sect_count);
@@ -146,6 +177,15 @@ CInifile::CInifile(LPCSTR szFileName,
             );
 			FS.r_close	(R);
         }
+#ifndef _EDITOR
+		m_load_deps		= 0;
+		if (b_loaded && b_cache)
+		{
+			if (ps_ini_cache_log)
+				Msg	("* [%s]: %d sections parsed in %2.3f ms",m_file_name,DATA.size(),T.GetElapsed_sec()*1000.f);
+			save_cache	(cache,deps);
+		}
+#endif
 	}
 }
 
@@ -161,6 +201,9 @@ CInifile::~CInifile( )
 	RootIt			E = DATA.end();
 	for ( ; I != E; ++I)
 		xr_delete	(*I);
+
+	for (u32 it=0; it<m_values.size(); ++it)
+		xr_free		(m_values[it]);
 }
 
 static void	insert_item(CInifile::Sect *tgt, const CInifile::Item& I)
@@ -254,6 +297,10 @@ void	CInifile::Load(IReader* F, LPCSTR path
 #endif                
 				{
 					IReader* I 	= FS.r_open(fn); R_ASSERT3(I,"Can't find include file:", inc_name);
+#ifndef _EDITOR
+					if (m_load_deps)
+						m_load_deps->push_back	(fn);
+#endif
             		Load		(I,inc_path
                     #ifndef _EDITOR
                     , allow_include_func
@@ -531,24 +578,28 @@ shared_str		CInifile::r_string_wb(LPCSTR S, LPCSTR L)const
 
 u8 CInifile::r_u8(LPCSTR S, LPCSTR L)const
 {
+	ini_stat_read	(S,L);
 	LPCSTR		C = r_string(S,L);
 	return		u8(atoi(C));
 }
 
 u16 CInifile::r_u16(LPCSTR S, LPCSTR L)const
 {
+	ini_stat_read	(S,L);
 	LPCSTR		C = r_string(S,L);
 	return		u16(atoi(C));
 }
 
 u32 CInifile::r_u32(LPCSTR S, LPCSTR L)const
 {
+	ini_stat_read	(S,L);
 	LPCSTR		C = r_string(S,L);
 	return		u32(atoi(C));
 }
 
 u64 CInifile::r_u64(LPCSTR S, LPCSTR L)const
 {
+	ini_stat_read	(S,L);
 	LPCSTR		C = r_string(S,L);
 #ifndef _EDITOR
 	return		_strtoui64(C,NULL,10);
@@ -559,36 +610,42 @@ u64 CInifile::r_u64(LPCSTR S, LPCSTR L)const
 
 s64 CInifile::r_s64(LPCSTR S, LPCSTR L)const
 {
+	ini_stat_read	(S,L);
 	LPCSTR		C = r_string(S,L);
 	return		_atoi64(C);
 }
 
 s8 CInifile::r_s8(LPCSTR S, LPCSTR L)const
 {
+	ini_stat_read	(S,L);
 	LPCSTR		C = r_string(S,L);
 	return		s8(atoi(C));
 }
 
 s16 CInifile::r_s16(LPCSTR S, LPCSTR L)const
 {
+	ini_stat_read	(S,L);
 	LPCSTR		C = r_string(S,L);
 	return		s16(atoi(C));
 }
 
 s32 CInifile::r_s32(LPCSTR S, LPCSTR L)const
 {
+	ini_stat_read	(S,L);
 	LPCSTR		C = r_string(S,L);
 	return		s32(atoi(C));
 }
 
 float CInifile::r_float(LPCSTR S, LPCSTR L)const
 {
+	ini_stat_read	(S,L);
 	LPCSTR		C = r_string(S,L);
 	return		float(atof( C ));
 }
 
 Fcolor CInifile::r_fcolor( LPCSTR S, LPCSTR L )const
 {
+	ini_stat_read	(S,L);
 	LPCSTR		C = r_string(S,L);
 	Fcolor		V={0,0,0,0};
 	sscanf		(C,"%f,%f,%f,%f",&V.r,&V.g,&V.b,&V.a);
@@ -597,6 +654,7 @@ Fcolor CInifile::r_fcolor( LPCSTR S, LPCSTR L )const
 
 u32 CInifile::r_color( LPCSTR S, LPCSTR L )const
 {
+	ini_stat_read	(S,L);
 	LPCSTR		C = r_string(S,L);
 	u32			r=0,g=0,b=0,a=255;
 	sscanf		(C,"%d,%d,%d,%d",&r,&g,&b,&a);
@@ -605,6 +663,7 @@ u32 CInifile::r_color( LPCSTR S, LPCSTR L )const
 
 Ivector2 CInifile::r_ivector2( LPCSTR S, LPCSTR L )const
 {
+	ini_stat_read	(S,L);
 	LPCSTR		C = r_string(S,L);
 	Ivector2	V={0,0};
 	sscanf		(C,"%d,%d",&V.x,&V.y);
@@ -613,6 +672,7 @@ Ivector2 CInifile::r_ivector2( LPCSTR S, LPCSTR L )const
 
 Ivector3 CInifile::r_ivector3( LPCSTR S, LPCSTR L )const
 {
+	ini_stat_read	(S,L);
 	LPCSTR		C = r_string(S,L);
 	Ivector		V={0,0,0};
 	sscanf		(C,"%d,%d,%d",&V.x,&V.y,&V.z);
@@ -621,6 +681,7 @@ Ivector3 CInifile::r_ivector3( LPCSTR S, LPCSTR L )const
 
 Ivector4 CInifile::r_ivector4( LPCSTR S, LPCSTR L )const
 {
+	ini_stat_read	(S,L);
 	LPCSTR		C = r_string(S,L);
 	Ivector4	V={0,0,0,0};
 	sscanf		(C,"%d,%d,%d,%d",&V.x,&V.y,&V.z,&V.w);
@@ -629,6 +690,7 @@ Ivector4 CInifile::r_ivector4( LPCSTR S, LPCSTR L )const
 
 Fvector2 CInifile::r_fvector2( LPCSTR S, LPCSTR L )const
 {
+	ini_stat_read	(S,L);
 	LPCSTR		C = r_string(S,L);
 	Fvector2	V={0.f,0.f};
 	sscanf		(C,"%f,%f",&V.x,&V.y);
@@ -637,6 +699,7 @@ Fvector2 CInifile::r_fvector2( LPCSTR S, LPCSTR L )const
 
 Fvector3 CInifile::r_fvector3( LPCSTR S, LPCSTR L )const
 {
+	ini_stat_read	(S,L);
 	LPCSTR		C = r_string(S,L);
 	Fvector3	V={0.f,0.f,0.f};
 	sscanf		(C,"%f,%f,%f",&V.x,&V.y,&V.z);
@@ -645,6 +708,7 @@ Fvector3 CInifile::r_fvector3( LPCSTR S, LPCSTR L )const
 
 Fvector4 CInifile::r_fvector4( LPCSTR S, LPCSTR L )const
 {
+	ini_stat_read	(S,L);
 	LPCSTR		C = r_string(S,L);
 	Fvector4	V={0.f,0.f,0.f,0.f};
 	sscanf		(C,"%f,%f,%f,%f",&V.x,&V.y,&V.z,&V.w);
@@ -653,6 +717,7 @@ Fvector4 CInifile::r_fvector4( LPCSTR S, LPCSTR L )const
 
 BOOL	CInifile::r_bool( LPCSTR S, LPCSTR L )const
 {
+	ini_stat_read	(S,L);
 	LPCSTR		C = r_string(S,L);
 	VERIFY2		(
 		xr_strlen(C) <= 5,
@@ -672,12 +737,14 @@ BOOL	CInifile::r_bool( LPCSTR S, LPCSTR L )const
 
 CLASS_ID CInifile::r_clsid( LPCSTR S, LPCSTR L)const
 {
+	ini_stat_read	(S,L);
 	LPCSTR		C = r_string(S,L);
 	return		TEXT2CLSID(C);
 }
 
 int CInifile::r_token( LPCSTR S, LPCSTR L, const xr_token *token_list)const
 {
+	ini_stat_read	(S,L);
 	LPCSTR		C = r_string(S,L);
 	for( int i=0; token_list[i].name; i++ )
 		if( !stricmp(C,token_list[i].name) )
@@ -0,0 +1,192 @@
+#include "stdafx.h"
+#pragma hdrstop
+
+#ifndef _EDITOR
+
+// Binary cache of read-only ini files.
+//
+// After a text parse the merged tree (includes resolved, inherited sections
+// expanded, keys sorted) is written to $app_data_root$\ltx_cache\. The next
+// load checks every file the parse has read against the locator (size,
+// modification time and, for files in archives, the stored contents CRC) and,
+// if nothing changed, builds the sections straight from the cache: every
+// distinct string is docked once with its stored CRC and the vectors are
+// filled in order.
+//
+//	u32 magic | u32 version | u32 crc of the rest
+//	u32 deps		{ stringZ name | u32 size | u32 modif | u32 crc }
+//	u32 strings		{ u32 crc | u16 length | char[length+1] }
+//	u32 sections	{ u32 name | u32 items { u32 first | u32 second } }		string ids, ltx_cache_null for none
+
+namespace {
+
+u32 const		ltx_cache_magic		= 0x4358544c;		// "LTXC"
+u32 const		ltx_cache_version	= 1;
+u32 const		ltx_cache_null		= u32(-1);
+
+typedef xr_map<const str_value*,u32>	string_ids;
+
+u32		string_id		(const shared_str& S, string_ids& ids, xr_vector<const str_value*>& table)
+{
+	const str_value*	V	= S._get();
+	if (!V)				return ltx_cache_null;
+
+	string_ids::iterator	it	= ids.find(V);
+	if (it!=ids.end())	return it->second;
+
+	u32 const		id		= u32(table.size());
+	ids.insert		(mk_pair(V,id));
+	table.push_back	(V);
+	return			id;
+}
+
+// loose files are registered with crc 0 (hashing them would mean reading every
+// include on each load), so for them this is a size and mtime check only
+bool	deps_valid		(IReader& F)
+{
+	u32 const		count	= F.r_u32();
+	for (u32 it=0; it<count; ++it)
+	{
+		string_path		name;
+		F.r_stringZ		(name,sizeof(name));
+		u32 const	size	= F.r_u32();
+		u32 const	modif	= F.r_u32();
+		u32 const	crc		= F.r_u32();
+
+		const CLocatorAPI::file*	desc	= FS.exist(name);
+		if (!desc || (desc->size_real!=size) || (desc->modif!=modif) || (desc->crc!=crc))
+			return	false;
+	}
+	return			true;
+}
+
+void	read_tree		(IReader& F, CInifile::Root& dest)
+{
+	u32 const		strings	= F.r_u32();
+	xr_vector<shared_str>	table	(strings);
+	for (u32 it=0; it<strings; ++it)
+	{
+		u32 const	crc		= F.r_u32();
+		u16 const	length	= F.r_u16();
+		LPCSTR		value	= (LPCSTR)F.pointer();
+		F.advance			(length+1);
+		table[it]._set		(value,length,crc);
+	}
+
+	u32 const		sections	= F.r_u32();
+	dest.reserve	(dest.size()+sections);
+	for (u32 s=0; s<sections; ++s)
+	{
+		CInifile::Sect*	S	= xr_new<CInifile::Sect>();
+		S->Name				= table[F.r_u32()];
+		S->Data.resize		(F.r_u32());
+		for (CInifile::SectIt_ it=S->Data.begin(); it!=S->Data.end(); ++it)
+		{
+			u32 const	first	= F.r_u32();
+			u32 const	second	= F.r_u32();
+			if (first!=ltx_cache_null)		it->first	= table[first];
+			if (second!=ltx_cache_null)		it->second	= table[second];
+		}
+		dest.push_back		(S);
+	}
+}
+
+} // namespace
+
+bool	CInifile::cache_name	(string_path& dest) const
+{
+	if (!m_file_name[0])						return false;
+	if (strstr(Core.Params,"-ltx_nocache"))		return false;
+	if (!FS.path_exist("$app_data_root$"))		return false;
+
+	string_path		source, name, file;
+	xr_strcpy		(source,m_file_name);
+	xr_strlwr		(source);
+	_splitpath		(source,0,0,name,0);
+	xr_sprintf		(file,"ltx_cache\\%s_%08x.ltxc",name,crc32(source,xr_strlen(source)));
+	FS.update_path	(dest,"$app_data_root$",file);
+	return			true;
+}
+
+bool	CInifile::load_cache	(LPCSTR cache_name)
+{
+	if (!FS.exist(cache_name))	return false;
+
+	IReader*		F		= FS.r_open(cache_name);
+	if (!F)			return false;
+
+	bool			result	= false;
+	if ((F->length()>=3*int(sizeof(u32))) && (F->r_u32()==ltx_cache_magic) && (F->r_u32()==ltx_cache_version))
+	{
+		u32 const	crc		= F->r_u32();
+		if ((crc==crc32(F->pointer(),u32(F->elapsed()))) && deps_valid(*F))
+		{
+			read_tree		(*F,DATA);
+			result			= true;
+		}
+	}
+	FS.r_close		(F);
+	return			result;
+}
+
+void	CInifile::save_cache	(LPCSTR cache_name, const xr_vector<shared_str>& deps) const
+{
+	CMemoryWriter	W;
+	W.w_u32			(u32(deps.size()));
+	for (u32 it=0; it<deps.size(); ++it)
+	{
+		// a file the locator doesn't know can't be validated later
+		const CLocatorAPI::file*	desc	= FS.exist(*deps[it]);
+		if (!desc)
+		{
+			Msg		("! Can't write ini cache [%s]: [%s] is unknown to FS",cache_name,*deps[it]);
+			return;
+		}
+
+		W.w_stringZ		(deps[it]);
+		W.w_u32			(desc->size_real);
+		W.w_u32			(desc->modif);
+		W.w_u32			(desc->crc);
+	}
+
+	// sections first, to collect the strings
+	string_ids						ids;
+	xr_vector<const str_value*>		table;
+	xr_vector<u32>					tree;
+	tree.push_back		(u32(DATA.size()));
+	for (RootCIt s_it=DATA.begin(); s_it!=DATA.end(); ++s_it)
+	{
+		const Sect&	S		= **s_it;
+		tree.push_back		(string_id(S.Name,ids,table));
+		tree.push_back		(u32(S.Data.size()));
+		for (SectCIt it=S.Data.begin(); it!=S.Data.end(); ++it)
+		{
+			tree.push_back	(string_id(it->first,ids,table));
+			tree.push_back	(string_id(it->second,ids,table));
+		}
+	}
+
+	W.w_u32			(u32(table.size()));
+	for (u32 it=0; it<table.size(); ++it)
+	{
+		const str_value*	V	= table[it];
+		W.w_u32			(V->dwCRC);
+		W.w_u16			(u16(V->dwLength));
+		W.w				(V->value,V->dwLength+1);
+	}
+	W.w				(&tree.front(),u32(tree.size()*sizeof(u32)));
+
+	IWriter*		F		= FS.w_open(cache_name);
+	if (!F)
+	{
+		Msg			("! Can't write ini cache [%s]",cache_name);
+		return;
+	}
+	F->w_u32		(ltx_cache_magic);
+	F->w_u32		(ltx_cache_version);
+	F->w_u32		(crc32(W.pointer(),W.size()));
+	F->w			(W.pointer(),W.size());
+	FS.w_close		(F);
+}
+
+#endif // _EDITOR
@@ -0,0 +1,138 @@
+#include "stdafx.h"
+#pragma hdrstop
+
+// Handles of hot ini lines and the read statistics to find them.
+//
+// r_handle looks the section and the line up once and parses the value for
+// every typed reader, exactly as the reader by name would (atof, atoi,
+// sscanf). Values live in blocks that are never moved, so the handle is a
+// plain pointer and typed reads through it need no lookup and no lock.
+
+bool	item_pred			(const CInifile::Item& x, LPCSTR val);	// Xr_ini.cpp
+
+namespace {
+
+u32 const		values_block	= 64;
+
+#ifdef PROFILE_CRITICAL_SECTIONS
+xrCriticalSection	g_ini_lock(MUTEX_PROFILE_ID(CInifile::handles));
+#else // PROFILE_CRITICAL_SECTIONS
+xrCriticalSection	g_ini_lock;
+#endif // PROFILE_CRITICAL_SECTIONS
+
+struct read_stat
+{
+	shared_str		section;
+	shared_str		line;
+	u32				count;
+};
+typedef xr_map<u32,read_stat>	read_stats;
+
+read_stats			g_read_stats;
+int					g_read_stats_enabled	= -1;	// -ini_stats, checked on the first read
+
+bool	read_stat_pred	(const read_stat* a, const read_stat* b)
+{
+	return			a->count>b->count;
+}
+
+void	parse_value		(CInifile::Value& V, LPCSTR string)
+{
+	LPCSTR			C		= string ? string : "";
+	V.string				= string;
+	V.f						= float(atof(C));
+	V.i						= s32(atoi(C));
+
+	V.fv.set				(0.f,0.f,0.f,0.f);
+	sscanf					(C,"%f,%f,%f,%f",&V.fv.x,&V.fv.y,&V.fv.z,&V.fv.w);
+	V.iv.set				(0,0,0,0);
+	sscanf					(C,"%d,%d,%d,%d",&V.iv.x,&V.iv.y,&V.iv.z,&V.iv.w);
+
+	u32				r=0,g=0,b=0,a=255;
+	sscanf					(C,"%d,%d,%d,%d",&r,&g,&b,&a);
+	V.color					= color_rgba(r,g,b,a);
+
+	char			B[8];
+	strncpy_s				(B,sizeof(B),C,7);
+	B[7]					= 0;
+	strlwr					(B);
+	V.b						= CInifile::IsBOOL(B);
+}
+
+} // namespace
+
+void	ini_stat_read		(LPCSTR S, LPCSTR L)
+{
+	if (g_read_stats_enabled<0)
+		g_read_stats_enabled	= strstr(Core.Params,"-ini_stats") ? 1 : 0;
+	if (!g_read_stats_enabled)	return;
+
+	u32 const		id		= crc32(L,xr_strlen(L),crc32(S,xr_strlen(S)));
+	g_ini_lock.Enter		();
+	read_stats::iterator	it	= g_read_stats.find(id);
+	if (it==g_read_stats.end())
+	{
+		read_stat	stat;
+		stat.section		= S;
+		stat.line			= L;
+		stat.count			= 0;
+		it					= g_read_stats.insert(mk_pair(id,stat)).first;
+	}
+	++it->second.count;
+	g_ini_lock.Leave		();
+}
+
+CInifile::Handle	CInifile::r_handle	(LPCSTR S, LPCSTR L)const
+{
+	VERIFY2					(m_flags.test(eReadOnly),"Handles are for read-only files only.");
+
+	Sect const&		I		= r_section(S);
+	SectCIt			A		= std::lower_bound(I.Data.begin(),I.Data.end(),L,item_pred);
+	if (!(A!=I.Data.end() && xr_strcmp(*A->first,L)==0))
+		Debug.fatal			(DEBUG_INFO,"Can't find variable %s in [%s]",L,S);
+
+	g_ini_lock.Enter		();
+	Handles::key_type const	key	= mk_pair(I.Name._get(),A->first._get());
+	Handles::iterator	it	= m_handles.find(key);
+	if (it==m_handles.end())
+	{
+		if (!m_values_free)
+		{
+			m_values.push_back	(xr_alloc<Value>(values_block));
+			m_values_free		= values_block;
+		}
+		Value*		V		= m_values.back()+(values_block-m_values_free);
+		--m_values_free;
+		parse_value			(*V,*A->second);
+		it					= m_handles.insert(mk_pair(key,V)).first;
+	}
+	Handle			result	= it->second;
+	g_ini_lock.Leave		();
+	return			result;
+}
+
+void	CInifile::dump_stats	(u32 count)
+{
+	if (g_read_stats_enabled<=0)
+	{
+		Msg					("! Ini reads are counted with -ini_stats only");
+		return;
+	}
+
+	g_ini_lock.Enter		();
+	xr_vector<const read_stat*>	sorted;
+	sorted.reserve			(g_read_stats.size());
+	u32				total	= 0;
+	for (read_stats::const_iterator it=g_read_stats.begin(); it!=g_read_stats.end(); ++it)
+	{
+		sorted.push_back	(&it->second);
+		total				+= it->second.count;
+	}
+	count					= _min(count,u32(sorted.size()));
+	std::partial_sort		(sorted.begin(),sorted.begin()+count,sorted.end(),read_stat_pred);
+
+	Msg						("* Ini reads: %d lines, %d typed reads, the most frequent:",sorted.size(),total);
+	for (u32 it=0; it<count; ++it)
+		Msg					("* %8d [%s] %s",sorted[it]->count,*sorted[it]->section,*sorted[it]->line);
+	g_ini_lock.Leave		();
+}
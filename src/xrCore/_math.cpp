@@ -356,6 +356,7 @@ void	thread_name(const char* name)
 	tn.szName = name;
 	tn.dwThreadID = DWORD(-1);
 	tn.dwFlags = 0;
+	xrTrace::thread_name(name);
 	__try
 	{	
 #ifdef _M_X64
@@ -387,6 +388,7 @@ void	__cdecl			thread_entry(void* _params) {
 
 	// call
 	entry(arglist);
+	xrTrace::thread_exit();
 }
 
 void	thread_spawn(thread_t* entry, const char* name, unsigned	stack, void* arglist)
@@ -0,0 +1,172 @@
+#include "stdafx.h"
+#pragma hdrstop
+
+#include "frame_arena.h"
+
+// Blocks of a thread are chained, the newest first, and only the newest one is
+// bumped. When a frame needed more than one block they are replaced by a
+// single block of their total size at the rewind, so after a few frames every
+// thread works in one block.
+
+namespace
+{
+
+u32 const		block_size		= 256*1024;
+u32 const		data_align		= 16;
+u32 const		block_magic		= 0xfa11fa11;
+
+struct block
+{
+	block*			next;
+	u32				size;			// of the data
+	u32				used;
+#ifndef _WIN64
+	u32				pad;
+#endif // _WIN64
+
+	u8*				data			()	{ return (u8*)(this+1);	}
+};
+
+struct arena;
+
+#ifdef DEBUG_FRAME_ARENA
+struct tag
+{
+	arena*			owner;
+	u32				generation;
+	u32				magic;
+#ifndef _WIN64
+	u32				pad;
+#endif // _WIN64
+};
+#endif // DEBUG_FRAME_ARENA
+
+struct arena
+{
+	block*			blocks;
+	u32				frame;
+#ifdef DEBUG_FRAME_ARENA
+	u32				generation;
+	u32				live;
+#endif // DEBUG_FRAME_ARENA
+};
+
+__declspec(thread) arena*	t_arena		= 0;
+
+block*		block_create	(u32 size)
+{
+	STATIC_CHECK			(sizeof(block)%data_align==0,Frame_arena_block_header_breaks_alignment);
+	block*			B		= (block*)xr_malloc(sizeof(block)+size);
+	B->next					= 0;
+	B->size					= size;
+	B->used					= 0;
+	return					B;
+}
+
+void		rewind			(arena& A)
+{
+#ifdef DEBUG_FRAME_ARENA
+	VERIFY2					(0==A.live,make_string("frame arena: %d block(s) allocated in frame %d are still in use",A.live,A.frame));
+	for (block* B=A.blocks; B; B=B->next)
+		Memory.mem_fill		(B->data(),0xdd,B->used);
+	A.generation			++;
+#endif // DEBUG_FRAME_ARENA
+
+	if (A.blocks && A.blocks->next)
+	{
+		u32			total	= 0;
+		while (A.blocks)
+		{
+			block*	B		= A.blocks;
+			A.blocks		= B->next;
+			total			+= B->size;
+			xr_free			(B);
+		}
+		A.blocks			= block_create(total);
+	}
+	else if (A.blocks)
+		A.blocks->used		= 0;
+
+	A.frame					= Core.dwFrame;
+}
+
+} // namespace
+
+void*		frame_arena_alloc		(u32 size)
+{
+	arena*			A		= t_arena;
+	if (!A)
+	{
+		t_arena	= A			= xr_new<arena>();
+		A->blocks			= 0;
+		A->frame			= Core.dwFrame;
+#ifdef DEBUG_FRAME_ARENA
+		A->generation		= 0;
+		A->live				= 0;
+#endif // DEBUG_FRAME_ARENA
+	}
+	else if (A->frame!=Core.dwFrame)
+		rewind				(*A);
+
+	Memory.stat_frame_calls	++;
+	Memory.stat_frame_bytes	+= size;
+
+	u32				need	= (_max(size,1u)+data_align-1)&~(data_align-1);
+#ifdef DEBUG_FRAME_ARENA
+	STATIC_CHECK			(sizeof(tag)%data_align==0,Frame_arena_tag_breaks_alignment);
+	need					+= sizeof(tag);
+#endif // DEBUG_FRAME_ARENA
+
+	block*			B		= A->blocks;
+	if (!B || (B->used+need>B->size))
+	{
+		B					= block_create(_max(block_size,need));
+		B->next				= A->blocks;
+		A->blocks			= B;
+	}
+
+	u8*				result	= B->data()+B->used;
+	B->used					+= need;
+
+#ifdef DEBUG_FRAME_ARENA
+	tag*			T		= (tag*)result;
+	T->owner				= A;
+	T->generation			= A->generation;
+	T->magic				= block_magic;
+	A->live					++;
+	result					+= sizeof(tag);
+#endif // DEBUG_FRAME_ARENA
+
+	return					result;
+}
+
+void		frame_arena_free		(void* p)
+{
+#ifdef DEBUG_FRAME_ARENA
+	if (!p)					return;
+	tag*			T		= (tag*)p - 1;
+	VERIFY2					(T->magic==block_magic,"frame arena: the block is not from a frame arena");
+	VERIFY2					(T->owner==t_arena,"frame arena: the block is freed by a thread which did not allocate it");
+	VERIFY2					(T->generation==T->owner->generation,"frame arena: the block is used after its frame");
+	T->owner->live			--;
+#endif // DEBUG_FRAME_ARENA
+}
+
+void		frame_arena_thread_exit	()
+{
+	arena*			A		= t_arena;
+	if (!A)					return;
+
+#ifdef DEBUG_FRAME_ARENA
+	VERIFY2					(0==A->live,make_string("frame arena: %d block(s) are still in use at the thread exit",A->live));
+#endif // DEBUG_FRAME_ARENA
+
+	while (A->blocks)
+	{
+		block*		B		= A->blocks;
+		A->blocks			= B->next;
+		xr_free				(B);
+	}
+	xr_delete				(A);
+	t_arena					= 0;
+}
@@ -0,0 +1,69 @@
+#ifndef FRAME_ARENA_H_INCLUDED
+#define FRAME_ARENA_H_INCLUDED
+
+// Frame arena: per-thread bump allocator for the temporary containers of a frame.
+// An allocation moves a pointer, a free does nothing. The arena of a thread is
+// rewound by its first allocation in a new frame (Core.dwFrame), so a container
+// using frame_alloc must not live longer than the frame it was filled in.
+// With DEBUG_FRAME_ARENA every block is tagged with the arena generation: a
+// block still alive at the rewind or freed after it asserts, and the rewound
+// memory is filled with 0xdd.
+// The allocations are counted in Memory.stat_frame_calls/stat_frame_bytes,
+// next to the heap calls of Memory.stat_calls.
+
+#ifdef DEBUG
+#	define DEBUG_FRAME_ARENA
+#endif // DEBUG
+
+XRCORE_API	void*	frame_arena_alloc		(u32 size);
+XRCORE_API	void	frame_arena_free		(void* p);
+
+// releases the arena of the calling thread, for threads which end before the engine
+XRCORE_API	void	frame_arena_thread_exit	();
+
+template <class T>
+class	frame_alloc	{
+public:
+	typedef	size_t		size_type;
+	typedef ptrdiff_t	difference_type;
+	typedef T*			pointer;
+	typedef const T*	const_pointer;
+	typedef T&			reference;
+	typedef const T&	const_reference;
+	typedef T			value_type;
+
+public:
+	template<class _Other>
+	struct rebind			{	typedef frame_alloc<_Other> other;	};
+public:
+							pointer					address			(reference _Val) const					{	return (&_Val);	}
+							const_pointer			address			(const_reference _Val) const			{	return (&_Val);	}
+													frame_alloc		()										{	}
+													frame_alloc		(const frame_alloc<T>&)					{	}
+	template<class _Other>							frame_alloc		(const frame_alloc<_Other>&)			{	}
+	template<class _Other>	frame_alloc<T>&			operator=		(const frame_alloc<_Other>&)			{	return (*this);	}
+							pointer					allocate		(size_type n, const void* p=0) const	{	return (T*)frame_arena_alloc(sizeof(T)*(u32)n);	}
+							char*					_charalloc		(size_type n)							{	return (char*)allocate(n); }
+							void					deallocate		(pointer p, size_type n) const			{	frame_arena_free(p);		}
+							void					deallocate		(void* p, size_type n) const			{	frame_arena_free(p);		}
+							void					construct		(pointer p, const T& _Val)				{	::new(p) T(_Val);	}
+							void					destroy			(pointer p)								{	p->~T();			}
+							size_type				max_size		() const								{	size_type _Count = (size_type)(-1) / sizeof (T);	return (0 < _Count ? _Count : 1);	}
+};
+
+template<class _Ty,	class _Other>	inline	bool operator==(const frame_alloc<_Ty>&, const frame_alloc<_Other>&)	{	return (true);							}
+template<class _Ty, class _Other>	inline	bool operator!=(const frame_alloc<_Ty>&, const frame_alloc<_Other>&)	{	return (false);							}
+
+// same interface as xr_allocator, for FixedMAP and friends
+struct frame_allocator {
+	template <typename T>
+	struct helper {
+		typedef frame_alloc<T>	result;
+	};
+
+	static	void	*alloc		(const u32 &n)	{	return frame_arena_alloc(n);	}
+	template <typename T>
+	static	void	dealloc		(T *&p)			{	frame_arena_free(p); p = 0;		}
+};
+
+#endif // #ifndef FRAME_ARENA_H_INCLUDED
@@ -0,0 +1,494 @@
+#include "stdafx.h"
+#pragma hdrstop
+
+#include "memory_profiler.h"
+#include "xrMemory_align.h"
+#include <dbghelp.h>
+
+#pragma comment(lib,"dbghelp.lib")
+
+// Sampled blocks are allocated outside of the pools with the header byte set
+// to mem_sampled, the sample record is placed before it:
+//   [sample][mem_sampled][data...]
+// The tables are allocated once with VirtualAlloc and never released, so
+// blocks sampled before the profiler is disabled are still freed correctly.
+// Work done under the lock may allocate, t_inside keeps the profiler from
+// sampling its own allocations.
+
+namespace memory_profiler
+{
+
+XRCORE_API u32		sample_rate		= 0;
+XRCORE_API bool		tagging			= false;
+
+namespace
+{
+
+u32 const			max_depth		= 16;			// frames per call site
+u32 const			max_sites		= 16*1024;
+u32 const			index_size		= 2*max_sites;	// open addressing, power of two
+u32 const			max_tags		= 64;
+u32 const			max_tag_depth	= 32;
+u32 const			sample_magic	= 0x5a3b1ed5;
+
+struct counters
+{
+	s64				live_bytes;
+	s64				live_count;
+	u64				bytes;			// allocated in total
+	u64				count;
+
+	void			add				(u32 size, u32 weight)
+	{
+		live_bytes					+= s64(size)*weight;
+		live_count					+= weight;
+		bytes						+= u64(size)*weight;
+		count						+= weight;
+	}
+	void			remove			(u32 size, u32 weight)
+	{
+		live_bytes					-= s64(size)*weight;
+		live_count					-= weight;
+	}
+};
+
+struct site
+{
+	u32				hash;
+	u32				depth;
+	void*			frames			[max_depth];
+	counters		c;
+};
+
+struct tag
+{
+	LPCSTR			name;
+	counters		c;
+};
+
+struct sample
+{
+	u16				site;
+	u16				tag;
+	u32				size;
+	u32				weight;
+	u32				magic;
+};
+
+struct checkpoint
+{
+	string64		name;
+	u32				time;			// ms
+	u32				frame;
+	u32				rate;
+	u32				sites_count;
+	counters*		sites;
+	counters		tags			[max_tags];
+	counters		total;
+};
+
+#ifdef PROFILE_CRITICAL_SECTIONS
+xrCriticalSection			g_lock(MUTEX_PROFILE_ID(memory_profiler::g_lock));
+#else // PROFILE_CRITICAL_SECTIONS
+xrCriticalSection			g_lock;
+#endif // PROFILE_CRITICAL_SECTIONS
+
+site*						g_sites			= 0;	// site 0 collects the samples past max_sites
+u32							g_sites_count	= 0;
+u16*						g_index			= 0;	// site index + 1
+tag							g_tags			[max_tags];	// tag 0 is untagged, the last one collects the overflow
+u32							g_tags_count	= 0;
+counters					g_total;
+CTimer						g_timer;
+xr_vector<checkpoint*>		g_checkpoints;
+
+__declspec(thread) s32		t_countdown		= 0;
+__declspec(thread) u32		t_seed			= 0;
+__declspec(thread) bool		t_inside		= false;
+__declspec(thread) LPCSTR	t_tag			= 0;
+__declspec(thread) LPCSTR	t_tag_stack		[max_tag_depth];
+__declspec(thread) u32		t_tag_depth		= 0;
+
+// uniform in [1,2*rate-1], keeps the mean at rate and avoids aliasing with periodic allocations
+s32			next_interval	()
+{
+	u32				x		= t_seed;
+	if (!x)			x		= GetCurrentThreadId()*2654435761u | 1;
+	x						^= x<<13;
+	x						^= x>>17;
+	x						^= x<<5;
+	t_seed					= x;
+	u32 const		rate	= _max(sample_rate,1u);
+	return					s32(1 + x%(2*rate-1));
+}
+
+bool		sites_equal		(const site& S, u32 hash, void** frames, u32 depth)
+{
+	if ((S.hash!=hash) || (S.depth!=depth))	return false;
+	return					0==memcmp(S.frames,frames,depth*sizeof(void*));
+}
+
+u16			site_find		(void** frames, u32 depth, u32 hash)
+{
+	u32				slot	= hash&(index_size-1);
+	for (;;)
+	{
+		u16 const	id		= g_index[slot];
+		if (!id)			break;
+		if (sites_equal(g_sites[id-1],hash,frames,depth))
+			return			u16(id-1);
+		slot				= (slot+1)&(index_size-1);
+	}
+
+	if (g_sites_count==max_sites)
+		return				0;
+
+	u16 const		id		= u16(g_sites_count++);
+	site&			S		= g_sites[id];
+	S.hash					= hash;
+	S.depth					= depth;
+	CopyMemory				(S.frames,frames,depth*sizeof(void*));
+	ZeroMemory				(&S.c,sizeof(S.c));
+	g_index[slot]			= u16(id+1);
+	return					id;
+}
+
+u16			tag_find		(LPCSTR name)
+{
+	if (!name)				return 0;
+	for (u32 it=1; it<g_tags_count; ++it)
+		if (g_tags[it].name==name)	return u16(it);
+	if (g_tags_count==max_tags)		return u16(max_tags-1);
+
+	tag&			T		= g_tags[g_tags_count];
+	T.name					= (g_tags_count==max_tags-1) ? "<other>" : name;
+	ZeroMemory				(&T.c,sizeof(T.c));
+	return					u16(g_tags_count++);
+}
+
+sample*		sample_of		(void* P)
+{
+	sample*			S		= (sample*)((u8*)P - 1) - 1;
+	VERIFY2					(S->magic==sample_magic,"Memory corruption");
+	return					S;
+}
+
+checkpoint*	checkpoint_find	(LPCSTR name)
+{
+	for (u32 it=0; it<g_checkpoints.size(); ++it)
+		if (!xr_strcmp(g_checkpoints[it]->name,name))
+			return			g_checkpoints[it];
+	return					0;
+}
+
+// the caller owns the result
+checkpoint*	checkpoint_create	(LPCSTR name)
+{
+	t_inside				= true;
+	checkpoint*		C		= xr_new<checkpoint>();
+	xr_strcpy				(C->name,name);
+	g_lock.Enter			();
+	C->time					= g_timer.GetElapsed_ms();
+	C->frame				= Core.dwFrame;
+	C->rate					= sample_rate;
+	C->sites_count			= g_sites_count;
+	C->sites				= xr_alloc<counters>(_max(g_sites_count,1u));
+	for (u32 it=0; it<g_sites_count; ++it)
+		C->sites[it]		= g_sites[it].c;
+	for (u32 it=0; it<max_tags; ++it)
+		C->tags[it]			= (it<g_tags_count) ? g_tags[it].c : counters();
+	C->total				= g_total;
+	g_lock.Leave			();
+	t_inside				= false;
+	return					C;
+}
+
+void		checkpoint_destroy	(checkpoint*& C)
+{
+	xr_free					(C->sites);
+	xr_delete				(C);
+}
+
+void		symbol_name		(void* address, LPSTR dest, u32 dest_size)
+{
+	HANDLE const	process	= GetCurrentProcess();
+
+	string_path		module	= "?";
+	HMODULE			handle	= 0;
+	if (GetModuleHandleEx(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS|GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,(LPCSTR)address,&handle))
+	{
+		string_path	path;
+		GetModuleFileName	(handle,path,sizeof(path));
+		LPCSTR		slash	= strrchr(path,'\\');
+		xr_strcpy			(module,slash ? slash+1 : path);
+	}
+
+	u8				buffer	[sizeof(SYMBOL_INFO)+256];
+	SYMBOL_INFO*	symbol	= (SYMBOL_INFO*)buffer;
+	ZeroMemory				(buffer,sizeof(buffer));
+	symbol->SizeOfStruct	= sizeof(SYMBOL_INFO);
+	symbol->MaxNameLen		= 255;
+	DWORD64			offset	= 0;
+	if (!SymFromAddr(process,DWORD64(address),&offset,symbol))
+	{
+		xr_sprintf			(dest,dest_size,"%s+0x%x",module,u32(size_t(address)-size_t(handle)));
+		return;
+	}
+
+	IMAGEHLP_LINE64	line;
+	ZeroMemory				(&line,sizeof(line));
+	line.SizeOfStruct		= sizeof(line);
+	DWORD			column	= 0;
+	if (SymGetLineFromAddr64(process,DWORD64(address),&column,&line))
+		xr_sprintf			(dest,dest_size,"%s!%s+0x%x (%s:%d)",module,symbol->Name,u32(offset),line.FileName,line.LineNumber);
+	else
+		xr_sprintf			(dest,dest_size,"%s!%s+0x%x",module,symbol->Name,u32(offset));
+}
+
+struct site_delta
+{
+	u32				id;
+	counters		c;
+};
+
+bool		pred_live		(const site_delta& a, const site_delta& b)	{ return a.c.live_bytes>b.c.live_bytes;	}
+bool		pred_count		(const site_delta& a, const site_delta& b)	{ return a.c.count>b.c.count;			}
+
+counters	delta			(const counters& from, const counters& to)
+{
+	counters		result;
+	result.live_bytes		= to.live_bytes-from.live_bytes;
+	result.live_count		= to.live_count-from.live_count;
+	result.bytes			= to.bytes-from.bytes;
+	result.count			= to.count-from.count;
+	return					result;
+}
+
+void		write_counters	(IWriter* W, LPCSTR prefix, const counters& c, float seconds, u32 frames)
+{
+	W->w_printf				("%slive %+10.1f KB (%+8d blocks), %10.1f KB/s, %8.2f allocs/frame\r\n",
+							prefix,float(c.live_bytes)/1024.f,s32(c.live_count),float(c.bytes)/1024.f/seconds,float(c.count)/float(frames));
+}
+
+void		write_sites		(IWriter* W, xr_vector<site_delta>& sites, u32 sites_count, float seconds, u32 frames)
+{
+	string1024		name;
+	for (u32 it=0; it<_min(sites_count,sites.size()); ++it)
+	{
+		const site_delta&	D	= sites[it];
+		const site&			S	= g_sites[D.id];
+		xr_sprintf			(name,"#%-3d ",it+1);
+		write_counters		(W,name,D.c,seconds,frames);
+		if (!D.id)
+		{
+			W->w_printf		("      <sites table is full>\r\n");
+			continue;
+		}
+		for (u32 f=0; f<S.depth; ++f)
+		{
+			symbol_name		(S.frames[f],name,sizeof(name));
+			W->w_printf		("      %s\r\n",name);
+		}
+	}
+}
+
+} // namespace
+
+void		enable			(u32 rate)
+{
+	if (rate && !g_sites)
+	{
+		g_sites				= (site*)VirtualAlloc(0,max_sites*sizeof(site),MEM_COMMIT|MEM_RESERVE,PAGE_READWRITE);
+		g_index				= (u16*)VirtualAlloc(0,index_size*sizeof(u16),MEM_COMMIT|MEM_RESERVE,PAGE_READWRITE);
+		R_ASSERT			(g_sites && g_index);
+		g_sites_count		= 1;
+		g_tags[0].name		= "<untagged>";
+		g_tags_count		= 1;
+		g_timer.Start		();
+		SymSetOptions		(SymGetOptions()|SYMOPT_UNDNAME|SYMOPT_LOAD_LINES|SYMOPT_DEFERRED_LOADS);
+		SymInitialize		(GetCurrentProcess(),0,TRUE);
+	}
+	sample_rate				= rate;
+	if (rate)				tagging	= true;		// never cleared, so every push made is popped after a disable
+	if (rate)				Msg("* Memory profiler: 1 of %d allocations is sampled",rate);
+	else					Msg("* Memory profiler disabled");
+}
+
+void		push_tag		(LPCSTR tag)
+{
+	// past the depth only the count is kept, the innermost tags nested there are not restored
+	if (t_tag_depth<max_tag_depth)
+		t_tag_stack[t_tag_depth]	= t_tag;
+	t_tag_depth				++;
+	t_tag					= tag;
+}
+
+void		pop_tag			(LPCSTR tag)
+{
+	if (!t_tag_depth)		return;
+	if ((t_tag_depth<=max_tag_depth) && (t_tag!=tag))	return;
+	t_tag_depth				--;
+	if (t_tag_depth<max_tag_depth)
+		t_tag				= t_tag_stack[t_tag_depth];
+}
+
+bool		sample			()
+{
+	if (t_inside)			return false;
+	if (--t_countdown>0)	return false;
+	t_countdown				= next_interval();
+	return					true;
+}
+
+void*		sampled_alloc	(size_t size)
+{
+	STATIC_CHECK			(sizeof(sample)==16,Memory_profiler_sample_header_size_changed);
+	u8*				real	= (u8*)xr_aligned_offset_malloc(sizeof(sample)+1+size,16,sizeof(sample)+1);
+	sample*			S		= (sample*)real;
+	u8*				result	= real+sizeof(sample)+1;
+	result[-1]				= u8(mem_sampled);
+
+	// skips this function and xrMemory::mem_alloc
+	void*			frames	[max_depth];
+	ULONG			hash	= 0;
+	u32 const		depth	= CaptureStackBackTrace(2,max_depth,frames,&hash);
+
+	t_inside				= true;
+	g_lock.Enter			();
+	S->site					= site_find(frames,depth,hash);
+	S->tag					= tag_find(t_tag);
+	S->size					= u32(size);
+	S->weight				= sample_rate ? sample_rate : 1;
+	S->magic				= sample_magic;
+	g_sites[S->site].c.add	(S->size,S->weight);
+	g_tags[S->tag].c.add	(S->size,S->weight);
+	g_total.add				(S->size,S->weight);
+	g_lock.Leave			();
+	t_inside				= false;
+
+	return					result;
+}
+
+void		sampled_free	(void* P)
+{
+	sample*			S		= sample_of(P);
+	g_lock.Enter			();
+	g_sites[S->site].c.remove	(S->size,S->weight);
+	g_tags[S->tag].c.remove	(S->size,S->weight);
+	g_total.remove			(S->size,S->weight);
+	g_lock.Leave			();
+	S->magic				= 0;
+	xr_aligned_free			(S);
+}
+
+u32			sampled_size	(void* P)
+{
+	return					sample_of(P)->size;
+}
+
+void		make_checkpoint	(LPCSTR name)
+{
+	if (!g_sites)
+	{
+		Msg					("! Memory profiler is off, start it with 'mem_profile <rate>' or -mem_profile <rate>");
+		return;
+	}
+
+	checkpoint*		C		= checkpoint_create(name);
+	for (u32 it=0; it<g_checkpoints.size(); ++it)
+	{
+		if (xr_strcmp(g_checkpoints[it]->name,name))
+			continue;
+		checkpoint_destroy	(g_checkpoints[it]);
+		g_checkpoints[it]	= C;
+		C					= 0;
+		break;
+	}
+	if (C)					g_checkpoints.push_back(C);
+
+	Msg						("* Memory checkpoint [%s]: live %d KB in %d blocks (estimated), frame %d",
+							name,u32(g_total.live_bytes/1024),u32(g_total.live_count),Core.dwFrame);
+}
+
+bool		dump_diff		(LPCSTR file_name, LPCSTR from, LPCSTR to, u32 sites_count)
+{
+	checkpoint*		A		= checkpoint_find(from);
+	if (!A)
+	{
+		Msg					("! Memory checkpoint [%s] not found",from);
+		return				false;
+	}
+
+	checkpoint*		B		= 0;
+	checkpoint*		current	= 0;
+	if (to)
+	{
+		if (0==(B = checkpoint_find(to)))
+		{
+			Msg				("! Memory checkpoint [%s] not found",to);
+			return			false;
+		}
+	}
+	else
+		B = current			= checkpoint_create("now");
+
+	if (B->time<A->time)
+		std::swap			(A,B);
+
+
+	IWriter*		W		= FS.w_open("$logs$",file_name);
+	if (!W)
+	{
+		Msg					("! Can't write memory profile [%s]",file_name);
+		if (current)		checkpoint_destroy(current);
+		return				false;
+	}
+
+	float const		seconds	= _max(float(B->time-A->time)/1000.f,0.001f);
+	u32 const		frames	= _max(B->frame-A->frame,1u);
+
+	W->w_printf				("memory profile [%s] -> [%s]: %.1f s, %d frames, 1 of %d allocations sampled\r\n",A->name,B->name,seconds,frames,B->rate);
+	W->w_printf				("all values are estimated from the samples\r\n\r\n");
+	write_counters			(W,"total: ",delta(A->total,B->total),seconds,frames);
+
+	W->w_printf				("\r\nby subsystem:\r\n");
+	for (u32 it=0; it<g_tags_count; ++it)
+	{
+		counters const	c	= delta(A->tags[it],B->tags[it]);
+		if (!c.count && !c.live_count)
+			continue;
+		string128	prefix;
+		xr_sprintf			(prefix,"  %-24s ",g_tags[it].name);
+		write_counters		(W,prefix,c,seconds,frames);
+	}
+
+	// sites are only added, the later checkpoint knows more of them
+	u32 const		count	= _max(A->sites_count,B->sites_count);
+	counters const	zero	= counters();
+	xr_vector<site_delta>	sites;
+	sites.reserve			(count);
+	for (u32 it=0; it<count; ++it)
+	{
+		site_delta	D;
+		D.id				= it;
+		D.c					= delta((it<A->sites_count) ? A->sites[it] : zero,(it<B->sites_count) ? B->sites[it] : zero);
+		if (D.c.count || D.c.live_count)
+			sites.push_back	(D);
+	}
+
+	W->w_printf				("\r\ncall sites by live growth:\r\n");
+	std::sort				(sites.begin(),sites.end(),pred_live);
+	write_sites				(W,sites,sites_count,seconds,frames);
+
+	W->w_printf				("\r\ncall sites by allocations per frame:\r\n");
+	std::sort				(sites.begin(),sites.end(),pred_count);
+	write_sites				(W,sites,sites_count,seconds,frames);
+
+	FS.w_close				(W);
+	Msg						("* Memory profile [%s] -> [%s] written to [%s]",A->name,B->name,file_name);
+
+	if (current)			checkpoint_destroy(current);
+	return					true;
+}
+
+} // namespace memory_profiler
@@ -0,0 +1,40 @@
+#ifndef MEMORY_PROFILER_H
+#define MEMORY_PROFILER_H
+#pragma once
+
+// Sampling heap profiler, usable in release builds.
+// One of sample_rate allocations of xrMemory is made with a small header and
+// recorded with its call stack and the subsystem tag of the thread (the name
+// of the innermost running CStatTimer). Live bytes and allocation totals are
+// kept per call site and per tag, scaled back by the sample rate. Checkpoints
+// copy the counters, the diff of two of them is written into $logs$ with the
+// sites sorted by live growth and by allocations per frame.
+// Freeing a sampled block costs a lock, the others are not affected; with the
+// profiler disabled an allocation pays one test of sample_rate.
+
+namespace memory_profiler
+{
+	extern XRCORE_API u32	sample_rate;		// 0 - disabled
+	extern XRCORE_API bool	tagging;			// set by the first enable, CStatTimer pushes tags only then
+
+	XRCORE_API void			enable				(u32 rate);
+
+	// nest the tag of the calling thread, the stack is per thread;
+	// pop_tag ignores a tag that is not on top (its timer began before tagging was set)
+	XRCORE_API void			push_tag			(LPCSTR tag);
+	XRCORE_API void			pop_tag				(LPCSTR tag);
+
+	XRCORE_API void			make_checkpoint		(LPCSTR name);
+
+	// compares checkpoint from with checkpoint to or with the current state if to is 0,
+	// writes the sites_count top sites of each list, returns false if nothing was written
+	XRCORE_API bool			dump_diff			(LPCSTR file_name, LPCSTR from, LPCSTR to, u32 sites_count);
+
+	// xrMemory side
+	bool					sample				();
+	void*					sampled_alloc		(size_t size);
+	void					sampled_free		(void* P);
+	u32						sampled_size		(void* P);
+}
+
+#endif // MEMORY_PROFILER_H
@@ -72,6 +72,17 @@ public:
                         memcpy( B.data, data, size );
                         B.count = size;
                     }
+
+	// copies the state and only the used part of B (sizeof(NET_Packet) is ~16K)
+	IC void			assign			(const NET_Packet& src)
+	{
+		inistream	= src.inistream;
+		CopyMemory	(B.data, src.B.data, src.B.count);
+		B.count		= src.B.count;
+		r_pos		= src.r_pos;
+		timeReceive	= src.timeReceive;
+		w_allow		= src.w_allow;
+	}
                     
 	NET_Buffer		B;
 	u32				r_pos;
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "stream_reader.h"
+#include "FS_blocks.h"
 
 void CStreamReader::construct				(
 		const HANDLE &file_mapping_handle,
@@ -14,6 +15,44 @@ void CStreamReader::construct				(
 	m_file_size					= file_size;
 	m_archive_size				= archive_size;
 	m_window_size				= _max(window_size,FS.dwAllocGranularity);
+	m_blocks					= 0;
+	m_block_id					= u32(-1);
+
+	map							(0);
+}
+
+void CStreamReader::construct_blocks		(
+		const HANDLE &file_mapping_handle,
+		const CBlockIndex &blocks,
+		const u32 &start_offset,
+		const u32 &file_size,
+		const u32 &archive_size
+	)
+{
+	CBlockStream				*shared = xr_new<CBlockStream>();
+	shared->index				= blocks;
+	shared->data				= xr_alloc<u8>(blocks.block_size);
+	shared->block_id			= u32(-1);
+	shared->refs				= 0;
+	construct_shared			(file_mapping_handle,shared,start_offset,file_size,archive_size);
+}
+
+void CStreamReader::construct_shared		(
+		const HANDLE &file_mapping_handle,
+		CBlockStream *blocks,
+		const u32 &start_offset,
+		const u32 &file_size,
+		const u32 &archive_size
+	)
+{
+	m_file_mapping_handle		= file_mapping_handle;
+	m_start_offset				= start_offset;
+	m_file_size					= file_size;
+	m_archive_size				= archive_size;
+	m_window_size				= blocks->index.block_size;
+	m_blocks					= blocks;
+	m_block_id					= u32(-1);
+	++m_blocks->refs;
 
 	map							(0);
 }
@@ -21,10 +60,62 @@ void CStreamReader::construct				(
 void CStreamReader::destroy					()
 {
 	unmap						();
+	if (m_blocks && !--m_blocks->refs) {
+		xr_free					(m_blocks->data);
+		xr_delete				(m_blocks);
+	}
+}
+
+// the shared buffer may hold a block of another reader of the file, the
+// pointers of this one stay valid once its own block is unpacked again
+void CStreamReader::unpack_block			()
+{
+	if (m_blocks->block_id == m_block_id)
+		return;
+
+	CBlockIndex const			&I = m_blocks->index;
+	u32							granularity = FS.dwAllocGranularity;
+	u32							start_offset = (I.offsets[m_block_id]/granularity)*granularity;
+	u32							end_offset = I.offsets[m_block_id + 1];
+	u8							*view = (u8*)
+		MapViewOfFile(
+			m_file_mapping_handle,
+			FILE_MAP_READ,
+			0,
+			start_offset,
+			end_offset - start_offset
+		);
+	R_ASSERT					(view);
+	fs_block_decompress			(m_blocks->data,view,start_offset,I,m_block_id,m_block_id + 1);
+	UnmapViewOfFile				(view);
+	m_blocks->block_id			= m_block_id;
+}
+
+void CStreamReader::map_block				(const u32 &new_offset)
+{
+	VERIFY						(new_offset <= m_file_size);
+	m_current_offset_from_start	= new_offset;
+
+	CBlockIndex const			&I = m_blocks->index;
+	u32							offset = m_start_offset + new_offset;
+	u32							block = _min(offset/I.block_size,I.count()-1);
+	m_block_id					= block;
+	unpack_block				();
+
+	u32							inside = offset - block*I.block_size;
+	m_current_map_view_of_file	= m_blocks->data;
+	m_start_pointer				= m_blocks->data + inside;
+	m_current_pointer			= m_start_pointer;
+	m_current_window_size		= I.block_real(block) - inside;
 }
 
 void CStreamReader::map						(const u32 &new_offset)
 {
+	if (m_blocks) {
+		map_block				(new_offset);
+		return;
+	}
+
 	VERIFY						(new_offset <= m_file_size);
 	m_current_offset_from_start	= new_offset;
 
@@ -80,6 +171,9 @@ void CStreamReader::advance					(const int &offset)
 
 void CStreamReader::r						(void *_buffer, u32 buffer_size)
 {
+	if (m_blocks)
+		unpack_block			();
+
 	VERIFY						(m_current_pointer >= m_start_pointer);
 	VERIFY						(u32(m_current_pointer - m_start_pointer) <= m_current_window_size);
 
@@ -116,7 +210,10 @@ CStreamReader *CStreamReader::open_chunk	(const u32 &chunk_id)
 
 	R_ASSERT2					(!compressed,"cannot use CStreamReader on compressed chunks");
 	CStreamReader				*result = xr_new<CStreamReader>();
-	result->construct			(file_mapping_handle(),m_start_offset + tell(),size,m_archive_size,m_window_size);
+	if (m_blocks)
+		result->construct_shared(file_mapping_handle(),m_blocks,m_start_offset + tell(),size,m_archive_size);
+	else
+		result->construct		(file_mapping_handle(),m_start_offset + tell(),size,m_archive_size,m_window_size);
 	return						(result);
 }
 
@@ -128,6 +225,9 @@ u32 CStreamReader::find_chunk				(u32 ID, BOOL* bCompressed)
 
 void CStreamReader::r_stringZ				(shared_str& dest)
 {
+	if (m_blocks)
+		unpack_block		();
+
 	char*	dest_str		= NULL;
 	u32	current_str_size	= 0;
 	u8*	end_str				= NULL;
@@ -1,6 +1,9 @@
 #ifndef STREAM_READER_H
 #define STREAM_READER_H
 
+class CBlockIndex;
+struct CBlockStream;
+
 class XRCORE_API CStreamReader : public IReaderBase<CStreamReader> {
 private:
 	HANDLE	m_file_mapping_handle;
@@ -16,8 +19,23 @@ private:
 	u8		*m_start_pointer;
 	u8		*m_current_pointer;
 
+private:
+	// block compressed source (FS_blocks.h): the window is the unpacked block,
+	// the table and the block buffer are shared with the chunks
+	CBlockStream	*m_blocks;
+	u32		m_block_id;
+
 private:
 			void			map					(const u32 &new_offset);
+			void			map_block			(const u32 &new_offset);
+			void			unpack_block		();
+			void			construct_shared	(
+								const HANDLE &file_mapping_handle,
+								CBlockStream *blocks,
+								const u32 &start_offset,
+								const u32 &file_size,
+								const u32 &archive_size
+							);
 	IC		void			unmap				();
 	IC		void			remap				(const u32 &new_offset);
 
@@ -37,6 +55,14 @@ public:
 								const u32 &archive_size,
 								const u32 &window_size
 							);
+			// start_offset is inside the unpacked file here
+			void			construct_blocks	(
+								const HANDLE &file_mapping_handle,
+								const CBlockIndex &blocks,
+								const u32 &start_offset,
+								const u32 &file_size,
+								const u32 &archive_size
+							);
 	virtual	void			destroy				();
 
 public:
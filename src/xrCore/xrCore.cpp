@@ -80,12 +80,20 @@ void xrCore::_initialize	(LPCSTR _ApplicationName, LogCallback cb, BOOL init_fs,
 		CPU::Detect			();
 		
 		Memory._initialize	(strstr(Params,"-mem_debug") ? TRUE : FALSE);
+		ps_ini_cache_log	= strstr(Params,"-ini_cache_log") ? TRUE : FALSE;
 
 		DUMP_PHASE;
 
 		InitLog				();
 		_initialize_cpu		();
 
+		if (LPCSTR profile = strstr(Params,"-mem_profile "))
+		{
+			int				rate	= 0;
+			sscanf			(profile+xr_strlen("-mem_profile "),"%d",&rate);
+			if (rate>0)		memory_profiler::enable(u32(rate));
+		}
+
 //		Debug._initialize	();
 
 		rtc_initialize		();
@@ -273,6 +273,8 @@ DEFINE_VECTOR	(xr_rtoken,RTokenVec,RTokenVecIt);
 #	include "LocatorAPI.h"
 #endif
 #include "FileSystem.h"
+#include "xrTrace.h"
+#include "memory_profiler.h"
 #include "FTimer.h"
 #include "fastdelegate.h"
 #include "intrusive_ptr.h"
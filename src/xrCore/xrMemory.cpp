@@ -64,6 +64,8 @@ void	xrMemory::_initialize	(BOOL bDebug)
 
 	stat_calls				= 0;
 	stat_counter			= 0;
+	stat_frame_calls		= 0;
+	stat_frame_bytes		= 0;
 
 	if (CPU::ID.hasFeature(CPUFeature::MMX))
 	{
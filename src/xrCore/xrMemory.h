@@ -53,6 +53,8 @@ public:
 
 	u32					stat_calls;
 	s32					stat_counter;
+	u32					stat_frame_calls;	// frame arena, see frame_arena.h
+	u32					stat_frame_bytes;
 public:
 	void				dbg_register	(void* _p,	size_t _size, const char* _name);
 	void				dbg_unregister	(void* _p);
@@ -137,6 +139,7 @@ XRCORE_API	char* 	xr_strdup	(const char* string);
 const		u32			mem_pools_count			=	64;
 const		u32			mem_pools_ebase			=	32;
 const		u32			mem_generic				=	mem_pools_count+1;
+const		u32			mem_sampled				=	mem_pools_count+2;	// see memory_profiler.h
 extern		MEMPOOL		mem_pools				[mem_pools_count];
 extern		BOOL		mem_initialized;
 
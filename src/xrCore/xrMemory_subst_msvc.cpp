@@ -64,6 +64,15 @@ void*	xrMemory::mem_alloc		(size_t size
 	}
 #endif // PURE_ALLOC
 
+	if (memory_profiler::sample_rate && mem_initialized && !debug_mode && memory_profiler::sample())
+	{
+		void*	_ptr			=	memory_profiler::sampled_alloc(size);
+#ifdef USE_MEMORY_MONITOR
+		memory_monitor::monitor_alloc	(_ptr,size,_name);
+#endif // USE_MEMORY_MONITOR
+		return	_ptr;
+	}
+
 #ifdef DEBUG_MEMORY_MANAGER
 	if (mem_initialized)		debug_cs.Enter		();
 #endif // DEBUG_MEMORY_MANAGER
@@ -148,7 +157,11 @@ void	xrMemory::mem_free		(void* P)
 	if		(debug_mode)		dbg_unregister	(P);
 	u32	pool					= get_header	(P);
 	void* _real					= (void*)(((u8*)P)-1);
-	if (mem_generic==pool)		
+	if (mem_sampled==pool)
+	{
+		// sampled by the memory profiler
+		memory_profiler::sampled_free	(P);
+	} else if (mem_generic==pool)		
 	{
 		// generic
 		xr_aligned_free			(_real);
@@ -203,7 +216,8 @@ void*	xrMemory::mem_realloc	(void* P, size_t size
 	//u32		p_new				= get_pool	(size+(debug_mode?4:0));
 	u32		p_mode				;
 
-	if (mem_generic==p_current)	{
+	if (mem_sampled==p_current)		p_mode	= 3	;
+	else if (mem_generic==p_current)	{
 		if (p_new<p_current)		p_mode	= 2	;
 		else						p_mode	= 0	;
 	} else 							p_mode	= 1	;
@@ -261,6 +275,17 @@ void*	xrMemory::mem_realloc	(void* P, size_t size
 		mem_copy				(p_new,p_old,(u32)size);
 		mem_free				(p_old);
 		_ptr					= p_new;
+	} else if (3==p_mode)		{
+		// sampled by the memory profiler, moved like a pooled block
+		void*	p_old			= P;
+		void*	p_new			= mem_alloc(size
+#	ifdef DEBUG_MEMORY_NAME
+			,_name
+#	endif // DEBUG_MEMORY_NAME
+		);
+		mem_copy				(p_new,p_old,_min(memory_profiler::sampled_size(p_old),(u32)size));
+		mem_free				(p_old);
+		_ptr					= p_new;
 	}
 
 #ifdef DEBUG_MEMORY_MANAGER
@@ -0,0 +1,265 @@
+#include "stdafx.h"
+#pragma hdrstop
+
+#include "xrTrace.h"
+
+// Ring buffers are published by the owner through the volatile head: the
+// event is written first, then the head moves. The dump copies a ring and
+// then reads the head again, everything the owner could have overwritten in
+// between is dropped from the copy. Zones are paired into complete events at
+// dump time, so begins and ends lost to the ring wrap or to enabling the trace
+// in the middle of a zone are skipped there.
+
+namespace xrTrace
+{
+
+XRCORE_API BOOL		enabled			= FALSE;
+
+namespace
+{
+
+u32 const			ring_size		= 1<<16;		// events per thread
+u32 const			ring_mask		= ring_size-1;
+u32 const			frames_size		= 256;			// frame marks kept
+u32 const			rings_reuse		= 32;			// rings of finished threads are reused past this count
+
+struct event
+{
+	u64				time;			// CPU::QPC
+	LPCSTR			name;
+	u32				type;
+	float			value;
+};
+
+struct ring
+{
+	event*			events;
+	volatile u32	head;			// written by the owner thread only
+	u32				thread_id;
+	string64		name;
+	bool			finished;
+};
+
+struct frame_mark
+{
+	u64				time;
+	u32				id;
+};
+
+#ifdef PROFILE_CRITICAL_SECTIONS
+xrCriticalSection			g_rings_lock(MUTEX_PROFILE_ID(xrTrace::g_rings_lock));
+#else // PROFILE_CRITICAL_SECTIONS
+xrCriticalSection			g_rings_lock;
+#endif // PROFILE_CRITICAL_SECTIONS
+xr_vector<ring*>			g_rings;
+frame_mark					g_frames		[frames_size];
+volatile u32				g_frames_head	= 0;
+
+__declspec(thread) ring*	t_ring			= 0;
+__declspec(thread) LPCSTR	t_name			= 0;
+
+void		ring_name		(ring* R)
+{
+	if (t_name)				xr_strcpy	(R->name,t_name);
+	else					xr_sprintf	(R->name,"thread %d",R->thread_id);
+}
+
+ring*		ring_acquire	()
+{
+	g_rings_lock.Enter		();
+	ring*			R		= 0;
+	if (g_rings.size()>=rings_reuse)
+	{
+		for (u32 it=0; it<g_rings.size(); ++it)
+			if (g_rings[it]->finished)	{ R = g_rings[it]; break; }
+	}
+	if (!R)
+	{
+		R					= xr_new<ring>();
+		R->events			= xr_alloc<event>(ring_size);
+		g_rings.push_back	(R);
+	}
+	R->head					= 0;
+	R->thread_id			= GetCurrentThreadId();
+	R->finished				= false;
+	ring_name				(R);
+	g_rings_lock.Leave		();
+	return					R;
+}
+
+// copies the valid events of a ring, oldest first
+void		ring_copy		(ring* R, xr_vector<event>& dest)
+{
+	u32 const		head	= R->head;
+	u32				first	= (head>ring_size) ? head-ring_size : 0;
+	dest.resize				(head-first);
+	for (u32 it=first; it<head; ++it)
+		dest[it-first]		= R->events[it&ring_mask];
+
+	// the owner may be writing the slot of index head_now meanwhile
+	u32 const	head_now	= R->head;
+	if (head_now+1>ring_size)
+	{
+		u32 const	valid	= head_now+1-ring_size;
+		if (first<valid)
+		{
+			u32 const	lost	= _min(valid-first,u32(dest.size()));
+			dest.erase		(dest.begin(),dest.begin()+lost);
+		}
+	}
+}
+
+void		json_name		(LPCSTR src, string256& dest)
+{
+	u32				i		= 0;
+	for (; src && *src && (i<sizeof(dest)-1); ++src, ++i)
+		dest[i]				= ((*src=='"') || (*src=='\\') || (u8(*src)<' ')) ? '_' : *src;
+	dest[i]					= 0;
+}
+
+} // namespace
+
+void		enable			(BOOL value)
+{
+	enabled					= value;
+	Msg						("* Frame trace %s",value ? "enabled" : "disabled");
+}
+
+void		record			(u32 type, LPCSTR name, float value)
+{
+	ring*			R		= t_ring;
+	if (!R)		t_ring = R	= ring_acquire();
+
+	u32 const		head	= R->head;
+	event&			E		= R->events[head&ring_mask];
+	E.time					= CPU::QPC();
+	E.name					= name;
+	E.type					= type;
+	E.value					= value;
+	R->head					= head+1;
+}
+
+void		frame			(u32 frame_id)
+{
+	if (!enabled)			return;
+
+	u32 const		head	= g_frames_head;
+	frame_mark&		F		= g_frames[head%frames_size];
+	F.time					= CPU::QPC();
+	F.id					= frame_id;
+	g_frames_head			= head+1;
+}
+
+void		thread_name		(LPCSTR name)
+{
+	t_name					= name;
+	if (!t_ring)			return;
+
+	g_rings_lock.Enter		();
+	ring_name				(t_ring);
+	g_rings_lock.Leave		();
+}
+
+void		thread_exit		()
+{
+	if (!t_ring)			return;
+
+	g_rings_lock.Enter		();
+	t_ring->finished		= true;
+	g_rings_lock.Leave		();
+	t_ring					= 0;
+}
+
+u32			dump			(LPCSTR file_name, u32 frames_count)
+{
+	// frame range, the newest mark may still be written
+	u32 const	frames_head	= g_frames_head;
+	u32 const	available	= _min(frames_head,frames_size-1);
+	if (!available)
+	{
+		Msg					("! Frame trace is empty, enable it with 'trace_enable on'");
+		return				0;
+	}
+	frames_count			= _max(_min(frames_count,available),1u);
+	u32 const	first_frame	= frames_head-frames_count;
+	u64 const	from		= g_frames[first_frame%frames_size].time;
+
+	IWriter*		W		= FS.w_open("$logs$",file_name);
+	if (!W)
+	{
+		Msg					("! Can't write frame trace [%s]",file_name);
+		return				0;
+	}
+
+	double const	to_us	= 1000000.0/double(CPU::qpc_freq);
+	u32 const		pid		= GetCurrentProcessId();
+	u32				count	= 0;
+	string256		name;
+
+	W->w_string				("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+	for (u32 it=first_frame; it<frames_head; ++it)
+	{
+		const frame_mark&	F	= g_frames[it%frames_size];
+		W->w_printf			("%s{\"name\":\"frame %d\",\"ph\":\"i\",\"s\":\"g\",\"pid\":%d,\"tid\":0,\"ts\":%.3f}\r\n",
+							count++ ? "," : "",F.id,pid,double(F.time-from)*to_us);
+	}
+
+	xr_vector<event>		events;
+	xr_vector<u32>			stack;
+	g_rings_lock.Enter		();
+	for (u32 r=0; r<g_rings.size(); ++r)
+	{
+		ring*		R		= g_rings[r];
+		ring_copy			(R,events);
+		if (events.empty() || (events.back().time<from))
+			continue;
+
+		json_name			(R->name,name);
+		W->w_printf			("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}\r\n",
+							count++ ? "," : "",pid,R->thread_id,name);
+
+		stack.clear			();
+		for (u32 e=0; e<events.size(); ++e)
+		{
+			const event&	E	= events[e];
+			switch (E.type)
+			{
+			case et_begin:
+				stack.push_back	(e);
+				break;
+			case et_end:
+				{
+					// unwind to the matching begin, zones without one are dropped
+					u32		depth	= stack.size();
+					while (depth && (events[stack[depth-1]].name!=E.name))	--depth;
+					if (!depth)		break;
+
+					const event&	B	= events[stack[depth-1]];
+					stack.resize	(depth-1);
+					if (E.time<from)	break;
+
+					u64 const	start	= _max(B.time,from);
+					json_name		(E.name,name);
+					W->w_printf		("%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}\r\n",
+									count++ ? "," : "",name,pid,R->thread_id,double(start-from)*to_us,double(E.time-start)*to_us);
+				}
+				break;
+			case et_counter:
+				if (E.time<from)	break;
+				json_name		(E.name,name);
+				W->w_printf		("%s{\"name\":\"%s\",\"ph\":\"C\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"args\":{\"value\":%f}}\r\n",
+								count++ ? "," : "",name,pid,R->thread_id,double(E.time-from)*to_us,E.value);
+				break;
+			}
+		}
+	}
+	g_rings_lock.Leave		();
+
+	W->w_string				("]}");
+	FS.w_close				(W);
+	Msg						("* Frame trace: %d frames, %d events written to [%s]",frames_count,count,file_name);
+	return					count;
+}
+
+} // namespace xrTrace
@@ -0,0 +1,52 @@
+#ifndef XR_TRACE_H
+#define XR_TRACE_H
+#pragma once
+
+// Frame tracer: scoped zones and counters of all threads, exported as Chrome
+// trace JSON (chrome://tracing, ui.perfetto.dev).
+//
+// Every thread records into its own ring buffer and is the only writer of it,
+// so an event costs a QPC read and a few stores, with no locks. When tracing is
+// disabled an event is one test of xrTrace::enabled. Names are stored as
+// pointers and must outlive the trace (string literals, CStatTimer names).
+
+namespace xrTrace
+{
+	enum event_type
+	{
+		et_begin		= 0,
+		et_end,
+		et_counter,
+		et_frame,
+	};
+
+	extern XRCORE_API BOOL	enabled;
+
+	XRCORE_API void			enable		(BOOL value);
+	XRCORE_API void			record		(u32 type, LPCSTR name, float value);
+
+	ICF void				zone_begin	(LPCSTR name)				{ if (enabled) record(et_begin,name,0.f);		}
+	ICF void				zone_end	(LPCSTR name)				{ if (enabled) record(et_end,name,0.f);			}
+	ICF void				counter		(LPCSTR name, float value)	{ if (enabled) record(et_counter,name,value);	}
+
+	// marks the start of a frame, called by the device
+	XRCORE_API void			frame		(u32 frame_id);
+
+	// name shown for the events of the calling thread
+	XRCORE_API void			thread_name	(LPCSTR name);
+	XRCORE_API void			thread_exit	();
+
+	// writes the last frames_count frames into $logs$\file_name, returns the number of events written
+	XRCORE_API u32			dump		(LPCSTR file_name, u32 frames_count);
+
+	struct zone
+	{
+		LPCSTR				m_name;
+		ICF					zone		(LPCSTR name) : m_name(name)	{ zone_begin(m_name);	}
+		ICF					~zone		()								{ zone_end(m_name);		}
+	};
+}
+
+#define TRACE_ZONE(name)	xrTrace::zone __trace_zone__(name)
+
+#endif // XR_TRACE_H
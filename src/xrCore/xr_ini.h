@@ -36,6 +36,19 @@ public:
 	typedef	xr_vector<Sect*>		Root;
 	typedef Root::iterator			RootIt;
 	typedef Root::const_iterator	RootCIt;
+
+	// value of a line parsed once for every typed reader, see r_handle
+	struct XRCORE_API	Value
+	{
+		LPCSTR			string;
+		float			f;			// r_float
+		s32				i;			// r_u8..r_s32
+		Fvector4		fv;			// r_fvector2..4, r_fcolor
+		Ivector4		iv;			// r_ivector2..4
+		u32				color;		// r_color
+		BOOL			b;			// r_bool
+	};
+	typedef const Value*			Handle;
 	
 #ifndef _EDITOR
 	typedef fastdelegate::FastDelegate1<LPCSTR, bool>	allow_include_func_t;
@@ -48,6 +61,19 @@ private:
 	Flags8			m_flags;
 	string_path		m_file_name;
 	Root			DATA;
+
+	typedef xr_map<std::pair<const str_value*,const str_value*>,Value*>	Handles;
+	mutable Handles				m_handles;		// by section and line name
+	mutable xr_vector<Value*>	m_values;		// blocks, handles point into them and never move
+	mutable u32					m_values_free;	// in the last block
+#ifndef _EDITOR
+	xr_vector<shared_str>*	m_load_deps;	// files read by Load while a binary cache is being built
+
+	// binary cache of read-only files, see Xr_ini_cache.cpp
+	bool			cache_name	(string_path& dest) const;
+	bool			load_cache	(LPCSTR cache_name);
+	void			save_cache	(LPCSTR cache_name, const xr_vector<shared_str>& deps) const;
+#endif
 	
 	void			Load		(IReader* F, LPCSTR path
                                 #ifndef _EDITOR
@@ -135,6 +161,31 @@ public:
 	BOOL		r_line			( LPCSTR S, int L,	LPCSTR* N, LPCSTR* V )const;
 	BOOL		r_line			( const shared_str& S, int L,	LPCSTR* N, LPCSTR* V )const;
 
+	// hot lookups: the section and the line are resolved once (read-only files only),
+	// the handle stays valid for the life of the file and typed reads are plain loads
+	Handle		r_handle		( LPCSTR S, LPCSTR L )const;
+	Handle		r_handle		( const shared_str& S, LPCSTR L )const				{ return r_handle(*S,L);		}
+	IC LPCSTR	r_string		( Handle H )const	{ return H->string;			}
+	IC u8		r_u8			( Handle H )const	{ return u8(H->i);			}
+	IC u16		r_u16			( Handle H )const	{ return u16(H->i);			}
+	IC u32		r_u32			( Handle H )const	{ return u32(H->i);			}
+	IC s8		r_s8			( Handle H )const	{ return s8(H->i);			}
+	IC s16		r_s16			( Handle H )const	{ return s16(H->i);			}
+	IC s32		r_s32			( Handle H )const	{ return H->i;				}
+	IC float	r_float			( Handle H )const	{ return H->f;				}
+	IC Fcolor	r_fcolor		( Handle H )const	{ Fcolor V; V.set(H->fv.x,H->fv.y,H->fv.z,H->fv.w); return V;	}
+	IC u32		r_color			( Handle H )const	{ return H->color;			}
+	IC Ivector2	r_ivector2		( Handle H )const	{ Ivector2 V = {H->iv.x,H->iv.y}; return V;			}
+	IC Ivector3	r_ivector3		( Handle H )const	{ Ivector3 V = {H->iv.x,H->iv.y,H->iv.z}; return V;	}
+	IC Ivector4	r_ivector4		( Handle H )const	{ return H->iv;				}
+	IC Fvector2	r_fvector2		( Handle H )const	{ Fvector2 V; V.set(H->fv.x,H->fv.y); return V;		}
+	IC Fvector3	r_fvector3		( Handle H )const	{ Fvector3 V; V.set(H->fv.x,H->fv.y,H->fv.z); return V;	}
+	IC Fvector4	r_fvector4		( Handle H )const	{ return H->fv;				}
+	IC BOOL		r_bool			( Handle H )const	{ return H->b;				}
+
+	// typed reads by name are counted per line when started with -ini_stats, this logs the most frequent ones
+	static void	dump_stats		( u32 count );
+
     void		w_string		( LPCSTR S, LPCSTR L, LPCSTR			V, LPCSTR comment=0 );
 	void		w_u8			( LPCSTR S, LPCSTR L, u8				V, LPCSTR comment=0 );
 	void		w_u16			( LPCSTR S, LPCSTR L, u16				V, LPCSTR comment=0 );
@@ -162,4 +213,7 @@ public:
 extern XRCORE_API CInifile const * pSettings;
 extern XRCORE_API CInifile const * pSettingsAuth;
 
+// report the load times of the cached files (-ini_cache_log, ini_cache_log)
+extern XRCORE_API BOOL ps_ini_cache_log;
+
 #endif //__XR_INI_H__
@@ -8,6 +8,14 @@
 XRCORE_API	extern		str_container*	g_pStringContainer	= NULL;
 #define		HEADER		12	+ sizeof(void*)				// ref + len + crc + next
 
+str_value*	str_container::dock		(str_c value)
+{
+	if (0==value)				return 0;
+
+	u32 const	length			= xr_strlen(value);
+	return						dock(value,length,crc32(value,length));
+}
+
 #if 1
 
 struct str_container_impl
@@ -138,9 +146,10 @@ str_container::str_container ()
 	impl = xr_new<str_container_impl>();
 }
 
-str_value*	str_container::dock		(str_c value)
+str_value*	str_container::dock		(str_c value, u32 length, u32 crc)
 {
-	if (0==value)				return 0;
+	VERIFY						(value);
+	VERIFY						(length==xr_strlen(value));
 
 	cs.Enter					();
 
@@ -151,7 +160,7 @@ str_value*	str_container::dock		(str_c value)
 	str_value*	result			= 0	;
 
 	// calc len
-	u32		s_len				= xr_strlen(value);
+	u32		s_len				= length;
 	u32		s_len_with_zero		= (u32)s_len+1;
 	VERIFY	(HEADER+s_len_with_zero < 4096);
 
@@ -160,7 +169,7 @@ str_value*	str_container::dock		(str_c value)
 	str_value*	sv				= (str_value*)header;
 	sv->dwReference				= 0;
 	sv->dwLength				= s_len;
-	sv->dwCRC					= crc32	(value,s_len);
+	sv->dwCRC					= crc;
 
 	// search
 	result						= impl->find	(sv, value);
@@ -267,9 +276,10 @@ str_container::str_container ()
 	impl = xr_new<str_container_impl>();
 }
 
-str_value*	str_container::dock		(str_c value)
+str_value*	str_container::dock		(str_c value, u32 length, u32 crc)
 {
-	if (0==value)				return 0;
+	VERIFY						(value);
+	VERIFY						(length==xr_strlen(value));
 
 	cs.Enter					();
 
@@ -291,7 +301,7 @@ str_value*	str_container::dock		(str_c value)
 	str_value*	result			= 0	;
 
 	// calc len
-	u32		s_len				= xr_strlen(value);
+	u32		s_len				= length;
 	u32		s_len_with_zero		= (u32)s_len+1;
 	VERIFY	(HEADER+s_len_with_zero < 4096);
 
@@ -300,7 +310,7 @@ str_value*	str_container::dock		(str_c value)
 	str_value*	sv				= (str_value*)header;
 	sv->dwReference				= 0;
 	sv->dwLength				= s_len;
-	sv->dwCRC					= crc32	(value,s_len);
+	sv->dwCRC					= crc;
 	sv->next					= NULL;
 	
 	// search
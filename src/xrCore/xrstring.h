@@ -40,6 +40,7 @@ public:
 						~str_container  ();
 
 	str_value*			dock			(str_c value);
+	str_value*			dock			(str_c value, u32 length, u32 crc);	// crc32 of the string, for prehashed sources
 	void				clean			();
 	void				dump			();
 	void				dump			(IWriter* W);
@@ -62,6 +63,7 @@ protected:
 public:
 	void				_set		(str_c rhs) 					{	str_value* v = g_pStringContainer->dock(rhs); if (0!=v) v->dwReference++; _dec(); p_ = v;	}
 	void				_set		(shared_str const &rhs)			{	str_value* v = rhs.p_; if (0!=v) v->dwReference++; _dec(); p_ = v;							}
+	void				_set		(str_c rhs, u32 length, u32 crc){	str_value* v = g_pStringContainer->dock(rhs,length,crc); if (0!=v) v->dwReference++; _dec(); p_ = v;	}
 //	void				_set		(shared_str const &rhs)			{	str_value* v = g_pStringContainer->dock(rhs.c_str()); if (0!=v) v->dwReference++; _dec(); p_ = v;							}
 	
 
@@ -5,17 +5,28 @@
 #include "xr_collide_form.h"
 #include "igame_level.h"
 #include "cl_intersect.h"
+#include "../xrCPU_Pipe/ttapi.h"
+#pragma comment(lib,"xrCPU_Pipe.lib")
 
 namespace Feel {
 
+	static bool						g_batch_active	= false;
+	static xr_vector<Vision*>		g_batch;
+
 	Vision::Vision( CObject const* owner ) : 
 		pure_relcase( &Vision::feel_vision_relcase ),
-		m_owner(owner)
+		m_owner(owner),
+		m_batch_pending(false)
 	{	
 	}
 
 	Vision::~Vision()
 	{	
+		if (m_batch_pending) {
+			xr_vector<Vision*>::iterator I = std::find(g_batch.begin(),g_batch.end(),this);
+			VERIFY			(I != g_batch.end());
+			g_batch.erase	(I);
+		}
 	}
 
 	struct SFeelParam	{
@@ -153,8 +164,10 @@ namespace Feel {
 	}
 	void Vision::o_trace	(Fvector& P, float dt, float vis_threshold)	{
 		RQR.r_clear			();
+		bool				pending = false;
 		xr_vector<feel_visible_Item>::iterator I=feel_visible.begin(),E=feel_visible.end();
 		for (; I!=E; I++){
+			I->trace_pending	= FALSE;
 			if (0==I->O->CFORM())	{ I->fuzzy = -1; continue; }
 
 			// verify relation
@@ -176,23 +189,33 @@ namespace Feel {
 			float				f = D.magnitude() + .2f;
 			if (f>fuzzy_guaranteed){
 				D.div						(f);
-				// setup ray defs & feel params
-				collide::ray_defs RD		(P,D,f,CDB::OPT_CULL,collide::rq_target(collide::rqtStatic|/**/collide::rqtObject|/**/collide::rqtObstacle));
-				SFeelParam	feel_params		(this,&*I,vis_threshold);
+				float			vis			= 1.f;
 				// check cache
 				if (I->Cache.result&&I->Cache.similar(P,D,f)){
 					// similar with previous query
-					feel_params.vis			= I->Cache_vis;
+					vis						= I->Cache_vis;
 //					Log("cache 0");
 				}else{
 					float _u,_v,_range;
 					if (CDB::TestRayTri(P,D,I->Cache.verts,_u,_v,_range,false)&&(_range>0 && _range<f))	{
-						feel_params.vis		= 0.f;
+						vis					= 0.f;
 //						Log("cache 1");
 					}else{
 						// cache outdated. real query.
-						VERIFY(!fis_zero(RD.dir.magnitude()));
+						VERIFY(!fis_zero(D.magnitude()));
 
+						if (g_batch_active) {
+							// deferred till feel_vision_batch_end
+							I->trace_dir		= D;
+							I->trace_range		= f;
+							I->trace_pending	= TRUE;
+							pending				= true;
+							continue;
+						}
+
+						// setup ray defs & feel params
+						collide::ray_defs RD	(P,D,f,CDB::OPT_CULL,collide::rq_target(collide::rqtStatic|/**/collide::rqtObject|/**/collide::rqtObstacle));
+						SFeelParam	feel_params	(this,&*I,vis_threshold);
 						if (g_pGameLevel->ObjectSpace.RayQuery	(RQR, RD, feel_vision_callback, &feel_params, NULL, NULL))	{
 							I->Cache_vis	= feel_params.vis	;
 							I->Cache.set	(P,D,f,TRUE	)		;
@@ -202,53 +225,204 @@ namespace Feel {
 //							I->Cache_vis	= feel_params.vis	;
 							I->Cache.set	(P,D,f,FALSE)		;
 						}
+						vis					= feel_params.vis;
 //						Log("query");
 					}
 				}
-//				Log("Vis",feel_params.vis);
-				r_spatial.clear_not_free();
-				g_SpatialSpace->q_ray( r_spatial, 0, STYPE_VISIBLEFORAI, P, D, f );
+//				Log("Vis",vis);
+				o_trace_item				(*I,P,D,f,dt,vis,vis_threshold);
+			}
+			else {
+				// VISIBLE, 'cause near
+				I->fuzzy				+=	fuzzy_update_vis*dt;
+				clamp					(I->fuzzy,-.5f,1.f);
+			}
+		}
 
-				RD.flags				= CDB::OPT_ONLYFIRST;
+		if (!pending)
+			return;
 
-				bool collision_found	= false;
-				xr_vector<ISpatial*>::const_iterator	i = r_spatial.begin();
-				xr_vector<ISpatial*>::const_iterator	e = r_spatial.end();
-				for ( ; i != e; ++i ) {
-					if ( *i == m_owner )
-						continue;
+		m_batch_position		= P;
+		m_batch_dt				= dt;
+		m_batch_vis_threshold	= vis_threshold;
+		if (!m_batch_pending) {
+			m_batch_pending		= true;
+			g_batch.push_back	(this);
+		}
+	}
 
-					if ( *i == I->O )
-						continue;
+	void Vision::o_trace_item	(feel_visible_Item& I, Fvector& P, Fvector& D, float f, float dt, float vis, float vis_threshold)
+	{
+		r_spatial.clear_not_free();
+		g_SpatialSpace->q_ray( r_spatial, 0, STYPE_VISIBLEFORAI, P, D, f );
 
-					CObject const* object	= (*i)->dcast_CObject();
-					RQR.r_clear				( );
-					if ( object && object->collidable.model && !object->collidable.model->_RayQuery(RD,RQR) )
-						continue;
+		collide::ray_defs RD	(P,D,f,CDB::OPT_ONLYFIRST,collide::rq_target(collide::rqtStatic|/**/collide::rqtObject|/**/collide::rqtObstacle));
 
-					collision_found		= true;
-					break;
-				}
+		bool collision_found	= false;
+		xr_vector<ISpatial*>::const_iterator	i = r_spatial.begin();
+		xr_vector<ISpatial*>::const_iterator	e = r_spatial.end();
+		for ( ; i != e; ++i ) {
+			if ( *i == m_owner )
+				continue;
 
-				if (collision_found)
-					feel_params.vis		= 0.f;
+			if ( *i == I.O )
+				continue;
 
-				if (feel_params.vis<feel_params.vis_threshold){
-					// INVISIBLE, choose next point
-					I->fuzzy				-=	fuzzy_update_novis*dt;
-					clamp					(I->fuzzy,-.5f,1.f);
-					I->cp_LP				= I->O->get_new_local_point_on_mesh( I->bone_id );
-				}else{
-					// VISIBLE
-					I->fuzzy				+=	fuzzy_update_vis*dt;
-					clamp					(I->fuzzy,-.5f,1.f);
+			CObject const* object	= (*i)->dcast_CObject();
+			RQR.r_clear				( );
+			if ( object && object->collidable.model && !object->collidable.model->_RayQuery(RD,RQR) )
+				continue;
+
+			collision_found		= true;
+			break;
+		}
+
+		if (collision_found)
+			vis					= 0.f;
+
+		if (vis<vis_threshold){
+			// INVISIBLE, choose next point
+			I.fuzzy				-=	fuzzy_update_novis*dt;
+			clamp				(I.fuzzy,-.5f,1.f);
+			I.cp_LP				= I.O->get_new_local_point_on_mesh( I.bone_id );
+		}else{
+			// VISIBLE
+			I.fuzzy				+=	fuzzy_update_vis*dt;
+			clamp				(I.fuzzy,-.5f,1.f);
+		}
+	}
+
+	// the dynamic part of the deferred traces, the static one is already done by batch_worker
+	void Vision::o_resolve	()
+	{
+		m_batch_pending		= false;
+		Fvector& P			= m_batch_position;
+		xr_vector<feel_visible_Item>::iterator I=feel_visible.begin(),E=feel_visible.end();
+		for (; I!=E; I++){
+			if (!I->trace_pending)
+				continue;
+
+			I->trace_pending	= FALSE;
+			Fvector&		D	= I->trace_dir;
+			float const		f	= I->trace_range;
+			SFeelParam	feel_params		(this,&*I,m_batch_vis_threshold);
+			feel_params.vis				= I->trace_vis;
+			BOOL			hit	= I->trace_hit;
+			if (feel_params.vis>feel_params.vis_threshold) {
+				collide::ray_defs RD	(P,D,f,CDB::OPT_CULL,collide::rq_target(collide::rqtObject|collide::rqtObstacle));
+				if (g_pGameLevel->ObjectSpace.RayQuery(RQR, RD, feel_vision_callback, &feel_params, NULL, NULL))
+					hit					= TRUE;
+			}
+
+			if (hit) {
+				I->Cache_vis	= feel_params.vis	;
+				I->Cache.set	(P,D,f,TRUE	)		;
+			}
+			else
+				I->Cache.set	(P,D,f,FALSE)		;
+
+			o_trace_item		(*I,P,D,f,m_batch_dt,feel_params.vis,m_batch_vis_threshold);
+		}
+	}
+
+	struct SBatchJob	{
+		Vision*						parent;
+		Vision::feel_visible_Item*	item;
+	};
+	struct SBatchWorker	{
+		u32							from;
+		u32							to;
+	};
+	static xr_vector<SBatchJob>		g_batch_jobs;
+	static u32 const				batch_min_jobs	= 32;
+
+	IC bool batch_result_less	(CDB::RESULT const& r0, CDB::RESULT const& r1)
+	{
+		return				(r0.range < r1.range);
+	}
+
+	// the static part of the trace, the same as the static hits of feel_vision_callback
+	void Vision::batch_worker	(LPVOID params)
+	{
+		SBatchWorker const&	worker	= *(SBatchWorker const*)params;
+		CDB::MODEL*			model	= g_pGameLevel->ObjectSpace.GetStaticModel();
+		CDB::COLLIDER		collider;
+		collider.ray_options		(CDB::OPT_CULL);
+		for (u32 i=worker.from; i<worker.to; ++i) {
+			Vision&				V	= *g_batch_jobs[i].parent;
+			feel_visible_Item&	I	= *g_batch_jobs[i].item;
+			collider.ray_query		(model,V.m_batch_position,I.trace_dir,I.trace_range);
+			I.trace_vis				= 1.f;
+			I.trace_hit				= collider.r_count() ? TRUE : FALSE;
+			if (collider.r_count() > 1)
+				std::sort			(collider.r_begin(),collider.r_end(),batch_result_less);
+
+			CDB::RESULT*	R		= collider.r_begin();
+			CDB::RESULT*	RE		= collider.r_end();
+			for (; R!=RE; ++R) {
+				float vis			= V.feel_vision_mtl_transp(NULL, R->id);
+				I.trace_vis			*= vis;
+				if (fis_zero(vis)) {
+					I.Cache.verts[0].set	(R->verts[0]);
+					I.Cache.verts[1].set	(R->verts[1]);
+					I.Cache.verts[2].set	(R->verts[2]);
 				}
+				if (!(I.trace_vis>V.m_batch_vis_threshold))
+					break;
 			}
-			else {
-				// VISIBLE, 'cause near
-				I->fuzzy				+=	fuzzy_update_vis*dt;
-				clamp					(I->fuzzy,-.5f,1.f);
+		}
+	}
+
+	void Vision::feel_vision_batch_begin	()
+	{
+		VERIFY				(!g_batch_active);
+		VERIFY				(g_batch.empty());
+		g_batch_active		= true;
+	}
+
+	void Vision::feel_vision_batch_end		()
+	{
+		VERIFY				(g_batch_active);
+		g_batch_active		= false;
+		if (g_batch.empty())
+			return;
+
+		Device.Statistic->AI_Vis_RayTests.Begin	();
+
+		g_batch_jobs.clear_not_free		();
+		xr_vector<Vision*>::iterator	I = g_batch.begin(), E = g_batch.end();
+		for (; I!=E; ++I) {
+			xr_vector<feel_visible_Item>::iterator i=(*I)->feel_visible.begin(),e=(*I)->feel_visible.end();
+			for (; i!=e; ++i) {
+				if (!i->trace_pending)
+					continue;
+
+				SBatchJob		job	= { *I, &*i };
+				g_batch_jobs.push_back	(job);
+			}
+		}
+
+		u32 const job_count		= g_batch_jobs.size();
+		u32 const worker_count	= _max(u32(1), _min(u32(ttapi_GetWorkersCount()), job_count/batch_min_jobs));
+		if (worker_count == 1) {
+			SBatchWorker		worker = { 0, job_count };
+			batch_worker		(&worker);
+		} else {
+			SBatchWorker*		workers = (SBatchWorker*)_alloca(sizeof(SBatchWorker)*worker_count);
+			u32 const			step = job_count/worker_count;
+			for (u32 i=0; i<worker_count; ++i) {
+				workers[i].from	= i*step;
+				workers[i].to	= (i == worker_count - 1) ? job_count : (workers[i].from + step);
+				ttapi_AddWorker	(&Vision::batch_worker, &workers[i]);
 			}
+			ttapi_RunAllWorkers	();
 		}
+
+		// in the order the agents were updated in
+		for (I = g_batch.begin(); I!=E; ++I)
+			(*I)->o_resolve		();
+
+		g_batch.clear_not_free	();
+		Device.Statistic->AI_Vis_RayTests.End	();
 	}
 };
@@ -25,9 +25,17 @@ namespace Feel
 		xr_vector<ISpatial*>		r_spatial;
 		CObject const*				m_owner;
 
+		// batched tracing
+		Fvector						m_batch_position;
+		float						m_batch_dt;
+		float						m_batch_vis_threshold;
+		bool						m_batch_pending;
+
 		void						o_new		(CObject* E);
 		void						o_delete	(CObject* E);
 		void						o_trace		(Fvector& P, float dt, float vis_threshold);
+		void						o_resolve	();
+		static	void				batch_worker(LPVOID params);
 	public:
 									Vision		(CObject const* owner);
 		virtual					~	Vision		();
@@ -42,13 +50,26 @@ namespace Feel
 			float				fuzzy;		// note range: (-1[no]..1[yes])
 			float				Cache_vis;
 			u16					bone_id;
+			// static part of the deferred trace, filled by the batch workers
+			Fvector				trace_dir;
+			float				trace_range;
+			float				trace_vis;
+			BOOL				trace_hit;
+			BOOL				trace_pending;
 		};
 		xr_vector<feel_visible_Item>	feel_visible;
+	private:
+		void						o_trace_item(feel_visible_Item& I, Fvector& P, Fvector& D, float f, float dt, float vis, float vis_threshold);
 	public:
 		void						feel_vision_clear		();
 		void						feel_vision_query		(Fmatrix& mFull,	Fvector& P);
 		void						feel_vision_update		(CObject* parent,	Fvector& P, float dt, float vis_threshold);
 		void	__stdcall			feel_vision_relcase		(CObject* object);
+
+		// between these calls feel_vision_update only queues the ray tests, feel_vision_batch_end
+		// resolves the queued tests of all the agents at once, the static part on all the worker threads
+		static	void				feel_vision_batch_begin	();
+		static	void				feel_vision_batch_end	();
 		void						feel_vision_get			(xr_vector<CObject*>& R)		{
 			R.clear					();
 			xr_vector<feel_visible_Item>::iterator I=feel_visible.begin(),E=feel_visible.end();
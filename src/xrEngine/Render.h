@@ -270,6 +270,8 @@ public:
 //	virtual void 					model_Delete			(IRender_DetailModel* & F)					= 0;
 	virtual void					model_Logging			(BOOL bEnable)								= 0;
 	virtual void					models_Prefetch			()											= 0;
+	// reads the model and its textures in the background, true while they are not in memory yet
+	virtual bool					model_Stream			(LPCSTR name, float priority)				= 0;
 	virtual void					models_Clear			(BOOL b_complete)							= 0;
 
 	// Occlusion culling
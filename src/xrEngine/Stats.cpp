@@ -45,6 +45,7 @@ static	optimizer	vtune;
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////
+#define STAT_TRACE_NAME(timer)	(timer).name = #timer
 BOOL			g_bDisableRedText	= FALSE;
 CStats::CStats	()
 {
@@ -53,7 +54,71 @@ CStats::CStats	()
 	fTPS				= 0;
 	pFont				= 0;
 	fMem_calls			= 0;
+	fMem_frame_calls	= 0;
+	dwMem_frame_bytes	= 0;
 	RenderDUMP_DT_Count = 0;
+	Animation_BatchBones= 0;
+	Animation_BatchModels	= 0;
+	Animation_BatchSkipped	= 0;
+	Animation_BonesEvaluated= 0;
+	Animation_BonesAvoided	= 0;
+	Animation_EvalTicks		= 0;
+	netServerUpdateObjects	= 0;
+	netServerUpdateBytes	= 0;
+
+	// zone names for xrTrace, RenderTOTAL only mirrors RenderTOTAL_Real
+	STAT_TRACE_NAME		(ph_collision);
+	STAT_TRACE_NAME		(ph_core);
+	STAT_TRACE_NAME		(Physics);
+	STAT_TRACE_NAME		(EngineTOTAL);
+	STAT_TRACE_NAME		(Sheduler);
+	STAT_TRACE_NAME		(UpdateClient);
+	STAT_TRACE_NAME		(AI_Think);
+	STAT_TRACE_NAME		(AI_Range);
+	STAT_TRACE_NAME		(AI_Path);
+	STAT_TRACE_NAME		(AI_Node);
+	STAT_TRACE_NAME		(AI_Vis);
+	STAT_TRACE_NAME		(AI_Vis_Query);
+	STAT_TRACE_NAME		(AI_Vis_RayTests);
+	STAT_TRACE_NAME		(RenderTOTAL_Real);
+	STAT_TRACE_NAME		(RenderCALC);
+	STAT_TRACE_NAME		(RenderCALC_HOM);
+	STAT_TRACE_NAME		(Animation);
+	STAT_TRACE_NAME		(Animation_Batch);
+	STAT_TRACE_NAME		(RenderDUMP);
+	STAT_TRACE_NAME		(RenderDUMP_Wait);
+	STAT_TRACE_NAME		(RenderDUMP_Wait_S);
+	STAT_TRACE_NAME		(RenderDUMP_RT);
+	STAT_TRACE_NAME		(RenderDUMP_SKIN);
+	STAT_TRACE_NAME		(RenderDUMP_HUD);
+	STAT_TRACE_NAME		(RenderDUMP_Glows);
+	STAT_TRACE_NAME		(RenderDUMP_Lights);
+	STAT_TRACE_NAME		(RenderDUMP_WM);
+	STAT_TRACE_NAME		(RenderDUMP_DT_VIS);
+	STAT_TRACE_NAME		(RenderDUMP_DT_Render);
+	STAT_TRACE_NAME		(RenderDUMP_DT_Cache);
+	STAT_TRACE_NAME		(RenderDUMP_Pcalc);
+	STAT_TRACE_NAME		(RenderDUMP_Scalc);
+	STAT_TRACE_NAME		(RenderDUMP_Srender);
+	STAT_TRACE_NAME		(Sound);
+	STAT_TRACE_NAME		(Input);
+	STAT_TRACE_NAME		(clRAY);
+	STAT_TRACE_NAME		(clBOX);
+	STAT_TRACE_NAME		(clFRUSTUM);
+	STAT_TRACE_NAME		(netClient1);
+	STAT_TRACE_NAME		(netClient2);
+	STAT_TRACE_NAME		(netServer);
+	STAT_TRACE_NAME		(netClientCompressor);
+	STAT_TRACE_NAME		(netServerCompressor);
+	STAT_TRACE_NAME		(netServerUpdates);
+	STAT_TRACE_NAME		(TEST0);
+	STAT_TRACE_NAME		(TEST1);
+	STAT_TRACE_NAME		(TEST2);
+	STAT_TRACE_NAME		(TEST3);
+
+	if (strstr(Core.Params,"-trace"))
+		xrTrace::enable	(TRUE);
+#undef STAT_TRACE_NAME
 	Device.seqRender.Add		(this,REG_PRIORITY_LOW-1000);
 }
 
@@ -84,6 +149,7 @@ void CStats::Show()
 		ph_collision.FrameEnd		();
 		ph_core.FrameEnd			();
 		Animation.FrameEnd			();	
+		Animation_Batch.FrameEnd	();
 		AI_Think.FrameEnd			();
 		AI_Range.FrameEnd			();
 		AI_Path.FrameEnd			();
@@ -123,6 +189,7 @@ void CStats::Show()
 
 		netClientCompressor.FrameEnd();
 		netServerCompressor.FrameEnd();
+		netServerUpdates.FrameEnd	();
 		
 		TEST0.FrameEnd				();
 		TEST1.FrameEnd				();
@@ -155,6 +222,13 @@ void CStats::Show()
 		if (mem_count>fMem_calls)	fMem_calls	=	mem_count;
 		else						fMem_calls	=	.9f*fMem_calls + .1f*mem_count;
 		Memory.stat_calls	= 0		;
+
+		float frame_count	= float	(Memory.stat_frame_calls);
+		if (frame_count>fMem_frame_calls)	fMem_frame_calls	=	frame_count;
+		else								fMem_frame_calls	=	.9f*fMem_frame_calls + .1f*frame_count;
+		dwMem_frame_bytes		= Memory.stat_frame_bytes;
+		Memory.stat_frame_calls	= 0	;
+		Memory.stat_frame_bytes	= 0	;
 	}
 
 	////////////////////////////////////////////////
@@ -221,7 +295,7 @@ void CStats::Show()
 
 #define PPP(a) (100.f*float(a)/float(EngineTOTAL.result))
 		F.OutNext	("*** ENGINE:  %2.2fms",EngineTOTAL.result);	
-		F.OutNext	("Memory:      %2.2fa",fMem_calls);
+		F.OutNext	("Memory:      %2.2fa, frame arena %2.2fa, %dK",fMem_calls,fMem_frame_calls,dwMem_frame_bytes/1024);
 		F.OutNext	("uClients:    %2.2fms, %2.1f%%, crow(%d)/active(%d)/total(%d)",UpdateClient.result,PPP(UpdateClient.result),UpdateClient_crows,UpdateClient_active,UpdateClient_total);
 		F.OutNext	("uSheduler:   %2.2fms, %2.1f%%",Sheduler.result,		PPP(Sheduler.result));
 		F.OutNext	("uSheduler_L: %2.2fms",fShedulerLoad);
@@ -246,6 +320,9 @@ void CStats::Show()
 		F.OutNext	("R_CALC:      %2.2fms, %2.1f%%",RenderCALC.result,	PPP(RenderCALC.result));	
 		F.OutNext	("  HOM:       %2.2fms, %d",RenderCALC_HOM.result,	RenderCALC_HOM.count);
 		F.OutNext	("  Skeletons: %2.2fms, %d",Animation.result,		Animation.count);
+		F.OutNext	("  SkelBatch: %2.2fms, %d models (%d up to date), %d bones, %2.1f bones/ms",Animation_Batch.result,
+			Animation_BatchModels,Animation_BatchSkipped,Animation_BatchBones,
+			Animation_Batch.result>EPS_S ? float(Animation_BatchBones)/Animation_Batch.result : 0.f);
 		F.OutNext	("R_DUMP:      %2.2fms, %2.1f%%",RenderDUMP.result,	PPP(RenderDUMP.result));	
 		F.OutNext	("  Wait-L:    %2.2fms",RenderDUMP_Wait.result);	
 		F.OutNext	("  Wait-S:    %2.2fms",RenderDUMP_Wait_S.result);	
@@ -276,6 +353,9 @@ void CStats::Show()
 		F.OutNext	("netServer:   %2.2fms, %d",		netServer.result,netServer.count);
 		F.OutNext	("netClientCompressor:   %2.2fms",	netClientCompressor.result);
 		F.OutNext	("netServerCompressor:   %2.2fms",	netServerCompressor.result);
+		F.OutNext	("netServerUpdates:   %2.2fms, %d objs, %2.1fK copied (%2.1fK as full packets)",
+			netServerUpdates.result, netServerUpdateObjects,
+			float(netServerUpdateBytes)/1024.f, float(netServerUpdateObjects*sizeof(NET_Packet))/1024.f);
 		
 		F.OutSkip	();
 
@@ -386,6 +466,7 @@ void CStats::Show()
 		ph_collision.FrameStart		();
 		ph_core.FrameStart			();
 		Animation.FrameStart		();	
+		Animation_Batch.FrameStart	();
 		AI_Think.FrameStart			();
 		AI_Range.FrameStart			();
 		AI_Path.FrameStart			();
@@ -424,6 +505,7 @@ void CStats::Show()
 		netServer.FrameStart		();
 		netClientCompressor.FrameStart();
 		netServerCompressor.FrameStart();
+		netServerUpdates.FrameStart	();
 
 		TEST0.FrameStart			();
 		TEST1.FrameStart			();
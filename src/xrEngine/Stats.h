@@ -30,6 +30,8 @@ public:
 
 	float		fFPS,fRFPS,fTPS		;			// FPS, RenderFPS, TPS
 	float		fMem_calls			;
+	float		fMem_frame_calls	;			// frame arena allocations
+	u32			dwMem_frame_bytes	;
 	u32			dwMem_calls			;
 	u32			dwSND_Played,dwSND_Allocated;	// Play/Alloc
 	float		fShedulerLoad		;
@@ -60,6 +62,13 @@ public:
 	CStatTimer	RenderCALC;			// portal traversal, frustum culling, entities "renderable_Render"
 	CStatTimer	RenderCALC_HOM;		// HOM rendering
 	CStatTimer	Animation;			// skeleton calculation
+	CStatTimer	Animation_Batch;	// skeleton calculation - frame batch
+	u32			Animation_BatchBones;// ...number of bones evaluated by the batch
+	u32			Animation_BatchModels;	// ...models evaluated by the batch
+	u32			Animation_BatchSkipped;	// ...models queued but up to date
+	u64			Animation_BonesEvaluated;	// bones evaluated (inline and by the batch), accumulated
+	u64			Animation_BonesAvoided;		// ...bones skipped by the animation LOD, accumulated
+	u64			Animation_EvalTicks;		// ...CPU ticks spent evaluating bones, accumulated
 	CStatTimer	RenderDUMP;			// actual primitive rendering
 	CStatTimer	RenderDUMP_Wait;	// ...waiting something back (queries results, etc.)
 	CStatTimer	RenderDUMP_Wait_S;	// ...frame-limit sync
@@ -91,6 +100,9 @@ public:
 	CStatTimer	netServer;
 	CStatTimer	netClientCompressor;
 	CStatTimer	netServerCompressor;
+	CStatTimer	netServerUpdates;	// MakeUpdatePackets + SendUpdatePacketsToAll
+	u32			netServerUpdateObjects;// ...number of entity snapshots in the last update tick
+	u32			netServerUpdateBytes;// ...bytes copied into the update arena in the last update tick
 	
 
 	
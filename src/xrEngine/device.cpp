@@ -19,6 +19,7 @@
 // must be defined before include of FS_impl.h
 #define INCLUDE_FROM_ENGINE
 #include "../xrCore/FS_impl.h"
+#include "../xrCore/frame_arena.h"
 
 #ifdef INGAME_EDITOR
 #	include "../include/editor/ide.hpp"
@@ -35,6 +36,7 @@ ENGINE_API CLoadScreenRenderer load_screen_renderer;
 
 
 ENGINE_API BOOL g_bRendering = FALSE; 
+ENGINE_API BOOL g_bSkipRender = FALSE;
 
 BOOL		g_bLoaded = FALSE;
 ref_light	precache_light = 0;
@@ -184,6 +186,7 @@ void 			mt_Thread	(void *ptr)	{
 		if (Device.mt_bMustExit) {
 			Device.mt_bMustExit = FALSE;				// Important!!!
 			Device.mt_csEnter.Leave();					// Important!!!
+			frame_arena_thread_exit();
 			return;
 		}
 		// we has granted permission to execute
@@ -293,7 +296,7 @@ void CRenderDevice::on_idle		()
 #ifndef DEDICATED_SERVER
 	Statistic->RenderTOTAL_Real.FrameStart	();
 	Statistic->RenderTOTAL_Real.Begin		();
-	if (b_is_Active)							{
+	if (b_is_Active && !g_bSkipRender)			{
 		if (Begin())				{
 
 			seqRender.Process						(rp_Render);
@@ -440,6 +443,7 @@ void CRenderDevice::FrameMove()
 	dwFrame			++;
 
 	Core.dwFrame = dwFrame;
+	xrTrace::frame	(dwFrame);
 
 	dwTimeContinual	= TimerMM.GetElapsed_ms() - app_inactive_time;
 
@@ -475,6 +479,8 @@ void CRenderDevice::FrameMove()
 		dwTimeDelta		= dwTimeGlobal-_old_global;
 	}
 
+	xrTrace::counter				("frame_ms",float(dwTimeDelta));
+
 	// Frame move
 	Statistic->EngineTOTAL.Begin	();
 
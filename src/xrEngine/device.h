@@ -319,6 +319,7 @@ extern		ENGINE_API		CRenderDevice		Device;
 
 
 extern		ENGINE_API		bool				g_bBenchmark;
+extern		ENGINE_API		BOOL				g_bSkipRender;		// frames are simulated only, no scene is drawn
 
 typedef fastdelegate::FastDelegate0<bool>		LOADING_EVENT;
 extern	ENGINE_API xr_list<LOADING_EVENT>		g_loading_events;
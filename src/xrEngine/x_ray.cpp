@@ -1202,6 +1202,7 @@ void CApplication::LoadEnd		()
 {
 	ll_dwReference--;
 	if (0==ll_dwReference)		{
+		FS.prefetch_end			();
 		Msg						("* phase time: %d ms",phase_timer.GetElapsed_ms());
 		Msg						("* phase cmem: %d K", Memory.mem_usage()/1024);
 		Console->Execute		("stat_memory");
@@ -1410,8 +1411,14 @@ int CApplication::Level_ID(LPCSTR name, LPCSTR ver, bool bSet)
 	}
 
 	if(bSet && result!=-1)
+	{
 		Level_Set(result);
 
+		// the files of the level load are recorded and read ahead from here
+		if (ll_dwReference)
+			FS.prefetch_begin(name);
+	}
+
 	if( arch_res )
 		g_pGamePersistent->OnAssetsChanged	();
 
@@ -87,6 +87,18 @@ struct	hdrNODES
 	Fbox	aabb;
 	xrGUID	guid;
 };
+
+// optional section of level.ai after the nodes : static cover vertices baked by xrAI,
+// followed by count u32 vertex ids in ascending order
+#define XRAI_COVERS_MAGIC		u32(0x53564f43)	// "COVS"
+#define XRAI_COVERS_VERSION		u32(1)
+
+struct	hdrCOVERS
+{
+	u32		magic;
+	u32		version;
+	u32		count;
+};
 #pragma pack(pop)
 
 #pragma pack(push,1)
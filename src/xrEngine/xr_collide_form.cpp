@@ -119,7 +119,9 @@ void CCF_Skeleton::BuildState()
 	dwFrame				= Device.dwFrame;
 	IRenderVisual* pVisual = owner->Visual();
 	IKinematics* K		= PKinematics(pVisual);
-	K->CalculateBones();
+	// skeletons under the animation LOD are evaluated lazily, hit queries
+	// need the current pose of the pickable bones
+	K->CalculateBones_Hit();
 	const Fmatrix& L2W	= owner->XFORM();
 	
 	if (vis_mask!=K->LL_GetBonesVisible()){
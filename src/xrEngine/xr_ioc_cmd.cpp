@@ -200,6 +200,103 @@ public:
 	}
 };
 
+class CCC_TraceEnable : public IConsole_Command
+{
+public:
+	CCC_TraceEnable(LPCSTR N) : IConsole_Command(N) { bEmptyArgsHandled = FALSE; };
+	virtual void Execute(LPCSTR args) {
+		if (EQ(args,"on") || EQ(args,"1"))			xrTrace::enable(TRUE);
+		else if (EQ(args,"off") || EQ(args,"0"))	xrTrace::enable(FALSE);
+		else InvalidSyntax();
+	}
+	virtual void	Status	(TStatus& S)	{ xr_strcpy(S,xrTrace::enabled?"on":"off"); }
+	virtual void	Info	(TInfo& I)		{ xr_strcpy(I,"'on/off' or '1/0'"); }
+	virtual void	Save	(IWriter* F)	{ }		// per-session, use -trace to start with it
+};
+
+class CCC_TraceDump : public IConsole_Command
+{
+public:
+	CCC_TraceDump(LPCSTR N) : IConsole_Command(N) { bEmptyArgsHandled = TRUE; };
+	virtual void Execute(LPCSTR args) {
+		int frames			= atoi(args);
+		if (frames<=0)		frames = 60;
+
+		string_path			fn;
+		xr_sprintf			(fn,sizeof(fn),"trace_%d.json",Device.dwFrame);
+		xrTrace::dump		(fn,u32(frames));
+	}
+	virtual void	Info	(TInfo& I)		{ xr_strcpy(I,"[frames], writes the last frames of the trace to $logs$ as Chrome trace json"); }
+};
+
+class CCC_IniStats : public IConsole_Command
+{
+public:
+	CCC_IniStats(LPCSTR N) : IConsole_Command(N) { bEmptyArgsHandled = TRUE; };
+	virtual void Execute(LPCSTR args) {
+		int count			= atoi(args);
+		CInifile::dump_stats(count>0 ? u32(count) : 32);
+	}
+	virtual void	Info	(TInfo& I)		{ xr_strcpy(I,"[count], logs the most frequently parsed ini lines (-ini_stats)"); }
+};
+
+class CCC_StreamStats : public IConsole_Command
+{
+public:
+	CCC_StreamStats(LPCSTR N) : IConsole_Command(N) { bEmptyArgsHandled = TRUE; };
+	virtual void Execute(LPCSTR args) {
+		FS.stream_stats		();
+	}
+	virtual void	Info	(TInfo& I)		{ xr_strcpy(I,"logs the files read ahead by the stream workers and their bandwidth"); }
+};
+
+class CCC_MemProfile : public IConsole_Command
+{
+public:
+	CCC_MemProfile(LPCSTR N) : IConsole_Command(N) { bEmptyArgsHandled = FALSE; };
+	virtual void Execute(LPCSTR args) {
+		if (EQ(args,"off"))	{ memory_profiler::enable(0); return; }
+		int rate			= atoi(args);
+		if (rate<0)			InvalidSyntax();
+		else				memory_profiler::enable(u32(rate));
+	}
+	virtual void	Status	(TStatus& S)	{ xr_sprintf(S,"%d",memory_profiler::sample_rate); }
+	virtual void	Info	(TInfo& I)		{ xr_strcpy(I,"<rate>|off, samples 1 of rate allocations with their call stacks"); }
+	virtual void	Save	(IWriter* F)	{ }		// per-session, use -mem_profile <rate> to start with it
+};
+
+class CCC_MemProfileCheckpoint : public IConsole_Command
+{
+public:
+	CCC_MemProfileCheckpoint(LPCSTR N) : IConsole_Command(N) { bEmptyArgsHandled = FALSE; };
+	virtual void Execute(LPCSTR args) {
+		string64			name;
+		if (sscanf(args,"%63s",name)<1)	InvalidSyntax();
+		else				memory_profiler::make_checkpoint(name);
+	}
+	virtual void	Info	(TInfo& I)		{ xr_strcpy(I,"<name>, stores the memory profiler counters"); }
+};
+
+class CCC_MemProfileDiff : public IConsole_Command
+{
+public:
+	CCC_MemProfileDiff(LPCSTR N) : IConsole_Command(N) { bEmptyArgsHandled = FALSE; };
+	virtual void Execute(LPCSTR args) {
+		string64			from, to;
+		to[0]				= 0;
+		if (sscanf(args,"%63s %63s",from,to)<1)
+		{
+			InvalidSyntax	();
+			return;
+		}
+
+		string_path			fn;
+		xr_sprintf			(fn,sizeof(fn),"mem_profile_%s_%s.txt",from,to[0] ? to : "now");
+		memory_profiler::dump_diff(fn,from,to[0] ? to : 0,32);
+	}
+	virtual void	Info	(TInfo& I)		{ xr_strcpy(I,"<from> [to], writes the memory growth between two checkpoints, or since one, to $logs$"); }
+};
+
 //-----------------------------------------------------------------------
 class CCC_SaveCFG : public IConsole_Command
 {
@@ -727,10 +824,10 @@ void CCC_Register()
 	CMD3(CCC_Mask,		"rs_detail",			&psDeviceFlags,		rsDetails	);
 	//CMD4(CCC_Float,		"r__dtex_range",		&r__dtex_range,		5,		175	);
 
-//	CMD3(CCC_Mask,		"rs_constant_fps",		&psDeviceFlags,		rsConstantFPS			);
 	CMD3(CCC_Mask,		"rs_render_statics",	&psDeviceFlags,		rsDrawStatic			);
 	CMD3(CCC_Mask,		"rs_render_dynamics",	&psDeviceFlags,		rsDrawDynamic			);
 #endif
+	CMD3(CCC_Mask,		"rs_constant_fps",		&psDeviceFlags,		rsConstantFPS			);
 
 	// Render device states
 	CMD4(CCC_Integer,	"r__supersample",		&ps_r__Supersample,			1,		4		);
@@ -759,6 +856,7 @@ void CCC_Register()
 	// Texture manager	
 	CMD4(CCC_Integer,	"texture_lod",			&psTextureLOD,				0,	4	);
 	CMD4(CCC_Integer,	"net_dedicated_sleep",	&psNET_DedicatedSleep,		0,	64	);
+	CMD4(CCC_Integer,	"ini_cache_log",		&ps_ini_cache_log,			0,	1	);
 
 	// General video control
 	CMD1(CCC_VidMode,	"vid_mode"				);
@@ -815,6 +913,14 @@ void CCC_Register()
 	CMD1(CCC_DumpOpenFiles,		"dump_open_files");
 #endif
 
+	CMD1(CCC_TraceEnable,		"trace_enable");
+	CMD1(CCC_TraceDump,			"trace_dump");
+	CMD1(CCC_IniStats,			"ini_stats");
+	CMD1(CCC_StreamStats,		"fs_stream_stats");
+	CMD1(CCC_MemProfile,		"mem_profile");
+	CMD1(CCC_MemProfileCheckpoint,"mem_profile_checkpoint");
+	CMD1(CCC_MemProfileDiff,	"mem_profile_diff");
+
 	CMD1(CCC_ExclusiveMode,		"input_exclusive_mode");
 
 	extern int g_svTextConsoleUpdateRate;
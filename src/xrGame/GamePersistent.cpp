@@ -29,6 +29,8 @@
 #include "xrserver_objects_alife_monsters.h"
 #include "../xrServerEntities/xrServer_Object_Base.h"
 #include "UI/UIGameTutorial.h"
+#include "mt_config.h"
+#include "../xrEngine/feel_vision.h"
 
 #ifndef MASTER_GOLD
 #	include "custommonster.h"
@@ -654,8 +656,18 @@ void CGamePersistent::OnFrame	()
 	__super::OnFrame			();
 
 	if(!Device.Paused())
+	{
+		// agents queue their visibility ray tests while being updated
+		bool const batch_vision		= !!g_mt_config.test(mtAiVisionBatch);
+		if (batch_vision)
+			Feel::Vision::feel_vision_batch_begin	();
+
 		Engine.Sheduler.Update		();
 
+		if (batch_vision)
+			Feel::Vision::feel_vision_batch_end		();
+	}
+
 	// update weathers ambient
 	if(!Device.Paused())
 		WeathersUpdate				();
@@ -50,6 +50,8 @@
 #include "demoinfo.h"
 #include "CustomDetector.h"
 #include "string_table.h"
+#include "animation_lod.h"
+#include "demo_benchmark.h"
 
 #include "../xrphysics/iphworld.h"
 #include "../xrphysics/console_vars.h"
@@ -161,6 +163,7 @@ CLevel::CLevel():NET_CLIENT_CLASS (Device.GetTimerGlobal())
 	m_msg_filter = NULL;
 	m_demoplay_control = NULL;
 	m_demo_info	= NULL;
+	m_spawn_stream_waiting		= false;
 
 	R_ASSERT				(NULL==g_player_hud);
 	g_player_hud			= xr_new<player_hud>();
@@ -219,6 +222,7 @@ CLevel::~CLevel()
 	hud_zones_list				= NULL;
 
 	Msg							("- Destroying level");
+	demo_benchmark_release		();
 
 	Engine.Event.Handler_Detach	(eEntitySpawn,	this);
 
@@ -471,7 +475,9 @@ void CLevel::cl_Process_Event				(u16 dest, u16 type, NET_Packet& P)
 	}
 };
 
-void CLevel::ProcessGameEvents		()
+// hold_spawns - from the frame update only, a synchronous pump (object
+// removal, level clear) must get through the queue in one go
+void CLevel::ProcessGameEvents		(bool hold_spawns)
 {
 	// Game events
 	{
@@ -485,6 +491,9 @@ void CLevel::ProcessGameEvents		()
 
 		while	(game_events->available(svT))
 		{
+			if (hold_spawns && spawn_stream_pending())
+				break;
+
 			u16 ID,dest,type;
 			game_events->get	(ID,dest,type,P);
 
@@ -539,6 +548,10 @@ void CLevel::ProcessGameEvents		()
 				}break;
 			}			
 		}
+
+		// the burst is over, the next one gets its own wait
+		if (!game_events->available(svT))
+			m_spawn_stream_waiting		= false;
 	}
 	if (OnServer() && GameID()!= eGameIDSingle)
 		Game().m_WeaponUsageStatistic->Send_Check_Respond();
@@ -630,8 +643,10 @@ void CLevel::OnFrame	()
 		Device.Statistic->netClient1.End	();
 	}
 
-	ProcessGameEvents	();
+	ProcessGameEvents	(true);
 
+	if (IsDemoPlayStarted())
+		demo_benchmark_update	();
 
 	if (m_bNeed_CrPr)					make_NetCorrectionPrediction();
 
@@ -650,6 +665,9 @@ void CLevel::OnFrame	()
 				GameTaskManager().UpdateTasks();
 		}
 	}
+	if (g_dedicated_server)
+		animation_lod_update	();
+
 	// Inherited update
 	inherited::OnFrame		();
 
@@ -713,6 +731,11 @@ void CLevel::OnFrame	()
 					net_Statistic.getSendedPerSec(),
 					net_Statistic.getRetriedCount(),
 					net_Statistic.dwTimesBlocked);
+
+				const INetQueue::Statistic& Q = net_msg_Statistic();
+				F->OutNext("Queue: batch(%3d/%3d), depth(%3d), latency(%2.2f/%2.2f ms), overflow(%d)",
+					Q.batch_last, Q.batch_max, Q.depth_max,
+					Q.latency_avg_ms(), Q.latency_max_ms(), Q.overflowed);
 #ifdef DEBUG
 				if (!pStatGraphR)
 				{
@@ -272,8 +272,14 @@ public:
 
 	void						cl_Process_Event		(u16 dest, u16 type, NET_Packet& P);
 	void						cl_Process_Spawn		(NET_Packet& P);
-	void						ProcessGameEvents		( );
+	void						ProcessGameEvents		(bool hold_spawns = false);
 	void						ProcessGameSpawns		( );
+
+	// visuals of the spawns read in the background, see Level_network_spawn.cpp
+	CTimer						m_spawn_stream_wait;
+	bool						m_spawn_stream_waiting;
+	void						spawn_stream_request	(NET_Packet& P);
+	bool						spawn_stream_pending	( );
 	void						ProcessCompressedUpdate	(NET_Packet& P, u8 const compression_type);
 
 	// Input
@@ -393,6 +399,7 @@ public:
 	//alligned to 16 bytes m_lzo_working_buffer
 	u8*											m_lzo_working_memory;
 	u8*											m_lzo_working_buffer;
+	update_baselines_receiver					m_update_baselines;
 	
 	void			init_compression			();
 	void			deinit_compression			();
@@ -15,6 +15,10 @@
 
 #include "../Include/xrRender/UIRender.h"
 #include "../Include/xrRender/Kinematics.h"
+#include "../xrcdb/ispatial.h"
+#include "../xrEngine/xr_collide_form.h"
+#include "../xrCPU_Pipe/ttapi.h"
+#pragma comment(lib,"xrCPU_Pipe.lib")
 
 #ifdef DEBUG
 #	include "debug_renderer.h"
@@ -116,6 +120,7 @@ CBulletManager::CBulletManager()
 {
 	m_Bullets.clear			();
 	m_Bullets.reserve		(100);
+	m_batch_frame			= u32(-1);
 }
 
 CBulletManager::~CBulletManager()
@@ -123,6 +128,12 @@ CBulletManager::~CBulletManager()
 	m_Bullets.clear			();
 	m_WhineSounds.clear		();
 	m_Events.clear			();
+
+	BatchWorkers::iterator	I = m_batch_workers.begin();
+	BatchWorkers::iterator	E = m_batch_workers.end();
+	for ( ; I != E; ++I)
+		xr_delete			(*I);
+	m_batch_workers.clear	();
 }
 
 void CBulletManager::Load		()
@@ -194,6 +205,8 @@ void CBulletManager::Clear		()
 {
 	m_Bullets.clear			();
 	m_Events.clear			();
+	m_batch_results.clear	();
+	m_batch_frame			= u32(-1);
 }
 
 void CBulletManager::AddBullet(const Fvector& position,
@@ -244,6 +257,11 @@ void CBulletManager::UpdateWorkload()
 
 	collide::rq_result			dummy;
 
+	// bullets already traced by UpdateBatch this frame only have to be removed,
+	// the rest is processed here in the same order as before, so events
+	// are registered deterministically
+	u32 const batch_count		= (m_batch_frame == Device.dwFrame) ? m_batch_results.size() : 0;
+
 	// this is because of ugly nature of removing bullets
 	// when index in vector passed through the tgt_material field
 	// and we can remove them only in case when we iterate bullets
@@ -251,7 +269,11 @@ void CBulletManager::UpdateWorkload()
 	BulletVec::reverse_iterator	i = m_Bullets.rbegin();
 	BulletVec::reverse_iterator	e = m_Bullets.rend();
 	for (u16 j=u16(e - i); i != e; ++i, --j) {
-		if ( process_bullet( rq_storage, *i, u32(time_delta*g_bullet_time_factor)) )
+		u8 const batch_result	= (u32(j - 1) < batch_count) ? m_batch_results[j - 1] : u8(BATCH_NONE);
+		if ( batch_result == BATCH_ALIVE )
+			continue;
+
+		if ( (batch_result == BATCH_NONE) && process_bullet( rq_storage, *i, u32(time_delta*g_bullet_time_factor)) )
 			continue;
 
 		VERIFY					(j > 0);
@@ -901,6 +923,197 @@ bool CBulletManager::process_bullet			(collide::rq_results & storage, SBullet& b
 	}
 }
 
+static u32 const batch_min_bullets	= 16;
+
+struct bullet_batch_worker
+{
+	CBulletManager*			manager;
+	u32						from;
+	u32						to;
+	u32						delta_time;
+	CDB::COLLIDER			collider;
+	xr_vector<ISpatial*>	spatial;
+};
+
+// the part of the bullet, changed while it is traced
+struct bullet_batch_state
+{
+	Fvector					bullet_pos;
+	Fvector					dir;
+	Fvector					tracer_start_position;
+	float					speed;
+	float					fly_dist;
+	float					life_time;
+	u32						change_rajectory_count;
+	u16						flags;
+
+	void					save		(SBullet const& bullet)
+	{
+		bullet_pos				= bullet.bullet_pos;
+		dir						= bullet.dir;
+		tracer_start_position	= bullet.tracer_start_position;
+		speed					= bullet.speed;
+		fly_dist				= bullet.fly_dist;
+		life_time				= bullet.life_time;
+		change_rajectory_count	= bullet.change_rajectory_count;
+		flags					= bullet.flags._storage;
+	}
+
+	void					restore		(SBullet& bullet) const
+	{
+		bullet.bullet_pos				= bullet_pos;
+		bullet.dir						= dir;
+		bullet.tracer_start_position	= tracer_start_position;
+		bullet.speed					= speed;
+		bullet.fly_dist					= fly_dist;
+		bullet.life_time				= life_time;
+		bullet.change_rajectory_count	= change_rajectory_count;
+		bullet.flags._storage			= flags;
+	}
+};
+
+// returns true if nothing could be hit on the segment,
+// tests the same targets as trajectory_check_error does with rqtBoth
+static bool trajectory_test_batched			(
+		bullet_batch_worker& worker,
+		SBullet& bullet,
+		float const low,
+		float const high,
+		Fvector const& gravity,
+		float const air_resistance,
+		float const parent_ignore_distance
+	)
+{
+	Fvector const& position	= bullet.start_position;
+	Fvector const& velocity	= bullet.start_velocity;
+	Fvector const start		= trajectory_position(position, velocity, gravity, air_resistance, low);
+	Fvector const target	= trajectory_position(position, velocity, gravity, air_resistance, high);
+	Fvector	start_to_target = Fvector().sub(target,start);
+	float const distance	= start_to_target.magnitude();
+	if ( fis_zero(distance) )
+		return				(true);
+
+	start_to_target.mul		( 1.f/distance );
+	bullet.flags.ricochet_was = 0;
+	bullet.dir				= start_to_target;
+
+	worker.collider.ray_query	(Level().ObjectSpace.GetStaticModel(), start, start_to_target, distance);
+	if ( worker.collider.r_count() )
+		return				(false);
+
+	g_SpatialSpace->q_ray	(worker.spatial, 0, STYPE_COLLIDEABLE, start, start_to_target, distance);
+	xr_vector<ISpatial*>::const_iterator	I = worker.spatial.begin();
+	xr_vector<ISpatial*>::const_iterator	E = worker.spatial.end();
+	for ( ; I != E; ++I) {
+		CObject* const object	= (*I)->dcast_CObject();
+		if ( !object || (object->collidable.model->Type() != cftObject) )
+			continue;
+
+		// test_callback never hits the shooter itself
+		if ( (object->ID() == bullet.parent_id) && (bullet.fly_dist < parent_ignore_distance) )
+			continue;
+
+		return				(false);
+	}
+
+	return					(true);
+}
+
+// the same steps as process_bullet takes when trajectory_check_error hits nothing
+// (debug bullet points are not collected for the traced bullets)
+void CBulletManager::trace_bullet_batched	(bullet_batch_worker& worker, SBullet& bullet, u32 const delta_time, u8& result)
+{
+	bullet_batch_state			state;
+	state.save					(bullet);
+
+	float const time_delta		= float(delta_time)/1000.f;
+	Fvector const gravity		= Fvector().set( 0.f, -m_fGravityConst, 0.f);
+
+	float const	air_resistance	= (GameID() == eGameIDSingle) ? m_fAirResistanceK : bullet.air_resistance;
+	bullet.tracer_start_position= bullet.bullet_pos;
+
+	float low					= bullet.life_time;
+	float const high			= bullet.life_time + time_delta;
+
+	bullet.change_rajectory_count	= 0;
+
+	worker.collider.ray_options	(CDB::OPT_ONLYFIRST);
+	for (;;) {
+		if ( bullet.speed < 1.f ) {
+			result				= BATCH_REMOVE;
+			return;
+		}
+
+		float const time		= trajectory_select_pick_time(bullet, low, high, gravity, air_resistance);
+		if (time == low) {
+			result				= BATCH_REMOVE;
+			return;
+		}
+
+		if ( !trajectory_test_batched(worker, bullet, low, time, gravity, air_resistance, parent_ignore_distance) ) {
+			state.restore		(bullet);
+			result				= BATCH_NONE;
+			return;
+		}
+
+		if ( !try_update_bullet(bullet, gravity, air_resistance, time) ) {
+			result				= BATCH_REMOVE;
+			return;
+		}
+
+		if ( fsimilar(time, high) ) {
+			result				= BATCH_ALIVE;
+			return;
+		}
+
+		VERIFY2					( low < time, make_string("start_low[%f] high[%f]", low, time) );
+		low						= time;
+	}
+}
+
+void CBulletManager::batch_worker			(LPVOID params)
+{
+	bullet_batch_worker& worker	= *(bullet_batch_worker*)params;
+	CBulletManager& manager		= *worker.manager;
+	for (u32 i = worker.from; i < worker.to; ++i)
+		manager.trace_bullet_batched	(worker, manager.m_Bullets[i], worker.delta_time, manager.m_batch_results[i]);
+}
+
+// runs on the main thread inside CLevel::OnFrame, while the parallel sequence
+// is idle, so the workers touch neither the bullets nor ttapi concurrently
+void CBulletManager::UpdateBatch			()
+{
+	m_batch_frame				= u32(-1);
+	if (!g_mt_config.test(mtBulletsBatch))
+		return;
+
+	u32 const time_delta		= Device.dwTimeDelta;
+	u32 const bullet_count		= m_Bullets.size();
+	u32 const worker_count		= _min(u32(ttapi_GetWorkersCount()), bullet_count/batch_min_bullets);
+	if ( !time_delta || (worker_count < 2) )
+		return;
+
+	while (m_batch_workers.size() < worker_count) {
+		bullet_batch_worker* const worker	= xr_new<bullet_batch_worker>();
+		worker->manager			= this;
+		m_batch_workers.push_back	(worker);
+	}
+
+	m_batch_results.assign		(bullet_count, u8(BATCH_NONE));
+
+	u32 const step				= bullet_count/worker_count;
+	for (u32 i = 0; i < worker_count; ++i) {
+		bullet_batch_worker& worker	= *m_batch_workers[i];
+		worker.from				= i*step;
+		worker.to				= (i == worker_count - 1) ? bullet_count : (worker.from + step);
+		worker.delta_time		= u32(time_delta*g_bullet_time_factor);
+		ttapi_AddWorker			(&CBulletManager::batch_worker, &worker);
+	}
+
+	ttapi_RunAllWorkers			();
+	m_batch_frame				= Device.dwFrame;
+}
+
 #ifdef DEBUG
 	BOOL g_bDrawBulletHit = FALSE;
 #endif
@@ -1028,6 +1241,7 @@ void CBulletManager::Render	()
 void CBulletManager::CommitRenderSet		()	// @ the end of frame
 {
 	m_BulletsRendered	= m_Bullets			;
+	UpdateBatch								();
 	if (g_mt_config.test(mtBullets))		{
 		Device.seqParallel.push_back		(fastdelegate::FastDelegate0<>(this,&CBulletManager::UpdateWorkload));
 	} else {
@@ -97,6 +97,7 @@ public:
 };
 
 class CLevel;
+struct bullet_batch_worker;
 
 class CBulletManager
 {
@@ -130,6 +131,14 @@ private:
 		u16					tgt_material;
 	};
 	static void CalculateNewVelocity(Fvector & dest_new_vel, Fvector const & old_velocity, float ar, float life_time);
+
+	// result of the batched trace of a bullet for the current frame
+	enum EBatchResult {
+		BATCH_NONE	= u8(0),	// not traced, UpdateWorkload processes it serially
+		BATCH_ALIVE,			// step traced without any hit
+		BATCH_REMOVE,			// step traced without any hit, bullet is dead
+	};
+	typedef xr_vector<bullet_batch_worker*>	BatchWorkers;
 protected:
 	SoundVec				m_WhineSounds		;
 	RStringVec				m_ExplodeParticles	;
@@ -141,6 +150,10 @@ protected:
 	BulletVec				m_BulletsRendered	;	// copy for rendering
 	xr_vector<_event>		m_Events			;
 
+	BatchWorkers			m_batch_workers		;
+	xr_vector<u8>			m_batch_results		;	// EBatchResult per bullet of m_Bullets
+	u32						m_batch_frame		;	// frame m_batch_results were traced at
+
 #ifdef DEBUG
 	u32						m_thread_id;
 
@@ -220,6 +233,17 @@ protected:
 								SBullet& bullet,
 								u32 delta_time
 							);
+	// traces the whole step of the bullet for the current frame, if it touches neither
+	// the static geometry nor the bounding volume of a dynamic object; otherwise restores
+	// the bullet and leaves it to the serial process_bullet
+	void					trace_bullet_batched(
+								bullet_batch_worker& worker,
+								SBullet& bullet,
+								u32 delta_time,
+								u8& result
+							);
+	static void				batch_worker		(LPVOID params);
+	void					UpdateBatch			();
 	void 		__stdcall	UpdateWorkload		();
 public:
 							CBulletManager		();
@@ -21,6 +21,7 @@
 #include "../xrNetServer/NET_AuthCheck.h"
 
 #include "../xrphysics/physicscommon.h"
+#include "server_load_test.h"
 ENGINE_API bool g_dedicated_server;
 
 const int max_objects_size			= 2*1024;
@@ -119,6 +120,8 @@ void CLevel::net_Stop		()
 {
 	Msg							("- Disconnect");
 
+	server_load_test_stop		();
+
 	script_client_events.clear();
 
 	if(CurrentGameUI())
@@ -335,9 +338,12 @@ void CLevel::net_Update	()
 	}
 	// If server - perform server-update
 	if (Server && OnServer())	{
+		CTimer							tick;
+		tick.Start						();
 		Device.Statistic->netServer.Begin();
 		Server->Update					();
 		Device.Statistic->netServer.End	();
+		server_load_test_update			(tick.GetElapsed_sec()*1000.f);
 	}
 }
 
@@ -358,6 +364,7 @@ BOOL			CLevel::Connect2Server				(LPCSTR options)
 	NET_Packet P;
 	m_bConnectResultReceived = false;
 	m_bConnectResult = true;
+	m_update_baselines.clear();
 
 	if(!psNET_direct_connect)
 	{
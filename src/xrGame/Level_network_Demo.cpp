@@ -12,6 +12,7 @@
 #include "DemoPlay_Control.h"
 #include "DemoInfo.h"
 #include "../xrEngine/CameraManager.h"
+#include "demo_benchmark.h"
 
 void CLevel::PrepareToSaveDemo		()
 {
@@ -73,6 +74,7 @@ void CLevel::StartPlayDemo()
 	m_starting_spawns_dtime	= 0;
 	Msg("! ------------- Demo Started ------------");
 	CatchStartingSpawns	();
+	demo_benchmark_start();
 
 	//if using some filter ...
 #ifdef MP_LOGGING
@@ -128,6 +130,7 @@ void CLevel::StopPlayDemo()
 		m_DemoPlayStoped	= TRUE;
 	}
 	Msg("! ------------- Demo Stoped ------------");
+	demo_benchmark_stop		();
 }
 
 void CLevel::StartSaveDemo(shared_str const & server_options)
@@ -7,6 +7,13 @@
 void CLevel::ProcessCompressedUpdate(NET_Packet& P, u8 const compress_type)
 {
 	NET_Packet	uncompressed_packet;
+	u16 delta_seq	= update_snapshots::invalid_seq;
+	u16 delta_base	= update_snapshots::invalid_seq;
+	if (compress_type & eto_delta_updates)
+	{
+		P.r_u16(delta_seq);
+		P.r_u16(delta_base);
+	}
 	u16 next_size;
 	P.r_u16(next_size);
 	Device.Statistic->netClientCompressor.Begin();
@@ -45,11 +52,17 @@ void CLevel::ProcessCompressedUpdate(NET_Packet& P, u8 const compress_type)
 
 		P.r_seek(P.r_tell() + next_size);
 		uncompressed_packet.r_seek(0);
-		Objects.net_Import(&uncompressed_packet);
+		if (compress_type & eto_delta_updates)
+			m_update_baselines.import(uncompressed_packet, delta_seq, delta_base, Objects);
+		else
+			Objects.net_Import(&uncompressed_packet);
 		P.r_u16(next_size);
 	}
 	Device.Statistic->netClientCompressor.End();
 
+	if ((compress_type & eto_delta_updates) && !IsDemoPlayStarted())
+		m_update_baselines.send_ack(delta_seq);
+
 	if (OnClient()) UpdateDeltaUpd(timeServer());
 	IClientStatistic pStat = Level().GetStatistic();
 	u32 dTime = 0;
@@ -98,6 +98,7 @@ void CLevel::ClientReceive()
 				cl_Process_Spawn(*P);
 				/*/
 				//Msg("--- Client received M_SPAWN message...");
+				spawn_stream_request	(*P);
 				game_events->insert		(*P);
 				if (g_bDebugEvents)		ProcessGameEvents();
 				//*/
@@ -135,9 +136,19 @@ void CLevel::ClientReceive()
 			{
 				game->net_import_update	(*P);
 			}break;
+		case M_DELTA_UPDATE_OBJECTS:
 		case M_UPDATE_OBJECTS:
 			{
-				Objects.net_Import		(P);
+				if (m_type == M_DELTA_UPDATE_OBJECTS)
+				{
+					u16 seq				= P->r_u16();
+					u16 base			= P->r_u16();
+					m_update_baselines.import(*P, seq, base, Objects);
+					if (!IsDemoPlayStarted())
+						m_update_baselines.send_ack(seq);
+				}
+				else
+					Objects.net_Import	(P);
 
 				if (OnClient()) UpdateDeltaUpd(timeServer());
 				IClientStatistic pStat = Level().GetStatistic();
@@ -237,6 +237,66 @@ CSE_Abstract *CLevel::spawn_item		(LPCSTR section, const Fvector &position, u32
 		return				(abstract);
 }
 
+// ms the spawns of a burst wait for their visuals and textures, all of them together:
+// the wait starts with the first spawn not ready and ends when the game events
+// available are processed; the game events behind a waiting spawn wait too;
+// real time, the frame update is the only caller that holds (see ProcessGameEvents);
+// 0 - the visuals are loaded by the spawn itself
+int		g_cl_spawn_stream_wait		= 100;
+
+static LPCSTR spawn_visual			(LPCSTR section)
+{
+	if (!pSettings->section_exist(section) || !pSettings->line_exist(section,"visual"))
+		return					(0);
+	return						(pSettings->r_string(section,"visual"));
+}
+
+void	CLevel::spawn_stream_request	(NET_Packet& P)
+{
+	if (!g_cl_spawn_stream_wait || g_dedicated_server)
+		return;
+
+	// see CSE_Abstract::Spawn_Write
+	u32 const			pos		= P.r_tell();
+	string256			s_name, s_name_replace;
+	Fvector				o_Position;
+	P.r_stringZ_s		(s_name);
+	P.r_stringZ_s		(s_name_replace);
+	P.r_u8				();
+	P.r_u8				();
+	P.r_vec3			(o_Position);
+	P.r_seek			(pos);
+
+	if (LPCSTR visual = spawn_visual(s_name))
+		::Render->model_Stream	(visual,Device.vCameraPosition.distance_to(o_Position));
+}
+
+bool	CLevel::spawn_stream_pending	()
+{
+	if (!g_cl_spawn_stream_wait || g_dedicated_server || game_events->queue.empty())
+		return					(false);
+
+	NET_Event const&	E		= game_events->queue.front();
+	LPCSTR				visual	= 0;
+	if (M_SPAWN==E.ID && E.data.size()>sizeof(u16))
+		visual					= spawn_visual((LPCSTR)&E.data[sizeof(u16)]);
+
+	if (!visual || !::Render->model_Stream(visual,0.f))
+		return					(false);
+
+	if (!m_spawn_stream_waiting)
+	{
+		m_spawn_stream_waiting	= true;
+		m_spawn_stream_wait.Start	();
+	}
+	if (m_spawn_stream_wait.GetElapsed_ms() < u32(g_cl_spawn_stream_wait))
+		return					(true);
+
+	// the wait of the burst is spent, loaded by the spawn, what is read already
+	// is taken from memory; the window is reset by ProcessGameEvents
+	return						(false);
+}
+
 void	CLevel::ProcessGameSpawns	()
 {
 	while (!game_spawn_queue.empty())
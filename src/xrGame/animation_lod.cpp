@@ -0,0 +1,116 @@
+#include "stdafx.h"
+#include "animation_lod.h"
+#include "level.h"
+#include "actor.h"
+#include "../Include/xrRender/Kinematics.h"
+#include "../xrEngine/xr_object_list.h"
+
+BOOL	g_sv_anim_lod			= TRUE;
+float	g_sv_anim_lod_near		= 30.f;
+float	g_sv_anim_lod_far		= 80.f;
+
+static u32 const	lod_update_period	= 200;	// ms
+static u32 const	lod_mid_interval	= 250;	// ms, slow update interval beyond near distance
+static u32 const	lod_far_interval	= 500;	// ms, slow update interval beyond far distance
+
+static u32			g_lod_last_update	= 0;
+static bool			g_lod_applied		= false;
+static xr_vector<Fvector>	g_lod_players;
+
+static void apply_lod(CObject* object, u32 interval, BOOL partial)
+{
+	IRenderVisual*	visual		= object->Visual();
+	if (!visual || !visual->dcast_PKinematicsAnimated())
+		return;
+	IKinematics*	kinematics	= visual->dcast_PKinematics();
+	if (kinematics)
+		kinematics->SetUpdateLOD(interval, partial);
+}
+
+void animation_lod_update()
+{
+	CObjectList&	objects		= Level().Objects;
+	if (!g_sv_anim_lod)
+	{
+		if (!g_lod_applied)
+			return;
+		for (u32 i = 0, n = objects.o_count(); i < n; ++i)
+			apply_lod	(objects.o_get_by_iterator(i), 0, FALSE);
+		g_lod_applied	= false;
+		return;
+	}
+
+	if (g_lod_applied && (Device.dwTimeGlobal < g_lod_last_update + lod_update_period))
+		return;
+	g_lod_last_update	= Device.dwTimeGlobal;
+	g_lod_applied		= true;
+
+	g_lod_players.clear_not_free();
+	for (u32 i = 0, n = objects.o_count(); i < n; ++i)
+	{
+		CObject*	object	= objects.o_get_by_iterator(i);
+		if (smart_cast<CActor*>(object))
+			g_lod_players.push_back(object->Position());
+	}
+
+	float const	near_sqr	= _sqr(g_sv_anim_lod_near);
+	float const	far_sqr		= _sqr(_max(g_sv_anim_lod_far, g_sv_anim_lod_near));
+	for (u32 i = 0, n = objects.o_count(); i < n; ++i)
+	{
+		CObject*	object	= objects.o_get_by_iterator(i);
+		if (smart_cast<CActor*>(object))
+			continue;
+
+		float		dist_sqr	= flt_max;
+		for (xr_vector<Fvector>::const_iterator it = g_lod_players.begin(), it_e = g_lod_players.end(); it != it_e; ++it)
+			dist_sqr	= _min(dist_sqr, it->distance_to_sqr(object->Position()));
+
+		if (dist_sqr < near_sqr)
+			apply_lod	(object, 0, FALSE);
+		else if (dist_sqr < far_sqr)
+			apply_lod	(object, lod_mid_interval, FALSE);
+		else
+			apply_lod	(object, lod_far_interval, TRUE);
+	}
+}
+
+void animation_lod_dump_stats(bool reset)
+{
+	static u32	s_start_time		= 0;
+	static u32	s_start_frame		= 0;
+	static u64	s_start_evaluated	= 0;
+	static u64	s_start_avoided		= 0;
+	static u64	s_start_ticks		= 0;
+
+	CStats*		stats		= Device.Statistic;
+	float const	seconds		= _max(float(Device.dwTimeGlobal - s_start_time) / 1000.f, 0.001f);
+	u32 const	frames		= _max(Device.dwFrame - s_start_frame, u32(1));
+	u64 const	evaluated	= stats->Animation_BonesEvaluated - s_start_evaluated;
+	u64 const	avoided		= stats->Animation_BonesAvoided - s_start_avoided;
+	u64 const	ticks		= stats->Animation_EvalTicks - s_start_ticks;
+
+	// time saved is estimated with the measured cost of an evaluated bone
+	double const bone_ms	= evaluated ? 1000.0 * double(ticks) / double(CPU::qpc_freq) / double(evaluated) : 0.0;
+	double const eval_ms	= 1000.0 * double(ticks) / double(CPU::qpc_freq);
+	double const saved_ms	= bone_ms * double(avoided);
+
+	Msg("- animation LOD %s, near %.1f m, far %.1f m, %d players",
+		g_sv_anim_lod ? "on" : "off", g_sv_anim_lod_near, g_sv_anim_lod_far, g_lod_players.size());
+	Msg("- bones evaluated: %10.0f /s, avoided: %10.0f /s (%3.0f%%)",
+		float(evaluated) / seconds,
+		float(avoided) / seconds,
+		(evaluated + avoided) ? 100.f * float(avoided) / float(evaluated + avoided) : 0.f);
+	Msg("- bone evaluation: %6.3f ms/tick, estimated saved: %6.3f ms/tick (%.1f ticks/s)",
+		float(eval_ms / frames),
+		float(saved_ms / frames),
+		float(frames) / seconds);
+
+	if (reset)
+	{
+		s_start_time		= Device.dwTimeGlobal;
+		s_start_frame		= Device.dwFrame;
+		s_start_evaluated	= stats->Animation_BonesEvaluated;
+		s_start_avoided		= stats->Animation_BonesAvoided;
+		s_start_ticks		= stats->Animation_EvalTicks;
+	}
+}
@@ -0,0 +1,16 @@
+#ifndef ANIMATION_LOD_H_INCLUDED
+#define ANIMATION_LOD_H_INCLUDED
+
+// Distance based animation LOD of the dedicated server.
+// Animated objects far from every player get a longer slow update interval
+// and, farther still, evaluate only the bones carrying hit shapes. Exact
+// requests (hit queries, physics, scripts) always get the full skeleton.
+
+extern	BOOL	g_sv_anim_lod;
+extern	float	g_sv_anim_lod_near;
+extern	float	g_sv_anim_lod_far;
+
+void	animation_lod_update		();
+void	animation_lod_dump_stats	(bool reset);
+
+#endif //#ifndef ANIMATION_LOD_H_INCLUDED
@@ -109,7 +109,7 @@ void register_mp_console_commands();
 
 		BOOL	g_bCheckTime			= FALSE;
 		int		net_cl_inputupdaterate	= 50;
-		Flags32	g_mt_config				= {mtLevelPath | mtDetailPath | mtObjectHandler | mtSoundPlayer | mtAiVision | mtBullets | mtLUA_GC | mtLevelSounds | mtALife | mtMap};
+		Flags32	g_mt_config				= {mtLevelPath | mtDetailPath | mtObjectHandler | mtSoundPlayer | mtAiVision | mtBullets | mtLUA_GC | mtLevelSounds | mtALife | mtMap | mtBulletsBatch | mtAiVisionBatch};
 
 
 #ifdef DEBUG
@@ -1876,11 +1876,13 @@ void CCC_RegisterCommands()
 #ifndef MASTER_GOLD
 	// ai
 	CMD3(CCC_Mask,				"mt_ai_vision",			&g_mt_config,	mtAiVision);
+	CMD3(CCC_Mask,				"mt_ai_vision_batch",	&g_mt_config,	mtAiVisionBatch);
 	CMD3(CCC_Mask,				"mt_level_path",		&g_mt_config,	mtLevelPath);
 	CMD3(CCC_Mask,				"mt_detail_path",		&g_mt_config,	mtDetailPath);
 	CMD3(CCC_Mask,				"mt_object_handler",	&g_mt_config,	mtObjectHandler);
 	CMD3(CCC_Mask,				"mt_sound_player",		&g_mt_config,	mtSoundPlayer);
 	CMD3(CCC_Mask,				"mt_bullets",			&g_mt_config,	mtBullets);
+	CMD3(CCC_Mask,				"mt_bullets_batch",		&g_mt_config,	mtBulletsBatch);
 	CMD3(CCC_Mask,				"mt_script_gc",			&g_mt_config,	mtLUA_GC);
 	CMD3(CCC_Mask,				"mt_level_sounds",		&g_mt_config,	mtLevelSounds);
 	CMD3(CCC_Mask,				"mt_alife",				&g_mt_config,	mtALife);
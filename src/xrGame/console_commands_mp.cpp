@@ -26,6 +26,8 @@
 #include "actor_mp_client.h"
 #include "ai/stalker/ai_stalker.h"
 #include "InventoryBox.h"
+#include "animation_lod.h"
+#include "server_load_test.h"
 
 #include <locale.h>
 
@@ -95,6 +97,7 @@ extern	int 	G_DELAYED_ROUND_TIME;
 extern	int		g_sv_Pending_Wait_Time;
 extern	u32		g_sv_Client_Reconnect_Time;
 		int		g_dwEventDelay			= 0	;
+extern	int		g_cl_spawn_stream_wait;
 
 extern	u32		g_sv_adm_menu_ban_time;
 extern	xr_token g_ban_times[];
@@ -884,6 +887,88 @@ public:
 	}
 }; //class CCC_ConfigsDumpAll
 
+class CCC_DumpUpdateTraffic : public IConsole_Command {
+public:
+	CCC_DumpUpdateTraffic (LPCSTR N) : IConsole_Command(N) { bEmptyArgsHandled = true; };
+	virtual void	Execute		(LPCSTR args_) 
+	{
+		if (!g_pGameLevel || !Level().Server) return;
+		struct TrafficDumper
+		{
+			IClient*	server_client;
+			bool		reset;
+			void operator()(IClient* C)
+			{
+				if (C == server_client)
+					return;
+				xrClientData* tmp_client = static_cast<xrClientData*>(C);
+				tmp_client->m_update_baselines.dump_traffic(C->name.c_str(), reset);
+			}
+		};
+		TrafficDumper tmp_functor;
+		tmp_functor.server_client	= Level().Server->GetServerClient();
+		tmp_functor.reset			= !xr_strcmp(args_, "reset");
+		Msg("- update traffic per client, sv_traffic_optimization_level = %d", g_sv_traffic_optimization_level);
+		Level().Server->ForEachClientDo(tmp_functor);
+	}
+	virtual void	Info		(TInfo& I)
+	{
+		xr_strcpy(I, 
+			"Dump entity update bytes per second of each client: raw, delta encoded and sent. Format: \"sv_dump_update_traffic [reset]\"");
+	}
+
+}; //class CCC_DumpUpdateTraffic
+
+class CCC_DumpAnimationLOD : public IConsole_Command {
+public:
+	CCC_DumpAnimationLOD (LPCSTR N) : IConsole_Command(N) { bEmptyArgsHandled = true; };
+	virtual void	Execute		(LPCSTR args_) 
+	{
+		animation_lod_dump_stats(!xr_strcmp(args_, "reset"));
+	}
+	virtual void	Info		(TInfo& I)
+	{
+		xr_strcpy(I, 
+			"Dump bones evaluated and avoided by the animation LOD per second and the estimated tick time saved. Format: \"sv_dump_anim_lod [reset]\"");
+	}
+
+}; //class CCC_DumpAnimationLOD
+
+class CCC_LoadTest : public IConsole_Command {
+public:
+	CCC_LoadTest (LPCSTR N) : IConsole_Command(N) { bEmptyArgsHandled = false; };
+	virtual void	Execute		(LPCSTR args_) 
+	{
+		int count = 0;
+		sscanf(args_, "%d", &count);
+		if (count > 0)
+			server_load_test_start(u32(count));
+		else
+			server_load_test_stop();
+	}
+	virtual void	Info		(TInfo& I)
+	{
+		xr_strcpy(I, 
+			"Connect in-process bots to the server, 0 stops the test and logs the report. Format: \"sv_load_test <bots>\"");
+	}
+
+}; //class CCC_LoadTest
+
+class CCC_LoadTestReport : public IConsole_Command {
+public:
+	CCC_LoadTestReport (LPCSTR N) : IConsole_Command(N) { bEmptyArgsHandled = true; };
+	virtual void	Execute		(LPCSTR args_) 
+	{
+		server_load_test_report(!xr_strcmp(args_, "reset"));
+	}
+	virtual void	Info		(TInfo& I)
+	{
+		xr_strcpy(I, 
+			"Log server update percentiles, traffic per bot and subsystem times of the load test. Format: \"sv_load_test_report [reset]\"");
+	}
+
+}; //class CCC_LoadTestReport
+
 
 #ifdef DEBUG
 
@@ -3036,6 +3121,7 @@ void register_mp_console_commands()
 #endif // DEBUG
 	CMD3(CCC_GSCDKey,	"cdkey",				gsCDKey,			sizeof(gsCDKey)			);
 	CMD4(CCC_Integer,	"g_eventdelay",			&g_dwEventDelay,	0,	1000);
+	CMD4(CCC_Integer,	"g_spawn_stream_wait",	&g_cl_spawn_stream_wait,	0,	1000);
 	CMD4(CCC_Integer,	"g_corpsenum",			(int*)&g_dwMaxCorpses,		0,	100);
 
 
@@ -3050,6 +3136,13 @@ void register_mp_console_commands()
 	CMD1(CCC_MakeConfigDump,			"make_config_dump"			);
 	CMD1(CCC_ScreenshotAllPlayers,		"screenshot_all"			);
 	CMD1(CCC_ConfigsDumpAll,			"config_dump_all"			);
+	CMD1(CCC_DumpUpdateTraffic,			"sv_dump_update_traffic"	);
+	CMD1(CCC_DumpAnimationLOD,			"sv_dump_anim_lod"			);
+	CMD4(CCC_Integer,					"sv_anim_lod",				(int*)&g_sv_anim_lod, 0, 1);
+	CMD4(CCC_Float,						"sv_anim_lod_near",			&g_sv_anim_lod_near, 5.f, 500.f);
+	CMD4(CCC_Float,						"sv_anim_lod_far",			&g_sv_anim_lod_far, 5.f, 1000.f);
+	CMD1(CCC_LoadTest,					"sv_load_test"				);
+	CMD1(CCC_LoadTestReport,			"sv_load_test_report"		);
 
 
 	CMD1(CCC_SetDemoPlaySpeed,			"mpdemoplay_speed_set"		);
@@ -3212,5 +3305,5 @@ void register_mp_console_commands()
 	CMD1(CCC_GameSpyRegisterUniqueNick,		"gs_register_unique_nick");
 	CMD1(CCC_GameSpyProfile,				"gs_profile");
 	CMD4(CCC_Integer,						"sv_write_update_bin",				&g_sv_write_updates_bin, 0, 1);
-	CMD4(CCC_Integer,						"sv_traffic_optimization_level",	(int*)&g_sv_traffic_optimization_level, 0, 7);
+	CMD4(CCC_Integer,						"sv_traffic_optimization_level",	(int*)&g_sv_traffic_optimization_level, 0, 15);
 }
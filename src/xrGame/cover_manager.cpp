@@ -83,12 +83,30 @@ IC	bool CCoverManager::critical_cover	(u32 index)
 
 void CCoverManager::compute_static_cover	()
 {
+	CTimer					timer;
+	timer.Start				();
+
 	clear					();
 	xr_delete				(m_covers);
 	m_covers				= xr_new<CPointQuadTree>(ai().level_graph().header().box(),ai().level_graph().header().cell_size()*.5f,8*65536,4*65536);
-	m_temp.resize			(ai().level_graph().header().vertex_count());
 
 	CLevelGraph const		&graph = ai().level_graph();
+	if (graph.baked_covers()) {
+		// baked by xrAI with the same algorithm, see xrSaveNodes
+		u32 const			*I = graph.baked_covers();
+		u32 const			*E = I + graph.baked_cover_count();
+		for ( ; I != E; ++I)
+			m_covers->insert(xr_new<CCoverPoint>(graph.vertex_position(graph.vertex(*I)),*I));
+
+		Msg					("* %d static covers loaded from level.ai (%.3fs)",graph.baked_cover_count(),timer.GetElapsed_sec());
+
+		VERIFY				(!m_smart_covers_storage);
+		m_smart_covers_storage	= xr_new<smart_cover::storage>();
+		return;
+	}
+
+	m_temp.resize			(ai().level_graph().header().vertex_count());
+
 	for (u32 i=0, n = ai().level_graph().header().vertex_count(); i<n; ++i) {
 		CLevelGraph::CVertex const &vertex = *graph.vertex(i);
 		if (vertex.high_cover(0) + vertex.high_cover(1) + vertex.high_cover(2) + vertex.high_cover(3)) {
@@ -104,9 +122,14 @@ void CCoverManager::compute_static_cover	()
 		m_temp[i]			= false;
 	}
 
+	u32						count = 0;
 	for (u32 i=0; i<n; ++i)
-		if (m_temp[i] && critical_cover(i))
+		if (m_temp[i] && critical_cover(i)) {
 			m_covers->insert(xr_new<CCoverPoint>(ai().level_graph().vertex_position(ai().level_graph().vertex(i)),i));
+			++count;
+		}
+
+	Msg						("* %d static covers computed (%.3fs), rebuild level.ai to bake them",count,timer.GetElapsed_sec());
 
 	VERIFY					(!m_smart_covers_storage);
 	m_smart_covers_storage	= xr_new<smart_cover::storage>();
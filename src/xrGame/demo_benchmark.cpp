@@ -0,0 +1,163 @@
+#include "stdafx.h"
+#include "demo_benchmark.h"
+#include "../xrEngine/xr_ioconsole.h"
+#include "../xrSound/Sound.h"
+#include <psapi.h>
+
+#pragma comment(lib, "psapi.lib")
+
+static u32 const	sim_step_ms		= 33;		// rsConstantFPS step, see CRenderDevice::FrameMove
+
+struct demo_subsystem
+{
+	LPCSTR			name;
+	CStatTimer*		timer;
+	u64				last;
+	u64				accum;
+};
+static demo_subsystem	g_subsystems[] =
+{
+	{ "Sheduler",		0, 0, 0 },
+	{ "UpdateClient",	0, 0, 0 },
+	{ "Physics",		0, 0, 0 },
+	{ "Animation",		0, 0, 0 },
+	{ "AI_Think",		0, 0, 0 },
+	{ "netClient1",		0, 0, 0 },
+	{ "netClient2",		0, 0, 0 },
+	{ "Sound",			0, 0, 0 },
+};
+static u32 const	g_subsystems_count	= sizeof(g_subsystems) / sizeof(g_subsystems[0]);
+
+static bool			g_running			= false;
+static CTimer		g_wall;
+static CTimer		g_frame;
+static u32			g_sim_ms			= 0;
+static xr_vector<float>	g_frames;
+
+// restored before quit for the console to save them, rs_constant_fps only
+// once the level is gone (see demo_benchmark_release)
+static Flags32		g_device_flags;
+static bool			g_hold_step			= false;
+static float		g_volume_effects;
+static float		g_volume_music;
+
+bool demo_benchmark_enabled()
+{
+	return				!!strstr(Core.Params, "-demo_benchmark");
+}
+
+void demo_benchmark_start()
+{
+	if (g_running || !demo_benchmark_enabled())
+		return;
+	g_running			= true;
+
+	g_device_flags		= psDeviceFlags;
+	g_volume_effects	= psSoundVEffects;
+	g_volume_music		= psSoundVMusic;
+	psDeviceFlags.set	(rsConstantFPS, TRUE);
+	psDeviceFlags.set	(rsStatistic, TRUE);
+	psSoundVEffects		= 0.f;
+	psSoundVMusic		= 0.f;
+	g_bSkipRender		= TRUE;
+
+	CStats*		S		= Device.Statistic;
+	CStatTimer*	timers[] =
+	{
+		&S->Sheduler, &S->UpdateClient, &S->Physics, &S->Animation,
+		&S->AI_Think, &S->netClient1, &S->netClient2, &S->Sound,
+	};
+	STATIC_CHECK(sizeof(timers) / sizeof(timers[0]) == sizeof(g_subsystems) / sizeof(g_subsystems[0]), Subsystems_and_timers_count_mismatch);
+	for (u32 i = 0; i < g_subsystems_count; ++i)
+	{
+		g_subsystems[i].timer	= timers[i];
+		g_subsystems[i].last	= timers[i]->accum;
+		g_subsystems[i].accum	= 0;
+	}
+
+	g_sim_ms			= 0;
+	g_frames.clear		();
+	g_frames.reserve	(64 * 1024);
+	g_wall.Start		();
+	g_frame.Start		();
+	Msg					("* Demo benchmark started");
+}
+
+void demo_benchmark_update()
+{
+	if (!g_running)
+		return;
+
+	// CLevel::Send drops the flag in multiplayer outside of the playback
+	psDeviceFlags.set	(rsConstantFPS, TRUE);
+
+	g_frames.push_back	(g_frame.GetElapsed_sec() * 1000.f);
+	g_frame.Start		();
+	g_sim_ms			+= sim_step_ms;
+
+	// CStats::Show resets the timers, it is not called without rendering
+	for (u32 i = 0; i < g_subsystems_count; ++i)
+	{
+		demo_subsystem&	S	= g_subsystems[i];
+		u64 const	accum	= S.timer->accum;
+		S.accum				+= (accum >= S.last) ? accum - S.last : accum;
+		S.last				= accum;
+	}
+}
+
+void demo_benchmark_stop()
+{
+	if (!g_running)
+		return;
+	g_running			= false;
+
+	float const	wall	= g_wall.GetElapsed_sec();
+	float const	sim		= _max(float(g_sim_ms) / 1000.f, 0.001f);
+	Msg					("* Demo benchmark: %d frames, %.1f s simulated in %.1f s (%.2fx real time)",
+						g_frames.size(), sim, wall, sim / _max(wall, 0.001f));
+
+	if (!g_frames.empty())
+	{
+		xr_vector<float>	sorted	= g_frames;
+		u32 const	last	= sorted.size() - 1;
+		u32 const	p50		= last * 50 / 100;
+		u32 const	p99		= last * 99 / 100;
+		std::nth_element	(sorted.begin(), sorted.begin() + p50, sorted.end());
+		float const	v50		= sorted[p50];
+		std::nth_element	(sorted.begin(), sorted.begin() + p99, sorted.end());
+		float const	v99		= sorted[p99];
+		float const	vmax	= *std::max_element(sorted.begin(), sorted.end());
+		Msg					("* frame ms: p50 %.2f, p99 %.2f, max %.2f", v50, v99, vmax);
+	}
+
+	double const	to_ms	= 1000.0 / double(CPU::qpc_freq) / double(sim);
+	for (u32 i = 0; i < g_subsystems_count; ++i)
+		Msg					("* %-14s %8.2f ms per simulated second", g_subsystems[i].name, double(g_subsystems[i].accum) * to_ms);
+
+	PROCESS_MEMORY_COUNTERS	counters;
+	ZeroMemory			(&counters, sizeof(counters));
+	counters.cb			= sizeof(counters);
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		Msg				("* peak memory: committed %d MB, working set %d MB",
+						u32(counters.PeakPagefileUsage >> 20), u32(counters.PeakWorkingSetSize >> 20));
+	Msg					("* engine heap in use: %d MB", Memory.mem_usage() >> 20);
+
+	// the fixed step stays while the level runs, the wall clock is behind the simulated time
+	psDeviceFlags		= g_device_flags;
+	psDeviceFlags.set	(rsConstantFPS, TRUE);
+	g_hold_step			= true;
+	psSoundVEffects		= g_volume_effects;
+	psSoundVMusic		= g_volume_music;
+	g_bSkipRender		= FALSE;
+	g_frames.clear		();
+
+	Console->Execute	("quit");
+}
+
+void demo_benchmark_release()
+{
+	if (!g_hold_step)
+		return;
+	g_hold_step			= false;
+	psDeviceFlags.set	(rsConstantFPS, g_device_flags.test(rsConstantFPS));
+}
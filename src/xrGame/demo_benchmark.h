@@ -0,0 +1,18 @@
+#ifndef DEMO_BENCHMARK_H_INCLUDED
+#define DEMO_BENCHMARK_H_INCLUDED
+
+// CPU benchmark on a recorded multiplayer demo.
+// With "-demo_benchmark" the demo started by "-start demo(<file>)" is played
+// in fixed 33 ms steps as fast as the frames run, without drawing the scene
+// and with the sound muted. Packet processing, object updates, physics,
+// animation and AI run as in a normal playback. When the demo ends the time
+// per simulated second of the main subsystems, the frame percentiles and the
+// peak memory are logged and the engine quits.
+
+bool	demo_benchmark_enabled		();
+void	demo_benchmark_start		();
+void	demo_benchmark_update		();
+void	demo_benchmark_stop			();
+void	demo_benchmark_release		();	// level destroyed, the user's rs_constant_fps is back
+
+#endif //#ifndef DEMO_BENCHMARK_H_INCLUDED
@@ -35,6 +35,28 @@ CLevelGraph::CLevelGraph		()
 	R_ASSERT					(header().version() == XRAI_CURRENT_VERSION);
 	m_reader->advance			(sizeof(CHeader));
 	m_nodes						= (CVertex*)m_reader->pointer();
+	m_reader->advance			(header().vertex_count()*sizeof(CVertex));
+
+	// baked static covers
+	m_covers					= 0;
+	m_cover_count				= 0;
+	if (m_reader->elapsed() >= int(sizeof(hdrCOVERS))) {
+		hdrCOVERS const			*covers = (hdrCOVERS const*)m_reader->pointer();
+		if ((covers->magic == XRAI_COVERS_MAGIC) && (covers->version == XRAI_COVERS_VERSION)) {
+			// a bake not matching the nodes is discarded, the covers are computed on load then
+			u32 const			*ids = (u32 const*)(covers + 1);
+			bool				valid = (covers->count <= header().vertex_count()) && (u64(m_reader->elapsed()) >= sizeof(hdrCOVERS) + u64(covers->count)*sizeof(u32));
+			for (u32 i=0; valid && (i < covers->count); ++i)
+				valid			= (ids[i] < header().vertex_count()) && (!i || (ids[i - 1] < ids[i]));
+
+			if (valid) {
+				m_covers		= ids;
+				m_cover_count	= covers->count;
+			}
+			else
+				Msg				("! level.ai static covers don't match the level graph, ignored");
+		}
+	}
 	m_row_length				= iFloor((header().box().max.z - header().box().min.z)/header().cell_size() + EPS_L + 1.5f);
 	m_column_length				= iFloor((header().box().max.x - header().box().min.x)/header().cell_size() + EPS_L + 1.5f);
 	m_access_mask.assign		(header().vertex_count(),true);
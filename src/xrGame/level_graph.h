@@ -52,6 +52,8 @@ private:
 	IReader					*m_reader;		// level graph virtual storage
 	CHeader					*m_header;		// level graph header
 	CVertex					*m_nodes;		// nodes array
+	u32 const				*m_covers;		// baked static cover vertices, if any
+	u32						m_cover_count;
 	xr_vector<bool>			m_access_mask;
 	GameGraph::_LEVEL_ID	m_level_id;		// unique level identifier
 	u32						m_row_length;
@@ -115,6 +117,8 @@ public:
 	IC		u32		value						(const CVertex *vertex, const_iterator &i) const;
 	IC		u32		value						(const u32 vertex_id,	const_iterator &i) const;
 	IC		const CHeader &header				() const;
+	IC		u32 const *baked_covers				() const;
+	IC		u32		baked_cover_count			() const;
 	ICF		bool	valid_vertex_id				(u32 vertex_id) const;
 	IC		const GameGraph::_LEVEL_ID &level_id() const;
 	IC		void	unpack_xz					(const CLevelGraph::CPosition &vertex_position, u32 &x, u32 &z) const;
@@ -23,6 +23,16 @@ IC const CLevelGraph::CHeader &CLevelGraph::header	() const
 	return				(*m_header);
 }
 
+IC	u32 const *CLevelGraph::baked_covers	() const
+{
+	return				(m_covers);
+}
+
+IC	u32	CLevelGraph::baked_cover_count	() const
+{
+	return				(m_cover_count);
+}
+
 ICF bool CLevelGraph::valid_vertex_id	(u32 id) const
 {
 	bool				b = id < header().vertex_count();
@@ -88,6 +88,7 @@ IC	CProfiler&	profiler();
 #	include "profiler_inline.h"
 
 #else // DEBUG
-#	define START_PROFILE(a) {
+	// portions still show up in the frame trace, xrTrace costs a flag test when it is off
+#	define START_PROFILE(a) { TRACE_ZONE(a);
 #	define STOP_PROFILE		}
 #endif // DEBUG
\ No newline at end of file
@@ -10,18 +10,22 @@
 
 IC	CProfilePortion::CProfilePortion	(LPCSTR timer_id)
 {
+	m_timer_id							= timer_id;
+	xrTrace::zone_begin					(m_timer_id);
+
 	if (!psAI_Flags.test(aiStats))
 		return;
 
 	if (!psDeviceFlags.test(rsStatistic))
 		return;
 
-	m_timer_id							= timer_id;
 	m_time								= CPU::QPC();
 }
 
 IC	CProfilePortion::~CProfilePortion	()
 {
+	xrTrace::zone_end					(m_timer_id);
+
 	if (!psAI_Flags.test(aiStats))
 		return;
 
@@ -0,0 +1,704 @@
+#include "stdafx.h"
+#include "server_load_test.h"
+#include "level.h"
+#include "xrServer.h"
+#include "xrMessages.h"
+#include "game_base.h"
+#include "actor_defs.h"
+#include "inventory_space.h"
+#include "Weapon.h"
+#include "ai_space.h"
+#include "patrol_path_storage.h"
+#include "patrol_path.h"
+#include "../xrNetServer/LoopbackClient.h"
+#include "../xrEngine/xr_ioconsole.h"
+
+static u32 const	report_period		= 60000;	// ms
+static u32 const	sync_timeout		= 5000;		// ms, the server info upload waits for a real client
+static u32 const	ready_period		= 3000;		// ms, the ready event is repeated until the actor spawns
+static u32 const	fire_period			= 5000;		// ms
+static u32 const	fire_burst			= 1000;		// ms
+static float const	walk_speed			= 3.f;		// m/s
+static float const	circle_radius		= 10.f;		// route around the spawn point without patrol paths
+static u16 const	invalid_id			= u16(-1);
+
+class load_test_client : public LoopbackClient
+{
+	enum state
+	{
+		ls_connecting,		// waiting for M_CLIENT_CONNECT_RESULT
+		ls_profile,			// player state sent, the server creates it with a delayed event
+		ls_syncing,			// connection data requested, waiting for M_SV_CONFIG_FINISHED
+		ls_spectator,		// M_CLIENTREADY sent, waiting for the spectator
+		ls_waiting,			// ready sent, waiting for the actor
+		ls_playing,
+		ls_failed,
+	};
+
+public:
+					load_test_client	(u32 index);
+
+	void			update				();
+	bool			playing				() const { return m_state == ls_playing; }
+	bool			failed				() const { return m_state == ls_failed; }
+
+	u32				sent_base;
+	u32				received_base;
+
+private:
+	void			receive				();
+	void			on_connect_result	(NET_Packet& P);
+	void			on_spawn			(NET_Packet& P);
+	void			on_event			(NET_Packet& P);
+	void			on_move				(NET_Packet& P);
+
+	void			send_player_state	(u16 message);
+	void			send_ready			();
+	void			send_update			();
+	void			send_fire			(bool fire);
+	void			build_route			();
+	void			walk				(float dt);
+	void			set_state			(state S);
+
+	u32				m_index;
+	state			m_state;
+	u32				m_state_time;
+	u32				m_state_frame;
+	u32				m_ready_time;
+	u32				m_update_time;
+
+	u16				m_spectator_id;
+	u16				m_actor_id;
+	u16				m_weapon_id;
+
+	// set by receive, handled by update once the queue is released
+	bool			m_connected;
+	bool			m_config_finished;
+	bool			m_move_respond;
+
+	bool			m_firing;
+	Fvector			m_position;
+	Fvector			m_velocity;
+	float			m_yaw;
+	xr_vector<Fvector>	m_route;
+	u32				m_route_point;
+};
+
+load_test_client::load_test_client(u32 index) : LoopbackClient(Device.GetTimerGlobal())
+{
+	m_index				= index;
+	m_state				= ls_connecting;
+	m_state_time		= Device.dwTimeGlobal;
+	m_state_frame		= Device.dwFrame;
+	m_ready_time		= 0;
+	m_update_time		= Device.dwTimeGlobal;
+	m_spectator_id		= invalid_id;
+	m_actor_id			= invalid_id;
+	m_weapon_id			= invalid_id;
+	m_connected			= false;
+	m_config_finished	= false;
+	m_move_respond		= false;
+	m_firing			= false;
+	m_position.set		(0.f, 0.f, 0.f);
+	m_velocity.set		(0.f, 0.f, 0.f);
+	m_yaw				= 0.f;
+	m_route_point		= 0;
+	sent_base			= 0;
+	received_base		= 0;
+}
+
+void load_test_client::set_state(state S)
+{
+	m_state				= S;
+	m_state_time		= Device.dwTimeGlobal;
+	m_state_frame		= Device.dwFrame;
+}
+
+void load_test_client::update()
+{
+	if (net_isDisconnected())
+	{
+		m_state			= ls_failed;
+		return;
+	}
+
+	receive				();
+
+	u32 const	now		= Device.dwTimeGlobal;
+	if (m_connected)
+	{
+		m_connected		= false;
+		send_player_state(M_CREATE_PLAYER_STATE);
+		set_state		(ls_profile);
+	}
+
+	switch (m_state)
+	{
+	case ls_profile:
+		{
+			// the player state is created by a delayed event, delayed packets go first
+			if (Device.dwFrame < m_state_frame + 2)
+				break;
+			NET_Packet	P;
+			P.w_begin	(M_CLIENT_REQUEST_CONNECTION_DATA);
+			Send		(P, net_flags(TRUE, TRUE, TRUE, TRUE));
+			set_state	(ls_syncing);
+		}break;
+	case ls_syncing:
+		{
+			if (!m_config_finished && (now < m_state_time + sync_timeout))
+				break;
+			send_player_state(M_CLIENTREADY);
+			set_state	(ls_spectator);
+		}break;
+	case ls_waiting:
+		{
+			if (now >= m_ready_time + ready_period)
+				send_ready();
+		}break;
+	case ls_playing:
+		{
+			float const	dt	= float(now - m_update_time) / 1000.f;
+			walk		(dt);
+
+			bool const	fire	= (m_weapon_id != invalid_id) && ((now + m_index * 731) % fire_period < fire_burst);
+			if (fire != m_firing)
+				send_fire	(fire);
+
+			if (net_HasBandwidth())
+				send_update	();
+		}break;
+	}
+	m_update_time		= now;
+
+	if (m_move_respond)
+	{
+		m_move_respond	= false;
+		NET_Packet		P;
+		P.w_begin		(M_MOVE_PLAYERS_RESPOND);
+		Send			(P, net_flags(TRUE, TRUE));
+	}
+
+	Flush_Send_Buffer	();
+}
+
+void load_test_client::receive()
+{
+	StartProcessQueue	();
+	for (NET_Packet* P = net_msg_Retreive(); P; P = net_msg_Retreive())
+	{
+		u16				type;
+		P->r_begin		(type);
+		switch (type)
+		{
+		case M_CLIENT_CONNECT_RESULT:	on_connect_result(*P);		break;
+		case M_SV_CONFIG_FINISHED:		m_config_finished = true;	break;
+		case M_SPAWN:					on_spawn(*P);				break;
+		case M_EVENT:					on_event(*P);				break;
+		case M_MOVE_PLAYERS:			on_move(*P);				break;
+		case M_EVENT_PACK:
+			{
+				NET_Packet	tmpP;
+				while (!P->r_eof())
+				{
+					tmpP.B.count	= P->r_u8();
+					P->r		(&tmpP.B.data, tmpP.B.count);
+					tmpP.r_begin(type);
+					if (type == M_EVENT)
+						on_event(tmpP);
+				}
+			}break;
+		}
+		net_msg_Release	();
+	}
+	EndProcessQueue		();
+}
+
+void load_test_client::on_connect_result(NET_Packet& P)
+{
+	u8 const	result	= P.r_u8();
+	P.r_u8				();
+	string512			reason;
+	P.r_stringZ_s		(reason);
+	if (!result)
+	{
+		Msg				("! Load test: bot %d rejected: %s", m_index, reason);
+		set_state		(ls_failed);
+		return;
+	}
+	m_connected			= true;
+}
+
+void load_test_client::on_spawn(NET_Packet& P)
+{
+	string256			name;
+	string256			name_replace;
+	Fvector				position;
+	Fvector				angle;
+	P.r_stringZ_s		(name);
+	P.r_stringZ_s		(name_replace);
+	P.r_u8				();
+	P.r_u8				();
+	P.r_vec3			(position);
+	P.r_vec3			(angle);
+	P.r_u16				();
+	u16 const	id		= P.r_u16();
+	u16 const	parent	= P.r_u16();
+	P.r_u16				();
+	u16 const	flags	= P.r_u16();
+
+	if ((m_actor_id != invalid_id) && (parent == m_actor_id))
+	{
+		if ((m_weapon_id == invalid_id) && !strncmp(name, "wpn_", 4))
+			m_weapon_id	= id;
+		return;
+	}
+
+	if (!(flags & M_SPAWN_OBJECT_LOCAL) || (parent != invalid_id))
+		return;
+
+	if (!xr_strcmp(name, "spectator"))
+	{
+		m_spectator_id	= id;
+		set_state		(ls_waiting);
+		m_ready_time	= 0;
+		return;
+	}
+
+	// the controlled entity, "mp_actor" in the multiplayer games
+	m_actor_id			= id;
+	m_weapon_id			= invalid_id;
+	m_firing			= false;
+	m_position			= position;
+	m_yaw				= angle.y;
+	build_route			();
+	set_state			(ls_playing);
+}
+
+void load_test_client::on_event(NET_Packet& P)
+{
+	P.r_u32				();
+	u16 const	type	= P.r_u16();
+	u16 const	dest	= P.r_u16();
+	if (type != GE_DESTROY)
+		return;
+
+	if (dest == m_weapon_id)
+	{
+		m_weapon_id		= invalid_id;
+		m_firing		= false;
+	}
+	else if (dest == m_spectator_id)
+		m_spectator_id	= invalid_id;
+	else if (dest == m_actor_id)
+	{
+		m_actor_id		= invalid_id;
+		m_weapon_id		= invalid_id;
+		m_firing		= false;
+		set_state		(ls_spectator);
+	}
+}
+
+void load_test_client::on_move(NET_Packet& P)
+{
+	u8 const	count	= P.r_u8();
+	for (u8 i = 0; i < count; ++i)
+	{
+		u16 const	id	= P.r_u16();
+		Fvector		position, angle;
+		P.r_vec3		(position);
+		P.r_vec3		(angle);
+		if (id == m_actor_id)
+		{
+			m_position	= position;
+			m_yaw		= angle.y;
+		}
+	}
+	m_move_respond		= true;
+}
+
+void load_test_client::send_player_state(u16 message)
+{
+	string64			name;
+	xr_sprintf			(name, "loadtest_%02d", m_index);
+
+	game_PlayerState	ps(NULL);
+	ps.resetFlag		(GAME_PLAYER_FLAG_SKIP);
+	ps.m_account.set_player_name(name);
+
+	NET_Packet			P;
+	P.w_begin			(message);
+	ps.net_Export		(P, TRUE);
+	Send				(P, net_flags(TRUE, TRUE, TRUE, TRUE));
+}
+
+void load_test_client::send_ready()
+{
+	if (m_spectator_id == invalid_id)
+		return;
+
+	NET_Packet			P;
+	P.w_begin			(M_EVENT);
+	P.w_u32				(timeServer());
+	P.w_u16				(GE_GAME_EVENT);
+	P.w_u16				(m_spectator_id);
+	P.w_u16				(GAME_EVENT_PLAYER_READY);
+	Send				(P, net_flags(TRUE, TRUE));
+	m_ready_time		= Device.dwTimeGlobal;
+}
+
+// CActor::net_Export without the physics state
+void load_test_client::send_update()
+{
+	Fvector				accel;
+	accel.set			(0.f, 0.f, 0.f);
+
+	NET_Packet			P;
+	P.w_begin			(M_CL_UPDATE);
+	P.w_u16				(m_actor_id);
+	P.w_u32				(0);				// ping, written by the server
+	P.w_float			(1.f);				// health
+	P.w_u32				(timeServer());
+	P.w_u8				(0);
+	P.w_vec3			(m_position);
+	P.w_float			(m_yaw);			// model
+	P.w_float			(m_yaw);			// torso yaw
+	P.w_float			(0.f);				// torso pitch
+	P.w_float			(0.f);				// torso roll
+	P.w_u8				(0);				// team
+	P.w_u8				(0);				// squad
+	P.w_u8				(0);				// group
+	P.w_u16				(u16(m_velocity.square_magnitude() > EPS ? mcFwd : 0));
+	P.w_sdir			(accel);
+	P.w_sdir			(m_velocity);
+	P.w_float			(0.f);				// radiation
+	P.w_u8				(u8(NO_ACTIVE_SLOT));
+	P.w_u16				(0);				// physics items
+	Send				(P, net_flags(FALSE));
+}
+
+// a burst is M_PLAYER_FIRE and the weapon state events CWeapon sends itself
+void load_test_client::send_fire(bool fire)
+{
+	NET_Packet			P;
+	if (fire)
+	{
+		P.w_begin		(M_PLAYER_FIRE);
+		P.w_u16			(m_actor_id);
+		Send			(P, net_flags(TRUE, TRUE));
+	}
+
+	P.w_begin			(M_EVENT);
+	P.w_u32				(timeServer());
+	P.w_u16				(GE_WPN_STATE_CHANGE);
+	P.w_u16				(m_weapon_id);
+	P.w_u8				(u8(fire ? CWeapon::eFire : CWeapon::eIdle));
+	P.w_u8				(0);				// sub state
+	P.w_u8				(0);				// ammo type
+	P.w_u8				(30);				// ammo elapsed
+	P.w_u8				(u8(CWeapon::undefined_ammo_type));
+	Send				(P, net_flags(TRUE, TRUE));
+
+	m_firing			= fire;
+}
+
+// walks the patrol path nearest to the spawn point, from its nearest vertex
+void load_test_client::build_route()
+{
+	m_route.clear		();
+	m_route_point		= 0;
+
+	float				best = flt_max;
+	const CPatrolPathStorage::PATROL_REGISTRY&	paths	= ai().patrol_paths().patrol_paths();
+	CPatrolPathStorage::const_iterator	I	= paths.begin();
+	CPatrolPathStorage::const_iterator	E	= paths.end();
+	for (; I != E; ++I)
+	{
+		const CPatrolPath::VERTICES&	vertices	= (*I).second->vertices();
+		if (vertices.size() < 2)
+			continue;
+
+		u32				nearest = 0, it = 0;
+		float			nearest_sqr = flt_max;
+		CPatrolPath::const_vertex_iterator	i = vertices.begin(), e = vertices.end();
+		for (; i != e; ++i, ++it)
+		{
+			float const	distance_sqr	= m_position.distance_to_sqr((*i).second->data().position());
+			if (distance_sqr < nearest_sqr)
+			{
+				nearest_sqr	= distance_sqr;
+				nearest		= it;
+			}
+		}
+		if (nearest_sqr >= best)
+			continue;
+
+		best			= nearest_sqr;
+		m_route.clear	();
+		for (i = vertices.begin(); i != e; ++i)
+			m_route.push_back((*i).second->data().position());
+		m_route_point	= nearest;
+	}
+
+	if (!m_route.empty())
+		return;
+
+	for (u32 it = 0; it < 8; ++it)
+	{
+		float const		angle	= float(it) * PI_MUL_2 / 8.f;
+		Fvector			point;
+		point.set		(m_position.x + circle_radius * _cos(angle), m_position.y, m_position.z + circle_radius * _sin(angle));
+		m_route.push_back(point);
+	}
+}
+
+void load_test_client::walk(float dt)
+{
+	Fvector				direction;
+	direction.sub		(m_route[m_route_point], m_position);
+	float const	distance	= direction.magnitude();
+	float const	step	= walk_speed * dt;
+	if (distance <= step)
+	{
+		m_position		= m_route[m_route_point];
+		m_route_point	= (m_route_point + 1) % m_route.size();
+		return;
+	}
+
+	direction.div		(distance);
+	m_position.mad		(direction, step);
+	m_velocity.mul		(direction, walk_speed);
+	m_yaw				= direction.getH();
+}
+
+// -----------------------------------------------------------------------------
+
+static xr_vector<load_test_client*>	g_bots;
+static xr_vector<float>				g_ticks;
+static u32							g_report_start		= 0;
+static u32							g_report_last		= 0;
+static bool							g_auto_checked		= false;
+static u32							g_auto_quit			= 0;		// ms, -load_test_time
+
+struct subsystem
+{
+	LPCSTR			name;
+	CStatTimer*		timer;
+	u64				last;
+	u64				accum;
+};
+static subsystem					g_subsystems[] =
+{
+	{ "Sheduler",		0, 0, 0 },
+	{ "UpdateClient",	0, 0, 0 },
+	{ "Physics",		0, 0, 0 },
+	{ "AI_Think",		0, 0, 0 },
+	{ "netClient1",		0, 0, 0 },
+	{ "netClient2",		0, 0, 0 },
+	{ "netServer",		0, 0, 0 },
+	{ "netServerUpdates",	0, 0, 0 },
+};
+
+static void bind_subsystems()
+{
+	CStats*		S		= Device.Statistic;
+	CStatTimer*	timers[] =
+	{
+		&S->Sheduler, &S->UpdateClient, &S->Physics, &S->AI_Think,
+		&S->netClient1, &S->netClient2, &S->netServer, &S->netServerUpdates,
+	};
+	STATIC_CHECK(sizeof(timers) / sizeof(timers[0]) == sizeof(g_subsystems) / sizeof(g_subsystems[0]), Subsystems_and_timers_count_mismatch);
+	for (u32 i = 0; i < sizeof(g_subsystems) / sizeof(g_subsystems[0]); ++i)
+	{
+		g_subsystems[i].timer	= timers[i];
+		g_subsystems[i].last	= timers[i]->accum;
+		g_subsystems[i].accum	= 0;
+	}
+}
+
+// the timers are reset by CStats::Show when it runs, a smaller value is a new frame
+static void sample_subsystems()
+{
+	for (u32 i = 0; i < sizeof(g_subsystems) / sizeof(g_subsystems[0]); ++i)
+	{
+		subsystem&	S		= g_subsystems[i];
+		u64 const	accum	= S.timer->accum;
+		S.accum				+= (accum >= S.last) ? accum - S.last : accum;
+		S.last				= accum;
+	}
+}
+
+static void reset_window()
+{
+	g_ticks.clear_not_free	();
+	g_report_start			= Device.dwTimeGlobal;
+	for (u32 i = 0; i < g_bots.size(); ++i)
+	{
+		g_bots[i]->sent_base		= g_bots[i]->BytesSent();
+		g_bots[i]->received_base	= g_bots[i]->BytesReceived();
+	}
+	for (u32 i = 0; i < sizeof(g_subsystems) / sizeof(g_subsystems[0]); ++i)
+		g_subsystems[i].accum		= 0;
+}
+
+void server_load_test_start(u32 count)
+{
+	if (!g_pGameLevel || !Level().Server)
+	{
+		Msg					("! Load test needs a running server");
+		return;
+	}
+
+	if (g_bots.empty())
+	{
+		psDeviceFlags.set	(rsStatistic, TRUE);
+		bind_subsystems		();
+		g_report_last		= Device.dwTimeGlobal;
+		reset_window		();
+	}
+
+	xrServer*	server		= Level().Server;
+	u32 const	first		= g_bots.size();
+	for (u32 i = first; i < first + count; ++i)
+	{
+		string64			name;
+		xr_sprintf			(name, "loadtest_%02d", i);
+		load_test_client*	bot	= xr_new<load_test_client>(i);
+		if (!bot->Connect(server, name))
+		{
+			Msg				("! Load test: bot %d can't connect", i);
+			xr_delete		(bot);
+			continue;
+		}
+		g_bots.push_back	(bot);
+	}
+	Msg						("* Load test: %d bots", g_bots.size());
+}
+
+void server_load_test_stop()
+{
+	if (g_bots.empty())
+		return;
+
+	server_load_test_report	(false);
+	for (u32 i = 0; i < g_bots.size(); ++i)
+		xr_delete			(g_bots[i]);
+	g_bots.clear			();
+	g_ticks.clear			();
+	Msg						("* Load test stopped");
+}
+
+void server_load_test_update(float tick_ms)
+{
+	if (!g_auto_checked)
+	{
+		// -load_test N starts once the server runs the game
+		if (!Level().game_configured || !Level().Server || !Level().Server->game)
+			return;
+		g_auto_checked		= true;
+		if (strstr(Core.Params, "-load_test "))
+		{
+			u32				count = 0, seconds = 0;
+			sscanf			(strstr(Core.Params, "-load_test ") + 11, "%d", &count);
+			if (strstr(Core.Params, "-load_test_time "))
+				sscanf		(strstr(Core.Params, "-load_test_time ") + 16, "%d", &seconds);
+			if (seconds)
+				g_auto_quit	= Device.dwTimeGlobal + seconds * 1000;
+			if (count)
+				server_load_test_start(count);
+		}
+	}
+
+	if (g_bots.empty())
+		return;
+
+	g_ticks.push_back		(tick_ms);
+	sample_subsystems		();
+
+	for (u32 i = 0; i < g_bots.size(); ++i)
+		g_bots[i]->update	();
+
+	if (g_auto_quit && (Device.dwTimeGlobal >= g_auto_quit))
+	{
+		g_auto_quit			= 0;
+		server_load_test_stop();
+		Console->Execute	("quit");
+		return;
+	}
+
+	if (Device.dwTimeGlobal >= g_report_last + report_period)
+	{
+		g_report_last		= Device.dwTimeGlobal;
+		server_load_test_report(true);
+	}
+}
+
+void server_load_test_report(bool reset)
+{
+	if (g_bots.empty())
+	{
+		Msg					("! Load test is not running, start it with \"sv_load_test <bots>\"");
+		return;
+	}
+
+	float const	seconds		= _max(float(Device.dwTimeGlobal - g_report_start) / 1000.f, 0.001f);
+	u32			playing		= 0;
+	u32			failed		= 0;
+	for (u32 i = 0; i < g_bots.size(); ++i)
+	{
+		if (g_bots[i]->playing())		++playing;
+		else if (g_bots[i]->failed())	++failed;
+	}
+	Msg						("* Load test: %d bots, %d playing, %d failed, %.1f s, %d ticks", g_bots.size(), playing, failed, seconds, g_ticks.size());
+
+	if (!g_ticks.empty())
+	{
+		xr_vector<float>	sorted	= g_ticks;
+		u32 const	last	= sorted.size() - 1;
+		u32 const	p50		= last * 50 / 100;
+		u32 const	p90		= last * 90 / 100;
+		u32 const	p99		= last * 99 / 100;
+		std::nth_element	(sorted.begin(), sorted.begin() + p50, sorted.end());
+		float const	v50		= sorted[p50];
+		std::nth_element	(sorted.begin(), sorted.begin() + p90, sorted.end());
+		float const	v90		= sorted[p90];
+		std::nth_element	(sorted.begin(), sorted.begin() + p99, sorted.end());
+		float const	v99		= sorted[p99];
+		float const	vmax	= *std::max_element(sorted.begin(), sorted.end());
+		Msg					("* server update ms: p50 %.2f, p90 %.2f, p99 %.2f, max %.2f", v50, v90, v99, vmax);
+
+		string512			line;
+		xr_strcpy			(line, "* ms per tick:");
+		double const	to_ms	= 1000.0 / double(CPU::qpc_freq) / double(g_ticks.size());
+		for (u32 i = 0; i < sizeof(g_subsystems) / sizeof(g_subsystems[0]); ++i)
+		{
+			string64		item;
+			xr_sprintf		(item, " %s %.3f", g_subsystems[i].name, double(g_subsystems[i].accum) * to_ms);
+			xr_strcat		(line, item);
+		}
+		Msg					("%s", line);
+	}
+
+	u32			total_sent	= 0,		total_received	= 0;
+	u32			min_sent	= u32(-1),	min_received	= u32(-1);
+	u32			max_sent	= 0,		max_received	= 0;
+	for (u32 i = 0; i < g_bots.size(); ++i)
+	{
+		u32 const	sent	= g_bots[i]->BytesSent() - g_bots[i]->sent_base;
+		u32 const	received	= g_bots[i]->BytesReceived() - g_bots[i]->received_base;
+		total_sent			+= sent;
+		total_received		+= received;
+		min_sent			= _min(min_sent, sent);
+		max_sent			= _max(max_sent, sent);
+		min_received		= _min(min_received, received);
+		max_received		= _max(max_received, received);
+	}
+	float const	to_kb		= 1.f / (1024.f * seconds);
+	float const	count		= float(g_bots.size());
+	Msg						("* bot upload KB/s: avg %.2f, min %.2f, max %.2f", total_sent * to_kb / count, min_sent * to_kb, max_sent * to_kb);
+	Msg						("* bot download KB/s: avg %.2f, min %.2f, max %.2f", total_received * to_kb / count, min_received * to_kb, max_received * to_kb);
+	Msg						("* server traffic KB/s: in %.2f, out %.2f", total_sent * to_kb, total_received * to_kb);
+
+	if (reset)
+		reset_window		();
+}
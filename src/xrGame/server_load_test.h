@@ -0,0 +1,19 @@
+#ifndef SERVER_LOAD_TEST_H_INCLUDED
+#define SERVER_LOAD_TEST_H_INCLUDED
+
+// In-process load test of the dedicated server.
+// Bots connect through the loopback transport and play like remote players:
+// they walk the level patrol paths, send their actor updates and shoot. The
+// server runs exactly the code it runs for real clients. The report gives the
+// percentiles of xrServer::Update time, the traffic per bot and the time per
+// tick of the main subsystems.
+//
+// "-load_test N" starts N bots once the level is up, "-load_test_time S"
+// logs the report after S seconds and quits.
+
+void	server_load_test_start		(u32 count);
+void	server_load_test_stop		();
+void	server_load_test_update		(float tick_ms);
+void	server_load_test_report		(bool reset);
+
+#endif //#ifndef SERVER_LOAD_TEST_H_INCLUDED
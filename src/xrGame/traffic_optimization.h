@@ -35,6 +35,7 @@ enum enum_traffic_optimization
 	eto_ppmd_compression	=	1 << 0,
 	eto_lzo_compression		=	1 << 1,
 	eto_last_change			=	1 << 2,
+	eto_delta_updates		=	1 << 3,
 };//enum enum_traffic_optimization
 
 extern u32	g_sv_traffic_optimization_level;
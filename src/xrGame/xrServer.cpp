@@ -51,6 +51,7 @@ void	xrClientData::Clear()
 	m_last_update_time_5 = 0;
 	m_last_update_time_1 = 0;
 	m_last_update_time_05 = 0;
+	m_update_baselines.clear();
 };
 
 
@@ -61,9 +62,12 @@ xrClientData::~xrClientData()
 
 
 xrServer::xrServer() : inherited(Device.GetTimerGlobal(), g_dedicated_server)
+#ifdef PROFILE_CRITICAL_SECTIONS
+	, m_csDelayedPackets(MUTEX_PROFILE_ID(xrServer::m_csDelayedPackets))
+#endif // PROFILE_CRITICAL_SECTIONS
 {
+	m_delayed_overflow_count	= 0;
 	m_file_transfers	= NULL;
-	m_aDelayedPackets.clear();
 	m_server_logo		= NULL;
 	m_server_rules		= NULL;
 	m_last_updates_size	= 0;
@@ -85,7 +89,13 @@ xrServer::~xrServer()
 		client_Destroy(tmp_client);
 		tmp_client = net_players.GetFoundClient(&ClientDestroyer::true_generator);
 	}
-	m_aDelayedPackets.clear();
+	DelayedPacket* DPacket;
+	while (m_aDelayedPackets.pop(DPacket))
+		xr_delete(DPacket);
+	while (m_aDelayedPacketsUnused.pop(DPacket))
+		xr_delete(DPacket);
+	delete_data(m_aDelayedPacketsOverflow);
+	delete_data(m_aDelayedPacketsTaken);
 	entities.clear();
 	delete_data(m_info_uploaders);
 	xr_delete(m_server_logo);
@@ -163,18 +173,7 @@ void		xrServer::client_Destroy	(IClient* C)
 			SendBroadcast		(C->ID,P,net_flags(TRUE,TRUE));
 		};
 
-		DelayedPacket pp;
-		pp.SenderID = alife_client->ID;
-		xr_deque<DelayedPacket>::iterator it;
-		do{
-			it						=std::find(m_aDelayedPackets.begin(),m_aDelayedPackets.end(),pp);
-			if(it!=m_aDelayedPackets.end())
-			{
-				m_aDelayedPackets.erase	(it);
-				Msg("removing packet from delayed event storage");
-			}else
-				break;
-		}while(true);
+		// the delayed packets of the client are dropped by ProceedDelayedPackets
 		
 		if (pOwner)
 		{
@@ -294,6 +293,7 @@ void xrServer::MakeUpdatePackets()
 
 #ifndef OLD_SYNC
 	m_update_packets.clear();
+	m_update_arena.clear();	// keeps the capacity of the previous ticks
 #endif // !OLD_SYNC
 
 	m_updator.begin_updates			();
@@ -327,15 +327,22 @@ void xrServer::MakeUpdatePackets()
 #ifdef OLD_SYNC
 			m_updator.write_update_for(Test.ID, tmpPacket);
 #else
-			// save all packets
+			// save all packets, copying only the used part of tmpPacket into the per-tick arena
 			m_update_packets.push_back(UpdatePacket());
 			UpdatePacket* NewPacket = &(m_update_packets.back());
 			NewPacket->Entity = I->second;
-			CopyMemory(&(NewPacket->Packet), &tmpPacket, sizeof(NET_Packet));
+			NewPacket->Offset = u32(m_update_arena.size());
+			NewPacket->Size = tmpPacket.B.count;
+			m_update_arena.insert(m_update_arena.end(), tmpPacket.B.data, tmpPacket.B.data + tmpPacket.B.count);
 #endif // OLD_SYNC
 			}
 	}//all entities
 
+#ifndef OLD_SYNC
+	Device.Statistic->netServerUpdateObjects= u32(m_update_packets.size());
+	Device.Statistic->netServerUpdateBytes	= u32(m_update_arena.size());
+#endif // !OLD_SYNC
+
 	m_updator.end_updates			(m_update_begin, m_update_end);
 }
 
@@ -390,6 +397,20 @@ void xrServer::SendUpdatePacketsToAll()
 		SenderFunctor(xrServer* owner, xr_vector<UpdatePacket> &packets, server_updates_compressor* updator, u32 dwFlags) :
 			m_owner(owner), m_packets(packets), m_updator(updator), m_dwFlags(dwFlags)
 		{}
+		void write_update(xrClientData* CL, u16 const id, u8 const* data, u32 const size)
+		{
+			if (!(g_sv_traffic_optimization_level & eto_delta_updates))
+			{
+				CL->m_update_baselines.add_raw_traffic(size);
+				m_updator->write_update_for(id, data, size);
+				return;
+			}
+			// the baselines keep the update itself, without the u16 id + u8 size header
+			u32 const header_size	= sizeof(u16) + sizeof(u8);
+			u8 encoded[sizeof(u16) + sizeof(u8)*2 + 256 + 32];
+			u32 const encoded_size	= CL->m_update_baselines.encode(id, data + header_size, size - header_size, encoded);
+			m_updator->write_update_for(id, encoded, encoded_size);
+		}
 		void operator()(IClient* client)
 		{
 			auto I = m_packets.begin();
@@ -411,14 +432,20 @@ void xrServer::SendUpdatePacketsToAll()
 			constexpr float distance_300 = 300.f * 300.f;
 
 			// create big net packets & compress (if enabled)
-			m_updator->begin_updates();
+			u16 delta_seq	= update_snapshots::invalid_seq;
+			u16 delta_base	= update_snapshots::invalid_seq;
+			if (g_sv_traffic_optimization_level & eto_delta_updates)
+				CL->m_update_baselines.begin_snapshot(delta_seq, delta_base);
+
+			m_updator->begin_updates(delta_seq, delta_base);
 			for (; I != E; ++I)
 			{
 				CSE_Abstract* owner = CL->owner;
 				if (!owner) continue;
 
 				CSE_Abstract*	entity = I->Entity;
-				NET_Packet& packet = I->Packet;
+				u8 const* data = m_owner->update_data(*I);
+				u32 const size = I->Size;
 
 				float distance = 0.f;
 
@@ -445,23 +472,23 @@ void xrServer::SendUpdatePacketsToAll()
 
 					if (distance <= distance_50)
 					{
-						m_updator->write_update_for(entity->ID, packet);
+						write_update(CL, entity->ID, data, size);
 					}
 					else if (need_to_update_15 && distance <= distance_100)
 					{
-						m_updator->write_update_for(entity->ID, packet);
+						write_update(CL, entity->ID, data, size);
 					}
 					else if (need_to_update_10 && distance <= distance_200)
 					{
-						m_updator->write_update_for(entity->ID, packet);
+						write_update(CL, entity->ID, data, size);
 					}
 					else if (need_to_update_5 && distance <= distance_300)
 					{
-						m_updator->write_update_for(entity->ID, packet);
+						write_update(CL, entity->ID, data, size);
 					}
 					else if (need_to_update_05)
 					{
-						m_updator->write_update_for(entity->ID, packet);
+						write_update(CL, entity->ID, data, size);
 					}
 				}
 				else if (entity->cast_actor_mp()) 
@@ -473,15 +500,15 @@ void xrServer::SendUpdatePacketsToAll()
 
 					if (distance <= distance_200)
 					{
-						m_updator->write_update_for(entity->ID, packet);
+						write_update(CL, entity->ID, data, size);
 					}
 					else if (need_to_update_10 && distance <= distance_300)
 					{
-						m_updator->write_update_for(entity->ID, packet);
+						write_update(CL, entity->ID, data, size);
 					}
 					else if (need_to_update_1)
 					{
-						m_updator->write_update_for(entity->ID, packet);
+						write_update(CL, entity->ID, data, size);
 					}
 				}
 				else if (entity->cast_item_artefact())
@@ -493,15 +520,15 @@ void xrServer::SendUpdatePacketsToAll()
 
 					if (need_to_update_10 && distance <= distance_30)
 					{
-						m_updator->write_update_for(entity->ID, packet);
+						write_update(CL, entity->ID, data, size);
 					}
 					else if (need_to_update_5 && distance <= distance_60)
 					{
-						m_updator->write_update_for(entity->ID, packet);
+						write_update(CL, entity->ID, data, size);
 					}
 					else if (need_to_update_05)
 					{
-						m_updator->write_update_for(entity->ID, packet);
+						write_update(CL, entity->ID, data, size);
 					}
 				}
 				else if (entity->cast_inventory_item())
@@ -515,27 +542,27 @@ void xrServer::SendUpdatePacketsToAll()
 
 						if (distance <= distance_200)
 						{
-							m_updator->write_update_for(entity->ID, packet);
+							write_update(CL, entity->ID, data, size);
 						}
 						else if (need_to_update_10 && distance <= distance_300)
 						{
-							m_updator->write_update_for(entity->ID, packet);
+							write_update(CL, entity->ID, data, size);
 						}
 						else if (need_to_update_1)
 						{
-							m_updator->write_update_for(entity->ID, packet);
+							write_update(CL, entity->ID, data, size);
 						}
 					}
 					else
 					{
 						//    ,       .
 						//      (    ).
-						m_updator->write_update_for(entity->ID, packet);
+						write_update(CL, entity->ID, data, size);
 					}
 				}
 				else
 				{
-					m_updator->write_update_for(entity->ID, packet);
+					write_update(CL, entity->ID, data, size);
 				}
 			} // end for
 
@@ -555,6 +582,7 @@ void xrServer::SendUpdatePacketsToAll()
 				CL->m_last_update_time_05 = Device.dwTimeGlobal;
 
 			m_updator->end_updates(m_update_begin, m_update_end);
+			CL->m_update_baselines.end_snapshot();
 
 			// send packets to client
 			for (update_iterator_t i = m_update_begin; i != m_update_end; ++i)
@@ -562,6 +590,7 @@ void xrServer::SendUpdatePacketsToAll()
 				NET_Packet& P = **i;
 				if (P.B.count > 2)
 				{
+					CL->m_update_baselines.add_wire_traffic(P.B.count);
 					m_owner->SendTo_LL(client->ID, P.B.data, P.B.count, m_dwFlags);
 				}
 			}
@@ -589,8 +618,10 @@ void xrServer::SendUpdatesToAll()
 
 	if ((Device.dwTimeGlobal - m_last_update_time) >= u32(1000/psNET_ServerUpdate))
 	{
+		Device.Statistic->netServerUpdates.Begin();
 		MakeUpdatePackets				();
 		SendUpdatePacketsToAll			();
+		Device.Statistic->netServerUpdates.End();
 
 #ifdef DEBUG
 		g_sv_SendUpdate = 0;
@@ -737,6 +768,14 @@ u32 xrServer::OnMessage	(NET_Packet& P, ClientID sender)			// Non-Zero means bro
 				SendTo	(SV_Client->ID, P, net_flags(TRUE, TRUE));
 			VERIFY					(verify_entities());
 		}break;
+	case M_CL_UPDATE_ACK:
+		{
+			xrClientData* CL		= ID_to_client	(sender);
+			if (!CL)				break;
+			u16 seq					= P.r_u16();
+			u16 records				= P.r_u16();
+			CL->m_update_baselines.on_ack(seq, records);
+		}break;
 	case M_MOVE_PLAYERS_RESPOND:
 		{
 			xrClientData* CL		= ID_to_client	(sender);
@@ -1196,29 +1235,67 @@ void xrServer::create_direct_client()
 }
 
 
+bool xrServer::PopDelayedPacket(DelayedPacket*& DPacket)
+{
+	if (!m_aDelayedPacketsTaken.empty())
+	{
+		DPacket = m_aDelayedPacketsTaken.front();
+		m_aDelayedPacketsTaken.pop_front();
+		return true;
+	}
+
+	if (m_aDelayedPackets.pop(DPacket))
+		return true;
+
+	// the overflow list is taken only after everything pushed into the queue
+	// before it, a claimed but not finished push waits for the next update
+	if (0 == m_delayed_overflow_count || !m_aDelayedPackets.empty())
+		return false;
+
+	m_csDelayedPackets.Enter();
+	m_aDelayedPacketsTaken.swap(m_aDelayedPacketsOverflow);
+	InterlockedExchange(&m_delayed_overflow_count, 0);
+	m_csDelayedPackets.Leave();
+
+	if (m_aDelayedPacketsTaken.empty())
+		return false;
+
+	DPacket = m_aDelayedPacketsTaken.front();
+	m_aDelayedPacketsTaken.pop_front();
+	return true;
+}
+
 void xrServer::ProceedDelayedPackets()
 {
-	DelayedPackestCS.Enter();
-	while (!m_aDelayedPackets.empty())
+	DelayedPacket* DPacket;
+	while (PopDelayedPacket(DPacket))
 	{
-		DelayedPacket& DPacket	= *m_aDelayedPackets.begin();
-		OnDelayedMessage(DPacket.Packet, DPacket.SenderID);
-//		OnMessage(DPacket.Packet, DPacket.SenderID);
-		m_aDelayedPackets.pop_front();
+		if (ID_to_client(DPacket->SenderID))
+			OnDelayedMessage(DPacket->Packet, DPacket->SenderID);
+		else
+			Msg("removing packet from delayed event storage");
+//		OnMessage(DPacket->Packet, DPacket->SenderID);
+		if (!m_aDelayedPacketsUnused.push(DPacket))
+			xr_delete(DPacket);
 	}
-	DelayedPackestCS.Leave();
 };
 
 void xrServer::AddDelayedPacket	(NET_Packet& Packet, ClientID Sender)
 {
-	DelayedPackestCS.Enter();
-
-	m_aDelayedPackets.push_back(DelayedPacket());
-	DelayedPacket* NewPacket = &(m_aDelayedPackets.back());
+	DelayedPacket* NewPacket;
+	if (!m_aDelayedPacketsUnused.pop(NewPacket))
+		NewPacket = xr_new<DelayedPacket>();
 	NewPacket->SenderID = Sender;
-	CopyMemory	(&(NewPacket->Packet),&Packet,sizeof(NET_Packet));	
+	NewPacket->Packet.assign(Packet);
+
+	// the game thread drains the queue each update, it is full while the game thread is stalled
+	if (0 == m_delayed_overflow_count && m_aDelayedPackets.push(NewPacket))
+		return;
 
-	DelayedPackestCS.Leave();
+	m_csDelayedPackets.Enter();
+	m_aDelayedPacketsOverflow.push_back(NewPacket);
+	InterlockedIncrement(&m_delayed_overflow_count);
+	m_csDelayedPackets.Leave();
 }
 
 u32 g_sv_dwMaxClientPing		= 2000;
@@ -8,11 +8,13 @@
 #pragma once
 
 #include "../xrNetServer/Net_Server.h"
+#include "../xrNetServer/NET_QueueLockFree.h"
 #include "game_sv_base.h"
 #include "id_generator.h"
 #include "../xrEngine/mp_logging.h"
 #include "secure_messaging.h"
 #include "xrServer_updates_compressor.h"
+#include "xrServer_updates_delta.h"
 #include "xrClientsPool.h"
 #include "script_event.h"
 
@@ -58,6 +60,8 @@ public:
 	u32 m_last_update_time_1;
 	u32 m_last_update_time_05;
 
+	update_baselines		m_update_baselines;
+
 							xrClientData			();
 	virtual					~xrClientData			();
 	virtual void			Clear					();
@@ -127,26 +131,37 @@ private:
 	IReader*					m_server_logo;
 	IReader*					m_server_rules;
 
+	// update snapshot of one entity, stored as a slice of m_update_arena
+	// (most updates are < 200 bytes, so we don't keep a whole NET_Packet per entity)
 	struct UpdatePacket
 	{
 		CSE_Abstract* Entity;
-		NET_Packet	  Packet;
+		u32			  Offset;
+		u32			  Size;
 	};
 
 	xr_vector<UpdatePacket> m_update_packets;
+	xr_vector<u8>			m_update_arena;
+	IC u8 const*			update_data			(UpdatePacket const& P) const { return &m_update_arena[P.Offset]; }
 
 	struct DelayedPacket
 	{
 		ClientID		SenderID;
 		NET_Packet		Packet;
-		bool operator == (const DelayedPacket& other)
-		{
-			return SenderID == other.SenderID;
-		}
 	};
 
-	xrCriticalSection			DelayedPackestCS;
-	xr_deque<DelayedPacket>		m_aDelayedPackets;
+	// pushed by the network thread, drained by Update; the packets of a
+	// destroyed client are dropped there. A push into the full queue goes into
+	// the overflow list under the lock, and the following pushes go there too
+	// until Update takes the list, as in INetQueue
+	enum { delayed_packets_size = 256 };
+	net_queue<DelayedPacket*,delayed_packets_size>	m_aDelayedPackets;
+	net_queue<DelayedPacket*,delayed_packets_size>	m_aDelayedPacketsUnused;
+	xrCriticalSection			m_csDelayedPackets;			// overflow only
+	xr_deque<DelayedPacket*>	m_aDelayedPacketsOverflow;
+	volatile LONG				m_delayed_overflow_count;
+	xr_deque<DelayedPacket*>	m_aDelayedPacketsTaken;		// game thread side
+	bool						PopDelayedPacket		(DelayedPacket*& DPacket);
 	void						ProceedDelayedPackets	();
 	void						AddDelayedPacket		(NET_Packet& Packet, ClientID Sender);
 	u32							OnDelayedMessage		(NET_Packet& P, ClientID sender);			// Non-Zero means broadcasting with "flags" as returned
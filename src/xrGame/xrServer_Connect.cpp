@@ -115,6 +115,15 @@ void xrServer::AttachNewClient			(IClient* CL)
 	msgConfig.sign1 = 0x12071980;
 	msgConfig.sign2 = 0x26111975;
 
+	if (CL->flags.bLoopback)
+	{
+		// in-process load test client: trusted, no keys, cd-key or digest to check
+		SendTo_LL				(CL->ID,&msgConfig,sizeof(msgConfig), net_flags(TRUE, TRUE, TRUE, TRUE));
+		Check_BuildVersion_Success(CL);
+		CL->m_guid[0]=0;
+		return;
+	}
+
 	if(psNET_direct_connect) //single_game
 	{
         SV_Client			= CL;
@@ -19,20 +19,25 @@ last_updates_cache::last_updates_cache()
 }
 
 u16 last_updates_cache::add_update			(u16 const entity_id, NET_Packet const & update)
+{
+	return add_update(entity_id, update.B.data, update.B.count);
+}
+
+u16 last_updates_cache::add_update			(u16 const entity_id, void const* data, u32 const size)
 {
 	last_update_t* tmp_entity = search_entity(entity_id);
 	u32 current_time = Device.dwTimeGlobal;
 	if (!tmp_entity)
 	{
-		tmp_entity = search_most_expired(current_time, update.B.count);
+		tmp_entity = search_most_expired(current_time, size);
 		if (!tmp_entity)
 		{
 			return 0;
 		}		
 	}
 	tmp_entity->first.m_object_id	= entity_id;
-	if ((tmp_entity->second.B.count == update.B.count) &&
-		(!memcmp(tmp_entity->second.B.data, update.B.data, update.B.count)))
+	if ((tmp_entity->second.B.count == size) &&
+		(!memcmp(tmp_entity->second.B.data, data, size)))
 	{
 		++tmp_entity->first.m_eq_count;
 	} else
@@ -40,8 +45,8 @@ u16 last_updates_cache::add_update			(u16 const entity_id, NET_Packet const & up
 		tmp_entity->first.m_eq_count = 0;
 	}	
 	tmp_entity->first.m_update_time	= current_time;
-	CopyMemory(tmp_entity->second.B.data, update.B.data, update.B.count);
-	tmp_entity->second.B.count = update.B.count;
+	CopyMemory(tmp_entity->second.B.data, data, size);
+	tmp_entity->second.B.count = size;
 	return tmp_entity->first.m_eq_count;
 }
 
@@ -100,6 +105,10 @@ server_updates_compressor::server_updates_compressor()
 		m_ready_for_send.push_back(xr_new<NET_Packet>());
 	}
 
+	m_delta_seq				= u16(-1);
+	m_delta_base			= u16(-1);
+	m_acc_header_size		= 0;
+
 	m_trained_stream		= NULL;
 	m_lzo_working_memory	= NULL;
 	m_lzo_working_buffer	= NULL;
@@ -144,20 +153,49 @@ void server_updates_compressor::deinit_compression()
 	}
 }
 
-void server_updates_compressor::begin_updates()
+void server_updates_compressor::begin_updates(u16 const delta_seq, u16 const delta_base)
+{
+	m_current_update	= 0;
+	m_delta_seq			= delta_seq;
+	m_delta_base		= delta_base;
+	write_dest_header			(m_ready_for_send.front());
+	start_accumulative_buffer	();
+}
+
+void server_updates_compressor::write_dest_header(NET_Packet* dest)
+{
+	if ((g_sv_traffic_optimization_level & eto_ppmd_compression) ||
+		(g_sv_traffic_optimization_level & eto_lzo_compression))
+	{
+		dest->w_begin(M_COMPRESSED_UPDATE_OBJECTS);
+		dest->w_u8(static_cast<u8>(g_sv_traffic_optimization_level));
+		if (g_sv_traffic_optimization_level & eto_delta_updates)
+		{
+			dest->w_u16(m_delta_seq);
+			dest->w_u16(m_delta_base);
+		}
+	} else
+	{
+		dest->write_start();
+	}
+}
+
+void server_updates_compressor::start_accumulative_buffer()
 {
-	m_current_update = 0;
 	if ((g_sv_traffic_optimization_level & eto_ppmd_compression) ||
 		(g_sv_traffic_optimization_level & eto_lzo_compression))
 	{
-		m_ready_for_send.front()->w_begin(M_COMPRESSED_UPDATE_OBJECTS);
-		m_ready_for_send.front()->w_u8(static_cast<u8>(g_sv_traffic_optimization_level));
 		m_acc_buff.write_start();
+	} else if (g_sv_traffic_optimization_level & eto_delta_updates)
+	{
+		m_acc_buff.w_begin(M_DELTA_UPDATE_OBJECTS);
+		m_acc_buff.w_u16(m_delta_seq);
+		m_acc_buff.w_u16(m_delta_base);
 	} else
 	{
-		m_ready_for_send.front()->write_start();
 		m_acc_buff.w_begin(M_UPDATE_OBJECTS);
-	}	
+	}
+	m_acc_header_size = m_acc_buff.w_tell();
 }
 
 NET_Packet*	server_updates_compressor::get_current_dest()
@@ -180,14 +218,7 @@ NET_Packet*	server_updates_compressor::goto_next_dest()
 		new_dest = m_ready_for_send[m_current_update];
 	}
 
-	if (g_sv_traffic_optimization_level & eto_ppmd_compression)
-	{
-		new_dest->w_begin(M_COMPRESSED_UPDATE_OBJECTS);
-		m_ready_for_send.front()->w_u8(static_cast<u8>(g_sv_traffic_optimization_level));
-	} else
-	{
-		new_dest->write_start();
-	}
+	write_dest_header(new_dest);
 	
 	return new_dest;
 }
@@ -227,43 +258,50 @@ void server_updates_compressor::flush_accumulative_buffer()
 		{
 			dst_packet->w_u16(static_cast<u16>(m_compress_buf.B.count));
 			dst_packet->w(m_compress_buf.B.data, m_compress_buf.B.count);
-			m_acc_buff.write_start();
+			start_accumulative_buffer();
 			return;
 		}
 		dst_packet->w_u16(0);
 		dst_packet = goto_next_dest();
 		dst_packet->w_u16(static_cast<u16>(m_compress_buf.B.count));
 		dst_packet->w(m_compress_buf.B.data, m_compress_buf.B.count);
-		m_acc_buff.write_start();
+		start_accumulative_buffer();
 		return;
 	} 
 	dst_packet->w(m_acc_buff.B.data, m_acc_buff.B.count);
 	goto_next_dest();
-	m_acc_buff.w_begin(M_UPDATE_OBJECTS);
+	start_accumulative_buffer();
 }
 
 void server_updates_compressor::write_update_for(u16 const enity, NET_Packet & update)
 {
-	if (g_sv_traffic_optimization_level & eto_last_change)
+	write_update_for(enity, update.B.data, update.B.count);
+}
+
+void server_updates_compressor::write_update_for(u16 const enity, void const* data, u32 const size)
+{
+	//delta encoded updates must reach the client, the baselines rely on it
+	if ((g_sv_traffic_optimization_level & eto_last_change) &&
+		!(g_sv_traffic_optimization_level & eto_delta_updates))
 	{
 		//if (m_updates_cache.get_last_equpdates(enity, update) >= max_eq_packets)
-		if (m_updates_cache.add_update(enity, update) >= max_eq_packets)
+		if (m_updates_cache.add_update(enity, data, size) >= max_eq_packets)
 		{
 			return;
 		}
 	}
 	//(sizeof(u16)*2 + 1) ::= w_begin(2) + compress_type(1) + zero_end(2)
-	if (m_acc_buff.w_tell() + update.w_tell() + (sizeof(u16)*2 + 1) >= sizeof(m_acc_buff.B.data))
+	if (m_acc_buff.w_tell() + size + (sizeof(u16)*2 + 1) >= sizeof(m_acc_buff.B.data))
 	{
 		flush_accumulative_buffer();
 	}
-	m_acc_buff.w(update.B.data, update.B.count);
+	m_acc_buff.w(data, size);
 }
 
 void server_updates_compressor::end_updates(send_ready_updates_t::const_iterator & b,
 											send_ready_updates_t::const_iterator & e)
 {
-	if (m_acc_buff.w_tell() > 2)
+	if (m_acc_buff.w_tell() > m_acc_header_size)
 		flush_accumulative_buffer();
 	
 	if ((g_sv_traffic_optimization_level & eto_ppmd_compression) ||
@@ -20,6 +20,7 @@ public:
 			~last_updates_cache	()	{};
 
 	u16		add_update			(u16 const entity_id, NET_Packet const & update);
+	u16		add_update			(u16 const entity_id, void const* data, u32 const size);
 	u16		get_last_equpdates	(u16 const entity_id, NET_Packet const & update);
 private:
 	last_update_t*	search_entity		(u16 const entity_id);
@@ -37,8 +38,10 @@ public:
 
 	typedef xr_vector<NET_Packet*>	send_ready_updates_t;
 
-	void	begin_updates		();
+	//delta_seq/delta_base are written to the header when eto_delta_updates is active
+	void	begin_updates		(u16 const delta_seq = u16(-1), u16 const delta_base = u16(-1));
 	void	write_update_for	(u16 const enity, NET_Packet & update);
+	void	write_update_for	(u16 const enity, void const* data, u32 const size);
 	void	end_updates			(send_ready_updates_t::const_iterator & b,
 								 send_ready_updates_t::const_iterator & e);
 private:
@@ -66,9 +69,15 @@ private:
 	void			init_compression			();
 	void			deinit_compression			();
 
+	u16								m_delta_seq;
+	u16								m_delta_base;
+	u32								m_acc_header_size;
+
 	void			flush_accumulative_buffer	();
 	NET_Packet*		get_current_dest			();
 	NET_Packet*		goto_next_dest				();
+	void			write_dest_header			(NET_Packet* dest);
+	void			start_accumulative_buffer	();
 
 	IWriter*		dbg_update_bins_writer;
 	void			create_update_bin_writer	();	
@@ -0,0 +1,354 @@
+#include "stdafx.h"
+#include "level.h"
+#include "xrServer_updates_delta.h"
+#include "xrMessages.h"
+#include "../xrEngine/xr_object_list.h"
+
+update_snapshots::update_snapshots()
+{
+	clear();
+}
+
+void update_snapshots::clear()
+{
+	for (u32 i = 0; i < snapshots_count; ++i)
+	{
+		m_snapshots[i].seq		= invalid_seq;
+		m_snapshots[i].acked	= false;
+		m_snapshots[i].sorted	= true;
+		m_snapshots[i].entries.clear();
+		m_snapshots[i].data.clear();
+	}
+}
+
+update_snapshots::snapshot* update_snapshots::find(u16 const seq)
+{
+	if (seq == invalid_seq)
+		return NULL;
+	snapshot& tmp_snapshot = m_snapshots[seq % snapshots_count];
+	return (tmp_snapshot.seq == seq) ? &tmp_snapshot : NULL;
+}
+
+update_snapshots::snapshot& update_snapshots::start(u16 const seq)
+{
+	VERIFY(seq != invalid_seq);
+	snapshot& tmp_snapshot	= m_snapshots[seq % snapshots_count];
+	tmp_snapshot.seq		= seq;
+	tmp_snapshot.acked		= false;
+	tmp_snapshot.sorted		= true;
+	tmp_snapshot.entries.clear();
+	tmp_snapshot.data.clear();
+	return tmp_snapshot;
+}
+
+void update_snapshots::add(snapshot & dest, u16 const id, u8 const* data, u8 const size)
+{
+	entry tmp_entry;
+	tmp_entry.id		= id;
+	tmp_entry.size		= size;
+	tmp_entry.offset	= u32(dest.data.size());
+	if (!dest.entries.empty() && (id < dest.entries.back().id))
+		dest.sorted		= false;
+	dest.entries.push_back(tmp_entry);
+	dest.data.insert	(dest.data.end(), data, data + size);
+}
+
+update_snapshots::entry const* update_snapshots::search(snapshot & src, u16 const id)
+{
+	if (!src.sorted)
+	{
+		std::sort		(src.entries.begin(), src.entries.end());
+		src.sorted		= true;
+	}
+	entry tmp_entry;
+	tmp_entry.id		= id;
+	xr_vector<entry>::const_iterator it = std::lower_bound(src.entries.begin(), src.entries.end(), tmp_entry);
+	if ((it == src.entries.end()) || (it->id != id))
+		return NULL;
+	return &*it;
+}
+
+//-----------------------------------------------------------------------------
+
+update_baselines::update_baselines()
+#ifdef PROFILE_CRITICAL_SECTIONS
+	: m_acks_lock(MUTEX_PROFILE_ID(update_baselines::m_acks_lock))
+#endif // PROFILE_CRITICAL_SECTIONS
+{
+	m_next_seq			= 0;
+	m_acked_seq			= invalid_seq;
+	m_current			= NULL;
+	m_base				= NULL;
+	m_stat_start_time	= Device.dwTimeGlobal;
+	m_raw_bytes			= 0;
+	m_delta_bytes		= 0;
+	m_wire_bytes		= 0;
+}
+
+void update_baselines::clear()
+{
+	update_snapshots::clear();
+	m_next_seq			= 0;
+	m_acked_seq			= invalid_seq;
+	m_current			= NULL;
+	m_base				= NULL;
+	m_acks_lock.Enter	();
+	m_acks.clear		();
+	m_acks_lock.Leave	();
+}
+
+void update_baselines::begin_snapshot(u16 & seq, u16 & base)
+{
+	VERIFY				(!m_current);
+
+	m_acks_lock.Enter	();
+	m_acks_taken.swap	(m_acks);
+	m_acks_lock.Leave	();
+	for (u32 i = 0; i < m_acks_taken.size(); ++i)
+		apply_ack		(m_acks_taken[i]);
+	m_acks_taken.clear	();
+
+	seq					= m_next_seq;
+	++m_next_seq;
+	if (m_next_seq == invalid_seq)
+		m_next_seq		= 0;
+
+	m_base				= find(m_acked_seq);
+	// the baseline is too old if the new snapshot is going to reuse its slot
+	if (m_base && (!m_base->acked || (m_base == &m_snapshots[seq % snapshots_count])))
+		m_base			= NULL;
+
+	base				= m_base ? m_base->seq : invalid_seq;
+	m_current			= &start(seq);
+}
+
+u32 update_baselines::encode(u16 const id, u8 const* data, u32 const size, u8* dest)
+{
+	VERIFY				(m_current);
+	VERIFY				(size < 256);
+	u8 const tmp_size	= static_cast<u8>(size);
+	entry const* base	= m_base ? search(*m_base, id) : NULL;
+
+	add					(*m_current, id, data, tmp_size);
+	m_raw_bytes			+= sizeof(u16) + sizeof(u8) + size;
+
+	u8* ptr				= dest;
+	*(u16*)ptr			= id;			ptr += sizeof(u16);
+	if (!base)
+	{
+		*ptr++			= eum_raw;
+		*ptr++			= tmp_size;
+		CopyMemory		(ptr, data, size);
+		ptr				+= size;
+		m_delta_bytes	+= u32(ptr - dest);
+		return			u32(ptr - dest);
+	}
+
+	u8 const* base_data	= &m_base->data[base->offset];
+	if ((base->size == tmp_size) && !memcmp(base_data, data, size))
+	{
+		*ptr++			= eum_same;
+		m_delta_bytes	+= u32(ptr - dest);
+		return			u32(ptr - dest);
+	}
+
+	u32 const mask_size	= (size + 7) >> 3;
+	u8* mode			= ptr++;
+	*ptr++				= tmp_size;
+	u8* mask			= ptr;
+	u8* changed			= mask + mask_size;
+	ZeroMemory			(mask, mask_size);
+	for (u32 i = 0; i < size; ++i)
+	{
+		if ((i < base->size) && (base_data[i] == data[i]))
+			continue;
+		mask[i >> 3]	|= u8(1 << (i & 7));
+		*changed++		= data[i];
+	}
+
+	if (mask_size + u32(changed - (mask + mask_size)) >= size)
+	{
+		// delta is not smaller than the update itself
+		*mode			= eum_raw;
+		CopyMemory		(ptr, data, size);
+		ptr				+= size;
+	} else
+	{
+		*mode			= eum_delta;
+		ptr				= changed;
+	}
+	m_delta_bytes		+= u32(ptr - dest);
+	return				u32(ptr - dest);
+}
+
+void update_baselines::end_snapshot()
+{
+	m_current			= NULL;
+	m_base				= NULL;
+}
+
+// network thread
+void update_baselines::on_ack(u16 const seq, u16 const records)
+{
+	ack tmp_ack;
+	tmp_ack.seq			= seq;
+	tmp_ack.records		= records;
+	m_acks_lock.Enter	();
+	m_acks.push_back	(tmp_ack);
+	m_acks_lock.Leave	();
+}
+
+void update_baselines::apply_ack(ack const & A)
+{
+	u16 const seq		= A.seq;
+	u16 const records	= A.records;
+	snapshot* tmp_snapshot = find(seq);
+	if (!tmp_snapshot || (tmp_snapshot == m_current))
+		return;
+	// partially received snapshots (lost packets) can't be a baseline
+	if (tmp_snapshot->entries.size() != records)
+		return;
+
+	tmp_snapshot->acked	= true;
+	u16 const distance	= u16(seq - m_acked_seq);
+	if ((m_acked_seq == invalid_seq) || (distance < 0x8000))
+		m_acked_seq		= seq;
+}
+
+void update_baselines::dump_traffic(LPCSTR client_name, bool reset)
+{
+	u32 const current_time	= Device.dwTimeGlobal;
+	float const seconds		= _max(float(current_time - m_stat_start_time) / 1000.f, 0.001f);
+	Msg("- %-24s raw: %8.1f B/s, delta: %8.1f B/s (%3.0f%%), wire: %8.1f B/s",
+		client_name,
+		float(m_raw_bytes) / seconds,
+		float(m_delta_bytes) / seconds,
+		m_raw_bytes ? 100.f * float(m_delta_bytes) / float(m_raw_bytes) : 0.f,
+		float(m_wire_bytes) / seconds);
+	if (reset)
+	{
+		m_stat_start_time	= current_time;
+		m_raw_bytes			= 0;
+		m_delta_bytes		= 0;
+		m_wire_bytes		= 0;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+update_baselines_receiver::update_baselines_receiver()
+{
+	m_receiving_seq		= invalid_seq;
+}
+
+void update_baselines_receiver::clear()
+{
+	update_snapshots::clear();
+	m_receiving_seq		= invalid_seq;
+}
+
+void update_baselines_receiver::import(NET_Packet & src, u16 const seq, u16 const base, CObjectList & objects)
+{
+	snapshot* base_snapshot	= find(base);
+	snapshot* dest			= find(seq);
+	// a slot left with the same sequence by an older snapshot is replaced,
+	// only the packets of the snapshot being received are appended
+	if (!dest || (seq != m_receiving_seq))
+		dest				= &start(seq);
+	m_receiving_seq			= seq;
+
+	NET_Packet	tmp_packet;
+	tmp_packet.write_start	();
+	u8			tmp_data[256];
+
+	while (!src.r_eof())
+	{
+		u16 id;		src.r_u16	(id);
+		u8 mode;	src.r_u8	(mode);
+		u8 size		= 0;
+		bool valid	= true;
+
+		switch (mode)
+		{
+		case eum_same:
+			{
+				entry const* base_entry = base_snapshot ? search(*base_snapshot, id) : NULL;
+				if (!base_entry)
+				{
+					valid	= false;
+					break;
+				}
+				size		= base_entry->size;
+				if (size)
+					CopyMemory(tmp_data, &base_snapshot->data[base_entry->offset], size);
+			}break;
+		case eum_raw:
+			{
+				src.r_u8	(size);
+				if (size)
+					src.r	(tmp_data, size);
+			}break;
+		case eum_delta:
+			{
+				src.r_u8	(size);
+				u8 mask[32];
+				u32 const mask_size = (u32(size) + 7) >> 3;
+				src.r		(mask, mask_size);
+				entry const* base_entry = base_snapshot ? search(*base_snapshot, id) : NULL;
+				u8 const* base_data = base_entry ? &base_snapshot->data[base_entry->offset] : NULL;
+				for (u32 i = 0; i < size; ++i)
+				{
+					if (mask[i >> 3] & (1 << (i & 7)))
+					{
+						src.r_u8(tmp_data[i]);
+					} else if (base_entry && (i < base_entry->size))
+					{
+						tmp_data[i]	= base_data[i];
+					} else
+					{
+						valid		= false;
+					}
+				}
+			}break;
+		default:
+			{
+				Msg("! ERROR: bad delta update record mode [%d]", mode);
+				return;
+			}
+		}
+		if (!valid)
+			continue;
+
+		add(*dest, id, tmp_data, size);
+
+		if (tmp_packet.w_tell() + sizeof(u16) + sizeof(u8) + size >= sizeof(tmp_packet.B.data))
+		{
+			tmp_packet.r_seek	(0);
+			objects.net_Import	(&tmp_packet);
+			tmp_packet.write_start();
+		}
+		tmp_packet.w_u16		(id);
+		tmp_packet.w_u8			(size);
+		if (size)
+			tmp_packet.w		(tmp_data, size);
+	}
+
+	if (tmp_packet.w_tell())
+	{
+		tmp_packet.r_seek		(0);
+		objects.net_Import		(&tmp_packet);
+	}
+}
+
+void update_baselines_receiver::send_ack(u16 const seq)
+{
+	snapshot* tmp_snapshot	= find(seq);
+	if (!tmp_snapshot)
+		return;
+
+	NET_Packet				P;
+	P.w_begin				(M_CL_UPDATE_ACK);
+	P.w_u16					(seq);
+	P.w_u16					(static_cast<u16>(tmp_snapshot->entries.size()));
+	Level().Send			(P, net_flags(FALSE));
+}
@@ -0,0 +1,120 @@
+#ifndef XRSERVER_UPDATES_DELTA_INCLUDED
+#define XRSERVER_UPDATES_DELTA_INCLUDED
+
+// Delta encoding of entity updates (eto_delta_updates) against the last
+// snapshot the client has acknowledged.
+//
+// Every update tick the server assigns a sequence number to the snapshot sent
+// to a client. The client reconstructs the full updates, keeps them under the
+// same sequence and answers with M_CL_UPDATE_ACK. The next snapshots are encoded
+// against the newest acknowledged one. Record format:
+//
+//   u16 id | u8 mode | mode data
+//     eum_same  : -                                         (equal to baseline)
+//     eum_raw   : u8 size | data[size]                      (no baseline)
+//     eum_delta : u8 size | u8 mask[(size+7)/8] | changed   (one mask bit per byte)
+
+class CObjectList;
+
+class update_snapshots : private boost::noncopyable
+{
+public:
+	static u16 const	invalid_seq		= u16(-1);
+	static u32 const	snapshots_count	= 16;
+
+	enum enum_update_mode
+	{
+		eum_same	= 0,
+		eum_raw,
+		eum_delta,
+	};
+
+	struct entry
+	{
+		u16		id;
+		u8		size;
+		u32		offset;
+		bool operator < (entry const & other) const { return id < other.id; }
+	};
+
+	struct snapshot
+	{
+		u16					seq;
+		bool				acked;
+		bool				sorted;
+		xr_vector<entry>	entries;
+		xr_vector<u8>		data;
+	};
+
+				update_snapshots	();
+
+	void		clear				();
+
+protected:
+	snapshot*	find				(u16 const seq);
+	snapshot&	start				(u16 const seq);
+	void		add					(snapshot & dest, u16 const id, u8 const* data, u8 const size);
+	entry const*search				(snapshot & src, u16 const id);
+
+	snapshot	m_snapshots			[snapshots_count];
+};//class update_snapshots
+
+// server side, one per client; the snapshots are touched by the game thread
+// only, the acks come from the network thread and are applied by begin_snapshot
+class update_baselines : public update_snapshots
+{
+public:
+				update_baselines	();
+
+	void		clear				();
+	void		begin_snapshot		(u16 & seq, u16 & base);
+	//returns encoded record size, dest must hold at least 4 + size + (size+7)/8 bytes
+	u32			encode				(u16 const id, u8 const* data, u32 const size, u8* dest);
+	void		end_snapshot		();
+	void		on_ack				(u16 const seq, u16 const records);
+
+	void		add_raw_traffic		(u32 const raw_bytes) { m_raw_bytes += raw_bytes; m_delta_bytes += raw_bytes; }
+	void		add_wire_traffic	(u32 const wire_bytes) { m_wire_bytes += wire_bytes; }
+	void		dump_traffic		(LPCSTR client_name, bool reset);
+private:
+	struct ack
+	{
+		u16		seq;
+		u16		records;
+	};
+
+	void		apply_ack			(ack const & A);
+
+	u16			m_next_seq;
+	u16			m_acked_seq;
+	snapshot*	m_current;
+	snapshot*	m_base;
+
+	xrCriticalSection	m_acks_lock;
+	xr_vector<ack>		m_acks;				// received, not applied yet
+	xr_vector<ack>		m_acks_taken;
+
+	// traffic statistics since last reset
+	u32			m_stat_start_time;
+	u64			m_raw_bytes;
+	u64			m_delta_bytes;
+	u64			m_wire_bytes;
+};//class update_baselines
+
+// client side
+class update_baselines_receiver : public update_snapshots
+{
+public:
+				update_baselines_receiver	();
+
+	// on connect, the baselines of the previous session don't match the server's
+	void		clear				();
+	// decodes all records of src into full updates and imports them into objects
+	void		import				(NET_Packet & src, u16 const seq, u16 const base, CObjectList & objects);
+	void		send_ack			(u16 const seq);
+private:
+	// the snapshot being received, its next packets append to it
+	u16			m_receiving_seq;
+};//class update_baselines_receiver
+
+#endif//#ifndef XRSERVER_UPDATES_DELTA_INCLUDED
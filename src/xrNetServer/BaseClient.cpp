@@ -147,7 +147,6 @@ void BaseClient::Disconnect()
 void BaseClient::OnMessage(void * data, u32 size)
 {
 	// One of the messages - decompress it
-	net_Queue.Lock();
 	NET_Packet* P = net_Queue.Create();
 
 	P->construct(data, size);
@@ -155,7 +154,7 @@ void BaseClient::OnMessage(void * data, u32 size)
 
 	u16 m_type;
 	P->r_begin(m_type);
-	net_Queue.Unlock();
+	net_Queue.Push(P);
 }
 
 #pragma endregion
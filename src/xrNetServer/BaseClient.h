@@ -112,10 +112,11 @@ public:
 	void                net_Syncronize();
 
 	// receive
-	IC void							StartProcessQueue() { net_Queue.Lock(); }; // WARNING ! after Start mast be End !!! <-
+	IC void							StartProcessQueue() { net_Queue.BeginBatch(); }; // WARNING ! after Start mast be End !!! <-
 	IC NET_Packet*			net_msg_Retreive() { return net_Queue.Retreive(); };//							|
 	IC void							net_msg_Release() { net_Queue.Release(); };//							|
-	IC void							EndProcessQueue() { net_Queue.Unlock(); };//							<-
+	IC void							EndProcessQueue() { net_Queue.EndBatch(); };//							<-
+	IC const INetQueue::Statistic&	net_msg_Statistic() const { return net_Queue.GetStatistic(); };
 
 	// send
 	virtual	void			  Send(NET_Packet& P, u32 dwFlags = DPNSEND_GUARANTEED, u32 dwTimeout = 0);
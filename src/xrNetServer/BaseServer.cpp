@@ -2,6 +2,7 @@
 #include "BaseServer.h"
 #include "IBannedClient.h"
 #include "IClient.h"
+#include "LoopbackClient.h"
 #include "NET_Log.h"
 
 
@@ -14,15 +15,20 @@ XRNETSERVER_API BOOL psNET_direct_connect = FALSE;
 
 static	INetLog* pSvNetLog = NULL;
 
+// ids of loopback clients, above the range transports hand out in practice
+static const u32 loopback_id_base = 0xf0000000;
+
 // -----------------------------------------------------------------------------
 
 BaseServer::BaseServer(CTimer* timer, BOOL	Dedicated)
 	: m_bDedicated(Dedicated)
 #ifdef PROFILE_CRITICAL_SECTIONS
 	, csMessage(MUTEX_PROFILE_ID(BaseServer::csMessage))
+	, csLoopback(MUTEX_PROFILE_ID(BaseServer::csLoopback))
 #endif // PROFILE_CRITICAL_SECTIONS
 {
 	SV_Client = NULL;
+	loopback_next_id = 0;
 	device_timer = timer;
 	stats.clear();
 	stats.dwSendTime = TimeGlobal(device_timer);
@@ -437,6 +443,12 @@ void BaseServer::SendTo_LL(ClientID ID, void* data, u32 size, u32 dwFlags, u32 d
 #endif
 */
 
+	if (loopback_Deliver(ID, data, size))
+	{
+		stats.bytes_out += size;
+		return;
+	}
+
 	_SendTo_LL(ID, data, size, dwFlags, dwTimeout);
 }
 
@@ -490,6 +502,115 @@ void BaseServer::SendBroadcast(ClientID exclude, NET_Packet& P, u32 dwFlags)
 
 // -----------------------------------------------------------------------------
 
+#pragma region loopback
+
+// csLoopback is taken under csPlayers (broadcasts), never the other way round.
+// A loopback client only queues what it is delivered, so delivering under
+// csLoopback keeps the client alive until loopback_Disconnect has removed it.
+
+bool BaseServer::loopback_Find(ClientID ID)
+{
+	if (loopback_clients.empty())
+		return false;
+
+	bool result = false;
+	csLoopback.Enter();
+	for (u32 it = 0; it < loopback_clients.size(); ++it)
+	{
+		if (loopback_clients[it]->GetClientID() == ID)
+		{
+			result = true;
+			break;
+		}
+	}
+	csLoopback.Leave();
+	return result;
+}
+
+bool BaseServer::loopback_Deliver(ClientID ID, const void* data, u32 size)
+{
+	if (loopback_clients.empty())
+		return false;
+
+	bool result = false;
+	csLoopback.Enter();
+	for (u32 it = 0; it < loopback_clients.size(); ++it)
+	{
+		if (loopback_clients[it]->GetClientID() == ID)
+		{
+			loopback_clients[it]->Deliver(data, size);
+			result = true;
+			break;
+		}
+	}
+	csLoopback.Leave();
+	return result;
+}
+
+ClientID BaseServer::loopback_Connect(LoopbackClient* C, LPCSTR name)
+{
+	SClientConnectData cl_data;
+	xr_strcpy(cl_data.name, name);
+	cl_data.process_id = GetCurrentProcessId();
+
+	cl_data.clientID.set(loopback_id_base + (u32(InterlockedIncrement(&loopback_next_id)) & 0x0fffffff));
+	C->SetClientID(cl_data.clientID);
+	csLoopback.Enter();
+	loopback_clients.push_back(C);
+	csLoopback.Leave();
+
+	IClient* CL = new_client(&cl_data);
+	if (!CL)
+	{
+		loopback_Disconnect(cl_data.clientID);
+		return ClientID();
+	}
+	CL->flags.bLoopback = TRUE;
+
+	Msg("- [BaseServer] loopback client [%s] connected, id 0x%08x", name, cl_data.clientID.value());
+	return cl_data.clientID;
+}
+
+void BaseServer::loopback_Disconnect(ClientID ID)
+{
+	csLoopback.Enter();
+	xr_vector<LoopbackClient*>::iterator it = loopback_clients.begin();
+	for (; it != loopback_clients.end(); ++it)
+	{
+		if ((*it)->GetClientID() == ID)
+			break;
+	}
+	if (it == loopback_clients.end())
+	{
+		csLoopback.Leave();
+		return;
+	}
+	LoopbackClient* loopback = *it;
+	loopback_clients.erase(it);
+	loopback->m_server = NULL;
+	loopback->net_Disconnected = TRUE;
+	csLoopback.Leave();
+
+	IClient* CL = GetClientByID(ID);
+	if (CL)
+	{
+		CL->flags.bConnected = FALSE;
+		CL->flags.bReconnect = FALSE;
+		OnCL_Disconnected(CL);
+		client_Destroy(CL);
+	}
+}
+
+void BaseServer::loopback_Recieve(ClientID ID, const void* data, u32 size)
+{
+	stats.bytes_in += size;
+	MultipacketReciever::RecievePacket(data, size, ID.value());
+}
+
+#pragma endregion
+
+// -----------------------------------------------------------------------------
+
 #pragma region receive
 
 void BaseServer::_Recieve(const void* data, u32 data_size, u32 param)
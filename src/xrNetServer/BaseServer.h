@@ -7,6 +7,7 @@
 
 class CServerInfo;
 class IBannedClient;
+class LoopbackClient;
 struct ip_address;
 
 // -----------------------------------------------------------------------------
@@ -82,6 +83,11 @@ protected:
 	IServerStatistic		stats;
 	CTimer*							device_timer;
 
+	// in-process clients, see LoopbackClient
+	xrCriticalSection		csLoopback;
+	xr_vector<LoopbackClient*>	loopback_clients;
+	volatile LONG						loopback_next_id;
+
 public:
 	BaseServer(CTimer* timer, BOOL	Dedicated);
 	virtual ~BaseServer();
@@ -142,6 +148,13 @@ public:
 	virtual void			  SendTo_Buf(ClientID ID, void* data, u32 size, u32 dwFlags = DPNSEND_GUARANTEED, u32 dwTimeout = 0);
 	virtual void			  Flush_Clients_Buffers();
 
+	// loopback transport, the transports ask for loopback clients before their own connections
+	ClientID				    loopback_Connect(LoopbackClient* C, LPCSTR name);
+	void					      loopback_Disconnect(ClientID ID);
+	void					      loopback_Recieve(ClientID ID, const void* data, u32 size);
+	bool					      loopback_Find(ClientID ID);
+	bool					      loopback_Deliver(ClientID ID, const void* data, u32 size);
+
 	void					      SendTo(ClientID ID, NET_Packet& P, u32 dwFlags = DPNSEND_GUARANTEED, u32 dwTimeout = 0);
 	void					      SendBroadcast_LL(ClientID exclude, void* data, u32 size, u32 dwFlags = DPNSEND_GUARANTEED);
 	virtual void			  SendBroadcast(ClientID exclude, NET_Packet& P, u32 dwFlags = DPNSEND_GUARANTEED);
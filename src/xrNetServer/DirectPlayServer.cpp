@@ -331,6 +331,14 @@ void DirectPlayServer::UpdateClientStatistic(IClient* C)
 
 bool DirectPlayServer::GetClientAddress(ClientID ID, ip_address& Address, DWORD* pPort)
 {
+	if (loopback_Find(ID))
+	{
+		Address.set("127.0.0.1");
+		if (pPort != NULL)
+			*pPort = 0;
+		return true;
+	}
+
 	IDirectPlay8Address* pClAddr = NULL;
 	CHK_DX(NET->GetClientAddress(ID.value(), &pClAddr, 0));
 
@@ -367,6 +375,12 @@ bool DirectPlayServer::DisconnectClient(IClient* C, LPCSTR Reason)
 {
 	if (!C) return false;
 
+	if (loopback_Find(C->ID))
+	{
+		loopback_Disconnect(C->ID);
+		return true;
+	}
+
 	HRESULT res = NET->DestroyClient(C->ID.value(), Reason, xr_strlen(Reason) + 1, 0);
 	CHK_DX(res);
 	return true;
@@ -376,6 +390,12 @@ bool DirectPlayServer::DisconnectClient(IClient* C, LPCSTR Reason)
 
 bool DirectPlayServer::GetClientPendingMessagesCount(ClientID ID, DWORD & dwPending)
 {
+	if (loopback_Find(ID))
+	{
+		dwPending = 0;
+		return true;
+	}
+
 	HRESULT hr = NET->GetSendQueueInfo(ID.value(), &dwPending, 0, 0);
 	return !FAILED(hr);
 }
@@ -9,6 +9,7 @@ IClient::IClient(CTimer* timer): stats(timer), server(NULL)
 	flags.bConnected = FALSE;
 	flags.bReconnect = FALSE;
 	flags.bVerified = TRUE;
+	flags.bLoopback = FALSE;
 }
 
 IClient::~IClient()
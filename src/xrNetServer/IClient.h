@@ -14,6 +14,7 @@ public:
 		u32		bConnected : 1;
 		u32		bReconnect : 1;
 		u32		bVerified : 1;
+		u32		bLoopback : 1;	// in-process LoopbackClient
 	};
 
 	IClient(CTimer* timer);
@@ -1,115 +1,183 @@
 #include "stdafx.h"
 #include "INetQueue.h"
 
-static u32 LastTimeCreate = 0;
+// the recycled packets above 32 are freed when no packet was allocated for a minute
+static u32 const	unused_keep			= 32;
+static u32 const	unused_keep_time	= 60000;
 
 INetQueue::INetQueue()
 #ifdef PROFILE_CRITICAL_SECTIONS
 	:cs(MUTEX_PROFILE_ID(INetQueue))
 #endif // PROFILE_CRITICAL_SECTIONS
 {
-	unused.reserve(128);
+	unused_count		= 0;
+	pending				= 0;
+	last_time_create	= 0;
+	overflow_count		= 0;
+	current_valid		= false;
+	batch_left			= 0;
+	batch_done			= 0;
+	ResetStatistic		();
+
 	for (int i = 0; i < 16; i++)
-		unused.push_back(xr_new<NET_Packet>());
+		Recycle(xr_new<NET_Packet>());
 }
 
 INetQueue::~INetQueue()
 {
-	cs.Enter();
-	u32				it;
-	for (it = 0; it < unused.size(); it++)	xr_delete(unused[it]);
-	for (it = 0; it < ready.size(); it++)	xr_delete(ready[it]);
-	cs.Leave();
+	NET_Packet*	P;
+	while (unused.pop(P))		xr_delete(P);
+
+	entry		E;
+	while (ready.pop(E))		xr_delete(E.packet);
+
+	u32			it;
+	for (it = 0; it < overflow.size(); it++)		xr_delete(overflow[it].packet);
+	for (it = 0; it < overflow_taken.size(); it++)	xr_delete(overflow_taken[it].packet);
+	if (current_valid)			xr_delete(current.packet);
 }
 
 NET_Packet*		INetQueue::Create()
 {
 	NET_Packet*	P = 0;
-	//cs.Enter		();
-//#ifdef _DEBUG
-//		Msg ("- INetQueue::Create - ready %d, unused %d", ready.size(), unused.size());
-//#endif
-	if (unused.empty())
+	if (unused.pop(P))
+		InterlockedDecrement(&unused_count);
+	else
 	{
-		ready.push_back(xr_new<NET_Packet>());
-		P = ready.back();
+		P = xr_new<NET_Packet>();
 		//---------------------------------------------
-		LastTimeCreate = GetTickCount();
+		last_time_create = GetTickCount();
 		//---------------------------------------------
 	}
-	else {
-		ready.push_back(unused.back());
-		unused.pop_back();
-		P = ready.back();
-	}
-	//cs.Leave		();
 	return	P;
 }
-NET_Packet*		INetQueue::Create(const NET_Packet& _other)
+
+void			INetQueue::Push(NET_Packet* P)
 {
-	NET_Packet*	P = 0;
-	cs.Enter();
-	//#ifdef _DEBUG
-	//		Msg ("- INetQueue::Create - ready %d, unused %d", ready.size(), unused.size());
-	//#endif
-	if (unused.empty())
+	entry		E;
+	E.packet	= P;
+	E.time		= CPU::QPC();
+
+	if (0 == overflow_count && ready.push(E))
 	{
-		ready.push_back(xr_new<NET_Packet>());
-		P = ready.back();
-		//---------------------------------------------
-		LastTimeCreate = GetTickCount();
-		//---------------------------------------------
+		InterlockedIncrement(&pending);
+		return;
 	}
-	else {
-		ready.push_back(unused.back());
-		unused.pop_back();
-		P = ready.back();
-	}
-	CopyMemory(P, &_other, sizeof(NET_Packet));
+
+	cs.Enter();
+	overflow.push_back(E);
+	InterlockedIncrement(&overflow_count);
+	InterlockedIncrement(&pending);
+	stats.overflowed++;
 	cs.Leave();
+}
+
+NET_Packet*		INetQueue::Create(const NET_Packet& _other)
+{
+	NET_Packet*	P = Create();
+	P->assign(_other);
+	Push(P);
 	return			P;
 }
-NET_Packet*		INetQueue::Retreive()
+
+bool			INetQueue::Pop(entry& E)
 {
-	NET_Packet*	P = 0;
-	//cs.Enter		();
-//#ifdef _DEBUG
-//			Msg ("INetQueue::Retreive - ready %d, unused %d", ready.size(), unused.size());
-//#endif
-	if (!ready.empty())		P = ready.front();
-	//---------------------------------------------	
-	else
+	if (!overflow_taken.empty())
 	{
-		u32 tmp_time = GetTickCount() - 60000;
-		u32 size = unused.size();
-		if ((LastTimeCreate < tmp_time) && (size > 32))
-		{
-			xr_delete(unused.back());
-			unused.pop_back();
-		}
+		E = overflow_taken.front();
+		overflow_taken.pop_front();
+		return true;
 	}
-	//---------------------------------------------	
-	//cs.Leave		();
-	return	P;
+
+	if (ready.pop(E))
+		return true;
+
+	// the overflow list is taken only after everything pushed into the queue
+	// before it, a claimed but not finished push waits for the next batch
+	if (0 == overflow_count || !ready.empty())
+		return false;
+
+	cs.Enter();
+	overflow_taken.swap(overflow);
+	InterlockedExchange(&overflow_count, 0);
+	cs.Leave();
+
+	if (overflow_taken.empty())
+		return false;
+
+	E = overflow_taken.front();
+	overflow_taken.pop_front();
+	return true;
 }
-void			INetQueue::Release()
+
+void			INetQueue::Recycle(NET_Packet* P)
 {
-	//cs.Enter		();
-//#ifdef _DEBUG
-//		Msg ("INetQueue::Release - ready %d, unused %d", ready.size(), unused.size());
-//#endif
-	VERIFY(!ready.empty());
+	P->B.count = 0;
 	//---------------------------------------------
-	u32 tmp_time = GetTickCount() - 60000;
-	u32 size = unused.size();
-	ready.front()->B.count = 0;
-	if ((LastTimeCreate < tmp_time) && (size > 32))
+	if ((GetTickCount() - last_time_create > unused_keep_time) && (u32(unused_count) > unused_keep))
 	{
-		xr_delete(ready.front());
+		xr_delete(P);
+		return;
 	}
+	//---------------------------------------------
+	if (unused.push(P))
+		InterlockedIncrement(&unused_count);
 	else
-		unused.push_back(ready.front());
-	//---------------------------------------------	
-	ready.pop_front();
-	//cs.Leave		();
+		xr_delete(P);
+}
+
+void			INetQueue::BeginBatch()
+{
+	batch_left = u32(pending);
+	batch_done = 0;
+	stats.depth_max = _max(stats.depth_max, batch_left);
+}
+
+NET_Packet*		INetQueue::Retreive()
+{
+	if (current_valid)
+		return current.packet;
+
+	if (!batch_left || !Pop(current))
+	{
+		//---------------------------------------------
+		if ((GetTickCount() - last_time_create > unused_keep_time) && (u32(unused_count) > unused_keep))
+		{
+			NET_Packet*	P;
+			if (unused.pop(P))
+			{
+				InterlockedDecrement(&unused_count);
+				xr_delete(P);
+			}
+		}
+		//---------------------------------------------
+		return 0;
+	}
+
+	current_valid = true;
+
+	u64 const	latency = CPU::QPC() - current.time;
+	stats.latency_total += latency;
+	stats.latency_max = _max(stats.latency_max, latency);
+	stats.retrieved++;
+
+	return current.packet;
+}
+
+void			INetQueue::Release()
+{
+	VERIFY(current_valid);
+	current_valid = false;
+	Recycle(current.packet);
+
+	InterlockedDecrement(&pending);
+	batch_left--;
+	batch_done++;
+}
+
+void			INetQueue::EndBatch()
+{
+	stats.batch_last = batch_done;
+	stats.batch_max = _max(stats.batch_max, batch_done);
+	batch_left = 0;
 }
@@ -1,18 +1,82 @@
 #pragma once
 
+#include "NET_QueueLockFree.h"
+
+// Inbound packets of the client: the network thread (and the demo playback)
+// pushes, the game thread drains the queue once a tick. Both the ready packets
+// and the recycled ones are kept in lock-free queues; only a push into the full
+// ready queue goes into the overflow list under the critical section, and the
+// following pushes go there too until the consumer takes the list, so the
+// packets of one producer keep their order.
 class XRNETSERVER_API INetQueue
 {
-	xrCriticalSection		cs;
-	xr_deque<NET_Packet*>	ready;
-	xr_vector<NET_Packet*>	unused;
+public:
+	struct Statistic
+	{
+		u32					overflowed;			// pushes into the overflow list
+		u32					depth_max;			// pending packets at the start of a batch
+		u32					batch_last;
+		u32					batch_max;
+		u32					retrieved;
+		u64					latency_total;		// ticks from the push to the retrieve
+		u64					latency_max;
+
+		float				latency_avg_ms		() const { return retrieved ? float(double(latency_total) * 1000.0 / double(CPU::qpc_freq) / retrieved) : 0.f;	}
+		float				latency_max_ms		() const { return float(double(latency_max) * 1000.0 / double(CPU::qpc_freq));	}
+	};
+
+private:
+	struct entry
+	{
+		NET_Packet*			packet;
+		u64					time;
+	};
+
+	enum
+	{
+		ready_size			= 4096,
+		unused_size			= 1024,
+	};
+
+	net_queue<entry,ready_size>			ready;
+	net_queue<NET_Packet*,unused_size>	unused;
+	volatile LONG			unused_count;
+	volatile LONG			pending;
+	volatile u32			last_time_create;
+
+	xrCriticalSection		cs;					// overflow only
+	xr_deque<entry>			overflow;
+	volatile LONG			overflow_count;
+
+	// consumer side
+	xr_deque<entry>			overflow_taken;
+	entry					current;
+	bool					current_valid;
+	u32						batch_left;
+	u32						batch_done;
+
+	Statistic				stats;
+
+	bool					Pop					(entry& E);
+	void					Recycle				(NET_Packet* P);
 public:
 	INetQueue();
 	~INetQueue();
 
+	// a free packet, the caller fills it and pushes it with Push
 	NET_Packet*			Create();
+	void				Push(NET_Packet* P);
+	// Create and Push of a copy
 	NET_Packet*			Create(const NET_Packet& _other);
+
+	// Retreive/Release between BeginBatch and EndBatch, the batch takes the
+	// packets pushed before BeginBatch
+	void				BeginBatch();
 	NET_Packet*			Retreive();
 	void				Release();
-	inline void			Lock() { cs.Enter(); };
-	inline void			Unlock() { cs.Leave(); };
+	void				EndBatch();
+
+	u32					Depth() const { return u32(pending); }
+	const Statistic&	GetStatistic() const { return stats; }
+	void				ResetStatistic() { ZeroMemory(&stats, sizeof(stats)); }
 };
@@ -0,0 +1,116 @@
+#include "stdafx.h"
+#include "LoopbackClient.h"
+#include "BaseServer.h"
+
+// -----------------------------------------------------------------------------
+
+LoopbackClient::LoopbackClient(CTimer* timer) : BaseClient(timer)
+{
+	m_name[0] = 0;
+}
+
+// -----------------------------------------------------------------------------
+
+LoopbackClient::~LoopbackClient()
+{
+	DestroyConnection();
+}
+
+// -----------------------------------------------------------------------------
+
+#pragma region connect / disconnect
+
+bool LoopbackClient::Connect(BaseServer* server, LPCSTR name)
+{
+	R_ASSERT(server && !m_server);
+
+	m_server = server;
+	xr_strcpy(m_name, name);
+
+	net_Connected = EnmConnectionWait;
+	net_Syncronised = FALSE;
+	net_Disconnected = FALSE;
+
+	ClientConnectionOptions connectOpt;
+	if (!CreateConnection(connectOpt))
+	{
+		m_server = nullptr;
+		net_Disconnected = TRUE;
+		return false;
+	}
+
+	// same process and timer as the server, nothing to synchronize
+	net_TimeDelta = 0;
+	net_Syncronised = TRUE;
+	return true;
+}
+
+bool LoopbackClient::CreateConnection(ClientConnectionOptions& /*opt*/)
+{
+	// the server sets the id before the client is registered
+	return m_server->loopback_Connect(this, m_name).value() != 0;
+}
+
+void LoopbackClient::DestroyConnection()
+{
+	if (!m_server)
+	{
+		return;
+	}
+
+	m_server->loopback_Disconnect(GetClientID());
+}
+
+#pragma endregion
+
+// -----------------------------------------------------------------------------
+
+#pragma region send / receive
+
+void LoopbackClient::SendTo_LL(void* data, u32 size, u32 /*dwFlags*/, u32 /*dwTimeout*/)
+{
+	if (!m_server)
+	{
+		return;
+	}
+
+	InterlockedExchangeAdd(&m_bytes_sent, LONG(size));
+	InterlockedIncrement(&m_packets_sent);
+	net_Statistic.dwBytesSended += size;
+
+	m_server->loopback_Recieve(GetClientID(), data, size);
+}
+
+void LoopbackClient::Deliver(const void* data, u32 size)
+{
+	InterlockedExchangeAdd(&m_bytes_received, LONG(size));
+	InterlockedIncrement(&m_packets_received);
+
+	MultipacketReciever::RecievePacket(data, size);
+}
+
+bool LoopbackClient::GetPendingMessagesCount(DWORD& dwPending)
+{
+	// delivery is synchronous
+	dwPending = 0;
+	return true;
+}
+
+bool LoopbackClient::SendPingMessage(MSYS_PING& /*clPing*/)
+{
+	return m_server != nullptr;
+}
+
+#pragma endregion
+
+// -----------------------------------------------------------------------------
+
+bool LoopbackClient::GetServerAddress(ip_address& pAddress, DWORD* pPort)
+{
+	pAddress.set("127.0.0.1");
+	if (pPort != NULL)
+	{
+		*pPort = m_server ? m_server->GetPort() : 0;
+	}
+	return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "BaseClient.h"
+
+class BaseServer;
+
+// In-process client of a BaseServer, without sockets. Multipackets go
+// straight into the server receive path and come back through
+// BaseServer::SendTo_LL, so the server runs exactly the code it runs for a
+// remote client. Used by the server load test.
+
+class XRNETSERVER_API LoopbackClient : public BaseClient
+{
+	friend class BaseServer;
+
+private:
+	BaseServer*             m_server = nullptr;
+	string64                m_name;
+
+	// wire traffic, compressed multipackets as a socket would carry them
+	volatile LONG           m_bytes_sent = 0;
+	volatile LONG           m_bytes_received = 0;
+	volatile LONG           m_packets_sent = 0;
+	volatile LONG           m_packets_received = 0;
+
+public:
+	LoopbackClient(CTimer* tm);
+	virtual ~LoopbackClient();
+
+	bool                    Connect(BaseServer* server, LPCSTR name);
+
+	u32                     BytesSent() const { return u32(m_bytes_sent); }
+	u32                     BytesReceived() const { return u32(m_bytes_received); }
+	u32                     PacketsSent() const { return u32(m_packets_sent); }
+	u32                     PacketsReceived() const { return u32(m_packets_received); }
+
+private:
+	// called by the server, data is a multipacket
+	void                    Deliver(const void* data, u32 size);
+
+protected:
+	virtual bool            IsConnectionInit() override { return m_server != nullptr; }
+
+	virtual bool            CreateConnection(ClientConnectionOptions& opt) override;
+	virtual void            DestroyConnection() override;
+	virtual void            SendTo_LL(void* data, u32 size, u32 dwFlags = DPNSEND_GUARANTEED, u32 dwTimeout = 0) override;
+
+	virtual bool            GetPendingMessagesCount(DWORD& dwPending) override;
+	virtual bool            SendPingMessage(MSYS_PING& clPing) override;
+
+public:
+	virtual bool            GetServerAddress(ip_address& pAddress, DWORD* pPort) override;
+	virtual LPCSTR          net_SessionName() const override { return "loopback"; }
+
+	virtual void            UpdateStatistic() override {}
+};
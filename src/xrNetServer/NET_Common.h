@@ -26,6 +26,8 @@ struct GameDescriptionData
 #define NET_DUMP_COMPRESSION            0
 
 
+#define NET_RECEIVE_BATCH               64      // messages taken from the socket library per call
+
 #define NET_GUARANTEEDPACKET_DEFAULT    0
 #define NET_GUARANTEEDPACKET_IGNORE     1
 #define NET_GUARANTEEDPACKET_SEPARATE   2
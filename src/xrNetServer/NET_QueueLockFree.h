@@ -0,0 +1,94 @@
+#ifndef NET_QUEUE_LOCK_FREE_H_INCLUDED
+#define NET_QUEUE_LOCK_FREE_H_INCLUDED
+#pragma once
+
+// Bounded lock-free queue of size cells (power of two), any number of threads
+// may push and pop. Every cell has a sequence number telling whether it is free
+// for the push with position pos (sequence == pos) or filled for the pop with
+// position pos (sequence == pos+1), the positions are claimed with a CAS.
+// push and pop return false instead of waiting when the queue is full or empty;
+// a cell whose push is claimed but not finished yet reads as empty.
+
+template <typename T, u32 size>
+class net_queue
+{
+	enum { mask = size - 1 };
+
+	struct cell
+	{
+		volatile LONG	sequence;
+		T				data;
+	};
+
+	cell				m_cells		[size];
+	u8					m_pad0		[64];
+	volatile LONG		m_push_pos;
+	u8					m_pad1		[64];
+	volatile LONG		m_pop_pos;
+
+public:
+						net_queue	()
+	{
+		STATIC_CHECK	(size && !(size & (size - 1)), Net_queue_size_must_be_a_power_of_two);
+		for (u32 i = 0; i < size; ++i)
+			m_cells[i].sequence	= LONG(i);
+		m_push_pos		= 0;
+		m_pop_pos		= 0;
+	}
+
+	bool				push		(T const& value)
+	{
+		LONG	pos		= m_push_pos;
+		cell*	C;
+		for (;;)
+		{
+			C			= &m_cells[pos & mask];
+			LONG	dif	= C->sequence - pos;
+			if (0 == dif)
+			{
+				LONG	prev	= InterlockedCompareExchange(&m_push_pos, pos + 1, pos);
+				if (prev == pos)
+					break;
+				pos		= prev;
+			}
+			else if (dif < 0)
+				return	false;
+			else
+				pos		= m_push_pos;
+		}
+		C->data			= value;
+		InterlockedExchange	(&C->sequence, pos + 1);
+		return			true;
+	}
+
+	bool				pop			(T& value)
+	{
+		LONG	pos		= m_pop_pos;
+		cell*	C;
+		for (;;)
+		{
+			C			= &m_cells[pos & mask];
+			LONG	dif	= C->sequence - (pos + 1);
+			if (0 == dif)
+			{
+				LONG	prev	= InterlockedCompareExchange(&m_pop_pos, pos + 1, pos);
+				if (prev == pos)
+					break;
+				pos		= prev;
+			}
+			else if (dif < 0)
+				return	false;
+			else
+				pos		= m_pop_pos;
+		}
+		value			= C->data;
+		InterlockedExchange	(&C->sequence, pos + mask + 1);
+		return			true;
+	}
+
+	// no push is claimed past the pops, exact only for a single consumer
+	IC bool				empty		() const	{ return m_push_pos == m_pop_pos;	}
+	IC u32				count		() const	{ return u32(m_push_pos - m_pop_pos);	}
+};
+
+#endif // NET_QUEUE_LOCK_FREE_H_INCLUDED
@@ -177,40 +177,49 @@ void SteamNetClient::Update()
 
 void SteamNetClient::PollIncomingMessages()
 {
+	ISteamNetworkingMessage*	pIncomingMsgs[NET_RECEIVE_BATCH];
+
 	while (true)
 	{
 		if (m_pInterface == nullptr)
 			break;
 
-		ISteamNetworkingMessage *pIncomingMsg = nullptr;
-		int numMsgs = m_pInterface->ReceiveMessagesOnConnection(m_hConnection, &pIncomingMsg, 1);
+		int numMsgs = m_pInterface->ReceiveMessagesOnConnection(m_hConnection, pIncomingMsgs, NET_RECEIVE_BATCH);
 		if (numMsgs <= 0)
 		{
 			break;
 		}
 
-		void* data = pIncomingMsg->m_pData;
-		int size = pIncomingMsg->m_cbSize;
-
-		if (!GameDescriptionReceived())
+		for (int i = 0; i < numMsgs; ++i)
 		{
-			MSYS_GAME_DESCRIPTION*	sys_gd = (MSYS_GAME_DESCRIPTION*)data;
-			if (
-				size == sizeof(MSYS_GAME_DESCRIPTION) &&
-				sys_gd->sign1 == 0x02281488 &&
-				sys_gd->sign2 == 0x01488228
-				)
-			{
-				CopyMemory(&m_game_description, &sys_gd->data, sizeof(m_game_description));
-				m_bGameDescriptionRecieved = true;
+			ISteamNetworkingMessage *pIncomingMsg = pIncomingMsgs[i];
+
+			void* data = pIncomingMsg->m_pData;
+			int size = pIncomingMsg->m_cbSize;
 
-				pIncomingMsg->Release();
-				continue;
+			if (!GameDescriptionReceived())
+			{
+				MSYS_GAME_DESCRIPTION*	sys_gd = (MSYS_GAME_DESCRIPTION*)data;
+				if (
+					size == sizeof(MSYS_GAME_DESCRIPTION) &&
+					sys_gd->sign1 == 0x02281488 &&
+					sys_gd->sign2 == 0x01488228
+					)
+				{
+					CopyMemory(&m_game_description, &sys_gd->data, sizeof(m_game_description));
+					m_bGameDescriptionRecieved = true;
+
+					pIncomingMsg->Release();
+					continue;
+				}
 			}
+
+			MultipacketReciever::RecievePacket(pIncomingMsg->m_pData, pIncomingMsg->m_cbSize);
+			pIncomingMsg->Release();
 		}
 
-		MultipacketReciever::RecievePacket(pIncomingMsg->m_pData, pIncomingMsg->m_cbSize);
-		pIncomingMsg->Release();
+		if (numMsgs < NET_RECEIVE_BATCH)
+			break;
 	}
 }
 
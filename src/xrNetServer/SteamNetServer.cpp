@@ -178,41 +178,49 @@ void SteamNetServer::PollConnectionStateChanges()
 
 void SteamNetServer::PollIncomingMessages()
 {
+	ISteamNetworkingMessage*	pIncomingMsgs[NET_RECEIVE_BATCH];
+
 	while (true)
 	{
 		if (m_pInterface == nullptr)
 			break;
 
-		ISteamNetworkingMessage *pIncomingMsg = nullptr;
-
-		int numMsgs = m_pInterface->ReceiveMessagesOnPollGroup(m_hPollGroup, &pIncomingMsg, 1);
+		int numMsgs = m_pInterface->ReceiveMessagesOnPollGroup(m_hPollGroup, pIncomingMsgs, NET_RECEIVE_BATCH);
 		if (numMsgs <= 0)
 		{
 			break;
 		}
 
-		void*	m_data = pIncomingMsg->m_pData;
-		u32	m_size = pIncomingMsg->m_cbSize;
-		HSteamNetConnection m_sender = pIncomingMsg->m_conn;
+		for (int i = 0; i < numMsgs; ++i)
+		{
+			ISteamNetworkingMessage *pIncomingMsg = pIncomingMsgs[i];
 
-		MSYS_PING*	m_ping = (MSYS_PING*)m_data;
+			void*	m_data = pIncomingMsg->m_pData;
+			u32	m_size = pIncomingMsg->m_cbSize;
+			HSteamNetConnection m_sender = pIncomingMsg->m_conn;
 
-		if (m_size == sizeof(MSYS_PING) && m_ping->sign1 == 0x12071980 && m_ping->sign2 == 0x26111975)
-		{
-			// ping - save server time and reply
-			m_ping->dwTime_Server = TimerAsync(device_timer);
-			ClientID ID; ID.set(m_sender);
-			BaseServer::SendTo_Buf(ID, m_data, m_size, net_flags(FALSE, FALSE, TRUE, TRUE));
-		}
-		else if (m_size == sizeof(MSYS_CLIENT_DATA) && m_ping->sign1 == 0x02281488 && m_ping->sign2 == 0x01488228)
-		{ // client data message
-			OnClientDataReceived(pIncomingMsg->m_conn, pIncomingMsg->m_identityPeer, (MSYS_CLIENT_DATA*)m_data);
-		}
-		else
-		{
-			MultipacketReciever::RecievePacket(m_data, m_size, m_sender);
+			MSYS_PING*	m_ping = (MSYS_PING*)m_data;
+
+			if (m_size == sizeof(MSYS_PING) && m_ping->sign1 == 0x12071980 && m_ping->sign2 == 0x26111975)
+			{
+				// ping - save server time and reply
+				m_ping->dwTime_Server = TimerAsync(device_timer);
+				ClientID ID; ID.set(m_sender);
+				BaseServer::SendTo_Buf(ID, m_data, m_size, net_flags(FALSE, FALSE, TRUE, TRUE));
+			}
+			else if (m_size == sizeof(MSYS_CLIENT_DATA) && m_ping->sign1 == 0x02281488 && m_ping->sign2 == 0x01488228)
+			{ // client data message
+				OnClientDataReceived(pIncomingMsg->m_conn, pIncomingMsg->m_identityPeer, (MSYS_CLIENT_DATA*)m_data);
+			}
+			else
+			{
+				MultipacketReciever::RecievePacket(m_data, m_size, m_sender);
+			}
+			pIncomingMsg->Release();
 		}
-		pIncomingMsg->Release();
+
+		if (numMsgs < NET_RECEIVE_BATCH)
+			break;
 	}
 }
 
@@ -433,6 +441,12 @@ bool SteamNetServer::DisconnectClient(IClient * C, LPCSTR Reason)
 {
 	if (!C) return false;
 
+	if (loopback_Find(C->ID))
+	{
+		loopback_Disconnect(C->ID);
+		return true;
+	}
+
 	CloseConnection(C->ID.value(), EDetailedReason, Reason);
 	DestroyCleint(C->ID.value());
 	return true;
@@ -493,6 +507,14 @@ void SteamNetServer::GetIpAddress(SteamNetConnectionInfo_t & info, ip_address &
 
 bool SteamNetServer::GetClientAddress(ClientID ID, ip_address& address, DWORD* pPort)
 {
+	if (loopback_Find(ID))
+	{
+		address.set("127.0.0.1");
+		if (pPort != NULL)
+			*pPort = 0;
+		return true;
+	}
+
 	SteamNetConnectionInfo_t info;
 	if (!m_pInterface->GetConnectionInfo(ID.value(), &info))
 	{
@@ -517,6 +539,12 @@ bool SteamNetServer::GetClientPendingMessagesCount(ClientID ID, DWORD & dwPendin
 {
 	R_ASSERT(m_pInterface);
 
+	if (loopback_Find(ID))
+	{
+		dwPending = 0;
+		return true;
+	}
+
 	SteamNetConnectionRealTimeStatus_t status;
 	if (m_pInterface->GetConnectionRealTimeStatus(ID.value(), &status, 0, 0))
 	{
@@ -79,6 +79,8 @@ enum {
 	M_SECURE_MESSAGE,
 	M_CREATE_PLAYER_STATE,
 	M_COMPRESSED_UPDATE_OBJECTS,
+	M_DELTA_UPDATE_OBJECTS,		// SV: delta encoded M_UPDATE_OBJECTS (eto_delta_updates)
+	M_CL_UPDATE_ACK,			// CL: acknowledges M_DELTA_UPDATE_OBJECTS snapshot
 
 	MSG_FORCEDWORD				= u32(-1)
 };